@@ -0,0 +1,119 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include "autosavewriter.h"
+#include "fileloader.h"
+#include "qtiocompressor.h"
+#include "scribusdoc.h"
+
+struct AutoSaveWriter::Job
+{
+	QString fileName;
+	QByteArray data;
+	bool success { false };
+	qint64 writeTime { 0 };
+	qint64 fileSize { 0 };
+	QSemaphore done;
+};
+
+AutoSaveWriter::AutoSaveWriter(QObject* parent) : QObject(parent)
+{
+
+}
+
+AutoSaveWriter::~AutoSaveWriter()
+{
+	// The worker accesses the job only, but must not outlive the file it writes to
+	if (m_job)
+		m_job->done.acquire();
+}
+
+bool AutoSaveWriter::start(ScribusDoc* doc, const QString& fileName)
+{
+	if (isRunning())
+		return false;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	auto job = std::make_shared<Job>();
+	job->fileName = fileName;
+	QBuffer buffer(&job->data);
+	if (!buffer.open(QIODevice::WriteOnly))
+		return false;
+	// A failed or empty snapshot must not replace a previous autosave file
+	FileLoader fl(fileName);
+	bool serialised = fl.saveToDevice(&buffer, QFileInfo(fileName).absolutePath(), doc);
+	buffer.close();
+	if (!serialised || job->data.isEmpty())
+		return false;
+
+	m_statistics = Statistics();
+	m_statistics.snapshotTime = timer.elapsed();
+	m_statistics.documentSize = job->data.size();
+
+	m_job = job;
+	QThreadPool::globalInstance()->start([this, job]() {
+		writeFile(*job);
+		// Post before releasing: our destructor waits for the release, so we are still alive here
+		QMetaObject::invokeMethod(this, &AutoSaveWriter::finishWrite, Qt::QueuedConnection);
+		job->done.release();
+	});
+	return true;
+}
+
+void AutoSaveWriter::waitForFinished()
+{
+	finishWrite();
+}
+
+void AutoSaveWriter::writeFile(Job& job)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QSaveFile file(job.fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		return;
+	QtIOCompressor compressor(&file);
+	compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+	if (!compressor.open(QIODevice::WriteOnly))
+		return;
+	bool written = (compressor.write(job.data) == job.data.size());
+	compressor.close();
+	job.data = QByteArray();
+	if (!written)
+	{
+		file.cancelWriting();
+		return;
+	}
+	job.fileSize = file.size();
+	job.success = file.commit();
+	job.writeTime = timer.elapsed();
+}
+
+void AutoSaveWriter::finishWrite()
+{
+	// Already done by waitForFinished()
+	if (!m_job)
+		return;
+	std::shared_ptr<Job> job = std::move(m_job);
+	job->done.acquire();
+
+	m_statistics.writeTime = job->writeTime;
+	m_statistics.fileSize = job->fileSize;
+	m_lastSucceeded = job->success;
+	m_lastFileName = job->fileName;
+	emit finished(job->success, job->fileName);
+}
@@ -0,0 +1,80 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef AUTOSAVEWRITER_H
+#define AUTOSAVEWRITER_H
+
+#include <memory>
+
+#include <QObject>
+#include <QString>
+
+#include "scribusapi.h"
+
+class ScribusDoc;
+
+/**
+ * \brief Writes autosave files of a document without blocking the GUI.
+ *
+ * The document is serialised to memory on the GUI thread: the document model is not
+ * copy on write and may only be read from the GUI thread, so this serialised copy is
+ * the snapshot of the document. Compressing it and writing the file, which take most
+ * of the time for large documents, then happen on a worker thread while editing goes on.
+ * The file is written under a temporary name and renamed into place once complete, an
+ * interrupted autosave never leaves a truncated file behind.
+ */
+class SCRIBUS_API AutoSaveWriter : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Timings of the last autosave, in milliseconds, and sizes in bytes
+	struct Statistics
+	{
+		qint64 snapshotTime { 0 };
+		qint64 writeTime { 0 };
+		qint64 documentSize { 0 };
+		qint64 fileSize { 0 };
+	};
+
+	explicit AutoSaveWriter(QObject* parent = nullptr);
+	~AutoSaveWriter() override;
+
+	/// Returns true while a file is being written
+	bool isRunning() const { return m_job != nullptr; }
+
+	/**
+	 * \brief Takes a snapshot of \a doc and starts writing it gzip compressed to \a fileName.
+	 * Returns false if a write is already running or the document could not be serialised,
+	 * otherwise finished() is emitted once the file is written.
+	 */
+	bool start(ScribusDoc* doc, const QString& fileName);
+
+	/// Blocks until the running write, if any, is done. finished() is emitted before returning.
+	void waitForFinished();
+
+	const Statistics& lastStatistics() const { return m_statistics; }
+	/// Result and file name of the last finished write, as passed to finished()
+	bool lastSucceeded() const { return m_lastSucceeded; }
+	const QString& lastFileName() const { return m_lastFileName; }
+
+signals:
+	void finished(bool success, const QString& fileName);
+
+private:
+	struct Job;
+
+	std::shared_ptr<Job> m_job;
+	Statistics m_statistics;
+	bool m_lastSucceeded { false };
+	QString m_lastFileName;
+
+	static void writeFile(Job& job);
+	void finishWrite();
+};
+
+#endif // AUTOSAVEWRITER_H
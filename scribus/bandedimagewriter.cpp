@@ -0,0 +1,180 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <png.h>
+#include <tiffio.h>
+
+#include "bandedimagewriter.h"
+
+static void BandedImageWriter_PNG_write_fn(png_structp pngPtr, png_bytep data, png_size_t length)
+{
+	QFile *file = (QFile*) png_get_io_ptr(pngPtr);
+	if (file->write((const char*) data, length) != static_cast<qint64>(length))
+		png_error(pngPtr, "Write Error");
+}
+
+static void BandedImageWriter_PNG_flush_fn(png_structp /*pngPtr*/)
+{
+}
+
+BandedImageWriter::BandedImageWriter(const QString& fileName, const QByteArray& format) :
+	m_fileName(fileName),
+	m_format(formatFromName(format))
+{
+}
+
+BandedImageWriter::~BandedImageWriter()
+{
+	release();
+}
+
+BandedImageWriter::Format BandedImageWriter::formatFromName(const QByteArray& format)
+{
+	QByteArray name = format.toLower();
+	if (name == "png")
+		return Format::PNG;
+	if ((name == "tif") || (name == "tiff"))
+		return Format::TIFF;
+	return Format::Unsupported;
+}
+
+bool BandedImageWriter::supportsFormat(const QByteArray& format)
+{
+	return formatFromName(format) != Format::Unsupported;
+}
+
+bool BandedImageWriter::open(int width, int height)
+{
+	if ((m_format == Format::Unsupported) || (width <= 0) || (height <= 0))
+	{
+		m_error = true;
+		return false;
+	}
+	m_width = width;
+	m_height = height;
+	m_rowsWritten = 0;
+	m_error = !((m_format == Format::PNG) ? openPNG() : openTIFF());
+	if (m_error)
+		release();
+	return !m_error;
+}
+
+bool BandedImageWriter::writeBand(const QImage& band)
+{
+	if (m_error || (band.width() != m_width) || (m_rowsWritten + band.height() > m_height))
+	{
+		m_error = true;
+		return false;
+	}
+	// Rows are stored unpremultiplied, in RGBA byte order
+	QImage rows = band.convertToFormat(QImage::Format_RGBA8888);
+	m_error = !((m_format == Format::PNG) ? writePNGRows(rows) : writeTIFFRows(rows));
+	if (m_error)
+		release();
+	else
+		m_rowsWritten += band.height();
+	return !m_error;
+}
+
+bool BandedImageWriter::close()
+{
+	if (!m_error && (m_rowsWritten != m_height))
+		m_error = true;
+	if (!m_error && (m_format == Format::PNG))
+		m_error = !closePNG();
+	if (!m_error && (m_format == Format::TIFF))
+		m_error = (TIFFFlush(m_tiff) == 0);
+	release();
+	return !m_error;
+}
+
+bool BandedImageWriter::openPNG()
+{
+	m_file.setFileName(m_fileName);
+	if (!m_file.open(QIODevice::WriteOnly))
+		return false;
+	m_png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	if (!m_png)
+		return false;
+	m_pngInfo = png_create_info_struct(m_png);
+	if (!m_pngInfo)
+		return false;
+	if (setjmp(png_jmpbuf(m_png)))
+		return false;
+
+	png_set_write_fn(m_png, &m_file, BandedImageWriter_PNG_write_fn, BandedImageWriter_PNG_flush_fn);
+	if (m_quality >= 0)
+		png_set_compression_level(m_png, (100 - qMin(m_quality, 100)) * 9 / 91);
+	png_set_IHDR(m_png, m_pngInfo, m_width, m_height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_set_pHYs(m_png, m_pngInfo, m_dotsPerMeter, m_dotsPerMeter, PNG_RESOLUTION_METER);
+	png_write_info(m_png, m_pngInfo);
+	return true;
+}
+
+bool BandedImageWriter::writePNGRows(const QImage& rows)
+{
+	if (setjmp(png_jmpbuf(m_png)))
+		return false;
+	for (int y = 0; y < rows.height(); ++y)
+		png_write_row(m_png, rows.constScanLine(y));
+	return true;
+}
+
+bool BandedImageWriter::closePNG()
+{
+	if (setjmp(png_jmpbuf(m_png)))
+		return false;
+	png_write_end(m_png, m_pngInfo);
+	m_file.close();
+	return (m_file.error() == QFileDevice::NoError);
+}
+
+bool BandedImageWriter::openTIFF()
+{
+	m_tiff = TIFFOpen(m_fileName.toLocal8Bit().data(), "w");
+	if (!m_tiff)
+		return false;
+	quint16 extraSample = EXTRASAMPLE_UNASSALPHA;
+	float resolution = m_dotsPerMeter * 2.54f / 100.0f;
+	TIFFSetField(m_tiff, TIFFTAG_IMAGEWIDTH, m_width);
+	TIFFSetField(m_tiff, TIFFTAG_IMAGELENGTH, m_height);
+	TIFFSetField(m_tiff, TIFFTAG_BITSPERSAMPLE, 8);
+	TIFFSetField(m_tiff, TIFFTAG_SAMPLESPERPIXEL, 4);
+	TIFFSetField(m_tiff, TIFFTAG_EXTRASAMPLES, 1, &extraSample);
+	TIFFSetField(m_tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+	TIFFSetField(m_tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+	TIFFSetField(m_tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+	TIFFSetField(m_tiff, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(m_tiff, 0));
+	TIFFSetField(m_tiff, TIFFTAG_XRESOLUTION, resolution);
+	TIFFSetField(m_tiff, TIFFTAG_YRESOLUTION, resolution);
+	TIFFSetField(m_tiff, TIFFTAG_RESOLUTIONUNIT, RESUNIT_INCH);
+	return true;
+}
+
+bool BandedImageWriter::writeTIFFRows(const QImage& rows)
+{
+	for (int y = 0; y < rows.height(); ++y)
+	{
+		// libtiff does not modify the row, it takes a non const pointer nevertheless
+		if (TIFFWriteScanline(m_tiff, const_cast<uchar*>(rows.constScanLine(y)), m_rowsWritten + y) < 0)
+			return false;
+	}
+	return true;
+}
+
+void BandedImageWriter::release()
+{
+	if (m_png)
+		png_destroy_write_struct(&m_png, m_pngInfo ? &m_pngInfo : nullptr);
+	m_png = nullptr;
+	m_pngInfo = nullptr;
+	if (m_file.isOpen())
+		m_file.close();
+	if (m_tiff)
+		TIFFClose(m_tiff);
+	m_tiff = nullptr;
+}
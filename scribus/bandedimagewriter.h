@@ -0,0 +1,87 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef BANDEDIMAGEWRITER_H
+#define BANDEDIMAGEWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QString>
+
+#include "scribusapi.h"
+
+struct png_struct_def;
+struct png_info_def;
+struct tiff;
+
+/**
+ * \brief Writes a PNG or TIFF image band after band.
+ *
+ * Images too large to be held in memory are rendered in horizontal bands, this writer
+ * encodes their rows as they come so that only one band is held at a time. Rows are
+ * written with 8 bits per channel and a non premultiplied alpha channel.
+ */
+class SCRIBUS_API BandedImageWriter
+{
+public:
+	/// Creates a writer for \a fileName in \a format, "png", "tif" or "tiff"
+	BandedImageWriter(const QString& fileName, const QByteArray& format);
+	~BandedImageWriter();
+
+	BandedImageWriter(const BandedImageWriter&) = delete;
+	BandedImageWriter& operator=(const BandedImageWriter&) = delete;
+
+	/// Returns true if images in \a format can be written band after band
+	static bool supportsFormat(const QByteArray& format);
+
+	/// Sets the resolution stored in the file
+	void setDotsPerMeter(int dotsPerMeter) { m_dotsPerMeter = dotsPerMeter; }
+	/// Sets the quality as for QImageWriter, used by PNG for the compression level
+	void setQuality(int quality) { m_quality = quality; }
+
+	/// Creates the file for an image of \a width by \a height pixels
+	bool open(int width, int height);
+	/// Appends the rows of \a band, whose width is that of the image
+	bool writeBand(const QImage& band);
+	/// Completes the file, returns false if the image is incomplete or could not be written
+	bool close();
+
+	bool hasError() const { return m_error; }
+
+private:
+	enum class Format
+	{
+		Unsupported,
+		PNG,
+		TIFF
+	};
+
+	QString m_fileName;
+	Format m_format { Format::Unsupported };
+	int m_dotsPerMeter { 2835 };
+	int m_quality { -1 };
+	int m_width { 0 };
+	int m_height { 0 };
+	int m_rowsWritten { 0 };
+	bool m_error { false };
+
+	QFile m_file;
+	png_struct_def* m_png { nullptr };
+	png_info_def* m_pngInfo { nullptr };
+	tiff* m_tiff { nullptr };
+
+	static Format formatFromName(const QByteArray& format);
+	bool openPNG();
+	bool writePNGRows(const QImage& rows);
+	bool closePNG();
+	bool openTIFF();
+	bool writeTIFFRows(const QImage& rows);
+	void release();
+};
+
+#endif // BANDEDIMAGEWRITER_H
@@ -19,6 +19,7 @@
 #include <cmath>
 
 // #include <QDebug>
+#include <QSet>
 #include <QToolTip>
 #include <QWidget>
 
@@ -91,6 +92,9 @@ Canvas::Canvas(ScribusDoc* doc, ScribusView* parent) : QWidget(parent), m_doc(do
 	m_buffer = QPixmap();
 	m_bufferRect = QRect();
 	m_renderMode = RENDER_NORMAL;
+	m_fullDetailTimer.setSingleShot(true);
+	m_fullDetailTimer.setInterval(fullDetailDelay);
+	connect(&m_fullDetailTimer, &QTimer::timeout, this, &Canvas::restoreFullDetail);
 }
 
 void Canvas::setPreviewVisual(int mode)
@@ -461,11 +465,20 @@ PageItem* Canvas::itemUnderCursor(QPointF globalPos, PageItem* itemAbove, bool a
 	if (m_doc->Items->isEmpty())
 		return nullptr;
 
-	QList<PageItem*> *itemList = (itemAbove && itemAbove->isGroupChild()) ? &itemAbove->parentGroup()->groupItemList : m_doc->Items;
-	int currNr = itemAbove ? itemList->indexOf(itemAbove) - 1 : itemList->count() - 1;
+	QList<PageItem*> itemList;
+	if (itemAbove && itemAbove->isGroupChild())
+		itemList = itemAbove->parentGroup()->groupItemList;
+	else
+	{
+		// only items around the mouse position are candidates, we get them in stacking order
+		itemList = m_doc->itemsInRect(m_doc->Items, mouseArea);
+		if (itemAbove && !itemList.contains(itemAbove))
+			itemList = *m_doc->Items;
+	}
+	int currNr = itemAbove ? itemList.indexOf(itemAbove) - 1 : itemList.count() - 1;
 	while (currNr >= 0)
 	{
-		currItem = itemList->at(currNr);
+		currItem = itemList.at(currNr);
 		if ((m_doc->masterPageMode())  && (!((currItem->OwnPage == -1) || (currItem->OwnPage == m_doc->currentPage()->pageNr()))))
 		{
 			--currNr;
@@ -634,6 +647,21 @@ void Canvas::clearBuffers()
 	m_bufferRect = QRect();
 	m_selectionBuffer = QPixmap();
 	m_selectionRect = QRect();
+	m_tileCache.clear();
+}
+
+void Canvas::setForcedRedraw(bool on)
+{
+	m_viewMode.forceRedraw = on;
+	// We don't know what changed, cached tiles may be outdated anywhere
+	if (on)
+		m_tileCache.clear();
+}
+
+void Canvas::setForcedRedraw(const QRectF& canvasRect)
+{
+	m_viewMode.forceRedraw = true;
+	m_tileCache.invalidate(canvasRect);
 }
 
 void Canvas::setScale(double scale)
@@ -641,7 +669,11 @@ void Canvas::setScale(double scale)
 	if (m_viewMode.scale == scale)
 		return;
 	m_viewMode.scale = scale;
-	clearBuffers();
+	// Keep tiles of the previous zoom level for zooming back
+	m_buffer = QPixmap();
+	m_bufferRect = QRect();
+	m_selectionBuffer = QPixmap();
+	m_selectionRect = QRect();
 	update();
 }
 
@@ -706,6 +738,8 @@ bool Canvas::adjustBuffer()
 		}
 		else
 		{
+			// The view is being scrolled
+			startReducedDetail();
 			// copy buffer:
 			QPixmap newBuffer = createPixmap(newRect.width(), newRect.height());
 			QPainter p(&newBuffer);
@@ -786,13 +820,127 @@ bool Canvas::adjustBuffer()
 	return ret;
 }
 
-void Canvas::fillBuffer(QPaintDevice* buffer, QPoint bufferOrigin, QRect clipRect)
+void Canvas::fillBuffer(QPixmap* buffer, QPoint bufferOrigin, QRect clipRect)
 {
 // 	qDebug()<<"Canvas::fillBuffer"<<clipRect<<m_viewMode.forceRedraw<<m_viewMode.operItemSelecting;
+	m_tileCache.setViewState(tileViewState());
+	QRect tiles = m_tileCache.tileRange(clipRect);
+
+	bool tilesCached = true;
+	for (int ty = tiles.top(); tilesCached && (ty <= tiles.bottom()); ++ty)
+	{
+		for (int tx = tiles.left(); tx <= tiles.right(); ++tx)
+		{
+			if (m_tileCache.tile(tx, ty) == nullptr)
+			{
+				tilesCached = false;
+				break;
+			}
+		}
+	}
+
 	QPainter painter(buffer);
 	painter.translate(-bufferOrigin.x(), -bufferOrigin.y());
+	if (tilesCached)
+	{
+		painter.setClipRect(clipRect);
+		for (int ty = tiles.top(); ty <= tiles.bottom(); ++ty)
+		{
+			for (int tx = tiles.left(); tx <= tiles.right(); ++tx)
+				painter.drawPixmap(m_tileCache.tileRect(tx, ty).topLeft(), *m_tileCache.tile(tx, ty));
+		}
+		painter.end();
+		return;
+	}
+	m_reducedDetailDrawn = false;
 	drawContents(&painter, clipRect.x(), clipRect.y(), clipRect.width(), clipRect.height());
 	painter.end();
+
+	// Only tiles drawn at full detail are cached, others are redrawn once navigation stops
+	if (m_reducedDetailDrawn)
+	{
+		m_reducedDetailRect |= QRectF(clipRect.x() / m_viewMode.scale + m_doc->minCanvasCoordinate.x(), clipRect.y() / m_viewMode.scale + m_doc->minCanvasCoordinate.y(),
+		                              clipRect.width() / m_viewMode.scale, clipRect.height() / m_viewMode.scale);
+		return;
+	}
+
+	// Keep the tiles we rendered completely for later fills
+	QRect bufferRect(bufferOrigin, buffer->deviceIndependentSize().toSize());
+	QRect renderedRect = clipRect.intersected(bufferRect);
+	double dpr = buffer->devicePixelRatio();
+	for (int ty = tiles.top(); ty <= tiles.bottom(); ++ty)
+	{
+		for (int tx = tiles.left(); tx <= tiles.right(); ++tx)
+		{
+			QRect tileRect = m_tileCache.tileRect(tx, ty);
+			if (!renderedRect.contains(tileRect))
+				continue;
+			QRect sourceRect((tileRect.x() - bufferOrigin.x()) * dpr, (tileRect.y() - bufferOrigin.y()) * dpr, tileRect.width() * dpr, tileRect.height() * dpr);
+			QPixmap tile = buffer->copy(sourceRect);
+			tile.setDevicePixelRatio(dpr);
+			m_tileCache.insert(tx, ty, tile);
+		}
+	}
+}
+
+CanvasTileCache::ViewState Canvas::tileViewState() const
+{
+	CanvasTileCache::ViewState state;
+	state.scale = m_viewMode.scale;
+	state.origin = m_doc->minCanvasCoordinate.toQPointF();
+	state.appMode = m_doc->appMode;
+	state.masterPageMode = m_doc->masterPageMode();
+	state.previewMode = m_viewMode.previewMode;
+	state.viewAsPreview = m_viewMode.viewAsPreview;
+	state.previewVisual = m_viewMode.previewVisual;
+	state.hideSelection = m_viewMode.operItemMoving || m_viewMode.drawSelectedItemsWithControls;
+	state.drawFramelinks = m_viewMode.drawFramelinksWithContents;
+	// Frame links of selected items are part of the contents
+	for (int i = 0; i < m_doc->m_Selection->count(); ++i)
+		state.selectionKey = state.selectionKey * 31 + reinterpret_cast<quintptr>(m_doc->m_Selection->itemAt(i));
+	return state;
+}
+
+void Canvas::startReducedDetail()
+{
+	m_viewMode.reducedDetail = true;
+	m_fullDetailTimer.start();
+}
+
+bool Canvas::drawItemWithReducedDetail(const PageItem* currItem)
+{
+	if (!currItem->hasReducibleDetail())
+		return false;
+	// Previews and output, e.g. page previews or bitmap export, keep all details
+	if (m_viewMode.previewMode || m_doc->imageLoadScheduler()->outputInProgress())
+		return false;
+	if (m_viewMode.reducedDetail)
+	{
+		m_reducedDetailDrawn = true;
+		return true;
+	}
+	QRectF bounds = currItem->getBoundingRect();
+	return (qMax(bounds.width(), bounds.height()) * m_viewMode.scale) < reducedDetailItemSize;
+}
+
+void Canvas::restoreFullDetail()
+{
+	// Don't touch the buffer while it is used to move or resize items
+	if (m_renderMode != RENDER_NORMAL)
+	{
+		m_fullDetailTimer.start();
+		return;
+	}
+	m_viewMode.reducedDetail = false;
+	QRectF canvasRect = m_reducedDetailRect;
+	m_reducedDetailRect = QRectF();
+	if (canvasRect.isEmpty() || !m_bufferRect.isValid())
+		return;
+	QRect localRect = canvasToLocal(canvasRect).adjusted(-1, -1, 1, 1).intersected(m_bufferRect);
+	if (localRect.isEmpty())
+		return;
+	fillBuffer(&m_buffer, m_bufferRect.topLeft(), localRect);
+	update(localRect);
 }
 
 /**
@@ -834,6 +982,15 @@ void Canvas::paintEvent ( QPaintEvent * p )
 			if ((m_viewMode.forceRedraw || m_viewMode.operTextSelecting) && (!bufferFilled))
 			{
 //				qDebug() << "Canvas::paintEvent: forceRedraw=" << m_viewMode.forceRedraw << "bufferFilled=" << bufferFilled;
+				// Text selection may change in frames outside of the view too
+				if (m_viewMode.operTextSelecting)
+					m_tileCache.clear();
+				else
+				{
+					QRect r = p->rect();
+					m_tileCache.invalidate(QRectF(r.x() / m_viewMode.scale + m_doc->minCanvasCoordinate.x(), r.y() / m_viewMode.scale + m_doc->minCanvasCoordinate.y(),
+					                              r.width() / m_viewMode.scale, r.height() / m_viewMode.scale));
+				}
 				fillBuffer(&m_buffer, m_bufferRect.topLeft(), p->rect());
 			}
 #ifdef SHOW_ME_WHAT_YOU_GET_IN_D_CANVA
@@ -1367,6 +1524,11 @@ void Canvas::DrawMasterItems(ScPainter *painter, const ScPage *page, const ScLay
 
 	PageItem *currItem;
 	ScPage* Mp = m_doc->MasterPages.at(m_doc->MasterNames[page->masterPageName()]);
+	// Items not changed on this page are drawn shifted from their masterpage position,
+	// so look them up with the culling area moved back onto the masterpage
+	QRectF masterCullingArea = cullingArea.translated(Mp->xOffset() - page->xOffset(), Mp->yOffset() - page->yOffset());
+	const QList<PageItem*> masterCandidates = m_doc->itemsInRect(&m_doc->MasterItems, masterCullingArea);
+	QSet<PageItem*> visibleMasterItems(masterCandidates.begin(), masterCandidates.end());
 	if (((layer.blendMode != 0) || (layer.transparency != 1.0)) && (!layer.outlineMode))
 		painter->beginLayer(layer.transparency, layer.blendMode);
 	int pageFromMasterCount = page->FromMaster.count();
@@ -1375,6 +1537,8 @@ void Canvas::DrawMasterItems(ScPainter *painter, const ScPage *page, const ScLay
 		currItem = page->FromMaster.at(a);
 		if (currItem->m_layerID != layer.ID)
 			continue;
+		if (!currItem->ChangedMasterItem && !visibleMasterItems.contains(currItem))
+			continue;
 		if ((currItem->OwnPage != -1) && (currItem->OwnPage != Mp->pageNr()))
 			continue;
 		if ((m_viewMode.previewMode) && (!currItem->printEnabled()))
@@ -1410,11 +1574,14 @@ void Canvas::DrawMasterItems(ScPainter *painter, const ScPage *page, const ScLay
 		}
 		if (cullingArea.intersects(currItem->getBoundingRect().adjusted(0.0, 0.0, 1.0, 1.0)))
 		{
+			m_doc->imageLoadScheduler()->request(currItem);
 			if (!((m_viewMode.operItemMoving) && (currItem->isSelected())))
 			{
 				if (m_viewMode.forceRedraw)
 					currItem->invalidateLayout();
+				painter->setReducedDetail(drawItemWithReducedDetail(currItem));
 				currItem->DrawObj(painter, cullingArea);
+				painter->setReducedDetail(false);
 				currItem->DrawObj_Decoration(painter);
 			}
 //			else 
@@ -1466,6 +1633,8 @@ void Canvas::DrawPageItems(ScPainter *painter, const ScLayer& layer, QRect clip,
 
 	PageItem *currItem { nullptr };
 	int docCurrPageNo = m_doc->currentPageNumber();
+	// Only items in the culling area are candidates for drawing, we get them in stacking order
+	const QList<PageItem*> candidateItems = m_doc->itemsInRect(m_doc->Items, cullingArea);
 	if (((layer.blendMode != 0) || (layer.transparency != 1.0)) && (!layer.outlineMode))
 		painter->beginLayer(layer.transparency, layer.blendMode);
 
@@ -1473,7 +1642,7 @@ void Canvas::DrawPageItems(ScPainter *painter, const ScLayer& layer, QRect clip,
 	//then we must be sure that text frames are valid and all notes frames are created before we start drawing
 	if (!notesFramesPass && !m_doc->notesList().isEmpty())
 	{
-		for (auto it = m_doc->Items->begin(); it != m_doc->Items->end(); ++it)
+		for (auto it = candidateItems.begin(); it != candidateItems.end(); ++it)
 		{
 			PageItem* currItem = *it;
 			if ( !currItem->isTextFrame()
@@ -1489,9 +1658,9 @@ void Canvas::DrawPageItems(ScPainter *painter, const ScLayer& layer, QRect clip,
 				currItem->layout();
 		}
 	}
-	for (int it = 0; it < m_doc->Items->count(); ++it)
+	for (int it = 0; it < candidateItems.count(); ++it)
 	{
-		currItem = m_doc->Items->at(it);
+		currItem = candidateItems.at(it);
 		if (notesFramesPass && !currItem->isNoteFrame())
 			continue;
 		if (!notesFramesPass && currItem->isNoteFrame())
@@ -1511,6 +1680,8 @@ void Canvas::DrawPageItems(ScPainter *painter, const ScLayer& layer, QRect clip,
 		}
 		if (cullingArea.intersects(currItem->getBoundingRect().adjusted(0.0, 0.0, 1.0, 1.0)))
 		{
+			// Images of large documents are loaded once their items are drawn
+			m_doc->imageLoadScheduler()->request(currItem);
 			if ((m_viewMode.operItemMoving || m_viewMode.drawSelectedItemsWithControls) && currItem->isSelected())
 			{
 //					qDebug() << "skipping pageitem (move/resizeEdit/selected)" << m_viewMode.operItemMoving << currItem->isSelected();
@@ -1518,7 +1689,9 @@ void Canvas::DrawPageItems(ScPainter *painter, const ScLayer& layer, QRect clip,
 			else if (m_viewMode.operItemSelecting)
 			{
 				currItem->invalid = false;
+				painter->setReducedDetail(drawItemWithReducedDetail(currItem));
 				currItem->DrawObj(painter, cullingArea);
+				painter->setReducedDetail(false);
 				currItem->DrawObj_Decoration(painter);
 			}
 			else
@@ -1527,7 +1700,18 @@ void Canvas::DrawPageItems(ScPainter *painter, const ScLayer& layer, QRect clip,
 				// alter the "data". And it really prevents optimisation - pm
 // 				if (m_viewMode.forceRedraw)
 // 					currItem->invalidateLayout();
-				currItem->DrawObj(painter, cullingArea);
+				if (currItem->isTextFrame() && !m_doc->textLayoutScheduler()->isReadyForDrawing(currItem->asTextFrame()))
+				{
+					// The chain is laid out progressively, draw the frame without
+					// text, it gets repainted once its layout is done
+					currItem->asTextFrame()->DrawObj_WithoutText(painter);
+				}
+				else
+				{
+					painter->setReducedDetail(drawItemWithReducedDetail(currItem));
+					currItem->DrawObj(painter, cullingArea);
+					painter->setReducedDetail(false);
+				}
 				currItem->DrawObj_Decoration(painter);
 			}
 			getLinkedFrames(currItem);
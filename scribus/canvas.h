@@ -29,10 +29,12 @@ scribusview.h  -  description
 #include <QPolygon>
 #include <QRect>
 #include <QRectF>
+#include <QTimer>
 #include <QWidget>
 
 #include "scribusapi.h"
 
+#include "canvastilecache.h"
 #include "commonstrings.h"
 #include "fpoint.h"
 #include "fpointarray.h"
@@ -61,6 +63,8 @@ struct CanvasViewMode
 	bool drawSelectedItemsWithControls {false};
 	/** if true, drawContents() will draw framelinks even if View->Show Framelinks is false */
 	bool drawFramelinksWithContents {false};
+	/** if true, drawContents() draws all items at reduced detail, set while the view is panned or zoomed */
+	bool reducedDetail {false};
 	// used for buffering:
 	bool forceRedraw {false};
 	double scale {1};
@@ -78,6 +82,10 @@ class SCRIBUS_API Canvas : public QWidget
 public:	
 	static const int moveWithFullOutlinesThreshold = 21;
 	static const int moveWithBoxesOnlyThreshold = 41;
+	/// Items smaller than this on screen, in pixels, are always drawn at reduced detail
+	static const int reducedDetailItemSize = 16;
+	/// Delay in ms after the last pan or zoom step before full detail is drawn again
+	static const int fullDetailDelay = 300;
 
 	Canvas(ScribusDoc* doc, ScribusView* parent);
 	
@@ -187,7 +195,9 @@ public:
 		m_viewMode.redrawPolygon.clear();
 		return m_viewMode.redrawPolygon;
 	}
-	void setForcedRedraw(bool on) { m_viewMode.forceRedraw = on; }
+	void setForcedRedraw(bool on);
+	/** Forces a redraw where only content inside \a canvasRect changed, cached tiles elsewhere stay valid */
+	void setForcedRedraw(const QRectF& canvasRect);
 	bool isForcedRedraw() const { return m_viewMode.forceRedraw; }
 	void setPreviewMode(bool on) { m_viewMode.previewMode = on; }
 	bool isPreviewMode() const { return m_viewMode.previewMode || m_viewMode.viewAsPreview; }
@@ -244,8 +254,15 @@ private:
 	/**
 		Fills the given buffer with contents.
 	    bufferOrigin and clipRect are in local coordinates
+	    Cached tiles are used if they cover clipRect, otherwise contents are
+	    rendered and the complete tiles of clipRect are stored in the cache.
 	 */
-	void fillBuffer(QPaintDevice* buffer, QPoint bufferOrigin, QRect clipRect);
+	void fillBuffer(QPixmap* buffer, QPoint bufferOrigin, QRect clipRect);
+	/// Returns the state of the view content is rendered with, used to select a level of cached tiles
+	CanvasTileCache::ViewState tileViewState() const;
+	/// Draws at reduced detail until no pan or zoom step happened for fullDetailDelay ms
+	void startReducedDetail();
+	bool drawItemWithReducedDetail(const PageItem* currItem);
 	void drawContents(QPainter *p, int clipx, int clipy, int clipw, int cliph);
 	void drawBackgroundMasterpage(ScPainter* painter, int clipx, int clipy, int clipw, int cliph);
 	void drawBackgroundPageOutlines(ScPainter* painter, int clipx, int clipy, int clipw, int cliph);
@@ -264,6 +281,10 @@ private:
 	QPixmap createPixmap(double w, double h);
 	// draw a potentially hidpi pixmap
 	void drawPixmap(QPainter &painter, double x, double y, const QPixmap &pixmap, double sx, double sy, double sw, double sh);
+
+private slots:
+	/// Redraws the areas drawn at reduced detail during the last pan or zoom
+	void restoreFullDetail();
 		
 private:
 	ScribusDoc* m_doc;
@@ -276,6 +297,10 @@ private:
 	QPixmap m_selectionBuffer;
 	QRect   m_selectionRect;
 	QPoint  m_oldMinCanvasCoordinate;
+	CanvasTileCache m_tileCache;
+	QTimer  m_fullDetailTimer;
+	QRectF  m_reducedDetailRect;
+	bool    m_reducedDetailDrawn {false};
 };
 
 
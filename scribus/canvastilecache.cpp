@@ -0,0 +1,128 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <cmath>
+
+#include <QHash>
+
+#include "canvastilecache.h"
+
+namespace
+{
+	// Number of view states whose tiles are kept, e.g. zoom levels
+	const int maxLevels = 4;
+	// Memory used by tiles, in bytes
+	const qsizetype maxCacheSize = 96 * 1024 * 1024;
+}
+
+size_t qHash(const CanvasTileCache::TileKey& key, size_t seed)
+{
+	return qHashMulti(seed, key.level, key.tx, key.ty);
+}
+
+bool CanvasTileCache::ViewState::operator==(const ViewState& other) const
+{
+	return (scale == other.scale) && (origin == other.origin)
+		&& (appMode == other.appMode) && (masterPageMode == other.masterPageMode)
+		&& (previewMode == other.previewMode) && (viewAsPreview == other.viewAsPreview)
+		&& (previewVisual == other.previewVisual) && (hideSelection == other.hideSelection)
+		&& (drawFramelinks == other.drawFramelinks) && (selectionKey == other.selectionKey);
+}
+
+CanvasTileCache::CanvasTileCache(int tileSize) :
+	m_tileSize(qMax(16, tileSize)),
+	m_tiles(maxCacheSize)
+{
+
+}
+
+void CanvasTileCache::setViewState(const ViewState& state)
+{
+	for (int i = 0; i < m_levels.count(); ++i)
+	{
+		if (m_levels.at(i).state != state)
+			continue;
+		if (i > 0)
+			m_levels.move(i, 0);
+		return;
+	}
+
+	Level level;
+	level.id = m_nextLevelId++;
+	level.state = state;
+	m_levels.prepend(level);
+	if (m_levels.count() <= maxLevels)
+		return;
+
+	int droppedLevel = m_levels.takeLast().id;
+	const QList<TileKey> keys = m_tiles.keys();
+	for (const TileKey& key : keys)
+	{
+		if (key.level == droppedLevel)
+			m_tiles.remove(key);
+	}
+}
+
+QRect CanvasTileCache::tileRange(const QRect& localRect) const
+{
+	int tx1 = static_cast<int>(std::floor(localRect.left() / static_cast<double>(m_tileSize)));
+	int ty1 = static_cast<int>(std::floor(localRect.top() / static_cast<double>(m_tileSize)));
+	int tx2 = static_cast<int>(std::floor(localRect.right() / static_cast<double>(m_tileSize)));
+	int ty2 = static_cast<int>(std::floor(localRect.bottom() / static_cast<double>(m_tileSize)));
+	return QRect(QPoint(tx1, ty1), QPoint(tx2, ty2));
+}
+
+QRect CanvasTileCache::tileRect(int tx, int ty) const
+{
+	return QRect(tx * m_tileSize, ty * m_tileSize, m_tileSize, m_tileSize);
+}
+
+const QPixmap* CanvasTileCache::tile(int tx, int ty) const
+{
+	if (m_levels.isEmpty())
+		return nullptr;
+	return m_tiles.object({ m_levels.first().id, tx, ty });
+}
+
+void CanvasTileCache::insert(int tx, int ty, const QPixmap& pixmap)
+{
+	if (m_levels.isEmpty())
+		return;
+	qsizetype cost = static_cast<qsizetype>(pixmap.width()) * pixmap.height() * 4;
+	m_tiles.insert({ m_levels.first().id, tx, ty }, new QPixmap(pixmap), cost);
+}
+
+void CanvasTileCache::invalidate(const QRectF& canvasRect)
+{
+	if (!canvasRect.isValid())
+	{
+		clear();
+		return;
+	}
+
+	const QList<TileKey> keys = m_tiles.keys();
+	for (const Level& level : std::as_const(m_levels))
+	{
+		// Tiles are bounded by local pixels, be generous with the rounding
+		const ViewState& state = level.state;
+		QRect localRect(QPoint(static_cast<int>(std::floor((canvasRect.left() - state.origin.x()) * state.scale)) - 1,
+		                       static_cast<int>(std::floor((canvasRect.top() - state.origin.y()) * state.scale)) - 1),
+		                QPoint(static_cast<int>(std::ceil((canvasRect.right() - state.origin.x()) * state.scale)) + 1,
+		                       static_cast<int>(std::ceil((canvasRect.bottom() - state.origin.y()) * state.scale)) + 1));
+		QRect range = tileRange(localRect);
+		for (const TileKey& key : keys)
+		{
+			if ((key.level == level.id) && range.contains(key.tx, key.ty))
+				m_tiles.remove(key);
+		}
+	}
+}
+
+void CanvasTileCache::clear()
+{
+	m_tiles.clear();
+}
@@ -0,0 +1,95 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef CANVASTILECACHE_H
+#define CANVASTILECACHE_H
+
+#include <QCache>
+#include <QList>
+#include <QPixmap>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
+
+#include "scribusapi.h"
+
+/**
+ * \brief Cache of rendered canvas content, split in square tiles.
+ *
+ * Tiles are grouped in levels, one level per state of the view the content was rendered
+ * with (zoom, canvas origin, preview settings...). Tile positions are in local canvas
+ * coordinates of their level. Canvas stores the complete tiles of each area it renders and
+ * composes later fills of its buffer from them, so that panning back to an area or zooming
+ * back to a previous level does not render the page items again.
+ * Invalidation happens in canvas coordinates and affects all levels.
+ */
+class SCRIBUS_API CanvasTileCache
+{
+public:
+	/// State of the view tiles are rendered for
+	struct ViewState
+	{
+		double scale { 1.0 };
+		QPointF origin;
+		int appMode { 0 };
+		bool masterPageMode { false };
+		bool previewMode { false };
+		bool viewAsPreview { false };
+		int previewVisual { -1 };
+		bool hideSelection { false };
+		bool drawFramelinks { false };
+		quint64 selectionKey { 0 };
+
+		bool operator==(const ViewState& other) const;
+		bool operator!=(const ViewState& other) const { return !(*this == other); }
+	};
+
+	explicit CanvasTileCache(int tileSize = 256);
+
+	int tileSize() const { return m_tileSize; }
+
+	/// Selects the level of \a state, creating it if needed
+	void setViewState(const ViewState& state);
+
+	/// Returns the range of indexes of tiles intersecting \a localRect in the current level
+	QRect tileRange(const QRect& localRect) const;
+	/// Returns the area covered by a tile in local coordinates
+	QRect tileRect(int tx, int ty) const;
+
+	/// Returns a tile of the current level, nullptr if it is not cached
+	const QPixmap* tile(int tx, int ty) const;
+	void insert(int tx, int ty, const QPixmap& pixmap);
+
+	/// Drops tiles of all levels intersecting \a canvasRect, an invalid rect drops everything
+	void invalidate(const QRectF& canvasRect);
+	void clear();
+
+private:
+	struct Level
+	{
+		int id { 0 };
+		ViewState state;
+	};
+
+	struct TileKey
+	{
+		int level { 0 };
+		int tx { 0 };
+		int ty { 0 };
+
+		bool operator==(const TileKey& other) const { return (level == other.level) && (tx == other.tx) && (ty == other.ty); }
+	};
+	friend size_t qHash(const TileKey& key, size_t seed);
+
+	int m_tileSize { 256 };
+	// Levels, most recently used first
+	QList<Level> m_levels;
+	int m_nextLevelId { 0 };
+	QCache<TileKey, QPixmap> m_tiles;
+};
+
+#endif // CANVASTILECACHE_H
@@ -9,6 +9,7 @@ for which a new license (GPL+exception) is in place.
 #define SCCOLORPROFILECACHE_H
 
 #include <QMap>
+#include <QMutex>
 #include <QString>
 #include <QWeakPointer>
 #include "sccolorprofile.h"
@@ -24,6 +25,8 @@ public:
 	ScColorProfile profile(const QString& profilePath) const;
 
 private:
+	// Profiles may be looked up from image loading threads
+	mutable QMutex m_mutex;
 	QMap<QString, QWeakPointer<ScColorProfileData> > m_profileMap;
 };
 
@@ -5,6 +5,7 @@ a copyright and/or license notice that predates the release of Scribus 1.3.2
 for which a new license (GPL+exception) is in place.
 */
 
+#include <QMutexLocker>
 #include <QSharedPointer>
 #include "sccolormgmtengine.h"
 #include "sccolormgmtstructs.h"
@@ -17,6 +18,7 @@ ScColorTransformPool::ScColorTransformPool(int engineID) : m_engineID(engineID)
 
 void ScColorTransformPool::clear()
 {
+	QMutexLocker locker(&m_mutex);
 	m_pool.clear();
 }
 
@@ -26,6 +28,7 @@ void ScColorTransformPool::addTransform(const ScColorTransform& transform, bool
 	//  and we MUST NOT add it to the transform pool
 	if (m_engineID != transform.engine().engineID())
 		return;
+	QMutexLocker locker(&m_mutex);
 	ScColorTransform trans;
 	if (!force)
 		trans = findTransform(transform.transformInfo());
@@ -37,11 +40,13 @@ void ScColorTransformPool::removeTransform(const ScColorTransform& transform)
 {
 	if (m_engineID != transform.engine().engineID())
 		return;
+	QMutexLocker locker(&m_mutex);
 	m_pool.removeOne(transform.strongRef());
 }
 
 void ScColorTransformPool::removeTransform(const ScColorTransformInfo& info)
 {
+	QMutexLocker locker(&m_mutex);
 	QList< QWeakPointer<ScColorTransformData> >::Iterator it = m_pool.begin();
 	while (it != m_pool.end())
 	{
@@ -58,6 +63,7 @@ void ScColorTransformPool::removeTransform(const ScColorTransformInfo& info)
 ScColorTransform ScColorTransformPool::findTransform(const ScColorTransformInfo& info) const
 {
 	ScColorTransform transform(nullptr);
+	QMutexLocker locker(&m_mutex);
 	QList< QWeakPointer<ScColorTransformData> >::ConstIterator it = m_pool.begin();
 	for ( ; it != m_pool.end(); ++it)
 	{
@@ -9,6 +9,7 @@ for which a new license (GPL+exception) is in place.
 #define SCCOLORTRANSFORMPOOL_H
 
 #include <QList>
+#include <QRecursiveMutex>
 #include <QWeakPointer>
 #include "sccolormgmtstructs.h"
 #include "sccolortransform.h"
@@ -29,6 +30,8 @@ public:
 
 private:
 	int m_engineID { 0 };
+	// Transforms may be looked up and added from image loading threads
+	mutable QRecursiveMutex m_mutex;
 	QList< QWeakPointer<ScColorTransformData> > m_pool;
 };
 
@@ -88,6 +88,9 @@ bool DocumentChecker::checkDocument(ScribusDoc *currDoc, const QString& checkerP
 	if (!checkerProfiles.contains(checkerProfile))
 		return false;
 
+	// Image resolution and color checks need the images of large documents, which are loaded on demand
+	currDoc->imageLoadScheduler()->loadAll();
+
 	struct CheckerPrefs checkerSettings;
 	checkerSettings = checkerProfiles[checkerProfile];
 	currDoc->pageErrors.clear();
@@ -0,0 +1,470 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMap>
+#include <QProcess>
+
+#include "exportservice.h"
+
+#include "appmodes.h"
+#include "fileloader.h"
+#include "filewatcher.h"
+#include "pdflib.h"
+#include "pdfoptions.h"
+#include "pdfoptionsio.h"
+#include "prefsmanager.h"
+#include "scpage.h"
+#include "scribuscore.h"
+#include "scribusdoc.h"
+#include "undomanager.h"
+#include "util.h"
+
+void ExportServiceInput::run()
+{
+	std::string line;
+	while (std::getline(std::cin, line))
+		emit lineRead(QByteArray::fromStdString(line));
+	emit inputClosed();
+}
+
+ExportService::ExportService(QObject* parent) : QObject(parent)
+{
+
+}
+
+ExportService::~ExportService()
+{
+	for (const Worker& worker : std::as_const(m_workers))
+	{
+		if (!worker.process)
+			continue;
+		worker.process->disconnect(this);
+		worker.process->closeWriteChannel();
+		worker.process->waitForFinished(5000);
+	}
+	// A thread still waiting for input cannot be stopped, it ends with the process
+	if (m_input && m_input->isRunning())
+	{
+		m_input->disconnect(this);
+		m_input->setParent(nullptr);
+	}
+}
+
+bool ExportService::start(const QString& serverName, int workers)
+{
+	m_output.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+
+	if (workers > 1)
+	{
+		for (int i = 0; i < workers; ++i)
+		{
+			m_workers.append(Worker());
+			if (!startWorker(i))
+				return false;
+		}
+	}
+
+	if (serverName.isEmpty() || (serverName == "-"))
+	{
+		m_input = new ExportServiceInput(this);
+		connect(m_input, &ExportServiceInput::lineRead, this, &ExportService::readInputLine, Qt::QueuedConnection);
+		connect(m_input, &ExportServiceInput::inputClosed, this, &ExportService::inputClosed, Qt::QueuedConnection);
+		m_input->start();
+		return true;
+	}
+
+	m_server = new QLocalServer(this);
+	QLocalServer::removeServer(serverName);
+	if (!m_server->listen(serverName))
+	{
+		std::cerr << tr("Export service cannot listen on %1: %2").arg(serverName, m_server->errorString()).toLocal8Bit().data() << std::endl;
+		return false;
+	}
+	connect(m_server, &QLocalServer::newConnection, this, &ExportService::newConnection);
+	return true;
+}
+
+void ExportService::newConnection()
+{
+	while (QLocalSocket* client = m_server->nextPendingConnection())
+	{
+		connect(client, &QLocalSocket::readyRead, this, &ExportService::readClient);
+		connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+	}
+}
+
+void ExportService::readClient()
+{
+	auto* client = qobject_cast<QLocalSocket*>(sender());
+	if (!client)
+		return;
+	while (client->canReadLine())
+		handleLine(client->readLine(), client);
+}
+
+void ExportService::readInputLine(const QByteArray& line)
+{
+	handleLine(line, &m_output);
+}
+
+void ExportService::inputClosed()
+{
+	m_stopping = true;
+	checkFinished();
+}
+
+void ExportService::handleLine(const QByteArray& line, QIODevice* replyTo)
+{
+	if (line.trimmed().isEmpty())
+		return;
+
+	QJsonParseError parseError;
+	QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+	if (!document.isObject())
+	{
+		QJsonObject reply;
+		reply.insert("status", "error");
+		reply.insert("error", tr("Invalid job: %1").arg(parseError.errorString()));
+		sendReply(replyTo, reply);
+		return;
+	}
+
+	QJsonObject request = document.object();
+	if (request.value("command").toString() == "quit")
+	{
+		m_stopping = true;
+		checkFinished();
+		return;
+	}
+	if (m_stopping)
+	{
+		QJsonObject reply;
+		reply.insert("id", request.value("id"));
+		reply.insert("status", "error");
+		reply.insert("error", tr("The export service is stopping"));
+		sendReply(replyTo, reply);
+		return;
+	}
+
+	if (m_workers.isEmpty())
+	{
+		sendReply(replyTo, runJob(request));
+		return;
+	}
+
+	Job job;
+	job.request = request;
+	job.replyTo = replyTo;
+	job.queued.start();
+	m_queue.append(job);
+	dispatch();
+}
+
+void ExportService::dispatch()
+{
+	for (int i = 0; (i < m_workers.count()) && !m_queue.isEmpty(); ++i)
+	{
+		Worker& worker = m_workers[i];
+		if (worker.busy || !worker.process || (worker.process->state() != QProcess::Running))
+			continue;
+		worker.job = m_queue.takeFirst();
+		worker.busy = true;
+		worker.process->write(QJsonDocument(worker.job.request).toJson(QJsonDocument::Compact) + '\n');
+	}
+}
+
+void ExportService::sendReply(QIODevice* replyTo, const QJsonObject& reply)
+{
+	// The client may have gone meanwhile
+	if (replyTo == nullptr)
+		return;
+	replyTo->write(QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n');
+}
+
+bool ExportService::startWorker(int index)
+{
+	Worker& worker = m_workers[index];
+	worker.process = new QProcess(this);
+	worker.process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	connect(worker.process, &QProcess::readyReadStandardOutput, this, &ExportService::readWorker);
+	connect(worker.process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished), this, &ExportService::workerFinished);
+	worker.process->start(QCoreApplication::applicationFilePath(), m_workerArguments);
+	if (!worker.process->waitForStarted())
+	{
+		std::cerr << tr("Export service cannot start worker: %1").arg(worker.process->errorString()).toLocal8Bit().data() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int ExportService::workerIndex(const QObject* process) const
+{
+	for (int i = 0; i < m_workers.count(); ++i)
+	{
+		if (m_workers.at(i).process == process)
+			return i;
+	}
+	return -1;
+}
+
+void ExportService::readWorker()
+{
+	int index = workerIndex(sender());
+	if (index < 0)
+		return;
+	Worker& worker = m_workers[index];
+	worker.buffer.append(worker.process->readAllStandardOutput());
+
+	int end;
+	while ((end = worker.buffer.indexOf('\n')) >= 0)
+	{
+		QByteArray line = worker.buffer.left(end);
+		worker.buffer.remove(0, end + 1);
+		// Workers may print other messages, only replies are JSON objects
+		QJsonDocument document = QJsonDocument::fromJson(line);
+		if (!document.isObject() || !worker.busy)
+			continue;
+		QJsonObject reply = document.object();
+		reply.insert("worker", index);
+		reply.insert("waitTime", worker.job.queued.elapsed() - reply.value("totalTime").toInteger());
+		sendReply(worker.job.replyTo, reply);
+		worker.busy = false;
+		worker.job = Job();
+	}
+	dispatch();
+	checkFinished();
+}
+
+void ExportService::workerFinished()
+{
+	auto* process = qobject_cast<QProcess*>(sender());
+	int index = workerIndex(process);
+	if (index < 0)
+		return;
+	Worker& worker = m_workers[index];
+	if (worker.busy)
+	{
+		QJsonObject reply;
+		reply.insert("id", worker.job.request.value("id"));
+		reply.insert("status", "error");
+		reply.insert("error", tr("Worker process ended unexpectedly"));
+		reply.insert("worker", index);
+		sendReply(worker.job.replyTo, reply);
+	}
+	worker.busy = false;
+	worker.job = Job();
+	worker.buffer.clear();
+	process->deleteLater();
+	worker.process = nullptr;
+
+	if (!m_stopping)
+	{
+		startWorker(index);
+		dispatch();
+	}
+	checkFinished();
+}
+
+void ExportService::checkFinished()
+{
+	if (!m_stopping || !m_queue.isEmpty())
+		return;
+	for (const Worker& worker : std::as_const(m_workers))
+	{
+		if (worker.busy)
+			return;
+	}
+	for (const Worker& worker : std::as_const(m_workers))
+	{
+		if (worker.process)
+			worker.process->closeWriteChannel();
+	}
+	emit finished();
+}
+
+QJsonObject ExportService::runJob(const QJsonObject& job)
+{
+	QJsonObject reply;
+	reply.insert("id", job.value("id"));
+
+	QElapsedTimer timer;
+	timer.start();
+	resetPeakMemory();
+
+	auto fail = [&](const QString& error) {
+		reply.insert("status", "error");
+		reply.insert("error", error);
+		reply.insert("totalTime", timer.elapsed());
+		return reply;
+	};
+
+	const QString fileName = job.value("file").toString();
+	const QString outputName = job.value("output").toString();
+	if (fileName.isEmpty() || outputName.isEmpty())
+		return fail(tr("A job needs a file and an output"));
+
+	QString error;
+	std::unique_ptr<ScribusDoc> doc(loadDocument(fileName, error));
+	if (!doc)
+		return fail(error);
+	qint64 loadTime = timer.elapsed();
+	reply.insert("loadTime", loadTime);
+
+	PDFOptions options = doc->pdfOptions();
+	const QString optionsFile = job.value("options").toString();
+	if (!optionsFile.isEmpty())
+	{
+		PDFOptionsIO io(options);
+		if (!io.readFrom(optionsFile))
+			return fail(io.lastError());
+	}
+	// Thumbnails are rendered by the document view
+	options.Thumbnails = false;
+	if (options.useDocBleeds)
+		options.bleeds = *doc->bleeds();
+
+	std::vector<int> pageNs;
+	parsePagesString(job.value("pages").toString("*"), &pageNs, doc->DocPages.count());
+	if (pageNs.empty())
+		return fail(tr("No page to export"));
+
+	ScCore->fileWatcher->forceScan();
+	ScCore->fileWatcher->stop();
+	PDFlib pdflib(*doc, options);
+	bool success = pdflib.doExport(outputName, pageNs, QMap<int, QImage>());
+	ScCore->fileWatcher->start();
+	if (!success)
+		return fail(pdflib.errorMessage().isEmpty() ? tr("Cannot write the file: %1").arg(outputName) : pdflib.errorMessage());
+
+	reply.insert("status", "ok");
+	reply.insert("pages", static_cast<int>(pageNs.size()));
+	reply.insert("exportTime", timer.elapsed() - loadTime);
+	reply.insert("totalTime", timer.elapsed());
+
+	qint64 memory = -1;
+	qint64 peakMemory = -1;
+	memoryUsage(memory, peakMemory);
+	if (memory >= 0)
+		reply.insert("memory", memory);
+	if (peakMemory >= 0)
+		reply.insert("peakMemory", peakMemory);
+	return reply;
+}
+
+ScribusDoc* ExportService::loadDocument(const QString& fileName, QString& error)
+{
+	QFileInfo fi(fileName);
+	if (!fi.exists())
+	{
+		error = tr("File does not exist: %1").arg(fileName);
+		return nullptr;
+	}
+	const QString filePath = fi.absoluteFilePath();
+
+	FileLoader fileLoader(filePath);
+	if (fileLoader.testFile() == -1)
+	{
+		error = tr("File %1 is not in an acceptable format").arg(filePath);
+		return nullptr;
+	}
+
+	// Fonts shipped with the document, as when opening it in the GUI
+	PrefsManager& prefsManager = PrefsManager::instance();
+	SCFonts& availableFonts = prefsManager.appPrefs.fontPrefs.AvailFonts;
+	availableFonts.addScalableFonts(fi.absolutePath() + "/", filePath);
+	const QStringList fontDirs = { "/fonts", "/Fonts", "/Document fonts" };
+	for (const QString& fontDir : fontDirs)
+	{
+		if (QDir(fi.absolutePath() + fontDir).exists())
+			availableFonts.addScalableFonts(fi.absolutePath() + fontDir, filePath);
+	}
+	availableFonts.updateFontMap();
+
+	UndoBlocker undoBlocker;
+	auto* doc = new ScribusDoc();
+	doc->setGUI(false, ScCore->primaryMainWindow(), nullptr);
+	doc->appMode = modeNormal;
+	doc->HasCMS = false;
+	doc->OpenNodes.clear();
+	doc->setLoading(true);
+	doc->SoftProofing = false;
+	doc->Gamut = false;
+	if (!fileLoader.loadFile(doc))
+	{
+		delete doc;
+		error = tr("Cannot load the file: %1").arg(filePath);
+		return nullptr;
+	}
+
+	// Missing color profiles are silently replaced by the default ones
+	if (ScCore->haveCMS() && doc->cmsSettings().CMSinUse)
+	{
+		doc->replaceMissingCMSProfiles();
+		if (doc->openLoadedCMSProfiles())
+		{
+			doc->recalculateColors();
+			doc->RecalcPictures(&ScCore->InputProfiles, &ScCore->InputProfilesCMYK);
+		}
+	}
+	else
+		doc->cmsSettings().CMSinUse = false;
+
+	doc->setDocumentFileName(filePath);
+	doc->hasName = true;
+	doc->setMasterPageMode(false);
+	// Same setup and layout steps as when opening the document in the GUI
+	doc->addMissingMasterPageAndSection();
+	doc->layoutLoadedItems();
+	doc->setLoading(true);
+	for (int i = 0; i < doc->DocPages.count(); ++i)
+		doc->applyMasterPage(doc->DocPages.at(i)->masterPageName(), i);
+	doc->setLoading(false);
+	doc->setModified(false);
+	return doc;
+}
+
+void ExportService::memoryUsage(qint64& current, qint64& peak)
+{
+	current = -1;
+	peak = -1;
+#if defined(Q_OS_LINUX)
+	QFile status("/proc/self/status");
+	if (!status.open(QIODevice::ReadOnly | QIODevice::Text))
+		return;
+	const QList<QByteArray> lines = status.readAll().split('\n');
+	for (const QByteArray& line : lines)
+	{
+		if (line.startsWith("VmRSS:"))
+			current = line.mid(6).trimmed().split(' ').first().toLongLong();
+		else if (line.startsWith("VmHWM:"))
+			peak = line.mid(6).trimmed().split(' ').first().toLongLong();
+	}
+#endif
+}
+
+void ExportService::resetPeakMemory()
+{
+#if defined(Q_OS_LINUX)
+	// Makes the peak resident memory of the process that of the next job
+	QFile clearRefs("/proc/self/clear_refs");
+	if (clearRefs.open(QIODevice::WriteOnly))
+		clearRefs.write("5");
+#endif
+}
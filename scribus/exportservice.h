@@ -0,0 +1,134 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef EXPORTSERVICE_H
+#define EXPORTSERVICE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include "scribusapi.h"
+
+class QLocalServer;
+class QLocalSocket;
+class QProcess;
+class ScribusDoc;
+
+/**
+ * \brief Thread reading lines from the standard input for the export service.
+ */
+class SCRIBUS_API ExportServiceInput : public QThread
+{
+	Q_OBJECT
+
+public:
+	using QThread::QThread;
+
+signals:
+	void lineRead(const QByteArray& line);
+	void inputClosed();
+
+protected:
+	void run() override;
+};
+
+/**
+ * \brief Long-lived service exporting documents to PDF without GUI.
+ *
+ * The service is started once, fonts, color profiles and plugins are thus loaded once for
+ * all jobs. Jobs are read as JSON objects, one per line, from the standard input or from
+ * clients of a local socket:
+ *
+ *     {"id": "1", "file": "doc.sla", "output": "doc.pdf", "pages": "1-4", "options": "pdf.xml"}
+ *
+ * "pages" defaults to all pages, "options" names a PDF options file as saved by the scripter,
+ * the options saved in the document are used otherwise. A reply is written for each job on
+ * the channel it came from, with its status, its load and export times in milliseconds, and
+ * the resident and peak memory of the process running it in KiB. {"command": "quit"} stops
+ * the service once running jobs are done, so does the end of the standard input.
+ *
+ * Documents are not thread safe, several jobs run concurrently in separate worker processes,
+ * each of them being an export service reading its jobs from its standard input.
+ */
+class SCRIBUS_API ExportService : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit ExportService(QObject* parent = nullptr);
+	~ExportService() override;
+
+	/// Sets the command line arguments starting a worker process reading jobs from its standard input
+	void setWorkerArguments(const QStringList& arguments) { m_workerArguments = arguments; }
+
+	/**
+	 * \brief Starts accepting jobs.
+	 * Jobs are read from the local socket \a serverName, or from the standard input if it is
+	 * empty or "-". With more than one \a workers, jobs are run by as many worker processes.
+	 */
+	bool start(const QString& serverName, int workers = 1);
+
+	/// Loads, exports and closes the document of a job, returns the reply to the job
+	static QJsonObject runJob(const QJsonObject& job);
+
+signals:
+	/// Emitted when the service stopped and all jobs are done
+	void finished();
+
+private slots:
+	void newConnection();
+	void readClient();
+	void readInputLine(const QByteArray& line);
+	void inputClosed();
+	void readWorker();
+	void workerFinished();
+
+private:
+	struct Job
+	{
+		QJsonObject request;
+		QPointer<QIODevice> replyTo;
+		QElapsedTimer queued;
+	};
+
+	struct Worker
+	{
+		QProcess* process { nullptr };
+		QByteArray buffer;
+		bool busy { false };
+		Job job;
+	};
+
+	QLocalServer* m_server { nullptr };
+	ExportServiceInput* m_input { nullptr };
+	QFile m_output;
+	QStringList m_workerArguments;
+	QList<Worker> m_workers;
+	QList<Job> m_queue;
+	bool m_stopping { false };
+
+	void handleLine(const QByteArray& line, QIODevice* replyTo);
+	void dispatch();
+	void sendReply(QIODevice* replyTo, const QJsonObject& reply);
+	bool startWorker(int index);
+	int workerIndex(const QObject* process) const;
+	void checkFinished();
+
+	static ScribusDoc* loadDocument(const QString& fileName, QString& error);
+	static void memoryUsage(qint64& current, qint64& peak);
+	static void resetPeakMemory();
+};
+
+#endif // EXPORTSERVICE_H
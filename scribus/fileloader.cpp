@@ -278,6 +278,15 @@ bool FileLoader::saveFile(const QString& fileName, ScribusDoc *doc, QString *sav
 	return ret;
 }
 
+bool FileLoader::saveToDevice(QIODevice* device, const QString& fileDir, ScribusDoc *doc, uint formatID)
+{
+	QList<FileFormat>::const_iterator it;
+	if (!findFormat(formatID, it))
+		return false;
+	it->setupTargets(doc, doc->view(), doc->scMW(), doc->scMW()->mainWindowProgressBar, &(m_prefsManager.appPrefs.fontPrefs.AvailFonts));
+	return it->saveToDevice(device, fileDir);
+}
+
 bool FileLoader::readStyles(ScribusDoc* doc, StyleSet<ParagraphStyle> &docParagraphStyles)
 {
 	QList<FileFormat>::const_iterator it;
@@ -20,6 +20,7 @@ for which a new license (GPL+exception) is in place.
 #include "styles/charstyle.h"
 
 class QDomElement;
+class QIODevice;
 class QProgressBar;
 class ScribusDoc;
 class ScribusView;
@@ -41,6 +42,7 @@ public:
 	bool loadPage(ScribusDoc* currDoc, int PageToLoad, bool Mpage, const QString& renamedPageName = QString());
 	bool loadFile(ScribusDoc* currDoc);
 	bool saveFile(const QString& fileName, ScribusDoc *doc, QString *savedFile = nullptr, uint formatID = FORMATID_CURRENTEXPORT);
+	bool saveToDevice(QIODevice* device, const QString& fileDir, ScribusDoc *doc, uint formatID = FORMATID_CURRENTEXPORT);
 	bool readStyles(ScribusDoc* doc, StyleSet<ParagraphStyle> &docParagraphStyles);
 	bool readCharStyles(ScribusDoc* doc, StyleSet<CharStyle> &docCharStyles);
 	bool readPageCount(int *num1, int *num2, QStringList & masterPageNames);
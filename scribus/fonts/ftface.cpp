@@ -199,15 +199,15 @@ ScFace::cid_type FtFace::glyphIndexToCID(ScFace::gid_type index) const
 
 void FtFace::loadGlyph(ScFace::gid_type gl) const
 {
-	if (m_glyphWidth.contains(gl))
+	if (isGlyphCached(gl))
 		return;
 
 	ScFace::GlyphData GRec;
+	GRec.advance = 1;
 	FT_Face face = ftFace();
 	if (FT_Load_Glyph( face, gl, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP ))
 	{
 		sDebug(QObject::tr("Font %1 has broken glyph %2").arg(fontFile).arg(gl));
-		m_glyphWidth[gl] = 1;
 	}
 	else
 	{
@@ -225,23 +225,17 @@ void FtFace::loadGlyph(ScFace::gid_type gl) const
 		qreal x, y;
 		bool error = false;
 		error = FT_Set_Char_Size( face, 0, 10, 72, 72 );
-		if (error)
-			m_glyphWidth[gl] = 1;
 		FPointArray outlines = traceGlyph(face, gl, 10, &x, &y, &error);
 		if (!error)
 		{
-			m_glyphWidth[gl] = ww;
+			GRec.advance = ww;
 			GRec.Outlines = outlines;
 			GRec.x = x;
 			GRec.y = y;
 			GRec.broken = false;
 		}
-		else
-		{
-			m_glyphWidth[gl] = 1;
-		}
 	}
-	m_glyphOutline[gl] = GRec;
+	cacheGlyph(gl, GRec);
 	if (GRec.broken && status < ScFace::BROKENGLYPHS)
 		status = ScFace::BROKENGLYPHS;
 }
@@ -17,10 +17,14 @@ for which a new license (GPL+exception) is in place.
 #include "fonts/scface.h"
 #include "text/storytext.h"
 
+// static:
+ScFace::ScFaceData::GlyphCacheList ScFace::ScFaceData::m_glyphCacheList;
+
 ScFace::ScFaceData::ScFaceData() = default;
 
 ScFace::ScFaceData::~ScFaceData()
 {
+	clearGlyphCache();
 	if (!m_hbFont)
 		return;
 	hb_font_destroy(reinterpret_cast<hb_font_t*>(m_hbFont));
@@ -108,9 +112,7 @@ GlyphMetrics ScFace::ScFaceData::glyphBBox(gid_type gl, qreal sz) const
 		res.descent = 0;
 		return res;
 	}
-	if (! m_glyphWidth.contains(gl))
-		loadGlyph(gl);
-	const struct GlyphData & data(m_glyphOutline[gl]);
+	const struct GlyphData & data(glyphData(gl));
 	res.width = data.bbox_width * sz;
 	res.ascent = data.bbox_ascent * sz;
 	res.descent = data.bbox_descent * sz;	
@@ -121,18 +123,14 @@ qreal ScFace::ScFaceData::glyphWidth(gid_type gl, qreal size) const
 {
 	if (gl >= CONTROL_GLYPHS)
 		return 0.0;
-	if (! m_glyphWidth.contains(gl))
-		loadGlyph(gl);
-	return m_glyphWidth[gl] * size;
+	return glyphData(gl).advance * size;
 }
 
 FPointArray ScFace::ScFaceData::glyphOutline(gid_type gl, qreal size) const
 { 
 	if (gl >= CONTROL_GLYPHS)
 		return FPointArray();
-	if (! m_glyphWidth.contains(gl))
-		loadGlyph(gl);
-	FPointArray res = m_glyphOutline[gl].Outlines.copy();
+	FPointArray res = glyphData(gl).Outlines.copy();
 	if (size != 1.0)
 		res.scale(size, size);
 	return res;
@@ -142,12 +140,110 @@ FPoint ScFace::ScFaceData::glyphOrigin(gid_type gl, qreal size) const
 {
 	if (gl >= CONTROL_GLYPHS)
 		return FPoint(0,0);
-	if (! m_glyphWidth.contains(gl))
-		loadGlyph(gl);
-	const struct GlyphData & res(m_glyphOutline[gl]);
+	const struct GlyphData & res(glyphData(gl));
 	return FPoint(res.x, res.y) * size;
 }
 
+const ScFace::GlyphData& ScFace::ScFaceData::glyphData(gid_type gl) const
+{
+	static const GlyphData noGlyph;
+
+	CachedGlyph* cached = m_glyphCache.value(gl, nullptr);
+	if (!cached)
+	{
+		++m_glyphCacheStats.misses;
+		loadGlyph(gl);
+		cached = m_glyphCache.value(gl, nullptr);
+		// faces without glyph data
+		if (!cached)
+			return noGlyph;
+		return cached->data;
+	}
+	++m_glyphCacheStats.hits;
+
+	// Move to the front of the least recently used list
+	GlyphCacheList& list = m_glyphCacheList;
+	if (cached != list.first)
+	{
+		cached->previous->next = cached->next;
+		if (cached->next)
+			cached->next->previous = cached->previous;
+		else
+			list.last = cached->previous;
+		cached->previous = nullptr;
+		cached->next = list.first;
+		list.first->previous = cached;
+		list.first = cached;
+	}
+	return cached->data;
+}
+
+void ScFace::ScFaceData::cacheGlyph(gid_type gl, const GlyphData& data) const
+{
+	removeCachedGlyph(gl);
+
+	auto* cached = new CachedGlyph();
+	cached->data = data;
+	cached->face = this;
+	cached->glyph = gl;
+	// Rough estimate including hash overhead, outlines account for most of it
+	cached->size = sizeof(CachedGlyph) + 32 + data.Outlines.size() * sizeof(FPoint);
+	m_glyphCache.insert(gl, cached);
+	m_glyphCacheStats.glyphs++;
+	m_glyphCacheStats.size += cached->size;
+
+	GlyphCacheList& list = m_glyphCacheList;
+	cached->next = list.first;
+	if (list.first)
+		list.first->previous = cached;
+	list.first = cached;
+	if (!list.last)
+		list.last = cached;
+	list.size += cached->size;
+
+	// Always keep the glyph just added, callers are about to use it
+	trimGlyphCache(cached);
+}
+
+void ScFace::ScFaceData::trimGlyphCache(const CachedGlyph* keep)
+{
+	GlyphCacheList& list = m_glyphCacheList;
+	while ((list.size > list.limit) && list.last && (list.last != keep))
+	{
+		const ScFaceData* face = list.last->face;
+		face->m_glyphCacheStats.evictions++;
+		face->removeCachedGlyph(list.last->glyph);
+	}
+}
+
+void ScFace::ScFaceData::removeCachedGlyph(gid_type gl) const
+{
+	CachedGlyph* cached = m_glyphCache.take(gl);
+	if (!cached)
+		return;
+
+	GlyphCacheList& list = m_glyphCacheList;
+	if (cached->previous)
+		cached->previous->next = cached->next;
+	else
+		list.first = cached->next;
+	if (cached->next)
+		cached->next->previous = cached->previous;
+	else
+		list.last = cached->previous;
+	list.size -= cached->size;
+
+	m_glyphCacheStats.glyphs--;
+	m_glyphCacheStats.size -= cached->size;
+	delete cached;
+}
+
+void ScFace::ScFaceData::clearGlyphCache() const
+{
+	while (!m_glyphCache.isEmpty())
+		removeCachedGlyph(m_glyphCache.constBegin().key());
+}
+
 /*****
    ScFace lifecycle:  unchecked -> loaded -> glyphs checked
                                |         \-> broken glyphs
@@ -383,11 +479,28 @@ void ScFace::unload() const
 		m_m->unload();
 	}
 	// clear caches
-	m_m->m_glyphWidth.clear();
-	m_m->m_glyphOutline.clear();
+	m_m->clearGlyphCache();
 	m_m->status = ScFace::UNKNOWN;
 }
 
+void ScFace::setGlyphCacheLimitMiB(int limitMiB)
+{
+	if (limitMiB < 1)
+		return;
+	ScFaceData::m_glyphCacheList.limit = Q_INT64_C(1048576) * limitMiB;
+	ScFaceData::trimGlyphCache();
+}
+
+int ScFace::glyphCacheLimitMiB()
+{
+	return static_cast<int>(ScFaceData::m_glyphCacheList.limit / Q_INT64_C(1048576));
+}
+
+qint64 ScFace::glyphCacheSize()
+{
+	return ScFaceData::m_glyphCacheList.size;
+}
+
 
 ScFace::gid_type ScFace::emulateGlyph(uint ch) const
 {
@@ -470,8 +583,7 @@ bool ScFace::canRender(QChar ch) const
 		return true;
 	if (gl != 0)
 	{
-		m_m->loadGlyph(gl);
-		return !m_m->m_glyphOutline[gl].broken;
+		return !m_m->glyphData(gl).broken;
 	}
 	return false;
 }
@@ -498,11 +610,10 @@ void ScFace::checkAllGlyphs()
 		return;
 	for (gid_type gl = 0; gl <= m_m->maxGlyph; ++gl)
 	{
-		if (!m_m->m_glyphWidth.contains(gl))
+		if (!m_m->isGlyphCached(gl))
 		{
 			m_m->loadGlyph(gl);
-			m_m->m_glyphWidth.remove(gl);
-			m_m->m_glyphOutline.remove(gl);
+			m_m->removeCachedGlyph(gl);
 		}
 	}
 }
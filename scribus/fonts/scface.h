@@ -55,6 +55,9 @@ need, so you can call unload() any time (well, better not multithreaded...)
 without producing errors. the increaseUsage() and decreaseUsage() keep track
 of at how many places a face is used and automatically unload when the count 
 reaches zero.
+The glyph caches of all faces share a common memory budget, see
+setGlyphCacheLimitMiB(). Once it is exceeded the least recently used glyphs are
+evicted, whichever face they belong to.
 Other data is recalculated on demand. The implementation can choose to do its
 own caching for this data.
 
@@ -105,10 +108,21 @@ public:
 		qreal bbox_width {1.0};
 		qreal bbox_ascent {1.0};
 		qreal bbox_descent {0.0};
+		qreal advance {0.0};
 		bool broken {true};
 		GlyphData() {}
 	};
 
+	/// usage of the glyph cache by one face, sizes are estimates in bytes
+	struct GlyphCacheStatistics
+	{
+		qint64 hits {0};
+		qint64 misses {0};
+		qint64 evictions {0};
+		int glyphs {0};
+		qint64 size {0};
+	};
+
     
 	/// see accessors for ScFace for docs
 	class ScFaceData 
@@ -151,25 +165,54 @@ public:
 		friend class ScFace;
 		Status m_cachedStatus {ScFace::UNKNOWN};
 
+		/// glyph cache entry, also a node of the least recently used list shared by all faces
+		struct CachedGlyph
+		{
+			GlyphData data;
+			const ScFaceData* face {nullptr};
+			gid_type glyph {0};
+			qint64 size {0};
+			CachedGlyph* previous {nullptr};
+			CachedGlyph* next {nullptr};
+		};
+
+		/// least recently used list of the glyphs cached by all faces, most recent first
+		struct GlyphCacheList
+		{
+			CachedGlyph* first {nullptr};
+			CachedGlyph* last {nullptr};
+			qint64 size {0};
+			qint64 limit {Q_INT64_C(1048576) * 64};
+		};
+		static GlyphCacheList m_glyphCacheList;
+
 		// caches
-		mutable QHash<gid_type, qreal>     m_glyphWidth;
-		mutable QHash<gid_type, GlyphData> m_glyphOutline;
+		mutable QHash<gid_type, CachedGlyph*> m_glyphCache;
+		mutable GlyphCacheStatistics m_glyphCacheStats;
 		void* m_hbFont {nullptr};
 
+		bool isGlyphCached(gid_type gl) const { return m_glyphCache.contains(gl); }
+		/// returns the data of glyph gl, loading it with loadGlyph() if not in cache
+		const GlyphData& glyphData(gid_type gl) const;
+		/// adds glyph data to the cache, evicting least recently used glyphs of any face if needed
+		void cacheGlyph(gid_type gl, const GlyphData& data) const;
+		void removeCachedGlyph(gid_type gl) const;
+		void clearGlyphCache() const;
+		/// evicts least recently used glyphs until the cache fits its budget
+		static void trimGlyphCache(const CachedGlyph* keep = nullptr);
+
 		// fill caches & members
 
 		virtual void load()             const 
 		{ 
-			m_glyphWidth.clear();
-			m_glyphOutline.clear();
+			clearGlyphCache();
 
 			status = qMax(m_cachedStatus, ScFace::LOADED);
 		}
 
 		virtual void unload()           const 
 		{
-			m_glyphWidth.clear();
-			m_glyphOutline.clear();
+			clearGlyphCache();
 
 			status = ScFace::UNKNOWN;
 		}
@@ -248,6 +291,16 @@ public:
 	/// unload face data. It will be reloaded on need
 	void unload()      const;
 
+	/// usage of the glyph cache by this face
+	GlyphCacheStatistics glyphCacheStatistics() const { return m_m->m_glyphCacheStats; }
+
+	/// set the memory budget of the glyph cache shared by all faces
+	static void setGlyphCacheLimitMiB(int limitMiB);
+	static int glyphCacheLimitMiB();
+
+	/// estimated memory used by the glyph cache of all faces, in bytes
+	static qint64 glyphCacheSize();
+
 	/// the name Scribus uses for this font
 	QString scName()   const { return m_replacedName.isEmpty() ? m_m->scName : m_replacedName; }
 
@@ -23,6 +23,7 @@ for which a new license (GPL+exception) is in place.
 
 #include "fpoint.h"
 
+#include <QDataStream>
 #include <QTransform>
 
 //Create transformed point
@@ -86,3 +87,18 @@ bool FPoint::isNull() const
 {
 	return xp == 0.0 && yp == 0.0;
 }
+
+QDataStream &operator<<(QDataStream & ds, const FPoint & point)
+{
+	ds << point.x() << point.y();
+	return ds;
+}
+
+QDataStream &operator>>(QDataStream & ds, FPoint & point)
+{
+	double x = 0.0;
+	double y = 0.0;
+	ds >> x >> y;
+	point.setXY(x, y);
+	return ds;
+}
@@ -29,6 +29,8 @@ for which a new license (GPL+exception) is in place.
 #include <QPointF>
 #include "scribusapi.h"
 
+class QDataStream;
+
 /**
   * @author Franz Schmid
   * @brief A point with floating point precision
@@ -81,6 +83,10 @@ private:
 	double yp {0.0};
 };
 
+/// Point arrays are streamed by the operators of QVector with these, e.g. for undo journals
+SCRIBUS_API QDataStream &operator<<(QDataStream & ds, const FPoint & point);
+SCRIBUS_API QDataStream &operator>>(QDataStream & ds, FPoint & point);
+
 
 inline FPoint operator+( const FPoint &p1, const FPoint &p2 )
 {
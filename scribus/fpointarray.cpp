@@ -461,6 +461,40 @@ void FPointArray::pointDerivativesAt(int seg, double t, FPoint* p, FPoint* d1, F
 		*p = q[0];
 }
 
+FPointArray FPointArray::simplified(double tolerance) const
+{
+	FPointArray result;
+	int count = size() - 3;
+	if (count <= 0)
+		return result;
+	result.reserve(size());
+
+	FPoint lastEnd;
+	bool subPathStart = true;
+	for (int poi = 0; poi < count; poi += 4)
+	{
+		if (isMarker(poi))
+		{
+			result.setMarker();
+			subPathStart = true;
+			continue;
+		}
+		const FPoint& end = point(poi + 2);
+		bool subPathEnd = (poi + 4 >= count) || isMarker(poi + 4);
+		if (subPathStart)
+		{
+			lastEnd = point(poi);
+			subPathStart = false;
+		}
+		else if (!subPathEnd && (qAbs(end.x() - lastEnd.x()) < tolerance) && (qAbs(end.y() - lastEnd.y()) < tolerance))
+			continue;
+		// The segment starts at the last kept point, skipped segments are shorter than tolerance
+		result.addQuadPoint(lastEnd, point(poi + 1), end, point(poi + 3));
+		lastEnd = end;
+	}
+	return result;
+}
+
 bool FPointArray::isBezierClosed() const
 {
 	int sz = size();
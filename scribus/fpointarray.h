@@ -80,6 +80,12 @@ public:
 	void pointTangentNormalAt( int seg, double t, FPoint* p, FPoint* tn, FPoint* n ) const;
 	void pointDerivativesAt( int seg, double t, FPoint* p, FPoint* d1, FPoint* d2 ) const;
 	bool isBezierClosed() const;
+	/**
+	 * Returns a copy of the path where segments whose end point lies within \a tolerance
+	 * of the previous kept end point are merged into the following segment.
+	 * Used to draw paths with many tiny segments at reduced detail.
+	 */
+	FPointArray simplified(double tolerance) const;
 	void svgInit();
 	void svgMoveTo(double x, double y);
 	void svgLineTo(double x, double y);
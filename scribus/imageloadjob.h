@@ -0,0 +1,73 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef IMAGELOADJOB_H
+#define IMAGELOADJOB_H
+
+#include <QSemaphore>
+#include <QString>
+
+#include "scribusapi.h"
+#include "cmsettings.h"
+#include "sccolor.h"
+#include "scimage.h"
+#include "scimagecacheproxy.h"
+#include "scimagestructs.h"
+
+class PageItem;
+
+/**
+ * @brief State of one image load, split in steps so that decoding can happen off the GUI thread
+ *
+ * A job is created by PageItem::createImageLoadJob() on the GUI thread, which takes a copy of
+ * everything the decoder needs. PageItem::runImageLoadJob() then decodes the file, applies color
+ * management, image effects and builds the low resolution proxy into the job's own ScImage. It does
+ * not touch the page item or the document and may run on any thread. Finally
+ * PageItem::finishImageLoadJob() commits the result to the item, again on the GUI thread.
+ */
+class SCRIBUS_API ImageLoadJob
+{
+public:
+	ImageLoadJob(PageItem* item, const QString& fileName, const CMSettings& cmSettings) :
+		item(item),
+		fileName(fileName),
+		cmSettings(cmSettings),
+		cache(fileName)
+	{ }
+
+	PageItem* const item;
+	const QString fileName;
+
+	bool reload { false };
+	bool showMsg { false };
+	int  gsResolution { 72 };
+	int  lowResType { 0 };
+	QString clipPath;
+
+	CMSettings cmSettings;
+	ScImageCacheProxy cache;
+	ScImageEffectList effects;
+	ColorList colors;
+	ScImage image;
+
+	// Results of runImageLoadJob()
+	bool loaded { false };
+	bool fromCache { false };
+	bool effectsApplied { false };
+	int  origWidth { 0 };
+	int  origHeight { 0 };
+
+	/// Signal that the job has been run, called by the worker
+	void setFinished() { m_finished.release(); }
+	/// Block until setFinished() has been called
+	void waitForFinished() { m_finished.acquire(); }
+
+private:
+	QSemaphore m_finished;
+};
+
+#endif // IMAGELOADJOB_H
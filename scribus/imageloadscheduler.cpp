@@ -0,0 +1,192 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <QRectF>
+#include <QString>
+#include <QTransform>
+
+#include "imageloadscheduler.h"
+#include "pageitem.h"
+#include "pageitemiterator.h"
+#include "scribusdoc.h"
+#include "undomanager.h"
+
+ImageLoadScheduler::ImageLoadScheduler(ScribusDoc* doc) :
+	m_doc(doc)
+{
+	m_timer.setSingleShot(true);
+	m_timer.setInterval(0);
+	connect(&m_timer, &QTimer::timeout, this, &ImageLoadScheduler::loadRequested);
+}
+
+bool ImageLoadScheduler::loadsOnDemand() const
+{
+	// Without a GUI nothing is drawn which could request the images
+	return m_doc->hasGUI() && (m_doc->DocPages.count() >= m_minPageCount);
+}
+
+void ImageLoadScheduler::addPending(PageItem* item, bool layerFound)
+{
+	m_pending.insert(item, layerFound);
+}
+
+void ImageLoadScheduler::removePending(PageItem* item)
+{
+	if (m_pending.remove(item) == 0)
+		return;
+	m_requested.removeAll(item);
+}
+
+void ImageLoadScheduler::request(PageItem* item)
+{
+	if (m_pending.isEmpty())
+		return;
+	if (!item->isGroup() && !m_pending.contains(item))
+		return;
+	if (m_outputDepth > 0)
+	{
+		load(QList<PageItem*>() << item);
+		return;
+	}
+	if (!m_requested.contains(item))
+		m_requested.append(item);
+	resume();
+}
+
+void ImageLoadScheduler::beginOutput()
+{
+	++m_outputDepth;
+}
+
+void ImageLoadScheduler::endOutput()
+{
+	--m_outputDepth;
+}
+
+void ImageLoadScheduler::resume()
+{
+	if (!m_requested.isEmpty() && !m_timer.isActive() && !m_doc->isLoading())
+		m_timer.start();
+}
+
+void ImageLoadScheduler::load(const QList<PageItem*>& items)
+{
+	if (m_pending.isEmpty())
+		return;
+
+	QList<PageItem*> imageItems;
+	PageItemIterator itemIt(items, PageItemIterator::IterateInGroups);
+	for ( ; *itemIt; ++itemIt)
+	{
+		PageItem* item = *itemIt;
+		auto it = m_pending.find(item);
+		if (it == m_pending.end())
+			continue;
+		// Images with a layer selection are requested with it right away
+		// instead of being loaded twice
+		if (it.value())
+			item->pixm.imgInfo.isRequest = true;
+		imageItems.append(item);
+		m_pending.erase(it);
+		m_requested.removeAll(item);
+	}
+	if (imageItems.isEmpty())
+		return;
+
+	// Loading resets the image settings, the item may have been edited
+	// since it was read from the file: keep the settings it has now
+	struct ImageSettings
+	{
+		double imageXOffset { 0.0 };
+		double imageYOffset { 0.0 };
+		QString imageProfile;
+		QString embeddedProfile;
+		bool useEmbeddedProfile { false };
+		QString clipPath;
+	};
+	QList<ImageSettings> imageSettings;
+	imageSettings.reserve(imageItems.count());
+	for (const PageItem* item : std::as_const(imageItems))
+	{
+		ImageSettings settings;
+		settings.imageXOffset = item->imageXOffset();
+		settings.imageYOffset = item->imageYOffset();
+		settings.imageProfile = item->ImageProfile;
+		settings.embeddedProfile = item->EmbeddedProfile;
+		settings.useEmbeddedProfile = item->UseEmbedded;
+		settings.clipPath = item->pixm.imgInfo.usedPath;
+		imageSettings.append(settings);
+	}
+
+	// Loading completes what was read from the file: this neither modifies
+	// the document nor is something the user could undo
+	bool wasLoading = m_doc->isLoading();
+	m_doc->setLoading(true);
+	UndoManager::instance()->setUndoEnabled(false);
+	m_doc->loadPicts(imageItems, false);
+	UndoManager::instance()->setUndoEnabled(true);
+	m_doc->setLoading(wasLoading);
+
+	for (int i = 0; i < imageItems.count(); ++i)
+	{
+		PageItem* item = imageItems.at(i);
+		const ImageSettings& settings = imageSettings.at(i);
+		item->setImageXYOffset(settings.imageXOffset, settings.imageYOffset);
+		item->ImageProfile = settings.imageProfile;
+		item->EmbeddedProfile = settings.embeddedProfile;
+		item->UseEmbedded = settings.useEmbeddedProfile;
+		if (item->pixm.imgInfo.PDSpathData.contains(settings.clipPath))
+		{
+			item->imageClip = item->pixm.imgInfo.PDSpathData[settings.clipPath].copy();
+			item->pixm.imgInfo.usedPath = settings.clipPath;
+			QTransform cl;
+			cl.translate(item->imageXOffset() * item->imageXScale(), item->imageYOffset() * item->imageYScale());
+			cl.scale(item->imageXScale(), item->imageYScale());
+			item->imageClip.map(cl);
+			// Text around the frame was laid out without the clipping path of the image
+			if (item->textFlowUsesImageClipping())
+				m_doc->invalidateRegion(item->getBoundingRect());
+		}
+	}
+}
+
+void ImageLoadScheduler::loadAll()
+{
+	load(m_pending.keys());
+}
+
+void ImageLoadScheduler::loadRequested()
+{
+	// Resumed by ScribusDoc::setLoading()
+	if (m_doc->isLoading())
+		return;
+
+	// Requested groups may have been deleted since
+	QList<PageItem*> items;
+	for (PageItem* item : std::as_const(m_requested))
+	{
+		if (item != nullptr)
+			items.append(item);
+	}
+	m_requested.clear();
+	load(items);
+
+	QRectF updateRect;
+	bool updateAll = false;
+	for (const PageItem* item : items)
+	{
+		// Master page items are drawn on every page based on them, text flowing
+		// around the clipping path of an image may move to other frames
+		if (!item->OnMasterPage.isEmpty() || item->textFlowUsesImageClipping())
+			updateAll = true;
+		updateRect = updateRect.united(item->getVisualBoundingRect());
+	}
+	if (updateAll)
+		m_doc->regionsChanged()->update(QRectF());
+	else if (!updateRect.isNull())
+		m_doc->regionsChanged()->update(updateRect.adjusted(-5.0, -5.0, 5.0, 5.0));
+}
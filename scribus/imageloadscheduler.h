@@ -0,0 +1,88 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef IMAGELOADSCHEDULER_H
+#define IMAGELOADSCHEDULER_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include "scribusapi.h"
+
+class PageItem;
+class ScribusDoc;
+
+/**
+ * \brief Loads the images of a large document when they are needed.
+ *
+ * Decoding every image of a long document when it is opened takes most of the
+ * loading time and keeps all images in memory, although only a few pages are looked
+ * at. The file loader registers the image frames of such documents as pending instead.
+ * The canvas requests an item before drawing it: pending images are then loaded from the
+ * event loop and their frames repainted. Selected items, exports, previews and checks,
+ * which need the actual images, load them synchronously.
+ *
+ * Every item of the document still exists, only image decoding is deferred. Until its
+ * image is loaded an item keeps its image settings, so saving or editing it is lossless:
+ * loading applies the settings the item has at that time to the image.
+ */
+class SCRIBUS_API ImageLoadScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit ImageLoadScheduler(ScribusDoc* doc);
+
+	/// Returns true if images of the document should be loaded only when needed
+	bool loadsOnDemand() const;
+
+	/// Registers \a item for loading its image later, \a layerFound if the file has a layer selection for it
+	void addPending(PageItem* item, bool layerFound);
+	bool hasPending() const { return !m_pending.isEmpty(); }
+	bool isPending(PageItem* item) const { return m_pending.contains(item); }
+	/// Forgets about \a item, e.g. because it is deleted or gets another image
+	void removePending(PageItem* item);
+
+	/**
+	 * \brief Requests the image of \a item and of the items it groups because they are going to be drawn.
+	 * Between beginOutput() and endOutput() the images are loaded immediately, otherwise they
+	 * are loaded from the event loop and the items repainted.
+	 */
+	void request(PageItem* item);
+	/**
+	 * \brief Pages are rendered for output, e.g. page previews or bitmap export, which need
+	 * their images right away. Calls nest, each one must be matched by endOutput().
+	 */
+	void beginOutput();
+	void endOutput();
+	bool outputInProgress() const { return m_outputDepth > 0; }
+	/// Goes on with loading requested images, once the document is not loading any more
+	void resume();
+	/// Loads the pending images of \a items and of the items they group
+	void load(const QList<PageItem*>& items);
+	/// Loads all pending images, before the document is exported or checked
+	void loadAll();
+
+private slots:
+	void loadRequested();
+
+private:
+	ScribusDoc* m_doc { nullptr };
+	// Pending items, mapped to whether the file has a layer selection for their image
+	QHash<PageItem*, bool> m_pending;
+	QList<QPointer<PageItem> > m_requested;
+	QTimer m_timer;
+	// Nesting depth of beginOutput() calls
+	int m_outputDepth { 0 };
+	// Number of pages from which images are loaded on demand
+	int m_minPageCount { 20 };
+};
+
+#endif // IMAGELOADSCHEDULER_H
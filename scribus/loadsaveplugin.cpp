@@ -220,6 +220,11 @@ bool LoadSavePlugin::saveFile(const QString & /* fileName */,
 	return false;
 }
 
+bool LoadSavePlugin::saveToDevice(QIODevice* /* device */, const QString& /* fileDir */)
+{
+	return false;
+}
+
 bool LoadSavePlugin::loadElements(const QString &  /*data*/, const QString&  /*fileDir*/, int /*toLayer*/, double /*Xp_in*/, double /*Yp_in*/, bool /*loc*/)
 {
 	return false;
@@ -463,6 +468,11 @@ bool FileFormat::saveFile(const QString & fileName) const
 	return (plug && save) ? plug->saveFile(fileName, *this) : false;
 }
 
+bool FileFormat::saveToDevice(QIODevice* device, const QString& fileDir) const
+{
+	return (plug && save) ? plug->saveToDevice(device, fileDir) : false;
+}
+
 bool FileFormat::savePalette(const QString & fileName) const
 {
 	return (plug && save) ? plug->savePalette(fileName) : false;
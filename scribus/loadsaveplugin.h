@@ -86,6 +86,10 @@ class SCRIBUS_API LoadSavePlugin : public ScPlugin
 
 		// Save the requested format to the requested path.
 		virtual bool saveFile(const QString & fileName, const FileFormat & fmt);
+		// Write the current document to an open device, file references are made relative
+		// to fileDir. Used to take a snapshot of the document, e.g. for autosave.
+		// Default implementation always reports failure.
+		virtual bool saveToDevice(QIODevice* device, const QString& fileDir);
 		virtual bool savePalette(const QString & fileName);
 		virtual QString saveElements(double, double, double, double, Selection*, QByteArray &prevData);
 
@@ -213,6 +217,7 @@ class SCRIBUS_API FileFormat
 
 		// Save a file with this format
 		bool saveFile(const QString & fileName) const;
+		bool saveToDevice(QIODevice* device, const QString& fileDir) const;
 		bool savePalette(const QString & fileName) const;
 		QString saveElements(double xp, double yp, double wp, double hp, Selection* selection, QByteArray &prevData) const;
 
@@ -27,6 +27,7 @@ for which a new license (GPL+exception) is in place.
 
 #include <iostream>
 #include <csignal>
+#include <cstring>
 
 #include <QApplication>
 #include <QImageReader>
@@ -67,7 +68,16 @@ int mainApp(int argc, char **argv)
 	emergencyActivated = false;
 
 #if !defined(Q_OS_MACOS)
-	qputenv("QT_QPA_PLATFORM", "xcb");
+	// The export service and benchmarks never show a window and must run without X server
+	bool headless = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--export-service") == 0) || (strcmp(argv[i], "-es") == 0))
+			headless = true;
+		else if ((strcmp(argv[i], "--benchmarks") == 0) || (strcmp(argv[i], "-B") == 0))
+			headless = true;
+	}
+	qputenv("QT_QPA_PLATFORM", headless ? "offscreen" : "xcb");
 #endif
 
 	QImageReader::setAllocationLimit(1024);
@@ -96,7 +106,7 @@ int mainApp(int argc, char **argv)
 	int appRetVal = app.init();
 	if (appRetVal == EXIT_FAILURE)
 		return(EXIT_FAILURE);
-	if (app.useGUI)
+	if (app.useGUI || app.runsExportService())
 		return app.exec();
 	return EXIT_SUCCESS;
 }
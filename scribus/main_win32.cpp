@@ -132,7 +132,7 @@ int mainApp(ScribusQApp& app)
 		appRetVal = app.init();
 		if (appRetVal != EXIT_FAILURE)
 		{
-			if (ScribusQApp::useGUI)
+			if (ScribusQApp::useGUI || app.runsExportService())
 				appRetVal = ScribusQApp::exec();
 		}
 #ifndef _DEBUG
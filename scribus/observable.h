@@ -19,8 +19,10 @@
 #include "scribusapi.h"
 
 #include <QObject>
+#include <QRectF>
 #include <QSet>
 #include <QVariant>
+#include <type_traits>
 
 #include "updatemanager.h"
 
@@ -68,11 +70,49 @@ signals:
 
 
 
+/**
+  Merges the update of 'other' into 'data' if one notification can stand for both.
+  Updates of the same object are merged, regions are united, see UpdateMemento::merge()
+ */
+template<class OBSERVED>
+inline bool Private_Merge(OBSERVED& data, const OBSERVED& other)
+{
+	return data == other;
+}
+
+template<>
+inline bool Private_Merge(QRectF& data, const QRectF& other)
+{
+	// An invalid region stands for the whole document
+	if (!data.isValid() || !other.isValid())
+		data = QRectF();
+	else
+		data = data.united(other);
+	return true;
+}
+
 template<class OBSERVED>
 struct Private_Memento : public UpdateMemento
 {
 	Private_Memento(OBSERVED data) : m_data(data) {}
 	Private_Memento(OBSERVED data, bool layout) : m_data(data), m_layout(layout) {}
+
+	bool merge(const UpdateMemento* other) override
+	{
+		const auto* memento = dynamic_cast<const Private_Memento<OBSERVED>*>(other);
+		if (!memento || !Private_Merge(m_data, memento->m_data))
+			return false;
+		m_layout |= memento->m_layout;
+		return true;
+	}
+
+	const void* subject() const override
+	{
+		if constexpr (std::is_pointer_v<OBSERVED>)
+			return m_data;
+		else
+			return nullptr;
+	}
 	
 	OBSERVED m_data;
 	bool     m_layout { false };
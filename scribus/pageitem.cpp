@@ -50,6 +50,7 @@ for which a new license (GPL+exception) is in place.
 #include "colorblind.h"
 #include "desaxe/saxXML.h"
 #include "iconmanager.h"
+#include "imageloadjob.h"
 #include "marks.h"
 #include "pageitem_arc.h"
 #include "pageitem_group.h"
@@ -90,6 +91,9 @@ for which a new license (GPL+exception) is in place.
 
 using namespace std;
 
+// Paths with fewer points are never simplified when drawing at reduced detail
+static const int simplifiedPathMinSize = 256;
+
 PageItem::PageItem(const PageItem & other)
 	: QObject(other.parent()),
 	 UndoObject(other),
@@ -679,6 +683,7 @@ PageItem::PageItem(ScribusDoc *doc, ItemType newType, double x, double y, double
 
 PageItem::~PageItem()
 {
+	m_Doc->itemDestroyed(this);
 	if (isTempFile && !Pfile.isEmpty())
 		QFile::remove(Pfile);
 	//remove marks
@@ -728,7 +733,10 @@ bool PageItem::isTableCell() const
 void PageItem::setXPos(double newXPos, bool drawingOnly)
 {
 	m_xPos = newXPos;
-	if (drawingOnly || m_Doc->isLoading())
+	if (drawingOnly)
+		return;
+	m_Doc->itemBoundsChanged(this);
+	if (m_Doc->isLoading())
 		return;
 	checkChanges();
 }
@@ -736,7 +744,10 @@ void PageItem::setXPos(double newXPos, bool drawingOnly)
 void PageItem::setYPos(double newYPos, bool drawingOnly)
 {
 	m_yPos = newYPos;
-	if (drawingOnly || m_Doc->isLoading())
+	if (drawingOnly)
+		return;
+	m_Doc->itemBoundsChanged(this);
+	if (m_Doc->isLoading())
 		return;
 	checkChanges();
 }
@@ -745,7 +756,10 @@ void PageItem::setXYPos(double newXPos, double newYPos, bool drawingOnly)
 {
 	m_xPos = newXPos;
 	m_yPos = newYPos;
-	if (drawingOnly || m_Doc->isLoading())
+	if (drawingOnly)
+		return;
+	m_Doc->itemBoundsChanged(this);
+	if (m_Doc->isLoading())
 		return;
 	checkChanges();
 }
@@ -779,7 +793,10 @@ void PageItem::moveBy(double dX, double dY, bool drawingOnly)
 		gYpos += dY;
 		BoundingY += dY;
 	}
-	if (drawingOnly || m_Doc->isLoading())
+	if (drawingOnly)
+		return;
+	m_Doc->itemBoundsChanged(this);
+	if (m_Doc->isLoading())
 		return;
 	moveWelded(dX, dY);
 	checkChanges();
@@ -789,6 +806,7 @@ void PageItem::setWidth(double newWidth)
 {
 	m_width = newWidth;
 	updateConstants();
+	m_Doc->itemBoundsChanged(this);
 	if (m_Doc->isLoading())
 		return;
 	checkChanges();
@@ -798,6 +816,7 @@ void PageItem::setHeight(double newHeight)
 {
 	m_height = newHeight;
 	updateConstants();
+	m_Doc->itemBoundsChanged(this);
 	if (m_Doc->isLoading())
 		return;
 	checkChanges();
@@ -810,6 +829,7 @@ void PageItem::setWidthHeight(double newWidth, double newHeight, bool drawingOnl
 	updateConstants();
 	if (drawingOnly)
 		return;
+	m_Doc->itemBoundsChanged(this);
 	checkChanges();
 }
 
@@ -818,6 +838,7 @@ void PageItem::setWidthHeight(double newWidth, double newHeight)
 	m_width = newWidth;
 	m_height = newHeight;
 	updateConstants();
+	m_Doc->itemBoundsChanged(this);
 	if (m_Doc->isLoading())
 		return;
 	checkChanges();
@@ -832,6 +853,7 @@ void PageItem::resizeBy(double dH, double dW)
 	if (dW != 0.0)
 		m_height += dW;
 	updateConstants();
+	m_Doc->itemBoundsChanged(this);
 	if (m_Doc->isLoading())
 		return;
 	checkChanges();
@@ -846,7 +868,10 @@ void PageItem::setRotation(double newRotation, bool drawingOnly)
 		m_rotation += 360.0;
 	while (m_rotation > 360.0)
 		m_rotation -= 360.0;
-	if (drawingOnly || m_Doc->isLoading())
+	if (drawingOnly)
+		return;
+	m_Doc->itemBoundsChanged(this);
+	if (m_Doc->isLoading())
 		return;
 	rotateWelded(dR, oldRot);
 	checkChanges();
@@ -861,6 +886,7 @@ void PageItem::rotateBy(double dR)
 		m_rotation += 360.0;
 	while (m_rotation > 360.0)
 		m_rotation -= 360.0;
+	m_Doc->itemBoundsChanged(this);
 	if (m_Doc->isLoading())
 		return;
 	checkChanges();
@@ -1628,7 +1654,7 @@ void PageItem::DrawObj_Pre(ScPainter *p)
 		return;
 	}
 
-	if ((hasSoftShadow()) && (m_Doc->appMode != modeEdit))
+	if ((hasSoftShadow()) && (m_Doc->appMode != modeEdit) && (!p->reducedDetail()))
 		DrawSoftShadow(p);
 	if (isGroup())
 		return;
@@ -1679,6 +1705,13 @@ void PageItem::DrawObj_Pre(ScPainter *p)
 			p->setFillMode(ScPainter::Pattern);
 		}
 	}
+	else if (p->reducedDetail() && ((GrType == Gradient_4Colors) || (GrType == Gradient_Diamond) || (GrType == Gradient_Mesh) || (GrType == Gradient_Conical) || (GrType == Gradient_PatchMesh)))
+	{
+		// Shading these is expensive, a flat fill is close enough at this size or while navigating
+		p->fill_gradient = VGradient(VGradient::linear);
+		p->setBrush(meanGradientColor());
+		p->setFillMode(ScPainter::Solid);
+	}
 	else if (GrType == Gradient_4Colors)
 	{
 		p->setFillMode(ScPainter::Gradient);
@@ -2187,6 +2220,75 @@ void PageItem::DrawStrokePattern(ScPainter *p, const QPainterPath &path)
 	p->newPath();
 }
 
+void PageItem::setupDrawingPath(ScPainter *p, bool closed)
+{
+	// Simplifying short paths costs more than it saves
+	if (!p->reducedDetail() || (PoLine.size() < simplifiedPathMinSize))
+	{
+		p->setupPolygon(&PoLine, closed);
+		return;
+	}
+	FPointArray path = PoLine.simplified(0.5 / p->zoomFactor());
+	p->setupPolygon(&path, closed);
+}
+
+bool PageItem::hasReducibleDetail() const
+{
+	if (hasSoftShadow())
+		return true;
+	if ((GrType == Gradient_4Colors) || (GrType == Gradient_Diamond) || (GrType == Gradient_Mesh) || (GrType == Gradient_Conical) || (GrType == Gradient_PatchMesh))
+		return true;
+	if (((itemType() == Polygon) || (itemType() == PolyLine)) && (PoLine.size() >= simplifiedPathMinSize))
+		return true;
+	if (isGroup())
+	{
+		for (const PageItem* item : groupItemList)
+		{
+			if (item->hasReducibleDetail())
+				return true;
+		}
+	}
+	return false;
+}
+
+QColor PageItem::meanGradientColor() const
+{
+	QList<QColor> colors;
+	if (GrType == Gradient_4Colors)
+		colors << m_grQColorP1 << m_grQColorP2 << m_grQColorP3 << m_grQColorP4;
+	else if ((GrType == Gradient_Mesh) || (GrType == Gradient_Conical))
+	{
+		for (const QList<MeshPoint>& row : meshGradientArray)
+		{
+			for (const MeshPoint& meshPoint : row)
+				colors << meshPoint.color;
+		}
+	}
+	else if (GrType == Gradient_PatchMesh)
+	{
+		for (const meshGradientPatch& patch : meshGradientPatches)
+			colors << patch.TL.color << patch.TR.color << patch.BL.color << patch.BR.color;
+	}
+	else
+	{
+		for (const VColorStop* stop : fill_gradient.colorStops())
+			colors << stop->color;
+	}
+	if (colors.isEmpty())
+		return m_fillQColor;
+
+	double r = 0.0, g = 0.0, b = 0.0, a = 0.0;
+	for (const QColor& color : std::as_const(colors))
+	{
+		r += color.redF();
+		g += color.greenF();
+		b += color.blueF();
+		a += color.alphaF();
+	}
+	double count = colors.count();
+	return QColor::fromRgbF(r / count, g / count, b / count, a / count);
+}
+
 void PageItem::DrawSoftShadow(ScPainter *p)
 {
 	if (m_softShadowColor == CommonStrings::None)
@@ -3713,6 +3815,7 @@ void PageItem::setLineColor(const QString &newColor)
 	}
 	m_lineColor = tmp;
 	setLineQColor();
+	m_Doc->itemBoundsChanged(this);
 }
 
 void PageItem::setLineShade(double newShade)
@@ -3747,6 +3850,7 @@ void PageItem::setStrokePattern(const QString &newPattern)
 		undoManager->action(this, is);
 	}
 	patternStrokeVal = newPattern;
+	m_Doc->itemBoundsChanged(this);
 }
 
 void PageItem::setStrokePatternToPath(bool enable)
@@ -3997,6 +4101,7 @@ void PageItem::setLineWidth(double newWidth)
 	}
 	m_oldLineWidth = m_lineWidth;
 	m_lineWidth = newWidth;
+	m_Doc->itemBoundsChanged(this);
 }
 
 void PageItem::setLineEnd(Qt::PenCapStyle newStyle)
@@ -8356,6 +8461,7 @@ void PageItem::setStrokeGradientType(int val)
 		undoManager->action(this, ss);
 	}
 	GrTypeStroke = val;
+	m_Doc->itemBoundsChanged(this);
 }
 
 void PageItem::setGradientCol1(const QString& val)
@@ -9798,41 +9904,135 @@ QString PageItem::getImageEffectsModifier() const
 }
 
 bool PageItem::loadImage(const QString& filename, const bool reload, const int gsResolution, bool showMsg)
+{
+	std::unique_ptr<ImageLoadJob> job = createImageLoadJob(filename, reload, gsResolution, showMsg);
+	if (!job)
+		return false;
+	runImageLoadJob(*job);
+	return finishImageLoadJob(*job);
+}
+
+std::unique_ptr<ImageLoadJob> PageItem::createImageLoadJob(const QString& filename, bool reload, int gsResolution, bool showMsg)
 {
 	bool useImage = (asImageFrame() != nullptr);
 	useImage |= (isAnnotation() && annotation().UseIcons());
 	if (!useImage)
-		return false;
-	QFileInfo fi(filename);
-	QString clPath(pixm.imgInfo.usedPath);
-	pixm.imgInfo.valid = false;
-	pixm.imgInfo.clipPath.clear();
-	pixm.imgInfo.PDSpathData.clear();
-	pixm.imgInfo.layerInfo.clear();
-	pixm.imgInfo.usedPath.clear();
-	imageClip.resize(0);
-	int lowResTypeBack = pixm.imgInfo.lowResType;
-	int gsRes = gsResolution;
-	if (gsResolution == -1) //If it wasn't supplied, get it from PrefsManager.
-		gsRes = PrefsManager::instance().gsResolution();
-	bool dummy;
+		return nullptr;
 
 	CMSettings cms(m_Doc, ImageProfile, ImageIntent);
 	cms.setUseEmbeddedProfile(UseEmbedded);
 	cms.allowSoftProofing(true);
 
-	ScImageCacheProxy imgcache(filename);
-	imgcache.addModifier("lowResType", QString::number(pixm.imgInfo.lowResType));
+	auto job = std::make_unique<ImageLoadJob>(this, filename, cms);
+	job->reload = reload;
+	job->showMsg = showMsg;
+	job->gsResolution = gsResolution;
+	if (gsResolution == -1) //If it wasn't supplied, get it from PrefsManager.
+		job->gsResolution = PrefsManager::instance().gsResolution();
+	job->lowResType = pixm.imgInfo.lowResType;
+	job->clipPath = pixm.imgInfo.usedPath;
+	job->effects = effectsInUse;
+	job->colors = m_Doc->PageColors;
+
+	// The decoder starts from the current image infos, minus what describes the previous image
+	job->image.imgInfo = pixm.imgInfo;
+	job->image.imgInfo.valid = false;
+	job->image.imgInfo.clipPath.clear();
+	job->image.imgInfo.PDSpathData.clear();
+	job->image.imgInfo.layerInfo.clear();
+	job->image.imgInfo.usedPath.clear();
+
+	job->cache.addModifier("lowResType", QString::number(job->lowResType));
 	if (!effectsInUse.isEmpty())
-		imgcache.addModifier("effectsInUse", getImageEffectsModifier());
+		job->cache.addModifier("effectsInUse", getImageEffectsModifier());
+	return job;
+}
+
+void PageItem::runImageLoadJob(ImageLoadJob& job)
+{
+	bool dummy;
+	ScImage& image = job.image;
+
+	job.loaded = image.loadPicture(job.cache, job.fromCache, image.imgInfo.actualPageNumber, job.cmSettings, ScImage::RGBData, job.gsResolution, &dummy, job.showMsg);
+	if (!job.loaded)
+		return;
 
-	bool fromCache = false;
-	if (!pixm.loadPicture(imgcache, fromCache, pixm.imgInfo.actualPageNumber, cms, ScImage::RGBData, gsRes, &dummy, showMsg))
+	if (job.fromCache)
 	{
+		job.origWidth = job.cache.getInfo("OrigW").toInt();
+		job.origHeight = job.cache.getInfo("OrigH").toInt();
+		return;
+	}
+
+	job.origWidth = image.width();
+	job.origHeight = image.height();
+	job.cache.addInfo("OrigW", QString::number(job.origWidth));
+	job.cache.addInfo("OrigH", QString::number(job.origHeight));
+
+	QString ext = QFileInfo(job.fileName).suffix().toLower();
+	if (extensionIndicatesPDF(ext) || extensionIndicatesEPSorPS(ext))
+	{
+		job.effects.clear();
+		job.cache.delModifier("effectsInUse");
+	}
+
+	// Duotone images loaded for the first time add their colors and effects to the
+	// document, which has to happen on the GUI thread, in finishImageLoadJob()
+	if ((image.imgInfo.colorspace == ColorSpaceDuotone) && (image.imgInfo.duotoneColors.count() != 0) && (!job.reload))
+		return;
+
+	applyImageEffectsAndLowRes(job);
+}
+
+void PageItem::applyImageEffectsAndLowRes(ImageLoadJob& job)
+{
+	ScImage& image = job.image;
+
+	image.applyEffect(job.effects, job.colors, false);
+	image.imgInfo.lowResType = job.lowResType;
+	if (image.imgInfo.lowResType != 0)
+	{
+		double scaling = image.imgInfo.xres / 36.0;
+		if (image.imgInfo.lowResType == 1)
+			scaling = image.imgInfo.xres / 72.0;
+		// Prevent exagerately large images when using low res preview modes
+		uint pixels = qRound(image.width() * image.height() / (scaling * scaling));
+		if (pixels > 3000000)
+		{
+			double ratio = pixels / 3000000.0;
+			scaling *= sqrt(ratio);
+		}
+		if (image.createLowRes(scaling))
+		{
+			image.imgInfo.lowResScale = scaling;
+			image.saveCache(job.cache);
+		}
+		else
+			image.imgInfo.lowResScale = 1.0;
+	}
+	job.effectsApplied = true;
+}
+
+bool PageItem::finishImageLoadJob(ImageLoadJob& job)
+{
+	const QString& filename = job.fileName;
+	const bool reload = job.reload;
+	QFileInfo fi(filename);
+	QString clPath(job.clipPath);
+
+	imageClip.resize(0);
+	if (!job.loaded)
+	{
+		pixm.imgInfo.valid = false;
+		pixm.imgInfo.clipPath.clear();
+		pixm.imgInfo.PDSpathData.clear();
+		pixm.imgInfo.layerInfo.clear();
+		pixm.imgInfo.usedPath.clear();
 		Pfile = fi.absoluteFilePath();
 		imageIsAvailable = false;
 		return false;
 	}
+	pixm = job.image;
 
 	QString ext = fi.suffix().toLower();
 	if (UndoManager::undoEnabled() && !reload)
@@ -9892,25 +10092,12 @@ bool PageItem::loadImage(const QString& filename, const bool reload, const int g
 	}
 	BBoxX = pixm.imgInfo.BBoxX;
 	BBoxH = pixm.imgInfo.BBoxH;
-	if (fromCache)
-	{
-		OrigW = imgcache.getInfo("OrigW").toInt();
-		OrigH = imgcache.getInfo("OrigH").toInt();
-	}
-	else
-	{
-		OrigW = pixm.width();
-		OrigH = pixm.height();
-		imgcache.addInfo("OrigW", QString::number(OrigW));
-		imgcache.addInfo("OrigH", QString::number(OrigH));
-	}
+	OrigW = job.origWidth;
+	OrigH = job.origHeight;
 
 	isRaster = !(extensionIndicatesPDF(ext) || extensionIndicatesEPSorPS(ext));
 	if (!isRaster)
-	{
 		effectsInUse.clear();
-		imgcache.delModifier("effectsInUse");
-	}
 
 	UseEmbedded = pixm.imgInfo.isEmbedded;
 	if (pixm.imgInfo.isEmbedded)
@@ -9930,7 +10117,7 @@ bool PageItem::loadImage(const QString& filename, const bool reload, const int g
 	oldLocalScX = m_imageXScale;
 	oldLocalScY = m_imageYScale;
 
-	if (imageIsAvailable && !fromCache)
+	if (!job.fromCache && !job.effectsApplied)
 	{
 		if ((pixm.imgInfo.colorspace == ColorSpaceDuotone) && (pixm.imgInfo.duotoneColors.count() != 0) && (!reload))
 		{
@@ -10053,31 +10240,13 @@ bool PageItem::loadImage(const QString& filename, const bool reload, const int g
 				ef.effectParameters = efVal;
 			}
 			effectsInUse.append(ef);
-			imgcache.addModifier("effectsInUse", getImageEffectsModifier());
-		}
-		pixm.applyEffect(effectsInUse, m_Doc->PageColors, false);
-//		if (reload)
-			pixm.imgInfo.lowResType = lowResTypeBack;
-		if (pixm.imgInfo.lowResType != 0)
-		{
-			double scaling = pixm.imgInfo.xres / 36.0;
-			if (pixm.imgInfo.lowResType == 1)
-				scaling = pixm.imgInfo.xres / 72.0;
-			// Prevent exagerately large images when using low res preview modes
-			uint pixels = qRound(pixm.width() * pixm.height() / (scaling * scaling));
-			if (pixels > 3000000)
-			{
-				double ratio = pixels / 3000000.0;
-				scaling *= sqrt(ratio);
-			}
-			if (pixm.createLowRes(scaling))
-			{
-				pixm.imgInfo.lowResScale = scaling;
-				pixm.saveCache(imgcache);
-			}
-			else
-				pixm.imgInfo.lowResScale = 1.0;
+			job.cache.addModifier("effectsInUse", getImageEffectsModifier());
 		}
+		job.image = pixm;
+		job.effects = effectsInUse;
+		job.colors = m_Doc->PageColors;
+		applyImageEffectsAndLowRes(job);
+		pixm = job.image;
 	}
 	if (imageIsAvailable && m_Doc->viewAsPreview)
 	{
@@ -10106,7 +10275,6 @@ bool PageItem::loadImage(const QString& filename, const bool reload, const int g
 	return true;
 }
 
-
 void PageItem::drawLockedMarker(ScPainter *p) const
 {
 	//TODO: CB clean
@@ -10993,6 +11161,8 @@ void PageItem::updateClip(bool updateWelded)
 		break;
 	}
 	updateGradientVectors();
+	// Callers change the geometry directly before, e.g. notes frames growing with their text
+	m_Doc->itemBoundsChanged(this);
 }
 
 QString PageItem::infoDescription() const
@@ -39,6 +39,8 @@ for which a new license (GPL+exception) is in place.
 #include <QVector>
 #include <QTemporaryFile>
 
+#include <memory>
+
 #include "scribusapi.h"
 #include "annotation.h"
 #include "commonstrings.h"
@@ -60,6 +62,7 @@ for which a new license (GPL+exception) is in place.
 #include "scconfig.h"
 #endif
 
+class ImageLoadJob;
 class QFrame;
 class QGridLayout;
 class QRegion;
@@ -312,6 +315,12 @@ public: // Start public functions
 	void DrawObj_Embedded(ScPainter *p, const QRectF& cullingArea, const CharStyle& style, PageItem* cembedded);
 	void DrawStrokePattern(ScPainter *p, const QPainterPath &path);
 	void DrawSoftShadow(ScPainter *p);
+	/// Returns true if drawing at reduced detail makes a difference for this item or its group members
+	bool hasReducibleDetail() const;
+	/// Sets up the path of PoLine on the painter, merging segments below device resolution when drawing at reduced detail
+	void setupDrawingPath(ScPainter *p, bool closed = true);
+	/// Returns the mean color of mesh, 4 colors and diamond gradient fills, used when drawing at reduced detail
+	QColor meanGradientColor() const;
 	/**
 	 * @brief Set or get the redraw bounding box of the item, moved from the View
 	 */
@@ -1247,6 +1256,25 @@ public: // Start public functions
 	 */
 	virtual bool loadImage(const QString& filename, bool reload, int gsResolution=-1, bool showMsg = false);
 
+	/**
+	 * @brief First step of loadImage(): snapshot what is needed to load an image into this item
+	 * @return the job, or nullptr if this item cannot hold an image
+	 */
+	std::unique_ptr<ImageLoadJob> createImageLoadJob(const QString& filename, bool reload, int gsResolution = -1, bool showMsg = false);
+
+	/**
+	 * @brief Second step of loadImage(): decode the image file of a job, apply color management,
+	 * image effects and build the low resolution proxy. Only uses the job and is safe to call from
+	 * a worker thread, provided showMsg is false.
+	 */
+	static void runImageLoadJob(ImageLoadJob& job);
+
+	/**
+	 * @brief Last step of loadImage(): commit a job previously run by runImageLoadJob() to the item
+	 * @return True if load succeeded
+	 */
+	bool finishImageLoadJob(ImageLoadJob& job);
+
 	/**
 	 * @brief Connect the item's signals to the GUI, primarily the Properties palette, also some to ScMW
 	 * @return
@@ -1910,6 +1938,12 @@ private:	// Start private functions
 	 */
 	QString getImageEffectsModifier() const;
 
+	/**
+	 * @brief Helper method applying the image effects of a job and creating its low resolution proxy
+	 * @sa runImageLoadJob()
+	 */
+	static void applyImageEffectsAndLowRes(ImageLoadJob& job);
+
 			// End private functions
 
 private:	// Start private variables
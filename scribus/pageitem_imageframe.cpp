@@ -62,6 +62,7 @@ PageItem_ImageFrame::PageItem_ImageFrame(ScribusDoc *pa, double x, double y, dou
 
 PageItem_ImageFrame::~PageItem_ImageFrame()
 {
+	m_Doc->imageLoadScheduler()->removePending(this);
 	if (imageIsAvailable && (!Pfile.isEmpty()))
 	{
 		ScCore->fileWatcher->removeFile(Pfile);
@@ -93,6 +94,10 @@ void PageItem_ImageFrame::DrawObj_Item(ScPainter *p, const QRectF& /*e*/)
 			p->drawLine(FPoint(0, m_height), FPoint(m_width, 0));
 		}
 	}
+	else if (!imageIsAvailable && m_Doc->imageLoadScheduler()->isPending(this))
+	{
+		// The image is loaded on demand, the frame is repainted once it is available
+	}
 	else if ((!m_imageVisible) || (!imageIsAvailable))
 	{
 		//If we are missing our image, draw a red cross in the frame
@@ -85,6 +85,7 @@ PageItem_NoteFrame::PageItem_NoteFrame(PageItem_TextFrame* inFrame, NotesStyle *
 	oldRot = m_rotation;
 	oldXpos = m_xPos;
 	m_yPos = oldYpos = m_masterFrame->yPos() + m_masterFrame->height();
+	m_Doc->itemBoundsChanged(this);
 
 	m_textFlowMode = TextFlowUsesFrameShape;
 	setColumns(1);
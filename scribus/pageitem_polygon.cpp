@@ -52,7 +52,7 @@ void PageItem_Polygon::DrawObj_Item(ScPainter *p, const QRectF& /*e*/)
 {
 	if (!m_Doc->RePos)
 	{
-		p->setupPolygon(&PoLine);
+		setupDrawingPath(p);
 		p->fillPath();
 	}
 }
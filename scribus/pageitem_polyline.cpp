@@ -100,7 +100,7 @@ void PageItem_PolyLine::DrawObj_Item(ScPainter *p, const QRectF& /*e*/)
 			p->setupPolygon(&cli);
 			p->fillPath();
 		}
-		p->setupPolygon(&PoLine, false);
+		setupDrawingPath(p, false);
 		if (NamedLStyle.isEmpty())
 		{
 			if ((!patternStrokeVal.isEmpty()) && (m_Doc->docPatterns.contains(patternStrokeVal)))
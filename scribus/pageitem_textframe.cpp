@@ -1071,6 +1071,81 @@ double calculateLineSpacing (const ParagraphStyle &style, PageItem *item)
 // This setup won't cause any problems, as the only way for the starting position to change
 // back is if the previous frame's layout() runs again, but if it does, it also sets the
 // incomplete* vars for us
+/**
+ Lines of the previous layout of a frame, taken out of its TextLayout so that
+ layout() can put back those it does not need to compute again.
+*/
+class ReusableLines
+{
+public:
+	explicit ReusableLines(const QList<Box*>& columns)
+		: m_columns(columns)
+	{
+		for (int col = 0; col < m_columns.count(); ++col)
+		{
+			QList<Box*>& lines = m_columns[col]->boxes();
+			for (Box* line : std::as_const(lines))
+				m_lines.append(qMakePair(col, line));
+			lines.clear();
+		}
+	}
+
+	~ReusableLines()
+	{
+		for (const auto& line : std::as_const(m_lines))
+			delete line.second;
+		qDeleteAll(m_columns);
+	}
+
+	int count() const { return m_lines.count(); }
+
+	/// Adds columns to textLayout, with the geometry of the previous ones, until it has column + 1 of them
+	void addColumns(TextLayout& textLayout, int column) const
+	{
+		while (textLayout.box()->boxCount() <= column && textLayout.box()->boxCount() < m_columns.count())
+		{
+			const Box* previous = m_columns.at(textLayout.box()->boxCount());
+			textLayout.addColumn(previous->x(), previous->width());
+		}
+	}
+
+	/// Appends the lines [first, last) to textLayout, moving their characters by charDelta
+	void moveLines(TextLayout& textLayout, int first, int last, int charDelta)
+	{
+		for (int i = first; i < last; ++i)
+		{
+			Box* line = m_lines[i].second;
+			if (!line)
+				continue;
+			addColumns(textLayout, m_lines[i].first);
+			if (charDelta != 0)
+				line->moveCharsBy(charDelta);
+			textLayout.appendLine(static_cast<LineBox*>(line));
+			m_lines[i].second = nullptr;
+		}
+	}
+
+private:
+	QList<Box*> m_columns;
+	QList<QPair<int, Box*> > m_lines;
+};
+
+bool PageItem_TextFrame::LayoutCheckpoint::sameState(const LayoutCheckpoint& other) const
+{
+	return (frameStart == other.frameStart) && (column == other.column)
+		&& (colLeft == other.colLeft) && (colRight == other.colRight)
+		&& (xPos == other.xPos) && (yPos == other.yPos)
+		&& (restartX == other.restartX) && (mustLineEnd == other.mustLineEnd)
+		&& (restartIndex == other.restartIndex) && (restartRowIndex == other.restartRowIndex)
+		&& (hyphenCount == other.hyphenCount) && (startOfCol == other.startOfCol)
+		&& (recalculateY == other.recalculateY) && (addLeftIndent == other.addLeftIndent)
+		&& (wasFirstInRow == other.wasFirstInRow) && (lastLineY == other.lastLineY)
+		&& (maxDX == other.maxDX) && (maxDY == other.maxDY)
+		&& (dropLines == other.dropLines) && (dropLinesCount == other.dropLinesCount)
+		&& (realAsce == other.realAsce) && (realDesc == other.realDesc)
+		&& (tabFillChar == other.tabFillChar) && (maxY == other.maxY);
+}
+
 bool PageItem_TextFrame::moveLinesFromPreviousFrame ()
 {
 	PageItem_TextFrame* prev = dynamic_cast<PageItem_TextFrame*>(m_backBox);
@@ -1104,6 +1179,7 @@ bool PageItem_TextFrame::moveLinesFromPreviousFrame ()
 	int startingPos = prev->incompletePositions[prev->incompleteLines - pull];
 	for (int i = 0; i < pull; ++i)
 		prev->textLayout.removeLastLine();
+	prev->resetLayoutState();
 	firstChar = prev->m_maxChars = startingPos;
 	// keep the remaining incomplete lines flagged as such
 	// this ensures that if pulling one line won't be enough, the subsequent call to layout() will pull more
@@ -1223,7 +1299,13 @@ void PageItem_TextFrame::layout()
 	int    DropLines = 0;
 	int    DropLinesCount = 0;
 
-	textLayout.clear();
+	// What is left of the previous layout, parts of it are reused below if the text was only edited
+	LayoutState previousLayout;
+	std::swap(previousLayout, m_layoutState);
+	ReusableLines previousLines(textLayout.takeColumns());
+	bool layoutReusable = false;
+	bool placedLastLine = false;
+
 	incompleteLines = 0;
 	incompletePositions.clear();
 
@@ -1260,6 +1342,7 @@ void PageItem_TextFrame::layout()
 			next->firstChar = itLen;
 			next->m_maxChars = itLen;
 			next->textLayout.clear();
+			next->resetLayoutState();
 			next = dynamic_cast<PageItem_TextFrame*>(next->nextInChain());
 		}
 		// TODO layout() shouldn't delete any frame here, as it breaks any loop
@@ -1308,21 +1391,58 @@ void PageItem_TextFrame::layout()
 		}
 		
 		// update Bullet & number list if any.
-		if (itemText.hasTextMarks() || itemText.hasBulletOrNum() ||  itemText.marksCountChanged())
+		bool hasMarksOrLists = itemText.hasTextMarks() || itemText.hasBulletOrNum() || itemText.marksCountChanged();
+		if (hasMarksOrLists)
 		{
 			updateBulletsNum();
 			itemText.resetMarksCountChanged();
 		}
 
+		// Marks, notes and lists are updated by layout itself, vertical alignment moves lines around
+		// and master page items are laid out for each page: those frames are always laid out from scratch.
+		// Otherwise, if only the text changed since the previous layout, layout resumes from the last
+		// paragraph starting before the change and reuses the previous lines once it is back in sync.
+		layoutReusable = OnMasterPage.isEmpty() && !isNoteFrame() && (verticalAlign == 0) && !hasMarksOrLists;
+		m_layoutState.settings = layoutSettings();
+		m_layoutState.availableRegion = m_availableRegion;
+		bool reuseLayout = layoutReusable && previousLayout.reusable
+				&& (previousLayout.changeStart != INT_MAX) && (previousLayout.changedLength == itLen)
+				&& (previousLayout.settings == m_layoutState.settings)
+				&& (previousLayout.availableRegion == m_availableRegion);
+		bool reuseLayoutEnd = reuseLayout && previousLayout.endReusable;
+		const QList<LayoutCheckpoint>& previousCheckpoints = previousLayout.checkpoints;
+		int changeEnd = itLen - previousLayout.unchangedTail;
+		int charDelta = itLen - previousLayout.storyLength;
+		int nextPreviousCheckpoint = 0;
+
+		int resumeCheckpoint = -1;
+		if (reuseLayout && !previousCheckpoints.isEmpty() && (previousCheckpoints.first().firstChar == firstInFrame()))
+		{
+			for (int k = 1; k < previousCheckpoints.count(); ++k)
+			{
+				if (previousCheckpoints[k].firstChar > previousLayout.changeStart)
+					break;
+				resumeCheckpoint = k;
+			}
+		}
+		int layoutStart = (resumeCheckpoint > 0) ? previousCheckpoints[resumeCheckpoint].firstChar : firstInFrame();
+
 		ITextContext* context = this;
 		//TextShaper textShaper(this, itemText, firstInFrame());
-		ShapedTextFeed shapedText(&itemText, firstInFrame(), context);
+		ShapedTextFeed shapedText(&itemText, layoutStart, context);
 
 		QList<GlyphCluster> glyphClusters; // = textShaper.shape();
 		// std::sort(glyphClusters.begin(), glyphClusters.end(), logicalGlyphRunComp);
 
 		LineControl current(m_width, m_height, m_textDistanceMargins, lineCorr, m_Doc, context, columnWidth(), m_columnGap);
-		current.nextColumn(textLayout);
+		if (resumeCheckpoint > 0)
+		{
+			const LayoutCheckpoint& checkpoint = previousCheckpoints[resumeCheckpoint];
+			previousLines.moveLines(textLayout, 0, checkpoint.lineCount, 0);
+			previousLines.addColumns(textLayout, checkpoint.column);
+		}
+		else
+			current.nextColumn(textLayout);
 
 		lastLineY = m_textDistanceMargins.top();
 
@@ -1382,7 +1502,107 @@ void PageItem_TextFrame::layout()
 		int regionMinY = 0, regionMaxY= 0;
 
 		double autoLeftIndent = 0.0;
-		for (int i = 0; shapedText.haveMoreText(i, glyphClusters); ++i)
+
+		// state of the loop below before the paragraph starting at char c, with glyph cluster index cluster
+		auto makeCheckpoint = [&](int c, int cluster)
+		{
+			LayoutCheckpoint checkpoint;
+			checkpoint.firstChar = c;
+			checkpoint.lineCount = static_cast<int>(textLayout.lines());
+			checkpoint.frameStart = (c == firstInFrame());
+			checkpoint.column = current.column;
+			checkpoint.colLeft = current.colLeft;
+			checkpoint.colRight = current.colRight;
+			checkpoint.xPos = current.xPos;
+			checkpoint.yPos = current.yPos;
+			checkpoint.restartX = current.restartX;
+			checkpoint.mustLineEnd = current.mustLineEnd;
+			checkpoint.restartIndex = current.restartIndex - cluster;
+			checkpoint.restartRowIndex = current.restartRowIndex - cluster;
+			checkpoint.hyphenCount = current.hyphenCount;
+			checkpoint.startOfCol = current.startOfCol;
+			checkpoint.recalculateY = current.recalculateY;
+			checkpoint.addLeftIndent = current.addLeftIndent;
+			checkpoint.wasFirstInRow = current.wasFirstInRow;
+			checkpoint.lastLineY = lastLineY;
+			checkpoint.maxDX = maxDX;
+			checkpoint.maxDY = maxDY;
+			checkpoint.dropLines = DropLines;
+			checkpoint.dropLinesCount = DropLinesCount;
+			checkpoint.realAsce = realAsce;
+			checkpoint.realDesc = realDesc;
+			checkpoint.tabFillChar = tabs.fillChar;
+			checkpoint.maxY = maxY;
+			return checkpoint;
+		};
+
+		// if the previous layout reached the same state at the same unchanged text, take its remaining lines
+		auto resynchronize = [&](const LayoutCheckpoint& checkpoint)
+		{
+			if (!reuseLayoutEnd || (checkpoint.firstChar <= changeEnd))
+				return false;
+			int previousFirstChar = checkpoint.firstChar - charDelta;
+			while ((nextPreviousCheckpoint < previousCheckpoints.count()) && (previousCheckpoints[nextPreviousCheckpoint].firstChar < previousFirstChar))
+				++nextPreviousCheckpoint;
+			if (nextPreviousCheckpoint >= previousCheckpoints.count())
+				return false;
+			const LayoutCheckpoint& previous = previousCheckpoints[nextPreviousCheckpoint];
+			if ((previous.firstChar != previousFirstChar) || !previous.sameState(checkpoint))
+				return false;
+			previousLines.moveLines(textLayout, previous.lineCount, previousLines.count(), charDelta);
+			for (int k = nextPreviousCheckpoint + 1; k < previousCheckpoints.count(); ++k)
+			{
+				LayoutCheckpoint moved = previousCheckpoints[k];
+				moved.firstChar += charDelta;
+				moved.lineCount += checkpoint.lineCount - previous.lineCount;
+				m_layoutState.checkpoints.append(moved);
+			}
+			m_maxChars = previousLayout.maxChars + charDelta;
+			maxY = previousLayout.maxY;
+			placedLastLine = previousLayout.placedLastLine;
+			return true;
+		};
+
+		bool resynchronized = false;
+		if (resumeCheckpoint > 0)
+		{
+			const LayoutCheckpoint& checkpoint = previousCheckpoints[resumeCheckpoint];
+			current.column = checkpoint.column;
+			current.colLeft = checkpoint.colLeft;
+			current.colRight = checkpoint.colRight;
+			current.xPos = checkpoint.xPos;
+			current.yPos = checkpoint.yPos;
+			current.startLine(0);
+			current.restartX = checkpoint.restartX;
+			current.mustLineEnd = checkpoint.mustLineEnd;
+			current.restartIndex = checkpoint.restartIndex;
+			current.restartRowIndex = checkpoint.restartRowIndex;
+			current.hyphenCount = checkpoint.hyphenCount;
+			current.startOfCol = checkpoint.startOfCol;
+			current.recalculateY = checkpoint.recalculateY;
+			current.addLeftIndent = checkpoint.addLeftIndent;
+			current.wasFirstInRow = checkpoint.wasFirstInRow;
+			lastLineY = checkpoint.lastLineY;
+			maxDX = checkpoint.maxDX;
+			maxDY = checkpoint.maxDY;
+			DropLines = checkpoint.dropLines;
+			DropLinesCount = checkpoint.dropLinesCount;
+			realAsce = checkpoint.realAsce;
+			realDesc = checkpoint.realDesc;
+			tabs.fillChar = checkpoint.tabFillChar;
+			maxY = checkpoint.maxY;
+			m_layoutState.checkpoints = previousCheckpoints.mid(0, resumeCheckpoint + 1);
+		}
+		else if (layoutReusable)
+		{
+			LayoutCheckpoint checkpoint = makeCheckpoint(firstInFrame(), 0);
+			m_layoutState.checkpoints.append(checkpoint);
+			resynchronized = resynchronize(checkpoint);
+			if (resynchronized && previousLayout.endedInNoRoom)
+				goto NoRoom;
+		}
+
+		for (int i = 0; !resynchronized && shapedText.haveMoreText(i, glyphClusters); ++i)
 		{
 			int currentIndex = i - current.lineData.firstCluster;
 			GlyphCluster newRun = glyphClusters[i];
@@ -1399,7 +1619,11 @@ void PageItem_TextFrame::layout()
 			PageItem* currentObject = itemText.object(a).getPageItem(m_Doc);
 			QRectF currentObjectBox;
 			if (HasObject)
+			{
 				currentObjectBox = currentObject->getVisualBoundingRect();
+				// objects can be resized without their text being changed
+				layoutReusable = false;
+			}
 
 			bool HasMark = itemText.hasMark(a);
 
@@ -2304,7 +2528,7 @@ void PageItem_TextFrame::layout()
 			if ((current.glyphs[currentIndex].hasFlag(ScLayout_HyphenationPossible)
 				  || itemText.text(a) == '-'
 				  || itemText.text(a) == SpecialChars::SHYPHEN)
-				 && (!outs) && ((i == 0) || !itemText.text(glyphClusters[i - 1].lastChar()).isSpace()) )
+				 && (!outs) && ((i == 0 && resumeCheckpoint <= 0) || !itemText.text((i > 0) ? glyphClusters[i - 1].lastChar() : a - 1).isSpace()) )
 			{
 				breakPos = current.xPos;
 				if (itemText.text(a) != '-')
@@ -2730,6 +2954,24 @@ void PageItem_TextFrame::layout()
 						goto NoRoom;
 					}
 				}
+				// remember the state at the start of non empty paragraphs, glyph clusters
+				// never span paragraphs there, and see if the previous layout can take over
+				if (layoutReusable && (itemText.text(a) == SpecialChars::PARSEP)
+					&& !current.afterOverflow && !current.hasDropCap
+					&& (a + 2 < itLen) && !itemText.isBlockStart(a + 2)
+					&& shapedText.haveMoreText(i + 1, glyphClusters) && (glyphClusters[i + 1].firstChar() == a + 1)
+					&& !glyphClusters[i + 1].glyphs().isEmpty())
+				{
+					LayoutCheckpoint checkpoint = makeCheckpoint(a + 1, i + 1);
+					m_layoutState.checkpoints.append(checkpoint);
+					if (resynchronize(checkpoint))
+					{
+						if (previousLayout.endedInNoRoom)
+							goto NoRoom;
+						resynchronized = true;
+						break;
+					}
+				}
 			}
 			else // if (outs)
 			{
@@ -2886,12 +3128,12 @@ void PageItem_TextFrame::layout()
 			textLayout.appendLine(current.createLineBox());
 			setMaxY(maxYDesc);
 			current.startOfCol = false;
-
-			if (moveLinesFromPreviousFrame ()) {
-				layout ();  // line moving ensures that this won't be an endless loop
-				itemText.blockSignals(false);
-				return;
-			}
+			placedLastLine = true;
+		}
+		if (placedLastLine && moveLinesFromPreviousFrame ()) {
+			layout ();  // line moving ensures that this won't be an endless loop
+			itemText.blockSignals(false);
+			return;
 		}
 	}
 	m_maxChars = itemText.length();
@@ -2938,6 +3180,12 @@ void PageItem_TextFrame::layout()
 			nextFrame = dynamic_cast<PageItem_TextFrame*>(nextFrame->m_nextBox);
 		}
 	}
+	m_layoutState.storyLength = itemText.length();
+	m_layoutState.maxChars = m_maxChars;
+	m_layoutState.maxY = maxY;
+	m_layoutState.endedInNoRoom = false;
+	m_layoutState.placedLastLine = placedLastLine;
+	m_layoutState.reusable = m_layoutState.endReusable = layoutReusable;
 	itemText.blockSignals(false);
 //	qDebug("textframe: len=%d, done relayout", itemText.length());
 	return;
@@ -2945,6 +3193,7 @@ void PageItem_TextFrame::layout()
 NoRoom:
 	invalid = false;
 	
+	int maxCharsInFrame = m_maxChars;
 	adjustParagraphEndings ();
 
 	if (verticalAlign > 0)
@@ -2997,26 +3246,46 @@ NoRoom:
 			next = dynamic_cast<PageItem_TextFrame*>(next->m_nextBox);
 		}
 	}
+	m_layoutState.storyLength = itemText.length();
+	m_layoutState.maxChars = m_maxChars;
+	m_layoutState.maxY = maxY;
+	m_layoutState.endedInNoRoom = true;
+	m_layoutState.placedLastLine = false;
+	m_layoutState.reusable = layoutReusable;
+	// lines pushed to the next frame by adjustParagraphEndings() are gone
+	m_layoutState.endReusable = layoutReusable && (m_maxChars == maxCharsInFrame);
+	if (m_maxChars != maxCharsInFrame)
+	{
+		while (!m_layoutState.checkpoints.isEmpty() && (m_layoutState.checkpoints.last().firstChar >= m_maxChars))
+			m_layoutState.checkpoints.removeLast();
+	}
 //	qDebug("textframe: len=%d, done relayout (no room %d)", itemText.length(), MaxChars);
 	itemText.blockSignals(false);
 }
 
+void PageItem_TextFrame::invalidateLayout()
+{
+	// the reason is not known, the layout can't be reused
+	invalid = true;
+	resetLayoutState();
+}
+
 void PageItem_TextFrame::invalidateLayout(bool wholeChain)
 {
 	//const bool wholeChain = true;
-	invalid = true;
+	invalidateLayout();
 	if (wholeChain)
 	{
 		PageItem *prevFrame = this->prevInChain();
 		while (prevFrame != nullptr)
 		{
-			prevFrame->invalid = true;
+			prevFrame->invalidateLayout();
 			prevFrame = prevFrame->prevInChain();
 		}
 		PageItem *nextFrame = this->nextInChain();
 		while (nextFrame != nullptr)
 		{
-			nextFrame->invalid = true;
+			nextFrame->invalidateLayout();
 			nextFrame = nextFrame->nextInChain();
 		}
 	}
@@ -3028,9 +3297,23 @@ void PageItem_TextFrame::invalidateLayout(int firstChar)
 	slotInvalidateLayout(firstChar, storyLen);
 }
 
-void PageItem_TextFrame::slotInvalidateLayout(int firstItem, int /*endItem*/)
+void PageItem_TextFrame::slotInvalidateLayout(int firstItem, int endItem)
 {
 	PageItem* firstFrame = firstInChain();
+
+	// remember the changed text in all frames of the chain, see layout()
+	int storyLength = itemText.length();
+	int unchangedTail = qMax(0, storyLength - endItem);
+	PageItem_TextFrame* changedFrame = dynamic_cast<PageItem_TextFrame*>(firstFrame);
+	while (changedFrame)
+	{
+		LayoutState& state = changedFrame->m_layoutState;
+		state.changeStart = qMin(state.changeStart, qMax(0, firstItem));
+		state.unchangedTail = qMin(state.unchangedTail, unchangedTail);
+		state.changedLength = storyLength;
+		changedFrame = dynamic_cast<PageItem_TextFrame*>(changedFrame->m_nextBox);
+	}
+
 	firstItem = itemText.prevParagraph(firstItem);
 
 	PageItem_TextFrame* firstInvalid = dynamic_cast<PageItem_TextFrame*>(firstFrame);
@@ -3051,6 +3334,28 @@ void PageItem_TextFrame::slotInvalidateLayout(int firstItem, int /*endItem*/)
 	}
 }
 
+QList<double> PageItem_TextFrame::layoutSettings() const
+{
+	QList<double> settings;
+	double pageOffset = 0.0;
+	if (OwnPage != -1)
+		pageOffset = m_Doc->Pages->at(OwnPage)->yOffset();
+	settings << m_xPos << m_yPos << pageOffset << m_width << m_height;
+	settings << m_lineWidth << ((lineColor() != CommonStrings::None) ? 1.0 : 0.0);
+	settings << m_columns << m_columnGap << m_firstLineOffset;
+	settings << m_textDistanceMargins.left() << m_textDistanceMargins.top();
+	settings << m_textDistanceMargins.right() << m_textDistanceMargins.bottom();
+	settings << m_Doc->guidesPrefs().valueBaselineGrid << m_Doc->guidesPrefs().offsetBaselineGrid;
+	settings << m_Doc->typographicPrefs().autoLineSpacing;
+	settings << itemText.defaultStyle().direction();
+	return settings;
+}
+
+void PageItem_TextFrame::resetLayoutState()
+{
+	m_layoutState = LayoutState();
+}
+
 bool PageItem_TextFrame::isValidChainFromBegin()
 {
 	if (invalid)
@@ -3068,6 +3373,14 @@ bool PageItem_TextFrame::isValidChainFromBegin()
 	return true;
 }
 
+void PageItem_TextFrame::DrawObj_WithoutText(ScPainter *p)
+{
+	no_fill = false;
+	no_stroke = false;
+	DrawObj_Pre(p);
+	DrawObj_Post(p);
+}
+
 void PageItem_TextFrame::DrawObj_Item(ScPainter *p, const QRectF& cullingArea)
 {
 	if (invalid)
@@ -22,6 +22,8 @@ for which a new license (GPL+exception) is in place.
 #ifndef PAGEITEMTEXTFRAME_H
 #define PAGEITEMTEXTFRAME_H
 
+#include <climits>
+
 #include <QHash>
 #include <QRectF>
 #include <QString>
@@ -72,13 +74,15 @@ public:
 	void deselectAll();
 
 	//for speed up updates when changed was only one frame from chain
+	void invalidateLayout() override;
 	virtual void invalidateLayout(bool wholeChain);
 	virtual void invalidateLayout(int firstChar);
-	using PageItem::invalidateLayout;
 	void layout() override;
 
 	//return true if all previous frames from chain are valid (including that one)
 	bool isValidChainFromBegin();
+	//draw fill and stroke of the frame without laying out its text
+	void DrawObj_WithoutText(ScPainter *p);
 	void setTextAnnotationOpen(bool open);
 
 	double columnWidth();
@@ -124,6 +128,72 @@ private:
 	QRectF m_origAnnotPos;
 	void updateBulletsNum();
 
+	/**
+	 * State of layout() at the start of a paragraph. After an edit layout() resumes from the
+	 * last checkpoint before the changed text, and stops at the first checkpoint after it
+	 * which matches one of the previous layout, reusing the previous lines from there on.
+	 */
+	struct LayoutCheckpoint
+	{
+		int    firstChar { 0 };
+		int    lineCount { 0 };
+		bool   frameStart { false };
+		int    column { 0 };
+		double colLeft { 0.0 };
+		double colRight { 0.0 };
+		double xPos { 0.0 };
+		double yPos { 0.0 };
+		double restartX { 0.0 };
+		double mustLineEnd { 0.0 };
+		int    restartIndex { 0 };     // relative to the first glyph cluster of the paragraph
+		int    restartRowIndex { 0 };  // relative to the first glyph cluster of the paragraph
+		int    hyphenCount { 0 };
+		bool   startOfCol { true };
+		bool   recalculateY { true };
+		bool   addLeftIndent { true };
+		bool   wasFirstInRow { false };
+		double lastLineY { 0.0 };
+		double maxDX { 0.0 };
+		double maxDY { 0.0 };
+		int    dropLines { 0 };
+		int    dropLinesCount { 0 };
+		double realAsce { 0.0 };
+		double realDesc { 0.0 };
+		QChar  tabFillChar;
+		double maxY { 0.0 };
+
+		// Whether layout continues the same way from both checkpoints, regardless of their position
+		bool sameState(const LayoutCheckpoint& other) const;
+	};
+
+	// What layout() keeps from one run to the next
+	struct LayoutState
+	{
+		QList<LayoutCheckpoint> checkpoints;
+		QList<double> settings;
+		QRegion availableRegion;
+		int    storyLength { 0 };
+		int    maxChars { 0 };
+		double maxY { 0.0 };
+		bool   endedInNoRoom { false };
+		bool   placedLastLine { false };
+		// layout can resume from the checkpoints
+		bool   reusable { false };
+		// the lines after a checkpoint can be reused up to the end of the frame
+		bool   endReusable { false };
+		// text changed since the last layout: first changed char, count of unchanged chars
+		// at the end of the story and story length after the last change
+		int    changeStart { INT_MAX };
+		int    unchangedTail { INT_MAX };
+		int    changedLength { -1 };
+	};
+	LayoutState m_layoutState;
+
+	// Frame and document settings layout() depends on, besides text and available region
+	QList<double> layoutSettings() const;
+	// Forget about the last layout, next one will be done from scratch
+	void resetLayoutState();
+
 private slots:
 	void slotInvalidateLayout(int firstItem, int endItem);
 
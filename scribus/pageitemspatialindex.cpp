@@ -0,0 +1,279 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "pageitemspatialindex.h"
+#include "pageitem.h"
+
+namespace
+{
+	// Items spanning more cells than this are kept in a separate list
+	// which is tested on every query instead of being bucketed
+	const int maxCellsPerItem = 64;
+	// Cell coordinates beyond this are not bucketed either
+	const double maxCellCoordinate = 1.0e8;
+}
+
+PageItemSpatialIndex::PageItemSpatialIndex(const QList<PageItem*>& itemList, double cellSize) :
+	m_itemList(itemList),
+	m_cellSize(cellSize > 0.0 ? cellSize : 256.0)
+{
+
+}
+
+void PageItemSpatialIndex::clear()
+{
+	m_entries.clear();
+	m_entryIndexes.clear();
+	m_cells.clear();
+	m_largeEntries.clear();
+	m_changedItems.clear();
+	m_queryStamp = 0;
+	m_valid = false;
+	m_listChanged = false;
+}
+
+void PageItemSpatialIndex::itemChanged(const PageItem* item)
+{
+	// Until the next rebuild all bounds are computed anyway
+	if (!m_valid)
+		return;
+	m_changedItems.insert(item);
+}
+
+void PageItemSpatialIndex::itemDestroyed(const PageItem* item)
+{
+	if (!m_valid || !m_entryIndexes.contains(item))
+		return;
+	// The address may be reused by a new item, whose bounds must not be taken from this one
+	m_changedItems.insert(item);
+	m_listChanged = true;
+}
+
+void PageItemSpatialIndex::update()
+{
+	if (!m_valid)
+	{
+		rebuild();
+		return;
+	}
+	if (m_listChanged || (static_cast<int>(m_entries.size()) != m_itemList.count()))
+	{
+		m_listChanged = false;
+		if (!matchesList())
+		{
+			rebuild();
+			return;
+		}
+	}
+	for (const PageItem* item : std::as_const(m_changedItems))
+	{
+		auto indexIt = m_entryIndexes.constFind(item);
+		if (indexIt == m_entryIndexes.constEnd())
+			continue;
+		int index = indexIt.value();
+		Entry& entry = m_entries[index];
+		removeEntry(index);
+		entry.bounds = boundsOf(entry.item);
+		computeCells(entry);
+		insertEntry(index);
+	}
+	m_changedItems.clear();
+}
+
+QList<PageItem*> PageItemSpatialIndex::itemsIntersecting(const QRectF& rect)
+{
+	QList<PageItem*> result;
+
+	update();
+	if (m_entries.empty() || !rect.isValid())
+		return result;
+
+	++m_queryStamp;
+	if (m_queryStamp == 0)
+	{
+		for (Entry& entry : m_entries)
+			entry.queryStamp = 0;
+		m_queryStamp = 1;
+	}
+
+	QList<int> hits;
+	double cx1 = std::floor(rect.left() / m_cellSize);
+	double cy1 = std::floor(rect.top() / m_cellSize);
+	double cx2 = std::floor(rect.right() / m_cellSize);
+	double cy2 = std::floor(rect.bottom() / m_cellSize);
+	double cellCount = (cx2 - cx1 + 1.0) * (cy2 - cy1 + 1.0);
+	if (!std::isfinite(cellCount) || (cellCount > m_cells.count()) || (qAbs(cx1) > maxCellCoordinate) || (qAbs(cy1) > maxCellCoordinate))
+	{
+		// The queried area covers more cells than are occupied, testing each entry is cheaper
+		int entryCount = static_cast<int>(m_entries.size());
+		for (int i = 0; i < entryCount; ++i)
+		{
+			if (m_entries[i].bounds.intersects(rect))
+				hits.append(i);
+		}
+	}
+	else
+	{
+		for (int cx = static_cast<int>(cx1); cx <= static_cast<int>(cx2); ++cx)
+		{
+			for (int cy = static_cast<int>(cy1); cy <= static_cast<int>(cy2); ++cy)
+			{
+				auto cellIt = m_cells.constFind(cellKey(cx, cy));
+				if (cellIt == m_cells.constEnd())
+					continue;
+				for (int index : cellIt.value())
+				{
+					Entry& entry = m_entries[index];
+					if (entry.queryStamp == m_queryStamp)
+						continue;
+					entry.queryStamp = m_queryStamp;
+					if (entry.bounds.intersects(rect))
+						hits.append(index);
+				}
+			}
+		}
+		for (int index : std::as_const(m_largeEntries))
+		{
+			if (m_entries[index].bounds.intersects(rect))
+				hits.append(index);
+		}
+		std::sort(hits.begin(), hits.end());
+	}
+
+	result.reserve(hits.count());
+	for (int index : std::as_const(hits))
+		result.append(m_entries[index].item);
+	return result;
+}
+
+QRectF PageItemSpatialIndex::boundsOf(const PageItem* item)
+{
+	// Visual bounds include the stroke, the plain bounding rect is what Canvas tests
+	QRectF bounds = item->getVisualBoundingRect().united(item->getBoundingRect());
+	// Same padding as used by Canvas when culling items
+	return bounds.adjusted(0.0, 0.0, 1.0, 1.0);
+}
+
+bool PageItemSpatialIndex::matchesList() const
+{
+	int itemCount = m_itemList.count();
+	if (static_cast<int>(m_entries.size()) != itemCount)
+		return false;
+	for (int i = 0; i < itemCount; ++i)
+	{
+		if (m_entries[i].item != m_itemList.at(i))
+			return false;
+	}
+	return true;
+}
+
+void PageItemSpatialIndex::rebuild()
+{
+	// Reuse bounds of items which were not reported as changed. Pointers of removed
+	// items may be dangling here, they are only used as keys and never dereferenced.
+	int itemCount = m_itemList.count();
+	std::vector<Entry> entries(itemCount);
+	QHash<const PageItem*, int> entryIndexes;
+	entryIndexes.reserve(itemCount);
+	for (int i = 0; i < itemCount; ++i)
+	{
+		Entry& entry = entries[i];
+		entry.item = m_itemList.at(i);
+		entryIndexes.insert(entry.item, i);
+		auto oldIt = m_entryIndexes.constFind(entry.item);
+		if (m_valid && (oldIt != m_entryIndexes.constEnd()) && !m_changedItems.contains(entry.item))
+		{
+			const Entry& oldEntry = m_entries[oldIt.value()];
+			entry.bounds = oldEntry.bounds;
+			entry.cellX1 = oldEntry.cellX1;
+			entry.cellY1 = oldEntry.cellY1;
+			entry.cellX2 = oldEntry.cellX2;
+			entry.cellY2 = oldEntry.cellY2;
+			entry.large = oldEntry.large;
+		}
+		else
+		{
+			entry.bounds = boundsOf(entry.item);
+			computeCells(entry);
+		}
+	}
+
+	m_entries.swap(entries);
+	m_entryIndexes.swap(entryIndexes);
+	m_cells.clear();
+	m_largeEntries.clear();
+	m_changedItems.clear();
+	m_queryStamp = 0;
+	m_valid = true;
+	m_listChanged = false;
+	for (int i = 0; i < itemCount; ++i)
+		insertEntry(i);
+}
+
+void PageItemSpatialIndex::insertEntry(int index)
+{
+	const Entry& entry = m_entries[index];
+	if (entry.large)
+	{
+		m_largeEntries.append(index);
+		return;
+	}
+	for (int cx = entry.cellX1; cx <= entry.cellX2; ++cx)
+	{
+		for (int cy = entry.cellY1; cy <= entry.cellY2; ++cy)
+			m_cells[cellKey(cx, cy)].append(index);
+	}
+}
+
+void PageItemSpatialIndex::removeEntry(int index)
+{
+	const Entry& entry = m_entries[index];
+	if (entry.large)
+	{
+		m_largeEntries.removeOne(index);
+		return;
+	}
+	for (int cx = entry.cellX1; cx <= entry.cellX2; ++cx)
+	{
+		for (int cy = entry.cellY1; cy <= entry.cellY2; ++cy)
+		{
+			auto cellIt = m_cells.find(cellKey(cx, cy));
+			if (cellIt == m_cells.end())
+				continue;
+			cellIt.value().removeOne(index);
+			if (cellIt.value().isEmpty())
+				m_cells.erase(cellIt);
+		}
+	}
+}
+
+void PageItemSpatialIndex::computeCells(Entry& entry) const
+{
+	const QRectF& bounds = entry.bounds;
+	double cx1 = std::floor(bounds.left() / m_cellSize);
+	double cy1 = std::floor(bounds.top() / m_cellSize);
+	double cx2 = std::floor(bounds.right() / m_cellSize);
+	double cy2 = std::floor(bounds.bottom() / m_cellSize);
+	double cellCount = (cx2 - cx1 + 1.0) * (cy2 - cy1 + 1.0);
+
+	entry.large = !std::isfinite(cellCount) || (cellCount > maxCellsPerItem)
+	           || (qAbs(cx1) > maxCellCoordinate) || (qAbs(cy1) > maxCellCoordinate)
+	           || (qAbs(cx2) > maxCellCoordinate) || (qAbs(cy2) > maxCellCoordinate);
+	if (entry.large)
+	{
+		entry.cellX1 = entry.cellY1 = 0;
+		entry.cellX2 = entry.cellY2 = -1;
+		return;
+	}
+	entry.cellX1 = static_cast<int>(cx1);
+	entry.cellY1 = static_cast<int>(cy1);
+	entry.cellX2 = static_cast<int>(cx2);
+	entry.cellY2 = static_cast<int>(cy2);
+}
@@ -0,0 +1,99 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef PAGEITEMSPATIALINDEX_H
+#define PAGEITEMSPATIALINDEX_H
+
+#include <vector>
+
+#include <QHash>
+#include <QList>
+#include <QRectF>
+#include <QSet>
+
+#include "scribusapi.h"
+
+class PageItem;
+
+/**
+ * \brief Bucketed grid index over the bounding rects of a list of page items.
+ *
+ * The index is bound to one item list (e.g. ScribusDoc::DocItems) and keeps the visual
+ * bounds each item had when it was last bucketed. It does not look at items by itself:
+ * the document reports items whose bounds changed with itemChanged(), deleted items with
+ * itemDestroyed() and edits which may have added, removed or reordered items with
+ * listChanged(). A query re-buckets the reported items only, after a list change the
+ * stacking order is compared with the list and the entry table is rebuilt if it differs,
+ * reusing the bounds of unreported items. The cost of a query thus depends on the items
+ * in the queried area and on the items changed since the previous query.
+ */
+class SCRIBUS_API PageItemSpatialIndex
+{
+public:
+	explicit PageItemSpatialIndex(const QList<PageItem*>& itemList, double cellSize = 256.0);
+
+	/// Drops all index data, next query will rebuild the index from scratch
+	void clear();
+
+	/// Marks the bounds of \a item, an item of the indexed list, as changed
+	void itemChanged(const PageItem* item);
+	/// Forgets \a item, which is being deleted
+	void itemDestroyed(const PageItem* item);
+	/// Marks the content or the order of the item list as possibly changed
+	void listChanged() { m_listChanged = true; }
+
+	/// Brings the index in sync with the changes reported since the last update
+	void update();
+
+	/**
+	 * \brief Returns the items whose bounding rect intersects \a rect, in stacking order.
+	 * The returned list is a superset only in the sense that bounds are slightly padded,
+	 * callers are expected to do their own exact test on returned items.
+	 */
+	QList<PageItem*> itemsIntersecting(const QRectF& rect);
+
+	/// Number of items currently indexed
+	int count() const { return static_cast<int>(m_entries.size()); }
+
+private:
+	struct Entry
+	{
+		PageItem* item { nullptr };
+		QRectF bounds;
+		int cellX1 { 0 };
+		int cellY1 { 0 };
+		int cellX2 { -1 };
+		int cellY2 { -1 };
+		bool large { false };
+		quint32 queryStamp { 0 };
+	};
+
+	const QList<PageItem*>& m_itemList;
+	double m_cellSize { 256.0 };
+
+	std::vector<Entry> m_entries;
+	QHash<const PageItem*, int> m_entryIndexes;
+	QHash<quint64, QList<int> > m_cells;
+	QList<int> m_largeEntries;
+	quint32 m_queryStamp { 0 };
+
+	// Changes reported since the last update
+	bool m_valid { false };
+	bool m_listChanged { false };
+	QSet<const PageItem*> m_changedItems;
+
+	static QRectF boundsOf(const PageItem* item);
+	static quint64 cellKey(int cx, int cy) { return (static_cast<quint64>(static_cast<quint32>(cx)) << 32) | static_cast<quint32>(cy); }
+
+	bool matchesList() const;
+	void rebuild();
+	void insertEntry(int index);
+	void removeEntry(int index);
+	void computeCells(Entry& entry) const;
+};
+
+#endif // PAGEITEMSPATIALINDEX_H
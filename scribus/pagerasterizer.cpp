@@ -0,0 +1,345 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <QSet>
+
+#include "pagerasterizer.h"
+#include "pageitem.h"
+#include "pageitem_group.h"
+#include "pageitemiterator.h"
+#include "scribusdoc.h"
+#include "sclayer.h"
+#include "scpage.h"
+#include "scpainter.h"
+
+PageRasterizer::PageRasterizer(ScribusDoc* doc, PageToPixmapFlags flags) :
+	m_doc(doc),
+	m_flags(flags)
+{
+	m_drawAsPreview = m_doc->drawAsPreview;
+	m_framesShown = m_doc->guidesPrefs().framesShown;
+	m_showControls = m_doc->guidesPrefs().showControls;
+	m_masterPageMode = m_doc->masterPageMode();
+	m_wasLoading = m_doc->isLoading();
+	m_gamutCheck = m_doc->cmsSettings().GamutCheck;
+
+	if (m_doc->cmsSettings().CMSinUse && m_gamutCheck && !m_flags.testFlag(Pixmap_NoCMSSettingsChange))
+	{
+		m_doc->cmsSettings().GamutCheck = false;
+		m_doc->enableCMS(true);
+	}
+	m_doc->drawAsPreview = true;
+	m_doc->guidesPrefs().framesShown = false;
+	m_doc->guidesPrefs().showControls = false;
+	m_doc->setMasterPageMode(false);
+	// Items drawn for output get their text and images right away
+	m_doc->setLoading(true);
+	m_doc->textLayoutScheduler()->beginOutput();
+	m_doc->imageLoadScheduler()->beginOutput();
+}
+
+PageRasterizer::~PageRasterizer()
+{
+	if (m_doc->cmsSettings().GamutCheck != m_gamutCheck)
+	{
+		m_doc->cmsSettings().GamutCheck = m_gamutCheck;
+		m_doc->enableCMS(true);
+	}
+	m_doc->drawAsPreview = m_drawAsPreview;
+	m_doc->guidesPrefs().framesShown = m_framesShown;
+	m_doc->guidesPrefs().showControls = m_showControls;
+	m_doc->setMasterPageMode(m_masterPageMode);
+	m_doc->imageLoadScheduler()->endOutput();
+	m_doc->textLayoutScheduler()->endOutput();
+	m_doc->setLoading(m_wasLoading);
+}
+
+QSize PageRasterizer::imageSize(const ScPage* page, double scale)
+{
+	return QSize(qRound(page->width() * scale), qRound(page->height() * scale));
+}
+
+QImage PageRasterizer::render(ScPage* page, double scale)
+{
+	QSize size = imageSize(page, scale);
+	if (size.isEmpty())
+		return QImage();
+	QImage image(size, QImage::Format_ARGB32_Premultiplied);
+	if (image.isNull())
+		return image;
+	image.fill(qRgba(0, 0, 0, 0));
+
+	QRect area(QPoint(0, 0), size);
+	QList<QPair<PageItem*, int> > lowResImages;
+	if (!m_flags.testFlag(Pixmap_DontReloadImages))
+		lowResImages = loadFullResolutionImages(page, cullingArea(page, scale, area));
+
+	ScPainter painter(&image, image.width(), image.height(), 1.0, 0);
+	renderArea(&painter, page, scale, area);
+	painter.end();
+
+	if (!lowResImages.isEmpty())
+		restoreImages(lowResImages);
+	return image;
+}
+
+bool PageRasterizer::renderBands(ScPage* page, double scale, int bandHeight, const std::function<bool (const QImage&)>& writeBand)
+{
+	QSize size = imageSize(page, scale);
+	if (size.isEmpty() || (bandHeight <= 0))
+		return false;
+
+	// Images are loaded once for all bands
+	QList<QPair<PageItem*, int> > lowResImages;
+	if (!m_flags.testFlag(Pixmap_DontReloadImages))
+		lowResImages = loadFullResolutionImages(page, cullingArea(page, scale, QRect(QPoint(0, 0), size)));
+
+	bool success = true;
+	QImage band;
+	for (int y = 0; y < size.height(); y += bandHeight)
+	{
+		int height = qMin(bandHeight, size.height() - y);
+		if (band.height() != height)
+			band = QImage(size.width(), height, QImage::Format_ARGB32_Premultiplied);
+		if (band.isNull())
+		{
+			success = false;
+			break;
+		}
+		band.fill(qRgba(0, 0, 0, 0));
+
+		ScPainter painter(&band, band.width(), band.height(), 1.0, 0);
+		renderArea(&painter, page, scale, QRect(0, y, size.width(), height));
+		painter.end();
+		if (!writeBand(band))
+		{
+			success = false;
+			break;
+		}
+	}
+
+	if (!lowResImages.isEmpty())
+		restoreImages(lowResImages);
+	return success;
+}
+
+QRectF PageRasterizer::cullingArea(const ScPage* page, double scale, const QRect& area)
+{
+	int clipX = static_cast<int>(page->xOffset() * scale);
+	int clipY = static_cast<int>(page->yOffset() * scale);
+	return QRectF((clipX + area.x()) / scale, (clipY + area.y()) / scale, area.width() / scale + 1.0, area.height() / scale + 1.0);
+}
+
+void PageRasterizer::renderArea(ScPainter* painter, ScPage* page, double scale, const QRect& area)
+{
+	// Bands are placed on whole pixels so that they join seamlessly
+	int clipX = static_cast<int>(page->xOffset() * scale);
+	int clipY = static_cast<int>(page->yOffset() * scale);
+	QSize pageSize = imageSize(page, scale);
+	QRectF cullingArea = PageRasterizer::cullingArea(page, scale, area);
+
+	if (m_flags & Pixmap_DrawBackground)
+		painter->clear(m_doc->paperColor());
+	else if (m_flags & Pixmap_DrawWhiteBackground)
+		painter->clear(QColor(255, 255, 255));
+	painter->translate(-clipX - area.x(), -clipY - area.y());
+	painter->setFillMode(ScPainter::Solid);
+	if (m_flags & Pixmap_DrawFrame)
+	{
+		painter->setPen(Qt::black, 1, Qt::SolidLine, Qt::FlatCap, Qt::MiterJoin);
+		painter->setBrush(m_doc->paperColor());
+		painter->drawRect(clipX, clipY, pageSize.width(), pageSize.height());
+	}
+	painter->beginLayer(1.0, 0);
+	painter->setZoomFactor(scale);
+
+	ScLayer layer;
+	layer.isViewable = false;
+	int layerCount = m_doc->layerCount();
+	for (int layerLevel = 0; layerLevel < layerCount; ++layerLevel)
+	{
+		m_doc->Layers.levelToLayer(layer, layerLevel);
+		if (!layer.isPrintable || !layer.isViewable)
+			continue;
+		drawMasterItems(painter, page, layer, cullingArea);
+		drawPageItems(painter, layer, cullingArea, false);
+		drawPageItems(painter, layer, cullingArea, true);
+	}
+	painter->endLayer();
+}
+
+void PageRasterizer::drawMasterItems(ScPainter* painter, ScPage* page, const ScLayer& layer, const QRectF& cullingArea)
+{
+	if (page->masterPageNameEmpty() || page->FromMaster.isEmpty())
+		return;
+
+	ScPage* masterPage = m_doc->MasterPages.at(m_doc->MasterNames[page->masterPageName()]);
+	// Items not changed on this page are drawn shifted from their master page position
+	QRectF masterCullingArea = cullingArea.translated(masterPage->xOffset() - page->xOffset(), masterPage->yOffset() - page->yOffset());
+	const QList<PageItem*> candidates = m_doc->itemsInRect(&m_doc->MasterItems, masterCullingArea);
+	QSet<PageItem*> visibleItems(candidates.begin(), candidates.end());
+
+	bool layerBlending = ((layer.blendMode != 0) || (layer.transparency != 1.0)) && !layer.outlineMode;
+	if (layerBlending)
+		painter->beginLayer(layer.transparency, layer.blendMode);
+	for (PageItem* currItem : std::as_const(page->FromMaster))
+	{
+		if (currItem->m_layerID != layer.ID)
+			continue;
+		if (!currItem->ChangedMasterItem && !visibleItems.contains(currItem))
+			continue;
+		if ((currItem->OwnPage != -1) && (currItem->OwnPage != masterPage->pageNr()))
+			continue;
+		if (!currItem->printEnabled())
+			continue;
+		double oldX = currItem->xPos();
+		double oldY = currItem->yPos();
+		double oldBX = currItem->BoundingX;
+		double oldBY = currItem->BoundingY;
+		if (!currItem->ChangedMasterItem)
+		{
+			currItem->moveBy(-masterPage->xOffset() + page->xOffset(), -masterPage->yOffset() + page->yOffset(), true);
+			currItem->BoundingX = oldBX - masterPage->xOffset() + page->xOffset();
+			currItem->BoundingY = oldBY - masterPage->yOffset() + page->yOffset();
+		}
+		// Page numbers placed in text frames are those of the page drawn
+		QList<PageItem*> pageItems;
+		pageItems.append(currItem);
+		if (currItem->isGroup())
+		{
+			PageItemIterator itemIt(currItem->asGroupFrame()->groupItemList, PageItemIterator::IterateInGroups);
+			for ( ; *itemIt; ++itemIt)
+				pageItems.append(*itemIt);
+		}
+		for (PageItem* item : std::as_const(pageItems))
+		{
+			item->savedOwnPage = item->OwnPage;
+			item->OwnPage = page->pageNr();
+		}
+		if (cullingArea.intersects(currItem->getBoundingRect().adjusted(0.0, 0.0, 1.0, 1.0)))
+		{
+			m_doc->imageLoadScheduler()->request(currItem);
+			currItem->DrawObj(painter, cullingArea);
+			currItem->DrawObj_Decoration(painter);
+		}
+		for (PageItem* item : std::as_const(pageItems))
+			item->OwnPage = item->savedOwnPage;
+		if (!currItem->ChangedMasterItem)
+		{
+			currItem->setXYPos(oldX, oldY, true);
+			currItem->BoundingX = oldBX;
+			currItem->BoundingY = oldBY;
+		}
+	}
+	if (layerBlending)
+		painter->endLayer();
+}
+
+void PageRasterizer::drawPageItems(ScPainter* painter, const ScLayer& layer, const QRectF& cullingArea, bool notesFramesPass)
+{
+	const QList<PageItem*> candidates = m_doc->itemsInRect(&m_doc->DocItems, cullingArea);
+	if (candidates.isEmpty())
+		return;
+
+	bool layerBlending = ((layer.blendMode != 0) || (layer.transparency != 1.0)) && !layer.outlineMode;
+	if (layerBlending)
+		painter->beginLayer(layer.transparency, layer.blendMode);
+
+	// Notes frames are created by the layout of their master frames, lay them out before drawing anything
+	if (!notesFramesPass && !m_doc->notesList().isEmpty())
+	{
+		for (PageItem* currItem : candidates)
+		{
+			if (!currItem->isTextFrame() || currItem->isNoteFrame() || !currItem->invalid)
+				continue;
+			if ((currItem->m_layerID != layer.ID) || !currItem->printEnabled() || !currItem->OnMasterPage.isEmpty())
+				continue;
+			if (cullingArea.intersects(currItem->getBoundingRect().adjusted(0.0, 0.0, 1.0, 1.0)))
+				currItem->layout();
+		}
+	}
+	for (PageItem* currItem : candidates)
+	{
+		if (currItem->isNoteFrame() != notesFramesPass)
+			continue;
+		if ((currItem->m_layerID != layer.ID) || !currItem->printEnabled() || !currItem->OnMasterPage.isEmpty())
+			continue;
+		if (!cullingArea.intersects(currItem->getBoundingRect().adjusted(0.0, 0.0, 1.0, 1.0)))
+			continue;
+		m_doc->imageLoadScheduler()->request(currItem);
+		currItem->DrawObj(painter, cullingArea);
+		currItem->DrawObj_Decoration(painter);
+	}
+
+	if (layerBlending)
+		painter->endLayer();
+}
+
+QList<QPair<PageItem*, int> > PageRasterizer::loadFullResolutionImages(ScPage* page, const QRectF& cullingArea)
+{
+	QList<PageItem*> candidates = page->FromMaster;
+	candidates += m_doc->itemsInRect(&m_doc->DocItems, cullingArea);
+
+	QList<QPair<PageItem*, int> > lowResImages;
+	QList<PageItem*> imageItems;
+	PageItemIterator itemIt(candidates, PageItemIterator::IterateInGroups);
+	for ( ; *itemIt; ++itemIt)
+	{
+		PageItem* currItem = *itemIt;
+		if (!currItem->isImageFrame() || !currItem->imageIsAvailable)
+			continue;
+		if (currItem->pixm.imgInfo.lowResType == 0)
+			continue;
+		lowResImages.append(qMakePair(currItem, currItem->pixm.imgInfo.lowResType));
+		currItem->pixm.imgInfo.lowResType = 0;
+		imageItems.append(currItem);
+	}
+	reloadImages(imageItems);
+	return lowResImages;
+}
+
+void PageRasterizer::restoreImages(const QList<QPair<PageItem*, int> >& images)
+{
+	QList<PageItem*> imageItems;
+	for (const QPair<PageItem*, int>& image : images)
+	{
+		image.first->pixm.imgInfo.lowResType = image.second;
+		imageItems.append(image.first);
+	}
+	reloadImages(imageItems);
+}
+
+void PageRasterizer::reloadImages(const QList<PageItem*>& items)
+{
+	if (items.isEmpty())
+		return;
+
+	struct ImagePlacement
+	{
+		bool flippedH;
+		bool flippedV;
+		double xOffset;
+		double yOffset;
+	};
+	QList<ImagePlacement> placements;
+	placements.reserve(items.count());
+	for (const PageItem* item : items)
+		placements.append({ item->imageFlippedH(), item->imageFlippedV(), item->imageXOffset(), item->imageYOffset() });
+
+	// Images are decoded concurrently, then committed one after the other
+	m_doc->loadPicts(items, true);
+
+	for (int i = 0; i < items.count(); ++i)
+	{
+		PageItem* item = items.at(i);
+		const ImagePlacement& placement = placements.at(i);
+		item->setImageFlippedH(placement.flippedH);
+		item->setImageFlippedV(placement.flippedV);
+		item->setImageXOffset(placement.xOffset);
+		item->setImageYOffset(placement.yOffset);
+	}
+}
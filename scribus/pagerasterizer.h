@@ -0,0 +1,90 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef PAGERASTERIZER_H
+#define PAGERASTERIZER_H
+
+#include <functional>
+
+#include <QImage>
+#include <QList>
+#include <QPair>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+
+#include "scribusapi.h"
+#include "scribusstructs.h"
+
+class PageItem;
+class ScLayer;
+class ScPage;
+class ScPainter;
+class ScribusDoc;
+
+/**
+ * \brief Renders document pages to images without going through the view canvas.
+ *
+ * Pages are drawn into their own painter as in preview mode: only printable layers and
+ * items, without guides, frames or controls. The canvas, its scale and its mode are left
+ * untouched, the document is prepared for output once when the rasterizer is created and
+ * restored when it is destroyed.
+ *
+ * Drawing reads and temporarily modifies the items of the document, e.g. master page items
+ * are moved onto the page they are drawn on. A rasterizer must thus be used in the thread
+ * owning the document, one page after the other. The returned images belong to the caller
+ * and may be processed concurrently.
+ */
+class SCRIBUS_API PageRasterizer
+{
+public:
+	/// Prepares \a doc for rendering its pages with \a flags, see PageToPixmapFlag
+	explicit PageRasterizer(ScribusDoc* doc, PageToPixmapFlags flags = Pixmap_DrawBackground);
+	~PageRasterizer();
+
+	PageRasterizer(const PageRasterizer&) = delete;
+	PageRasterizer& operator=(const PageRasterizer&) = delete;
+
+	/// Returns the size in pixels of \a page rendered at \a scale, 1.0 being 72 dpi
+	static QSize imageSize(const ScPage* page, double scale);
+
+	/// Renders \a page at \a scale, returns a null image if it cannot be allocated
+	QImage render(ScPage* page, double scale);
+	/**
+	 * \brief Renders \a page at \a scale in horizontal bands of \a bandHeight pixels.
+	 * Bands are passed from top to bottom to \a writeBand, which returns false to stop
+	 * rendering. Only one band is held in memory, pages too large for a single image can
+	 * thus be rendered. Returns false if a band cannot be allocated or written.
+	 */
+	bool renderBands(ScPage* page, double scale, int bandHeight, const std::function<bool (const QImage&)>& writeBand);
+
+private:
+	ScribusDoc* m_doc { nullptr };
+	PageToPixmapFlags m_flags;
+
+	// Document settings restored when done
+	bool m_drawAsPreview { false };
+	bool m_framesShown { false };
+	bool m_showControls { false };
+	bool m_masterPageMode { false };
+	bool m_wasLoading { false };
+	bool m_gamutCheck { false };
+
+	/// Returns the part \a area of \a page in document coordinates, \a area being in pixels of the page image
+	static QRectF cullingArea(const ScPage* page, double scale, const QRect& area);
+	/// Draws the part \a area of \a page, in pixels from the top left corner of the page image
+	void renderArea(ScPainter* painter, ScPage* page, double scale, const QRect& area);
+	void drawMasterItems(ScPainter* painter, ScPage* page, const ScLayer& layer, const QRectF& cullingArea);
+	void drawPageItems(ScPainter* painter, const ScLayer& layer, const QRectF& cullingArea, bool notesFramesPass);
+
+	/// Loads images drawn on \a page in \a cullingArea at full resolution, returns their previous resolution
+	QList<QPair<PageItem*, int> > loadFullResolutionImages(ScPage* page, const QRectF& cullingArea);
+	void restoreImages(const QList<QPair<PageItem*, int> >& images);
+	void reloadImages(const QList<PageItem*>& items);
+};
+
+#endif // PAGERASTERIZER_H
@@ -0,0 +1,369 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QSaveFile>
+
+#include "pagethumbnailcache.h"
+#include "pageitem.h"
+#include "pagerasterizer.h"
+#include "scpage.h"
+#include "scribus.h"
+#include "scribusdoc.h"
+#include "scribusstructs.h"
+#include "scribusview.h"
+
+namespace
+{
+	const quint32 thumbnailFileMagic = 0x53435448; // "SCTH"
+	const quint32 thumbnailFileVersion = 1;
+
+	QRectF pageRect(const ScPage* page)
+	{
+		return QRectF(page->xOffset(), page->yOffset(), page->width(), page->height());
+	}
+}
+
+PageThumbnailCache::PageThumbnailCache(ScribusDoc* doc) :
+	m_doc(doc)
+{
+	m_timer.setSingleShot(true);
+	connect(&m_timer, &QTimer::timeout, this, &PageThumbnailCache::renderNext);
+	// Sent by palettes after changes which may affect any page
+	connect(doc, &ScribusDoc::pagePreviewChanged, this, &PageThumbnailCache::invalidateAll);
+}
+
+void PageThumbnailCache::setThumbnailHeight(int height)
+{
+	if (height == m_height)
+		return;
+	m_height = height;
+	if (m_height <= 0)
+	{
+		m_timer.stop();
+		return;
+	}
+	// Previous images are kept until replaced, they are only scaled meanwhile
+	for (auto it = m_thumbnails.begin(); it != m_thumbnails.end(); ++it)
+		it->upToDate = false;
+	schedule(0);
+}
+
+QImage PageThumbnailCache::thumbnail(int pageIndex)
+{
+	ScPage* page = m_doc->DocPages.value(pageIndex, nullptr);
+	if (page == nullptr)
+		return QImage();
+	auto it = m_thumbnails.find(page);
+	if (it == m_thumbnails.end())
+	{
+		schedule(0);
+		return QImage();
+	}
+	if (!isUpToDate(page, *it))
+		schedule(0);
+	return it->image;
+}
+
+bool PageThumbnailCache::isUpToDate(int pageIndex) const
+{
+	ScPage* page = m_doc->DocPages.value(pageIndex, nullptr);
+	if (page == nullptr)
+		return false;
+	auto it = m_thumbnails.constFind(page);
+	return (it != m_thumbnails.constEnd()) && isUpToDate(page, *it);
+}
+
+bool PageThumbnailCache::isUpToDate(const ScPage* page, const Thumbnail& thumbnail) const
+{
+	return thumbnail.upToDate &&
+		(thumbnail.pageSize == QSizeF(page->width(), page->height())) &&
+		(thumbnail.masterPageName == page->masterPageName());
+}
+
+void PageThumbnailCache::invalidate(int pageIndex)
+{
+	ScPage* page = m_doc->DocPages.value(pageIndex, nullptr);
+	if (page == nullptr)
+		return;
+	invalidatePage(page);
+	schedule(m_idleDelay);
+}
+
+void PageThumbnailCache::invalidateAll()
+{
+	for (auto it = m_thumbnails.begin(); it != m_thumbnails.end(); ++it)
+		it->upToDate = false;
+	schedule(m_idleDelay);
+}
+
+void PageThumbnailCache::invalidateMasterPage(const QString& masterPageName)
+{
+	for (ScPage* page : std::as_const(m_doc->DocPages))
+	{
+		if (page->masterPageName() == masterPageName)
+			invalidatePage(page);
+	}
+	schedule(m_idleDelay);
+}
+
+void PageThumbnailCache::itemDestroyed(const PageItem* item)
+{
+	m_itemRects.remove(item);
+}
+
+void PageThumbnailCache::pageDestroyed(const ScPage* page)
+{
+	m_thumbnails.remove(page);
+}
+
+void PageThumbnailCache::invalidatePage(ScPage* page)
+{
+	auto it = m_thumbnails.find(page);
+	if (it != m_thumbnails.end())
+		it->upToDate = false;
+}
+
+void PageThumbnailCache::invalidateRect(const QRectF& rect, bool masterPages)
+{
+	if (masterPages)
+	{
+		for (const ScPage* page : std::as_const(m_doc->MasterPages))
+		{
+			if (pageRect(page).intersects(rect))
+				invalidateMasterPage(page->pageName());
+		}
+		return;
+	}
+	for (ScPage* page : std::as_const(m_doc->DocPages))
+	{
+		if (pageRect(page).intersects(rect))
+			invalidatePage(page);
+	}
+	schedule(m_idleDelay);
+}
+
+void PageThumbnailCache::changed(QRectF re, bool)
+{
+	// Drawing a page may update its items
+	if (m_rendering)
+		return;
+	if (!re.isValid())
+		invalidateAll();
+	else
+		invalidateRect(re, m_doc->masterPageMode());
+}
+
+void PageThumbnailCache::changed(PageItem* item, bool)
+{
+	if (m_rendering || (item == nullptr))
+		return;
+	while (item->Parent != nullptr)
+		item = item->Parent;
+	if (!item->OnMasterPage.isEmpty())
+	{
+		invalidateMasterPage(item->OnMasterPage);
+		return;
+	}
+	QRectF rect = item->getVisualBoundingRect();
+	invalidateRect(rect.united(m_itemRects.value(item)), false);
+	m_itemRects.insert(item, rect);
+}
+
+bool PageThumbnailCache::canRender() const
+{
+	ScribusView* view = m_doc->view();
+	if ((view == nullptr) || !view->updatesEnabled())
+		return false;
+	if (m_doc->isLoading() || m_doc->inlineEditMode() || m_doc->symbolEditMode())
+		return false;
+	if ((m_doc->scMW() != nullptr) && m_doc->scMW()->scriptIsRunning())
+		return false;
+	// Wait for the user to finish dragging or drawing
+	return (QGuiApplication::mouseButtons() == Qt::NoButton);
+}
+
+void PageThumbnailCache::schedule(int delay)
+{
+	if (m_height <= 0)
+		return;
+	// Changes postpone rendering until the document is idle again
+	if (delay > 0 || !m_timer.isActive())
+		m_timer.start(delay);
+}
+
+void PageThumbnailCache::renderNext()
+{
+	if (m_height <= 0)
+		return;
+	// Thumbnails of other documents are rendered when the Pages palette shows them again
+	if ((m_doc->scMW() != nullptr) && (m_doc->scMW()->doc != m_doc))
+		return;
+	if (!canRender())
+	{
+		m_timer.start(m_idleDelay);
+		return;
+	}
+
+	// The current page is the one most likely looked at
+	ScPage* page = nullptr;
+	ScPage* currentPage = m_doc->currentPage();
+	if ((currentPage != nullptr) && m_doc->DocPages.contains(currentPage))
+	{
+		auto it = m_thumbnails.constFind(currentPage);
+		if ((it == m_thumbnails.constEnd()) || !isUpToDate(currentPage, *it))
+			page = currentPage;
+	}
+	for (int i = 0; (page == nullptr) && (i < m_doc->DocPages.count()); ++i)
+	{
+		ScPage* docPage = m_doc->DocPages.at(i);
+		auto it = m_thumbnails.constFind(docPage);
+		if ((it == m_thumbnails.constEnd()) || !isUpToDate(docPage, *it))
+			page = docPage;
+	}
+	// All pages are up to date, thumbnails of deleted pages are removed by pageDestroyed()
+	if (page == nullptr)
+		return;
+
+	int pageIndex = m_doc->DocPages.indexOf(page);
+	// The rasterizer leaves the canvas, its scale and its cached tiles alone
+	PageToPixmapFlags flags = Pixmap_DrawFrame | Pixmap_DrawBackground | Pixmap_DontReloadImages | Pixmap_NoCMSSettingsChange;
+	m_rendering = true;
+	QImage image;
+	{
+		PageRasterizer rasterizer(m_doc, flags);
+		image = rasterizer.render(page, m_height / page->height());
+	}
+	QRectF rect = pageRect(page);
+	for (const PageItem* item : std::as_const(m_doc->DocItems))
+	{
+		QRectF itemRect = item->getVisualBoundingRect();
+		if (itemRect.intersects(rect))
+			m_itemRects.insert(item, itemRect);
+	}
+	m_rendering = false;
+
+	Thumbnail& thumbnail = m_thumbnails[page];
+	thumbnail.image = image;
+	thumbnail.pageSize = QSizeF(page->width(), page->height());
+	thumbnail.masterPageName = page->masterPageName();
+	thumbnail.upToDate = true;
+	m_modified = true;
+	emit thumbnailChanged(pageIndex);
+
+	// Leave the event loop a chance to process user input before the next page
+	m_timer.start(0);
+}
+
+QString PageThumbnailCache::cacheFileName() const
+{
+	QFileInfo fi(m_doc->documentFileName());
+	return fi.absolutePath() + "/." + fi.fileName() + ".thumbnails";
+}
+
+bool PageThumbnailCache::load()
+{
+	if (!m_doc->hasName)
+		return false;
+	QFileInfo docInfo(m_doc->documentFileName());
+	QFile file(cacheFileName());
+	if (!docInfo.exists() || !file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_6_0);
+	quint32 magic = 0;
+	quint32 version = 0;
+	qint64 fileSize = 0;
+	qint64 fileTime = 0;
+	qint32 height = 0;
+	qint32 pageCount = 0;
+	stream >> magic >> version;
+	if ((magic != thumbnailFileMagic) || (version != thumbnailFileVersion))
+		return false;
+	stream >> fileSize >> fileTime >> height >> pageCount;
+	if ((stream.status() != QDataStream::Ok) || (height <= 0))
+		return false;
+	// Thumbnails of another version of the document are useless
+	if ((fileSize != docInfo.size()) || (fileTime != docInfo.lastModified().toMSecsSinceEpoch()))
+		return false;
+	if (pageCount != m_doc->DocPages.count())
+		return false;
+
+	QHash<const ScPage*, Thumbnail> thumbnails;
+	for (int i = 0; i < pageCount; ++i)
+	{
+		bool valid = false;
+		stream >> valid;
+		if (!valid)
+			continue;
+		Thumbnail thumbnail;
+		stream >> thumbnail.pageSize >> thumbnail.masterPageName >> thumbnail.image;
+		if (stream.status() != QDataStream::Ok)
+			return false;
+		thumbnail.upToDate = true;
+		thumbnails.insert(m_doc->DocPages.at(i), thumbnail);
+	}
+
+	if (m_height <= 0)
+		m_height = height;
+	for (auto it = thumbnails.begin(); it != thumbnails.end(); ++it)
+		it->upToDate = (height == m_height);
+	m_thumbnails = thumbnails;
+	m_modified = false;
+	m_savedFileTime = fileTime;
+	for (int i = 0; i < pageCount; ++i)
+	{
+		if (m_thumbnails.contains(m_doc->DocPages.at(i)))
+			emit thumbnailChanged(i);
+	}
+	schedule(m_idleDelay);
+	return true;
+}
+
+bool PageThumbnailCache::save()
+{
+	if (!m_doc->hasName || m_doc->isModified() || m_thumbnails.isEmpty() || (m_height <= 0))
+		return false;
+	QFileInfo docInfo(m_doc->documentFileName());
+	if (!docInfo.exists())
+		return false;
+	qint64 fileTime = docInfo.lastModified().toMSecsSinceEpoch();
+	if (!m_modified && (fileTime == m_savedFileTime))
+		return true;
+
+	QSaveFile file(cacheFileName());
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_6_0);
+	stream << thumbnailFileMagic << thumbnailFileVersion;
+	stream << qint64(docInfo.size()) << fileTime << qint32(m_height) << qint32(m_doc->DocPages.count());
+	for (ScPage* page : std::as_const(m_doc->DocPages))
+	{
+		// Outdated thumbnails are left out, they are rendered again after loading
+		auto it = m_thumbnails.constFind(page);
+		bool valid = (it != m_thumbnails.constEnd()) && isUpToDate(page, *it);
+		stream << valid;
+		if (valid)
+			stream << it->pageSize << it->masterPageName << it->image;
+	}
+	if (stream.status() != QDataStream::Ok)
+	{
+		file.cancelWriting();
+		return false;
+	}
+	if (!file.commit())
+		return false;
+	m_modified = false;
+	m_savedFileTime = fileTime;
+	return true;
+}
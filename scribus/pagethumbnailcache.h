@@ -0,0 +1,114 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef PAGETHUMBNAILCACHE_H
+#define PAGETHUMBNAILCACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QRectF>
+#include <QSizeF>
+#include <QString>
+#include <QTimer>
+
+#include "observable.h"
+#include "scribusapi.h"
+
+class PageItem;
+class ScPage;
+class ScribusDoc;
+
+/**
+ * \brief Keeps the thumbnails of the pages of a document, as shown by the Pages palette.
+ *
+ * Item and region changes of the document mark the pages they touch as outdated, changes
+ * of master page items mark the pages based on that master page. Outdated thumbnails are
+ * rendered again one page at a time once the document has been idle for a moment, their
+ * previous image is returned meanwhile. Pages are rendered with a PageRasterizer, which does
+ * not touch the canvas of the document view, in the GUI thread between two passes of the
+ * event loop.
+ *
+ * Thumbnails are stored in a hidden file next to the document when the document is saved or
+ * closed unmodified, and read back when it is opened again, as long as the document file has
+ * not changed since.
+ */
+class SCRIBUS_API PageThumbnailCache : public QObject, public Observer<QRectF>, public Observer<PageItem*>
+{
+	Q_OBJECT
+
+public:
+	explicit PageThumbnailCache(ScribusDoc* doc);
+
+	/// Sets the height in pixels of the thumbnails, 0 stops rendering them
+	void setThumbnailHeight(int height);
+	int thumbnailHeight() const { return m_height; }
+
+	/**
+	 * \brief Returns the thumbnail of page \a pageIndex.
+	 * The returned image may be outdated or null, the page is then rendered later and
+	 * thumbnailChanged() emitted.
+	 */
+	QImage thumbnail(int pageIndex);
+	/// Returns true if the thumbnail of page \a pageIndex matches the page
+	bool isUpToDate(int pageIndex) const;
+
+	void invalidate(int pageIndex);
+	void invalidateAll();
+	/// Marks the pages based on master page \a masterPageName as outdated
+	void invalidateMasterPage(const QString& masterPageName);
+	/// Forgets about \a item or \a page, which are being deleted, their address may be reused
+	void itemDestroyed(const PageItem* item);
+	void pageDestroyed(const ScPage* page);
+
+	/// Reads the thumbnails stored for the document file, returns true if they match it
+	bool load();
+	/// Stores the thumbnails next to the document file if the document is not modified
+	bool save();
+	/// Name of the file storing the thumbnails of the document
+	QString cacheFileName() const;
+
+	void changed(QRectF re, bool doLayout) override;
+	void changed(PageItem* item, bool doLayout) override;
+
+signals:
+	/// Emitted when the thumbnail of page \a pageIndex has been rendered or loaded
+	void thumbnailChanged(int pageIndex);
+
+private slots:
+	void renderNext();
+
+private:
+	struct Thumbnail
+	{
+		QImage image;
+		QSizeF pageSize;
+		QString masterPageName;
+		bool upToDate { false };
+	};
+
+	ScribusDoc* m_doc { nullptr };
+	QHash<const ScPage*, Thumbnail> m_thumbnails;
+	// Bounding rectangles of items as last drawn, to update the pages an item is moved away from
+	QHash<const PageItem*, QRectF> m_itemRects;
+	QTimer m_timer;
+	int m_height { 0 };
+	bool m_rendering { false };
+	// Thumbnails changed since they were loaded or saved
+	bool m_modified { false };
+	qint64 m_savedFileTime { -1 };
+	// Time in milliseconds the document must be left unchanged before thumbnails are rendered
+	int m_idleDelay { 500 };
+
+	bool isUpToDate(const ScPage* page, const Thumbnail& thumbnail) const;
+	bool canRender() const;
+	void invalidatePage(ScPage* page);
+	void invalidateRect(const QRectF& rect, bool masterPages);
+	void schedule(int delay);
+};
+
+#endif // PAGETHUMBNAILCACHE_H
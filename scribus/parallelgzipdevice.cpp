@@ -0,0 +1,280 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <cstring>
+#include <zlib.h>
+
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include "parallelgzipdevice.h"
+
+struct ParallelGzipDevice::Block
+{
+	QByteArray input;
+	QByteArray output;
+	bool last { false };
+	bool success { false };
+	uLong crc { 0 };
+	QSemaphore done;
+};
+
+ParallelGzipDevice::ParallelGzipDevice(QIODevice* target, QObject* parent) :
+	QIODevice(parent),
+	m_target(target),
+	m_threadPool(QThreadPool::globalInstance())
+{
+
+}
+
+ParallelGzipDevice::~ParallelGzipDevice()
+{
+	// Workers access their block only, which they share with us
+	for (const auto& block : m_blocksInFlight)
+		block->done.acquire();
+}
+
+void ParallelGzipDevice::reserveExtraField(const QByteArray& id, int length)
+{
+	if ((id.size() != 2) || (length < 0) || (length > 65535 - 4))
+		return;
+	m_extraFieldId = id;
+	m_extraFieldLength = length;
+}
+
+bool ParallelGzipDevice::setExtraField(const QByteArray& data)
+{
+	if (isOpen() || (m_extraFieldPos < 0) || (data.size() > m_extraFieldLength))
+		return false;
+	QByteArray field(data);
+	field.append(QByteArray(m_extraFieldLength - data.size(), ' '));
+	qint64 endPos = m_target->pos();
+	if (!m_target->seek(m_extraFieldPos))
+		return false;
+	bool success = (m_target->write(field) == field.size());
+	return m_target->seek(endPos) && success;
+}
+
+int ParallelGzipDevice::addRestartPoint(char delimiter)
+{
+	PendingRestartPoint point;
+	point.id = m_restartPoints.count();
+	point.delimiter = delimiter;
+	m_restartPoints.append(RestartPointData());
+	m_pendingRestartPoints.append(point);
+	return point.id;
+}
+
+ParallelGzipDevice::RestartPoint ParallelGzipDevice::restartPoint(int id) const
+{
+	RestartPoint point;
+	if ((id < 0) || (id >= m_restartPoints.count()))
+		return point;
+	const RestartPointData& data = m_restartPoints.at(id);
+	point.offset = data.offset;
+	if ((data.block >= 0) && (data.block < m_blockCompressedOffsets.count()))
+		point.compressedOffset = m_blockCompressedOffsets.at(data.block);
+	return point;
+}
+
+bool ParallelGzipDevice::open(OpenMode mode)
+{
+	if ((mode & ReadWrite) != WriteOnly)
+	{
+		setErrorString(tr("Only writing is supported"));
+		return false;
+	}
+	if ((m_target == nullptr) || (!m_target->isOpen() && !m_target->open(WriteOnly)) || !m_target->isWritable())
+	{
+		setErrorString(tr("Target device cannot be written"));
+		return false;
+	}
+
+	m_currentBlock.clear();
+	m_currentBlock.reserve(m_blockSize);
+	m_blockCount = 0;
+	m_blockCompressedOffsets.clear();
+	m_uncompressedSize = 0;
+	m_compressedSize = 0;
+	m_crc = crc32(0L, Z_NULL, 0);
+	m_failed = false;
+	m_maxBlocksInFlight = qMax(2, 2 * m_threadPool->maxThreadCount());
+
+	QByteArray header;
+	header.append('\x1f').append('\x8b').append('\x08');
+	header.append(m_extraFieldId.isEmpty() ? '\x00' : '\x04'); // FEXTRA
+	header.append(QByteArray(4, '\x00')); // no modification time
+	header.append('\x00').append('\xff'); // no extra flags, unknown OS
+	if (!m_extraFieldId.isEmpty())
+	{
+		int extraLength = m_extraFieldLength + 4;
+		header.append(static_cast<char>(extraLength & 0xff)).append(static_cast<char>(extraLength >> 8));
+		header.append(m_extraFieldId);
+		header.append(static_cast<char>(m_extraFieldLength & 0xff)).append(static_cast<char>(m_extraFieldLength >> 8));
+		m_extraFieldPos = m_target->pos() + header.size();
+		header.append(QByteArray(m_extraFieldLength, ' '));
+	}
+	if (m_target->write(header) != header.size())
+	{
+		setErrorString(m_target->errorString());
+		return false;
+	}
+	return QIODevice::open(mode);
+}
+
+void ParallelGzipDevice::close()
+{
+	if (!isOpen())
+		return;
+
+	// Restart points whose delimiter never came are placed at the end
+	for (const PendingRestartPoint& point : std::as_const(m_pendingRestartPoints))
+	{
+		m_restartPoints[point.id].offset = m_uncompressedSize;
+		m_restartPoints[point.id].block = m_blockCount;
+	}
+	m_pendingRestartPoints.clear();
+
+	startBlock(true);
+	while (!m_blocksInFlight.empty())
+		writeFinishedBlock();
+
+	QByteArray trailer;
+	const quint32 trailerValues[2] = { m_crc, static_cast<quint32>(m_uncompressedSize & 0xffffffff) };
+	for (quint32 value : trailerValues)
+	{
+		for (int shift = 0; shift < 32; shift += 8)
+			trailer.append(static_cast<char>((value >> shift) & 0xff));
+	}
+	if (!m_failed && (m_target->write(trailer) != trailer.size()))
+	{
+		setErrorString(m_target->errorString());
+		m_failed = true;
+	}
+	QIODevice::close();
+}
+
+qint64 ParallelGzipDevice::readData(char* /*data*/, qint64 /*maxSize*/)
+{
+	return -1;
+}
+
+qint64 ParallelGzipDevice::writeData(const char* data, qint64 size)
+{
+	if (m_failed)
+		return -1;
+
+	qint64 written = 0;
+	while (written < size)
+	{
+		qint64 chunkSize = qMin<qint64>(size - written, m_blockSize - m_currentBlock.size());
+		// Stop at the first delimiter a restart point waits for
+		for (const PendingRestartPoint& point : std::as_const(m_pendingRestartPoints))
+		{
+			const char* found = static_cast<const char*>(memchr(data + written, point.delimiter, chunkSize));
+			if (found != nullptr)
+				chunkSize = found - (data + written);
+		}
+		if (chunkSize > 0)
+		{
+			m_currentBlock.append(data + written, chunkSize);
+			written += chunkSize;
+			m_uncompressedSize += chunkSize;
+		}
+		if (written < size)
+		{
+			bool restart = false;
+			for (int i = m_pendingRestartPoints.count() - 1; i >= 0; --i)
+			{
+				if (m_pendingRestartPoints.at(i).delimiter != data[written])
+					continue;
+				restart = true;
+				m_restartPoints[m_pendingRestartPoints.at(i).id].offset = m_uncompressedSize;
+				m_restartPoints[m_pendingRestartPoints.at(i).id].block = m_currentBlock.isEmpty() ? m_blockCount : m_blockCount + 1;
+				m_pendingRestartPoints.removeAt(i);
+			}
+			if ((restart && !m_currentBlock.isEmpty()) || (m_currentBlock.size() >= m_blockSize))
+				startBlock(false);
+		}
+		else if (m_currentBlock.size() >= m_blockSize)
+			startBlock(false);
+		if (m_failed)
+			return -1;
+	}
+	return written;
+}
+
+void ParallelGzipDevice::startBlock(bool last)
+{
+	auto block = std::make_shared<Block>();
+	block->input = std::move(m_currentBlock);
+	block->last = last;
+	m_currentBlock = QByteArray();
+	m_currentBlock.reserve(m_blockSize);
+	++m_blockCount;
+
+	const int compressionLevel = m_compressionLevel;
+	m_blocksInFlight.push_back(block);
+	m_threadPool->start([block, compressionLevel]() {
+		compressBlock(*block, compressionLevel);
+		block->done.release();
+	});
+
+	while (static_cast<int>(m_blocksInFlight.size()) > m_maxBlocksInFlight)
+		writeFinishedBlock();
+}
+
+bool ParallelGzipDevice::writeFinishedBlock()
+{
+	std::shared_ptr<Block> block = m_blocksInFlight.front();
+	m_blocksInFlight.pop_front();
+	block->done.acquire();
+
+	m_blockCompressedOffsets.append(m_compressedSize);
+	if (m_failed)
+		return false;
+	if (!block->success)
+	{
+		setErrorString(tr("Compression failed"));
+		m_failed = true;
+		return false;
+	}
+	m_crc = crc32_combine(m_crc, block->crc, block->input.size());
+	if (m_target->write(block->output) != block->output.size())
+	{
+		setErrorString(m_target->errorString());
+		m_failed = true;
+		return false;
+	}
+	m_compressedSize += block->output.size();
+	return true;
+}
+
+void ParallelGzipDevice::compressBlock(Block& block, int compressionLevel)
+{
+	const QByteArray& input = block.input;
+	block.crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(input.constData()), static_cast<uInt>(input.size()));
+
+	z_stream zs;
+	zs.zalloc = Z_NULL;
+	zs.zfree = Z_NULL;
+	zs.opaque = Z_NULL;
+	if (deflateInit2(&zs, compressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return;
+
+	// A sync flush ends the block on a byte boundary without marking the deflate stream
+	// as complete, the next block can be appended as is. Only the last block finishes it.
+	block.output.resize(deflateBound(&zs, input.size()) + 16);
+	zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+	zs.avail_in = static_cast<uInt>(input.size());
+	zs.next_out = reinterpret_cast<Bytef*>(block.output.data());
+	zs.avail_out = static_cast<uInt>(block.output.size());
+	int status = deflate(&zs, block.last ? Z_FINISH : Z_SYNC_FLUSH);
+	block.success = block.last ? (status == Z_STREAM_END) : ((status == Z_OK) && (zs.avail_in == 0) && (zs.avail_out > 0));
+	block.output.resize(block.output.size() - zs.avail_out);
+	deflateEnd(&zs);
+}
@@ -0,0 +1,132 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef PARALLELGZIPDEVICE_H
+#define PARALLELGZIPDEVICE_H
+
+#include <deque>
+#include <memory>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+
+#include "scribusapi.h"
+
+class QThreadPool;
+
+/**
+ * \brief Write only device compressing its data to gzip format on several threads.
+ *
+ * Written data is cut into blocks, each block is deflated independently by a thread pool
+ * while the caller goes on writing, in the way pigz does. Compressed blocks are written to
+ * the target device in order, ending with a sync flush, so that the output is a single
+ * ordinary gzip member readable by any gzip decoder, including QtIOCompressor. As blocks
+ * share no history, inflating can also start at the beginning of any block: restart points
+ * force a block boundary and report where it lies in the compressed data.
+ *
+ * The number of blocks being compressed is bounded, writing waits for the oldest block when
+ * the limit is reached. Memory use thus does not depend on the size of the data.
+ */
+class SCRIBUS_API ParallelGzipDevice : public QIODevice
+{
+	Q_OBJECT
+
+public:
+	/// Uncompressed and compressed offset of a restart point, the latter from the start of the deflate data
+	struct RestartPoint
+	{
+		qint64 offset { -1 };
+		qint64 compressedOffset { -1 };
+	};
+
+	explicit ParallelGzipDevice(QIODevice* target, QObject* parent = nullptr);
+	~ParallelGzipDevice() override;
+
+	/// Sets the zlib compression level, default is 6. Must be called before open().
+	void setCompressionLevel(int level) { m_compressionLevel = level; }
+	/// Sets the size of uncompressed blocks, default is 512 KiB. Must be called before open().
+	void setBlockSize(int size) { m_blockSize = qMax(size, 4096); }
+	/// Sets the pool compressing blocks, the global pool is used by default. Must be called before open().
+	void setThreadPool(QThreadPool* threadPool) { m_threadPool = threadPool; }
+
+	/**
+	 * \brief Reserves a subfield of the gzip header extra field.
+	 * The subfield \a id of two characters is written with \a length spaces,
+	 * its content can be set once all data is written, see setExtraField().
+	 * Must be called before open().
+	 */
+	void reserveExtraField(const QByteArray& id, int length);
+	/// Fills the reserved extra field after close(), \a data is padded with spaces. Requires a seekable target.
+	bool setExtraField(const QByteArray& data);
+
+	/**
+	 * \brief Adds a restart point before the next \a delimiter character written.
+	 * Data written from there on starts a new block. Returns an id to query the point once
+	 * the device is closed.
+	 */
+	int addRestartPoint(char delimiter = '<');
+	RestartPoint restartPoint(int id) const;
+
+	/// Writes the gzip header, only QIODevice::WriteOnly is supported
+	bool open(OpenMode mode) override;
+	/// Compresses remaining data and writes the gzip trailer
+	void close() override;
+	bool isSequential() const override { return true; }
+
+	/// Size of the uncompressed data written so far
+	qint64 uncompressedSize() const { return m_uncompressedSize; }
+	/// Size of the compressed data written to the target so far, without gzip header and trailer
+	qint64 compressedSize() const { return m_compressedSize; }
+	/// Returns true if compressing or writing to the target failed, see errorString()
+	bool hasError() const { return m_failed; }
+
+protected:
+	qint64 readData(char* data, qint64 maxSize) override;
+	qint64 writeData(const char* data, qint64 size) override;
+
+private:
+	struct Block;
+	struct PendingRestartPoint
+	{
+		int id { -1 };
+		char delimiter { '<' };
+	};
+	struct RestartPointData
+	{
+		qint64 offset { -1 };
+		qint64 block { -1 };
+	};
+
+	QIODevice* m_target { nullptr };
+	QThreadPool* m_threadPool { nullptr };
+	int m_compressionLevel { 6 };
+	int m_blockSize { 512 * 1024 };
+	int m_maxBlocksInFlight { 2 };
+
+	QByteArray m_extraFieldId;
+	int m_extraFieldLength { 0 };
+	qint64 m_extraFieldPos { -1 };
+
+	QByteArray m_currentBlock;
+	std::deque< std::shared_ptr<Block> > m_blocksInFlight;
+	qint64 m_blockCount { 0 };
+	QList<qint64> m_blockCompressedOffsets;
+	QList<RestartPointData> m_restartPoints;
+	QList<PendingRestartPoint> m_pendingRestartPoints;
+
+	qint64 m_uncompressedSize { 0 };
+	qint64 m_compressedSize { 0 };
+	quint32 m_crc { 0 };
+	bool m_failed { false };
+
+	void startBlock(bool last);
+	bool writeFinishedBlock();
+	static void compressBlock(Block& block, int compressionLevel);
+};
+
+#endif // PARALLELGZIPDEVICE_H
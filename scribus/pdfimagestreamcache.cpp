@@ -0,0 +1,272 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "pdfimagestreamcache.h"
+#include "scpaths.h"
+#include "scdebug.h"
+
+namespace
+{
+	const quint32 entryMagic = 0x53435049; // "SCPI"
+	// Increase whenever the entry layout changes, or the way images are decoded,
+	// converted, downsampled or encoded before being stored
+	const quint16 entryVersion = 3;
+	const QString entrySuffix = QStringLiteral(".pdfimg");
+
+	const quint32 digestsMagic = 0x53435044; // "SCPD"
+	const quint16 digestsVersion = 1;
+	const QString digestsFileName = QStringLiteral("filedigests.dat");
+	// Digests of files not used for the longest time are dropped beyond this count
+	const int maxFileDigests = 20000;
+}
+
+PdfImageStreamCache & PdfImageStreamCache::instance()
+{
+	static PdfImageStreamCache instance;
+	return instance;
+}
+
+bool PdfImageStreamCache::setMaxCacheSizeMiB(int maxCacheSizeMiB)
+{
+	if (maxCacheSizeMiB < 1)
+		return false;
+	m_maxTotalSize = Q_INT64_C(1048576) * static_cast<qint64>(maxCacheSizeMiB);
+	return true;
+}
+
+void PdfImageStreamCache::initialize()
+{
+	m_initialized = true;
+	if (enabled())
+		cleanupCache();
+}
+
+QString PdfImageStreamCache::entryPath(const QByteArray& key)
+{
+	QString name = QString::fromLatin1(key.toHex());
+	return ScPaths::pdfImageCacheDir() + name.left(2) + "/" + name.mid(2) + entrySuffix;
+}
+
+bool PdfImageStreamCache::contains(const QByteArray& key) const
+{
+	if (!enabled() || key.isEmpty())
+		return false;
+	return QFile::exists(entryPath(key));
+}
+
+bool PdfImageStreamCache::load(const QByteArray& key, Entry& entry)
+{
+	if (!enabled() || key.isEmpty())
+		return false;
+
+	QFile file(entryPath(key));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_6_0);
+	quint32 magic = 0;
+	quint16 version = 0;
+	QByteArray storedKey;
+	ds >> magic >> version;
+	if ((magic != entryMagic) || (version != entryVersion))
+		return false;
+	ds >> storedKey;
+	if (storedKey != key)
+		return false;
+
+	Entry e;
+	ds >> e.colorSpace >> e.realCMYK >> e.progressive >> e.exifOrientation;
+	ds >> e.width >> e.height >> e.origWidth >> e.origHeight >> e.pixelDigest;
+	ds >> e.hasAlpha >> e.alphaCompressed >> e.alpha;
+	ds >> e.outputType >> e.compression >> e.quality >> e.jpegUseOriginal >> e.precalculatedGray;
+	ds >> e.stream;
+	if ((ds.status() != QDataStream::Ok) || e.stream.isEmpty())
+	{
+		scDebug() << "invalid pdf image cache entry" << file.fileName();
+		return false;
+	}
+	entry = e;
+
+	// Entries are evicted oldest first, mark this one as recently used
+	file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+	return true;
+}
+
+bool PdfImageStreamCache::store(const QByteArray& key, const Entry& entry)
+{
+	if (!enabled() || key.isEmpty())
+		return false;
+
+	QString path = entryPath(key);
+	QDir dir = QFileInfo(path).absoluteDir();
+	if (!dir.exists() && !dir.mkpath(dir.absolutePath()))
+		return false;
+
+	// Other Scribus instances may read the same entry, write it atomically
+	QSaveFile file(path);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_6_0);
+	ds << entryMagic << entryVersion << key;
+	ds << entry.colorSpace << entry.realCMYK << entry.progressive << entry.exifOrientation;
+	ds << entry.width << entry.height << entry.origWidth << entry.origHeight << entry.pixelDigest;
+	ds << entry.hasAlpha << entry.alphaCompressed << entry.alpha;
+	ds << entry.outputType << entry.compression << entry.quality << entry.jpegUseOriginal << entry.precalculatedGray;
+	ds << entry.stream;
+	if ((ds.status() != QDataStream::Ok) || !file.commit())
+		return false;
+
+	if (!m_initialized)
+		return true;
+	m_totalCacheSize += QFileInfo(path).size();
+	if (m_totalCacheSize > m_maxTotalSize)
+		cleanupCache();
+	return true;
+}
+
+quint16 PdfImageStreamCache::version()
+{
+	return entryVersion;
+}
+
+QByteArray PdfImageStreamCache::fileDigest(const QString& fileName)
+{
+	QFileInfo info(fileName);
+	if (!info.isFile())
+		return QByteArray();
+	if (!m_fileDigestsLoaded)
+		loadFileDigests();
+
+	FileDigest& fileDigest = m_fileDigests[info.absoluteFilePath()];
+	qint64 size = info.size();
+	qint64 modified = info.lastModified().toMSecsSinceEpoch();
+	fileDigest.lastUsed = QDateTime::currentMSecsSinceEpoch();
+	if (!fileDigest.digest.isEmpty() && (fileDigest.size == size) && (fileDigest.modified == modified))
+		return fileDigest.digest;
+
+	QFile file(fileName);
+	QCryptographicHash fileHash(QCryptographicHash::Sha256);
+	if (!file.open(QIODevice::ReadOnly) || !fileHash.addData(&file))
+	{
+		m_fileDigests.remove(info.absoluteFilePath());
+		return QByteArray();
+	}
+	fileDigest.size = size;
+	fileDigest.modified = modified;
+	fileDigest.digest = fileHash.result();
+	m_fileDigestsChanged = true;
+	return fileDigest.digest;
+}
+
+void PdfImageStreamCache::loadFileDigests()
+{
+	m_fileDigestsLoaded = true;
+	if (!enabled())
+		return;
+
+	QFile file(ScPaths::pdfImageCacheDir() + digestsFileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_6_0);
+	quint32 magic = 0;
+	quint16 version = 0;
+	qint32 count = 0;
+	ds >> magic >> version >> count;
+	if ((magic != digestsMagic) || (version != digestsVersion))
+		return;
+	for (qint32 i = 0; (i < count) && (ds.status() == QDataStream::Ok); ++i)
+	{
+		QString path;
+		FileDigest fileDigest;
+		ds >> path >> fileDigest.size >> fileDigest.modified >> fileDigest.lastUsed >> fileDigest.digest;
+		if (ds.status() == QDataStream::Ok)
+			m_fileDigests.insert(path, fileDigest);
+	}
+}
+
+void PdfImageStreamCache::saveFileDigests()
+{
+	if (!enabled() || !m_fileDigestsChanged)
+		return;
+
+	QList<QString> paths = m_fileDigests.keys();
+	if (paths.count() > maxFileDigests)
+	{
+		std::sort(paths.begin(), paths.end(), [this](const QString& a, const QString& b) {
+			return m_fileDigests.value(a).lastUsed > m_fileDigests.value(b).lastUsed;
+		});
+		for (int i = maxFileDigests; i < paths.count(); ++i)
+			m_fileDigests.remove(paths.at(i));
+		paths.resize(maxFileDigests);
+	}
+
+	QDir dir(ScPaths::pdfImageCacheDir());
+	if (!dir.exists() && !dir.mkpath(dir.absolutePath()))
+		return;
+	QSaveFile file(dir.filePath(digestsFileName));
+	if (!file.open(QIODevice::WriteOnly))
+		return;
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_6_0);
+	ds << digestsMagic << digestsVersion << static_cast<qint32>(paths.count());
+	for (const QString& path : std::as_const(paths))
+	{
+		const FileDigest& fileDigest = m_fileDigests[path];
+		ds << path << fileDigest.size << fileDigest.modified << fileDigest.lastUsed << fileDigest.digest;
+	}
+	if ((ds.status() == QDataStream::Ok) && file.commit())
+		m_fileDigestsChanged = false;
+}
+
+void PdfImageStreamCache::cleanupCache()
+{
+	struct CacheFile
+	{
+		QDateTime lastModified;
+		QString path;
+		qint64 size;
+	};
+	std::vector<CacheFile> files;
+
+	m_totalCacheSize = 0;
+	QDirIterator it(ScPaths::pdfImageCacheDir(), QStringList() << "*" + entrySuffix, QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext())
+	{
+		it.next();
+		QFileInfo info = it.fileInfo();
+		files.push_back({ info.lastModified(), info.filePath(), info.size() });
+		m_totalCacheSize += info.size();
+	}
+	if (m_totalCacheSize <= m_maxTotalSize)
+		return;
+
+	scDebug() << "pdf image cache size:" << m_totalCacheSize << "/ max:" << m_maxTotalSize;
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.lastModified < b.lastModified; });
+	for (const CacheFile& file : files)
+	{
+		if (m_totalCacheSize <= m_maxTotalSize)
+			break;
+		if (QFile::remove(file.path))
+			m_totalCacheSize -= file.size;
+	}
+}
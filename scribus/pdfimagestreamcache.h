@@ -0,0 +1,153 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef PDFIMAGESTREAMCACHE_H
+#define PDFIMAGESTREAMCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include "scribusapi.h"
+
+/**
+  * @brief Persistent cache of encoded image streams written by PDF export
+  *
+  * Each entry holds the final, unencrypted stream of an image XObject along with
+  * the image properties PDF export needs to write its dictionary, so that a later
+  * export of an unchanged image skips decoding, color conversion, downsampling and
+  * encoding. Entries are stored below ScPaths::pdfImageCacheDir(), one file per key.
+  * Keys are computed by the caller from the source file content, every export
+  * setting affecting the stream and version(). The cache follows the image cache
+  * preferences: it is enabled with the image cache and uses the same size limit.
+  *
+  * The cache also remembers digests of source files along with their size and
+  * modification time, so that files are only read again when one of them changed.
+  */
+class SCRIBUS_API PdfImageStreamCache
+{
+public:
+	struct Entry
+	{
+		// Properties of the decoded image
+		int  colorSpace { 0 };
+		bool realCMYK { false };
+		bool progressive { false };
+		int  exifOrientation { 1 };
+		int  width { 0 };
+		int  height { 0 };
+		int  origWidth { 0 };
+		int  origHeight { 0 };
+		QByteArray pixelDigest;
+
+		// Mask data as written to the PDF file
+		bool hasAlpha { false };
+		bool alphaCompressed { false };
+		QByteArray alpha;
+
+		// Settings the stream was encoded with
+		int  outputType { 0 };
+		int  compression { 0 };
+		int  quality { 0 };
+		bool jpegUseOriginal { false };
+		bool precalculatedGray { false };
+		QByteArray stream;
+	};
+
+	/**
+	* @brief Get cache instance
+	* @return Reference to the singleton instance
+	*/
+	static PdfImageStreamCache & instance();
+
+	/**
+	* @brief Enable/disable the cache
+	* @param enableCache \c true if the cache should be enabled
+	*/
+	void setEnabled(bool enableCache) { m_isEnabled = enableCache; }
+	/**
+	* @brief Check if the cache is enabled
+	* @return \c true if the cache is enabled, \c false otherwise
+	*/
+	bool enabled() const { return m_isEnabled; }
+	/**
+	* @brief Set cache size limit
+	* @param maxCacheSizeMiB Maximum cache size in MiB.
+	* @return \c true if the cache size limit could be set, \c false otherwise
+	*/
+	bool setMaxCacheSizeMiB(int maxCacheSizeMiB);
+
+	/**
+	* @brief Initialize the cache, removes oldest entries above the size limit
+	*/
+	void initialize();
+
+	/**
+	* @brief Check if an entry exists for a key
+	* @param key Hash identifying the entry
+	*/
+	bool contains(const QByteArray& key) const;
+	/**
+	* @brief Read an entry
+	* @param key Hash identifying the entry
+	* @param entry Receives the entry data
+	* @return \c true if a valid entry was found, \c false otherwise
+	*/
+	bool load(const QByteArray& key, Entry& entry);
+	/**
+	* @brief Write an entry, replacing any existing entry for the same key
+	* @param key Hash identifying the entry
+	* @param entry Entry data
+	* @return \c true if the entry could be written, \c false otherwise
+	*/
+	bool store(const QByteArray& key, const Entry& entry);
+
+	/**
+	* @brief Version of the entries and of the image processing producing their streams
+	* @return Value to include in every key, so that entries of another version are not used
+	*/
+	static quint16 version();
+	/**
+	* @brief Get the SHA-256 digest of the content of a file
+	* The file is only read if its size or modification time differs from the last time
+	* its digest was computed, by this or by an earlier session.
+	* @param fileName Path of the file
+	* @return The digest, an empty array if the file cannot be read
+	*/
+	QByteArray fileDigest(const QString& fileName);
+	/**
+	* @brief Write digests of source files computed during this session to the cache directory
+	*/
+	void saveFileDigests();
+
+private:
+	PdfImageStreamCache() = default;
+	~PdfImageStreamCache() = default;
+
+	static QString entryPath(const QByteArray& key);
+
+	void cleanupCache();
+	void loadFileDigests();
+
+	bool m_isEnabled { false };
+	bool m_initialized { false };
+	qint64 m_maxTotalSize { Q_INT64_C(1048576) * 1000 };
+	qint64 m_totalCacheSize { 0 };
+
+	struct FileDigest
+	{
+		qint64 size { -1 };
+		qint64 modified { 0 };
+		qint64 lastUsed { 0 };
+		QByteArray digest;
+	};
+	QHash<QString, FileDigest> m_fileDigests;
+	bool m_fileDigestsLoaded { false };
+	bool m_fileDigestsChanged { false };
+};
+
+#endif
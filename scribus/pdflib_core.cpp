@@ -53,10 +53,12 @@ for which a new license (GPL+exception) is in place.
 #include <QRect>
 #include <QRegularExpression>
 #include <QScopedPointer>
+#include <QSemaphore>
 #include <QStack>
 #include <QString>
 #include <QTemporaryFile>
 #include <QTextCodec>
+#include <QThreadPool>
 #include <QUuid>
 
 #include "cmsettings.h"
@@ -65,11 +67,13 @@ for which a new license (GPL+exception) is in place.
 #include "pageitem_textframe.h"
 #include "pageitem_group.h"
 #include "pageitem_table.h"
+#include "pdfimagestreamcache.h"
 #include "pdfoptions.h"
 #include "prefsmanager.h"
 #include "sccolor.h"
 #include "sccolorengine.h"
 #include "scfonts.h"
+#include "scimage.h"
 #include "text/textlayoutpainter.h"
 #include "fonts/cff.h"
 #include "fonts/sfnt.h"
@@ -77,6 +81,7 @@ for which a new license (GPL+exception) is in place.
 #include "scpaths.h"
 #include "scpattern.h"
 
+#include "scribus.h"
 #include "scribuscore.h"
 #include "scribusdoc.h"
 #include "scstreamfilter_flate.h"
@@ -91,8 +96,6 @@ for which a new license (GPL+exception) is in place.
 	#include "third_party/prc/exportPRC.h"
 #endif
 
-#include "ui/bookmwin.h"
-#include "ui/bookmarkpalette.h"
 #include "ui/multiprogressdialog.h"
 
 using namespace std;
@@ -561,6 +564,43 @@ public:
 	void drawObjectDecoration(PageItem* item) override { }
 };
 
+struct PDFLibCore::PdfRasterJob
+{
+	PdfRasterJob(ScribusDoc* doc, const QString& fileName, const QString& profile, eRenderIntent intent) :
+		fileName(fileName),
+		profile(profile),
+		intent(intent),
+		cmSettings(doc, profile, intent)
+	{ }
+
+	int page { 0 };
+	const QString fileName;
+	const QString profile;
+	const eRenderIntent intent;
+	bool embedded { false };
+	CMSettings cmSettings;
+	ScImage::RequestType requestType { ScImage::RGBData };
+	int imagePage { 0 };
+	QMap<int, ImageLoadRequest> requestProps;
+	bool isRequest { false };
+	bool loadAlpha { true };
+	double scaleX { 1.0 };
+	double scaleY { 1.0 };
+	ScImageEffectList effects;
+	ColorList colors;
+
+	// Results of PDF_RunRasterJob()
+	ScImage image;
+	QByteArray alpha;
+	bool imageLoaded { false };
+	bool alphaLoaded { false };
+	bool realCMYK { false };
+	int origWidth { 1 };
+	int origHeight { 1 };
+
+	QSemaphore finished;
+};
+
 PDFLibCore::PDFLibCore(ScribusDoc & docu)
 	: PDFLibCore(docu, docu.pdfOptions())
 {
@@ -598,6 +638,7 @@ PDFLibCore::PDFLibCore(ScribusDoc & docu, const PDFOptions& options)
 
 PDFLibCore::~PDFLibCore()
 {
+	PDF_End_ImagePrefetch();
 	delete progressDialog;
 }
 
@@ -650,7 +691,14 @@ bool PDFLibCore::doExport(const QString& fn, const std::vector<int> & pageNs, co
 		return false;
 	}
 
-	if (PDF_Begin_Doc(fn, doc.scMW()->bookmarkPalette->BView))
+	// Images of large documents are loaded on demand, export needs all of them
+	doc.imageLoadScheduler()->loadAll();
+
+	// Outlines are built from the bookmarks of the document, the bookmark palette of
+	// documents shown in the GUI may hold changes made since they were loaded or saved
+	if (doc.hasGUI() && doc.scMW() && (doc.scMW()->doc == &doc))
+		doc.scMW()->StoreBookmarks();
+	if (PDF_Begin_Doc(fn))
 	{
 		QMap<int, int> pageNsMpa;
 		for (uint a = 0; a < pageNs.size(); ++a)
@@ -666,15 +714,33 @@ bool PDFLibCore::doExport(const QString& fn, const std::vector<int> & pageNs, co
 			progressDialog->setProgress("EMP", 0);
 			progressDialog->setProgress("EP", 0);
 		}
+		// Pages in the order they are exported, images they contain get decoded
+		// on worker threads while preceding pages are being written
+		QList<const ScPage*> exportedPages;
+		if (doc.MasterItems.count() != 0)
+		{
+			for (int ap = 0; ap < doc.MasterPages.count(); ++ap)
+			{
+				if (pageNsMpa.contains(ap))
+					exportedPages.append(doc.MasterPages.at(ap));
+			}
+		}
+		for (uint a = 0; a < pageNs.size(); ++a)
+			exportedPages.append(doc.DocPages.at(pageNs[a] - 1));
+		PDF_Begin_ImagePrefetch(exportedPages);
+		int exportedPage = 0;
 		for (int ap = 0; ap < doc.MasterPages.count() && !abortExport; ++ap)
 		{
 			if (doc.MasterItems.count() != 0)
 			{
 				if (pageNsMpa.contains(ap))
 				{
-					QApplication::processEvents();
+					PDF_PrefetchImages(exportedPage);
+					if (usingGUI)
+						QApplication::processEvents();
 					if (!PDF_TemplatePage(doc.MasterPages.at(ap)))
 						error = abortExport = true;
+					PDF_ReleasePrefetchedImages(exportedPage++);
 					++pc_exportmasterpages;
 				}
 			}
@@ -688,19 +754,24 @@ bool PDFLibCore::doExport(const QString& fn, const std::vector<int> & pageNs, co
 		{
 			if (Options.Thumbnails)
 				thumb = thumbs[pageNs[a]];
-			QApplication::processEvents();
+			PDF_PrefetchImages(exportedPage);
+			if (usingGUI)
+				QApplication::processEvents();
 			if (abortExport) break;
 
 			PDF_Begin_Page(doc.DocPages.at(pageNs[a]-1), thumb);
-			QApplication::processEvents();
+			if (usingGUI)
+				QApplication::processEvents();
 			if (abortExport) break;
 
 			if (!PDF_ProcessPage(doc.DocPages.at(pageNs[a]-1), pageNs[a]-1, Options.doClip))
 				error = abortExport = true;
-			QApplication::processEvents();
+			if (usingGUI)
+				QApplication::processEvents();
 			if (abortExport) break;
 
 			PDF_End_Page();
+			PDF_ReleasePrefetchedImages(exportedPage++);
 			pc_exportpages++;
 			if (usingGUI)
 			{
@@ -708,6 +779,7 @@ bool PDFLibCore::doExport(const QString& fn, const std::vector<int> & pageNs, co
 				progressDialog->setOverallProgress(pc_exportmasterpages+pc_exportpages);
 			}
 		}
+		PDF_End_ImagePrefetch();
 		ret = true;//Even when aborting we return true. Don't want that "couldn't write msg"
 		if (!abortExport)
 		{
@@ -948,13 +1020,12 @@ int PDFLibCore::WriteFlateImageToStream(const ScImage& image, PdfId ObjNum, Colo
 	return (succeed ? bytesWritten : 0);
 }
 
-bool PDFLibCore::PDF_Begin_Doc(const QString& fn, BookmarkView* vi)
+bool PDFLibCore::PDF_Begin_Doc(const QString& fn)
 {
 	if (!writer.open(fn))
 		return false;
 	
 	inPattern = 0;
-	Bvie = vi;
 	BookMinUse = false;
 	UsedFontsP.clear();
 	UsedFontsF.clear();
@@ -9801,8 +9872,15 @@ void PDFLibCore::PDF_Form(const QByteArray& im) // unused? - av
 
 void PDFLibCore::PDF_Bookmark(const PageItem *currItem, double ypos)
 {
-	Bvie->setAction(currItem, "/XYZ 0 " + FToStr(ypos) + " 0");
-	BookMinUse = true;
+	for (ScribusDoc::BookMa& bookmark : doc.BookMarks)
+	{
+		if (bookmark.PageObject == currItem)
+		{
+			bookmark.Action = "/XYZ 0 " + FToStr(ypos) + " 0";
+			BookMinUse = true;
+			break;
+		}
+	}
 }
 
 bool PDFLibCore::PDF_EmbeddedPDF(PageItem* c, const QString& fn, double sx, double sy, double x, double y, ShIm& imgInfo, bool &fatalError)
@@ -10590,6 +10668,346 @@ static ColorSpaceEnum getOutputType(const bool gray, const bool cmyk)
 	return ColorSpaceRGB;
 }
 
+static QByteArray imageDigest(const QImage& image)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha256);
+	QByteArray header;
+	QDataStream ds(&header, QIODevice::WriteOnly);
+	ds << image.width() << image.height() << static_cast<int>(image.format());
+	hash.addData(header);
+	const qsizetype lineLength = (static_cast<qsizetype>(image.width()) * image.depth() + 7) / 8;
+	for (int i = 0; i < image.height(); ++i)
+	{
+		QByteArrayView lineView(image.constScanLine(i), lineLength);
+		hash.addData(lineView);
+	}
+	return hash.result();
+}
+
+void PDFLibCore::PDF_Begin_ImagePrefetch(const QList<const ScPage*>& pages)
+{
+	PDF_End_ImagePrefetch();
+	if (QThreadPool::globalInstance()->maxThreadCount() < 2)
+		return;
+
+	// Items showing the same image with the same settings end up in one shared XObject,
+	// queue only the first of them
+	QMultiHash<QString, const PageItem*> queuedImages;
+	for (int i = 0; i < pages.count(); ++i)
+	{
+		const ScPage* page = pages.at(i);
+		const QList<PageItem*>& items = page->pageNameEmpty() ? doc.DocItems : doc.MasterItems;
+		double bLeft, bRight, bBottom, bTop;
+		getBleeds(page, bLeft, bRight, bBottom, bTop);
+		QRectF pageRect(page->xOffset() - bLeft, page->yOffset() - bTop, page->width() + bLeft + bRight, page->height() + bBottom + bTop);
+		for (PageItem* item : items)
+		{
+			double ilw = item->visualLineWidth();
+			QRectF itemRect(item->BoundingX - ilw / 2.0, item->BoundingY - ilw / 2.0, item->BoundingW + ilw, item->BoundingH + ilw);
+			if (!item->printEnabled() || !itemRect.intersects(pageRect))
+				continue;
+			QList<PageItem*> imageItems = item->getAllChildren();
+			imageItems.prepend(item);
+			for (PageItem* imageItem : std::as_const(imageItems))
+			{
+				if (!PDF_IsRasterImage(imageItem, imageItem->Pfile))
+					continue;
+				bool queued = false;
+				for (auto it = queuedImages.constFind(imageItem->Pfile); (it != queuedImages.constEnd()) && (it.key() == imageItem->Pfile) && !queued; ++it)
+				{
+					const PageItem* other = it.value();
+					queued = (other->pixm.imgInfo.actualPageNumber == imageItem->pixm.imgInfo.actualPageNumber)
+					      && (other->imageXScale() == imageItem->imageXScale()) && (other->imageYScale() == imageItem->imageYScale())
+					      && (other->UseEmbedded == imageItem->UseEmbedded) && (other->ImageProfile == imageItem->ImageProfile)
+					      && (other->ImageIntent == imageItem->ImageIntent) && (other->effectsInUse == imageItem->effectsInUse)
+					      && (other->pixm.imgInfo.RequestProps == imageItem->pixm.imgInfo.RequestProps);
+				}
+				if (queued)
+					continue;
+				queuedImages.insert(imageItem->Pfile, imageItem);
+				rasterQueue.append(qMakePair(i, imageItem));
+			}
+		}
+	}
+}
+
+void PDFLibCore::PDF_PrefetchImages(int currentPage)
+{
+	rasterPage = currentPage;
+
+	QThreadPool* threadPool = QThreadPool::globalInstance();
+	// Decoded images are kept until their page is written, bound their number
+	const int maxJobsInFlight = qMax(2, 2 * threadPool->maxThreadCount());
+	while ((rasterQueuePos < rasterQueue.count()) && (rasterJobs.count() < maxJobsInFlight))
+	{
+		const QPair<int, PageItem*>& queued = rasterQueue.at(rasterQueuePos++);
+		if (queued.first < currentPage)
+			continue;
+		PageItem* item = queued.second;
+		// Images whose encoded stream is cached need no decoding
+		QByteArray sourceKey = PDF_ImageSourceKey(item, item->Pfile, item->ImageProfile, item->UseEmbedded, item->ImageIntent);
+		if (PdfImageStreamCache::instance().contains(PDF_ImageStreamCacheKey(item, sourceKey)))
+			continue;
+		std::shared_ptr<PdfRasterJob> job = PDF_CreateRasterJob(item, item->Pfile, item->ImageProfile, item->UseEmbedded, item->ImageIntent);
+		job->page = queued.first;
+		rasterJobs.insert(item, job);
+		threadPool->start([this, job]() {
+			PDF_RunRasterJob(*job);
+			job->finished.release();
+		});
+	}
+}
+
+void PDFLibCore::PDF_ReleasePrefetchedImages(int page)
+{
+	for (auto it = rasterJobs.begin(); it != rasterJobs.end(); )
+	{
+		if (it.value()->page > page)
+		{
+			++it;
+			continue;
+		}
+		it.value()->finished.acquire();
+		it = rasterJobs.erase(it);
+	}
+}
+
+void PDFLibCore::PDF_End_ImagePrefetch()
+{
+	for (auto it = rasterJobs.begin(); it != rasterJobs.end(); ++it)
+		it.value()->finished.acquire();
+	rasterJobs.clear();
+	rasterQueue.clear();
+	rasterQueuePos = 0;
+	rasterPage = 0;
+}
+
+bool PDFLibCore::PDF_IsRasterImage(const PageItem* item, const QString& fn) const
+{
+	if (!item->isImageFrame() || item->isLatexFrame() || !item->imageIsAvailable || fn.isEmpty())
+		return false;
+	QFileInfo fi(fn);
+	QString ext = fi.suffix().toLower();
+	if (ext.isEmpty())
+		ext = getImageType(fn);
+	// PDF and PostScript files are embedded or rendered by Ghostscript instead
+	return !((extensionIndicatesPDF(ext) || extensionIndicatesEPSorPS(ext)) && (item->pixm.imgInfo.type != ImageType7));
+}
+
+std::shared_ptr<PDFLibCore::PdfRasterJob> PDFLibCore::PDF_CreateRasterJob(PageItem* item, const QString& fn, const QString& Profil, bool Embedded, eRenderIntent Intent) const
+{
+	auto job = std::make_shared<PdfRasterJob>(&doc, fn, Profil, Intent);
+	job->embedded = Embedded;
+	job->cmSettings.setUseEmbeddedProfile(Embedded);
+	if (Options.UseRGB)
+		job->requestType = ScImage::RGBData;
+	else if ((doc.HasCMS) && (Options.UseProfiles2))
+		job->requestType = ScImage::RawData;
+	else if (Options.isGrayscale)
+		job->requestType = ScImage::RGBData;
+	else
+		job->requestType = ScImage::CMYKData;
+	job->imagePage = item->pixm.imgInfo.actualPageNumber;
+	job->requestProps = item->pixm.imgInfo.RequestProps;
+	job->isRequest = item->pixm.imgInfo.isRequest;
+	job->loadAlpha = (item->pixm.imgInfo.type != ImageType7);
+	job->scaleX = item->imageXScale();
+	job->scaleY = item->imageYScale();
+	job->effects = item->effectsInUse;
+	// ScImage::applyEffect() may insert into the list it is given, use a private copy
+	job->colors = doc.PageColors;
+	return job;
+}
+
+std::shared_ptr<PDFLibCore::PdfRasterJob> PDFLibCore::PDF_TakeRasterJob(const PageItem* item, const QString& fn, const QString& Profil, bool Embedded, eRenderIntent Intent)
+{
+	auto it = rasterJobs.find(item);
+	if (it == rasterJobs.end())
+		return nullptr;
+	std::shared_ptr<PdfRasterJob> job = it.value();
+	// Item may request other images, e.g. for button icons
+	if ((job->fileName != fn) || (job->profile != Profil) || (job->embedded != Embedded) || (job->intent != Intent))
+		return nullptr;
+	if ((job->scaleX != item->imageXScale()) || (job->scaleY != item->imageYScale()))
+		return nullptr;
+	rasterJobs.erase(it);
+	job->finished.acquire();
+	PDF_PrefetchImages(rasterPage);
+	return job;
+}
+
+void PDFLibCore::PDF_RunRasterJob(PdfRasterJob& job) const
+{
+	// Keep in sync with PDF_Image(), results must not depend on the thread this runs on
+	ScImage& img = job.image;
+	img.imgInfo.valid = false;
+	img.imgInfo.clipPath.clear();
+	img.imgInfo.PDSpathData.clear();
+	img.imgInfo.layerInfo.clear();
+	img.imgInfo.RequestProps = job.requestProps;
+	img.imgInfo.isRequest = job.isRequest;
+	job.imageLoaded = img.loadPicture(job.fileName, job.imagePage, job.cmSettings, job.requestType, 72, &job.realCMYK);
+	if (!job.imageLoaded)
+		return;
+	if ((Options.RecalcPic) && (Options.PicRes < (qMax(72.0 / job.scaleX, 72.0 / job.scaleY))))
+	{
+		double afl = Options.PicRes;
+		double a2 = (72.0 / job.scaleX) / afl;
+		double a1 = (72.0 / job.scaleY) / afl;
+		double ax = img.width() / a2;
+		double ay = img.height() / a1;
+		// #10510 : do not use scaled() here, may cause display problem
+		// with acrobat reader if image contains some transparency
+		img.scaleImage(qRound(ax), qRound(ay), ScImage::ScaleFilter::Box);
+	}
+
+	job.alphaLoaded = true;
+	if (job.loadAlpha)
+	{
+		ScImage img2;
+		img2.imgInfo.clipPath.clear();
+		img2.imgInfo.PDSpathData.clear();
+		img2.imgInfo.layerInfo.clear();
+		img2.imgInfo.RequestProps = job.requestProps;
+		img2.imgInfo.isRequest = job.isRequest;
+		job.alphaLoaded = img2.getAlpha(job.fileName, job.imagePage, job.alpha, true, Options.supportsTransparency(), Options.Resolution, img.width(), img.height());
+		if (!job.alphaLoaded)
+			return;
+	}
+
+	bool imgE = false;
+	if ((Options.UseRGB) || (Options.isGrayscale))
+		imgE = false;
+	else
+		imgE = !((Options.UseProfiles2) && (img.imgInfo.colorspace != ColorSpaceCMYK));
+	job.origWidth = img.width();
+	job.origHeight = img.height();
+	img.applyEffect(job.effects, job.colors, imgE);
+}
+
+// Digest of the content of the color profile \a name, empty if it is not installed
+static QByteArray profileDigest(const QString& name)
+{
+	if (name.isEmpty())
+		return QByteArray();
+	for (const ScProfileInfoMap* profiles : { &ScCore->InputProfiles, &ScCore->InputProfilesCMYK, &ScCore->PrinterProfiles })
+	{
+		auto profileIt = profiles->constFind(name);
+		if (profileIt != profiles->constEnd())
+			return PdfImageStreamCache::instance().fileDigest(profileIt->file);
+	}
+	return QByteArray();
+}
+
+QByteArray PDFLibCore::PDF_ImageSourceKey(const PageItem* item, const QString& fn, const QString& Profil, bool Embedded, eRenderIntent Intent)
+{
+	// Files are only read again if their size or modification time changed
+	QByteArray fileDigest = PdfImageStreamCache::instance().fileDigest(fn);
+	if (fileDigest.isEmpty())
+		return QByteArray();
+
+	// Everything besides the file content which PDF_Image() uses to produce the image stream
+	QByteArray parameters;
+	QDataStream ds(&parameters, QIODevice::WriteOnly);
+	ds << fileDigest << QFileInfo(fn).suffix().toLower();
+	ds << item->pixm.imgInfo.actualPageNumber << static_cast<int>(item->pixm.imgInfo.type);
+	ds << Profil << profileDigest(Profil) << Embedded << static_cast<int>(Intent);
+	ds << item->pixm.imgInfo.isRequest;
+	for (auto it = item->pixm.imgInfo.RequestProps.constBegin(); it != item->pixm.imgInfo.RequestProps.constEnd(); ++it)
+		ds << it.key() << it->visible << it->useMask << it->opacity << it->blend;
+	ds << static_cast<int>(item->effectsInUse.count());
+	for (const ImageEffect& effect : item->effectsInUse)
+		ds << static_cast<int>(effect.effectCode) << effect.effectParameters;
+	bool downsampled = (Options.RecalcPic) && (Options.PicRes < (qMax(72.0 / item->imageXScale(), 72.0 / item->imageYScale())));
+	ds << downsampled;
+	if (downsampled)
+		ds << item->imageXScale() << item->imageYScale();
+	ds << item->OverrideCompressionMethod << item->CompressionMethodIndex;
+	ds << item->OverrideCompressionQuality << item->CompressionQualityIndex;
+	return QCryptographicHash::hash(parameters, QCryptographicHash::Sha256);
+}
+
+QByteArray PDFLibCore::PDF_ImageStreamCacheKey(const PageItem* item, const QByteArray& sourceKey) const
+{
+	if (sourceKey.isEmpty() || !PdfImageStreamCache::instance().enabled())
+		return QByteArray();
+	// Color effects refer to document colors, which are not part of the source key
+	if (item->effectsInUse.useColorEffect())
+		return QByteArray();
+
+	QByteArray parameters;
+	QDataStream ds(&parameters, QIODevice::WriteOnly);
+	ds << PdfImageStreamCache::version() << sourceKey;
+	ds << Options.UseRGB << Options.UseProfiles2 << Options.isGrayscale;
+	ds << Options.RecalcPic << Options.PicRes << Options.Resolution;
+	ds << Options.supportsTransparency() << static_cast<int>(Options.CompressMethod) << Options.Quality;
+	ds << Options.EmbeddedI << Options.ImageProf << Options.PrintProf;
+	ds << profileDigest(Options.ImageProf) << profileDigest(Options.PrintProf);
+	ds << static_cast<int>(static_cast<PDFVersion::Version>(Options.Version));
+	// Color management state images are loaded and converted with
+	ds << doc.HasCMS;
+	if (doc.HasCMS)
+	{
+		const CMSData& cms = doc.cmsSettings();
+		ds << doc.colorEngine.engineID() << doc.colorEngine.description();
+		ds << cms.DefaultImageRGBProfile << profileDigest(cms.DefaultImageRGBProfile);
+		ds << cms.DefaultImageCMYKProfile << profileDigest(cms.DefaultImageCMYKProfile);
+		ds << cms.DefaultPrinterProfile << profileDigest(cms.DefaultPrinterProfile);
+		ds << static_cast<int>(cms.DefaultIntentImages) << cms.BlackPoint;
+	}
+	return QCryptographicHash::hash(parameters, QCryptographicHash::Sha256);
+}
+
+QByteArray PDFLibCore::PDF_EncodeImageStream(ScImage& image, const QString& fn, PDFOptions::PDFCompression compression, int quality, ColorSpaceEnum format, bool jpegUseOriginal, bool precal)
+{
+	// Same encoding as WriteJPEGImageToStream(), WriteFlateImageToStream() and WriteImageToStream(), without encryption
+	QByteArray data;
+	if (compression == PDFOptions::Compression_JPEG)
+	{
+		QString ext = QFileInfo(fn).suffix().toLower();
+		QString jpgFileName, tmpFile;
+		if (extensionIndicatesJPEG(ext) && jpegUseOriginal)
+			jpgFileName = fn;
+		else
+		{
+			tmpFile  = QDir::toNativeSeparators(ScPaths::tempFileDir() + "sc.jpg");
+			if (format == ColorSpaceGray && (!precal))
+				image.convertToGray();
+			if (image.convert2JPG(tmpFile, quality, format == ColorSpaceCMYK, format == ColorSpaceGray))
+				jpgFileName = tmpFile;
+		}
+		if (!jpgFileName.isEmpty() && !loadRawBytes(jpgFileName, data))
+			data.clear();
+		if (!tmpFile.isEmpty() && QFile::exists(tmpFile))
+			QFile::remove(tmpFile);
+		return data;
+	}
+
+	QDataStream ds(&data, QIODevice::WriteOnly);
+	ScNullEncodeFilter nullEncode(&ds);
+	ScFlateEncodeFilter flateEncode(&ds);
+	ScStreamFilter* filter = &nullEncode;
+	if (compression == PDFOptions::Compression_ZIP)
+		filter = &flateEncode;
+	if (!filter->openFilter())
+		return QByteArray();
+	bool fromCmyk, succeed = false;
+	switch (format)
+	{
+		case ColorSpaceMonochrome :
+			fromCmyk = !Options.UseRGB && !Options.isGrayscale && !(doc.HasCMS && Options.UseProfiles2);
+			succeed = image.writeMonochromeDataToFilter(filter, fromCmyk); break;
+		case ColorSpaceGray :
+			succeed = image.writeGrayDataToFilter(filter, precal); break;
+		case ColorSpaceCMYK :
+			succeed = image.writeCMYKDataToFilter(filter); break;
+		default :
+			succeed = image.writeRGBDataToFilter(filter); break;
+	}
+	succeed &= filter->closeFilter();
+	return (succeed ? data : QByteArray());
+}
+
 /**
  * Add the image item to this.output
  * Returns false if the image can't be read or if it can't be added to this.output
@@ -10628,13 +11046,30 @@ bool PDFLibCore::PDF_Image(PageItem* item, const QString& fn, double sx, double
 	ImInfo.imageEffects = item->effectsInUse;
 	ImInfo.RequestProps = item->pixm.imgInfo.RequestProps;
 
-	auto sharedImageIt = SharedImages.findSuitable(fn, ImInfo);
-	if ((!SharedImages.containsSuitable(fn, ImInfo))
-		|| fromAN
-		|| item->isLatexFrame())
+	// The same image file may also be used under another path
+	const ShIm* sharedImage = nullptr;
+	QByteArray sourceKey;
+	if (!fromAN && !item->isLatexFrame())
+	{
+		auto sharedImageIt = SharedImages.findSuitable(fn, ImInfo);
+		if (sharedImageIt != SharedImages.end())
+			sharedImage = &(*sharedImageIt);
+		else if (PDF_IsRasterImage(item, fn))
+		{
+			sourceKey = PDF_ImageSourceKey(item, fn, Profil, Embedded, Intent);
+			auto sourceImageIt = SourceImages.constFind(sourceKey);
+			if (!sourceKey.isEmpty() && (sourceImageIt != SourceImages.constEnd()))
+				sharedImage = &(*sourceImageIt);
+		}
+	}
+	if (!sharedImage)
 	{
 		bool imageLoaded = false;
 		bool fatalError  = false;
+		std::shared_ptr<PdfRasterJob> rasterJob;
+		QByteArray streamCacheKey = PDF_ImageStreamCacheKey(item, sourceKey);
+		PdfImageStreamCache::Entry cachedImage;
+		bool fromStreamCache = !streamCacheKey.isEmpty() && PdfImageStreamCache::instance().load(streamCacheKey, cachedImage);
 		QString pdfFile = fn;
 		if ((extensionIndicatesPDF(ext) || ((extensionIndicatesEPSorPS(ext)) && (item->pixm.imgInfo.type != ImageType7))) && item->effectsInUse.isEmpty())
 		{
@@ -10770,50 +11205,43 @@ bool PDFLibCore::PDF_Image(PageItem* item, const QString& fn, double sx, double
 			// not PS/PDF
 			else
 			{
-				img.imgInfo.valid = false;
-				img.imgInfo.clipPath.clear();
-				img.imgInfo.PDSpathData.clear();
-				img.imgInfo.layerInfo.clear();
-				img.imgInfo.RequestProps = item->pixm.imgInfo.RequestProps;
-				img.imgInfo.isRequest = item->pixm.imgInfo.isRequest;
-				CMSettings cms(item->doc(), Profil, Intent);
-				cms.setUseEmbeddedProfile(Embedded);
-				if (Options.UseRGB)
-					imageLoaded = img.loadPicture(fn, item->pixm.imgInfo.actualPageNumber, cms, ScImage::RGBData, 72, &realCMYK);
+				if (fromStreamCache)
+				{
+					// Only the properties of the image are needed, its stream comes from the cache
+					realCMYK = cachedImage.realCMYK;
+					img.imgInfo.colorspace = static_cast<ColorSpaceEnum>(cachedImage.colorSpace);
+					img.imgInfo.progressive = cachedImage.progressive;
+					img.imgInfo.exifInfo.orientation = cachedImage.exifOrientation;
+				}
 				else
 				{
-					if ((doc.HasCMS) && (Options.UseProfiles2))
-						imageLoaded = img.loadPicture(fn, item->pixm.imgInfo.actualPageNumber, cms, ScImage::RawData, 72, &realCMYK);
-					else
+					// Decoding, downsampling, alpha mask and effects, possibly done ahead of time on a worker thread
+					rasterJob = PDF_TakeRasterJob(item, fn, Profil, Embedded, Intent);
+					if (!rasterJob)
 					{
-						if (Options.isGrayscale)
-							imageLoaded = img.loadPicture(fn, item->pixm.imgInfo.actualPageNumber, cms, ScImage::RGBData, 72, &realCMYK);
-						else
-							imageLoaded = img.loadPicture(fn, item->pixm.imgInfo.actualPageNumber, cms, ScImage::CMYKData, 72, &realCMYK);
+						rasterJob = PDF_CreateRasterJob(item, fn, Profil, Embedded, Intent);
+						PDF_RunRasterJob(*rasterJob);
 					}
-				}
-				if (!imageLoaded)
-				{
-					PDF_Error_ImageLoadFailure(fn);
-					return false;
+					if (!rasterJob->imageLoaded)
+					{
+						PDF_Error_ImageLoadFailure(fn);
+						return false;
+					}
+					realCMYK = rasterJob->realCMYK;
+					img = rasterJob->image;
 				}
 				if ((Options.RecalcPic) && (Options.PicRes < (qMax(72.0 / item->imageXScale(), 72.0 / item->imageYScale()))))
 				{
 					double afl = Options.PicRes;
 					double a2 = (72.0 / sx) / afl;
 					double a1 = (72.0 / sy) / afl;
-					origWidth = img.width();
-					origHeight = img.height();
-					double ax = img.width() / a2;
-					double ay = img.height() / a1;
-					// #10510 : do not use scaled() here, may cause display problem 
-					// with acrobat reader if image contains some transparency
-					img.scaleImage(qRound(ax), qRound(ay));
 					ImInfo.sxa = sx * a2;
 					ImInfo.sya = sy * a1;
 				}
 				ImInfo.reso = 1;
 			}
+			int imageWidth = fromStreamCache ? cachedImage.width : img.width();
+			int imageHeight = fromStreamCache ? cachedImage.height : img.height();
 			bool hasColorEffect = item->effectsInUse.useColorEffect();
 			if ((doc.HasCMS) && (Options.UseProfiles2))
 			{
@@ -10953,84 +11381,73 @@ bool PDFLibCore::PDF_Image(PageItem* item, const QString& fn, double sx, double
 				}
 			}
 			QByteArray im2;
-			ScImage img2;
-			img2.imgInfo.clipPath.clear();
-			img2.imgInfo.PDSpathData.clear();
-			img2.imgInfo.layerInfo.clear();
-			img2.imgInfo.RequestProps = item->pixm.imgInfo.RequestProps;
-			img2.imgInfo.isRequest = item->pixm.imgInfo.isRequest;
-			if (item->pixm.imgInfo.type == ImageType7)
-				alphaM = false;
-			else
+			bool compAlphaAvail = false;
+			if (fromStreamCache)
+			{
+				im2 = cachedImage.alpha;
+				alphaM = cachedImage.hasAlpha;
+				compAlphaAvail = cachedImage.alphaCompressed;
+				origWidth = cachedImage.origWidth;
+				origHeight = cachedImage.origHeight;
+			}
+			else if (rasterJob)
 			{
-				bool gotAlpha = false;
-				bool pdfVer14 = Options.supportsTransparency();
-				gotAlpha = img2.getAlpha(fn, item->pixm.imgInfo.actualPageNumber, im2, true, pdfVer14, afl, img.width(), img.height());
-				if (!gotAlpha)
+				if (!rasterJob->alphaLoaded)
 				{
 					PDF_Error_MaskLoadFailure(fn);
 					return false;
 				}
+				im2 = rasterJob->alpha;
 				alphaM = !im2.isEmpty();
+				origWidth = rasterJob->origWidth;
+				origHeight = rasterJob->origHeight;
+				rasterJob.reset();
 			}
-			bool imgE = false;
-			if ((Options.UseRGB) || (Options.isGrayscale))
-				imgE = false;
 			else
-				imgE = !((Options.UseProfiles2) && (img.imgInfo.colorspace != ColorSpaceCMYK));
-			origWidth = img.width();
-			origHeight = img.height();
-			img.applyEffect(item->effectsInUse, item->doc()->PageColors, imgE);
-			if (!((Options.RecalcPic) && (Options.PicRes < (qMax(72.0 / item->imageXScale(), 72.0 / item->imageYScale())))))
-			{
-				ImInfo.sxa = sx * (1.0 / ImInfo.reso);
-				ImInfo.sya = sy * (1.0 / ImInfo.reso);
-			}
-			PdfId maskObj = 0;
-			if (alphaM)
 			{
-				bool compAlphaAvail = false;
-				maskObj = writer.newObject();
-				writer.startObj(maskObj);
-				PutDoc("<<\n/Type /XObject\n/Subtype /Image\n");
-				if (Options.CompressMethod != PDFOptions::Compression_None)
+				ScImage img2;
+				img2.imgInfo.clipPath.clear();
+				img2.imgInfo.PDSpathData.clear();
+				img2.imgInfo.layerInfo.clear();
+				img2.imgInfo.RequestProps = item->pixm.imgInfo.RequestProps;
+				img2.imgInfo.isRequest = item->pixm.imgInfo.isRequest;
+				if (item->pixm.imgInfo.type == ImageType7)
+					alphaM = false;
+				else
 				{
-					QByteArray compAlpha = CompressArray(im2);
-					if (compAlpha.size() > 0)
+					bool gotAlpha = false;
+					bool pdfVer14 = Options.supportsTransparency();
+					gotAlpha = img2.getAlpha(fn, item->pixm.imgInfo.actualPageNumber, im2, true, pdfVer14, afl, img.width(), img.height());
+					if (!gotAlpha)
 					{
-						im2 = compAlpha;
-						compAlphaAvail = true;
+						PDF_Error_MaskLoadFailure(fn);
+						return false;
 					}
+					alphaM = !im2.isEmpty();
 				}
-				if (Options.supportsTransparency())
-				{
-					PutDoc("/Width " + Pdf::toPdf(origWidth) + "\n");
-					PutDoc("/Height " + Pdf::toPdf(origHeight) + "\n");
-					PutDoc("/ColorSpace /DeviceGray\n");
-					PutDoc("/BitsPerComponent 8\n");
-					PutDoc("/Length " + Pdf::toPdf(im2.size()) + "\n");
-				}
+				bool imgE = false;
+				if ((Options.UseRGB) || (Options.isGrayscale))
+					imgE = false;
 				else
+					imgE = !((Options.UseProfiles2) && (img.imgInfo.colorspace != ColorSpaceCMYK));
+				origWidth = img.width();
+				origHeight = img.height();
+				img.applyEffect(item->effectsInUse, item->doc()->PageColors, imgE);
+			}
+			if (alphaM && !fromStreamCache && (Options.CompressMethod != PDFOptions::Compression_None))
+			{
+				QByteArray compAlpha = CompressArray(im2);
+				if (compAlpha.size() > 0)
 				{
-					PutDoc("/Width " + Pdf::toPdf(origWidth) + "\n");
-					PutDoc("/Height " + Pdf::toPdf(origHeight) + "\n");
-					PutDoc("/ImageMask true\n/BitsPerComponent 1\n");
-					PutDoc("/Length " + Pdf::toPdf(im2.size()) + "\n");
+					im2 = compAlpha;
+					compAlphaAvail = true;
 				}
-				if ((Options.CompressMethod != PDFOptions::Compression_None) && compAlphaAvail)
-					PutDoc("/Filter /FlateDecode\n");
-				PutDoc(">>\nstream\n");
-				EncodeArrayToStream(im2, maskObj);
-				PutDoc("\nendstream");
-				writer.endObj(maskObj);
-				pageData.ImgObjects[ResNam + "I" + Pdf::toPdf(ResCount)] = maskObj;
-				ResCount++;
 			}
-			PdfId imageObj = writer.newObject();
-			writer.startObj(imageObj);
-			PutDoc("<<\n/Type /XObject\n/Subtype /Image\n");
-			PutDoc("/Width " + Pdf::toPdf(img.width()) + "\n");
-			PutDoc("/Height " + Pdf::toPdf(img.height()) + "\n");
+			if (!((Options.RecalcPic) && (Options.PicRes < (qMax(72.0 / item->imageXScale(), 72.0 / item->imageYScale())))))
+			{
+				ImInfo.sxa = sx * (1.0 / ImInfo.reso);
+				ImInfo.sya = sy * (1.0 / ImInfo.reso);
+			}
 			enum PDFOptions::PDFCompression compress_method = Options.CompressMethod;
  			enum PDFOptions::PDFCompression cm = Options.CompressMethod;
 			bool exportToCMYK = false;
@@ -11111,89 +11528,195 @@ bool PDFLibCore::PDF_Image(PageItem* item, const QString& fn, double sx, double
 			}
 			if (hasGrayProfile && doc.HasCMS && Options.UseProfiles2 && (!hasColorEffect))
 				exportToGrayscale = true;
-			int bytesWritten = 0;
 			// Fixme: outType variable should be set directly in the if/else maze above.
 			ColorSpaceEnum outType;
 			if (img.imgInfo.colorspace == ColorSpaceMonochrome && item->effectsInUse.isEmpty())
 				outType = ColorSpaceMonochrome;
 			else
 				outType = getOutputType(exportToGrayscale, exportToCMYK);
+			QByteArray colorSpaceEntries;
 			if ((outType != ColorSpaceMonochrome) && (doc.HasCMS) && (Options.UseProfiles2) && (!avoidPDFXOutputIntentProf))
 			{
-				PutDoc("/ColorSpace " + ICCProfiles[profInUse].ICCArray + "\n");
-				PutDoc("/Intent /");
+				colorSpaceEntries += "/ColorSpace " + ICCProfiles[profInUse].ICCArray + "\n";
+				colorSpaceEntries += "/Intent /";
 				int inte2 = Intent;
 				if (Options.EmbeddedI)
 					inte2 = Options.Intent2;
 				static const QByteArray cmsmode[] = {"Perceptual", "RelativeColorimetric", "Saturation", "AbsoluteColorimetric"};
-				PutDoc(cmsmode[inte2] + "\n");
+				colorSpaceEntries += cmsmode[inte2] + "\n";
 			}
 			else
 			{
 				switch (outType)
 				{
 					case ColorSpaceMonochrome :
-					case ColorSpaceGray : PutDoc("/ColorSpace /DeviceGray\n"); break;
-					case ColorSpaceCMYK : PutDoc("/ColorSpace /DeviceCMYK\n"); break;
-					default : PutDoc("/ColorSpace /DeviceRGB\n"); break;
+					case ColorSpaceGray : colorSpaceEntries = "/ColorSpace /DeviceGray\n"; break;
+					case ColorSpaceCMYK : colorSpaceEntries = "/ColorSpace /DeviceCMYK\n"; break;
+					default : colorSpaceEntries = "/ColorSpace /DeviceRGB\n"; break;
 				}
 			}
-			if (outType == ColorSpaceMonochrome)
-				PutDoc("/BitsPerComponent 1\n");
+			int quality = item->OverrideCompressionQuality ? item->CompressionQualityIndex : Options.Quality;
+			if (item->OverrideCompressionQuality)
+				jpegUseOriginal = false;
+			// Frames whose image resolves to the same output share a single XObject
+			QByteArray outputParameters;
+			QDataStream outputStream(&outputParameters, QIODevice::WriteOnly);
+			bool precalGray = (!hasColorEffect && hasGrayProfile);
+			outputStream << static_cast<int>(outType) << static_cast<int>(cm) << quality << jpegUseOriginal << precalGray;
+			outputStream << colorSpaceEntries << origWidth << origHeight << alphaM << compAlphaAvail;
+			QCryptographicHash outputHash(QCryptographicHash::Sha256);
+			outputHash.addData(outputParameters);
+			QByteArray pixelDigest = fromStreamCache ? cachedImage.pixelDigest : imageDigest(img.qImage());
+			outputHash.addData(pixelDigest);
+			if (alphaM)
+				outputHash.addData(im2);
+			QByteArray outputKey = outputHash.result();
+			auto sharedOutputIt = ImageOutputs.constFind(outputKey);
+			if (sharedOutputIt != ImageOutputs.constEnd())
+				ImInfo.ResNum = sharedOutputIt.value();
 			else
-				PutDoc("/BitsPerComponent 8\n");
-			PdfId lengthObj = writer.newObject();
-			PutDoc("/Length " + Pdf::toPdf(lengthObj) + " 0 R\n");
-			if (cm == PDFOptions::Compression_JPEG)
-				PutDoc("/Filter /DCTDecode\n");
-			else if (cm != PDFOptions::Compression_None)
-				PutDoc("/Filter /FlateDecode\n");
+			{
+				if (fromStreamCache && ((cachedImage.outputType != outType) || (cachedImage.compression != cm) || (cachedImage.quality != quality)
+				                        || (cachedImage.jpegUseOriginal != jpegUseOriginal) || (cachedImage.precalculatedGray != precalGray)))
+				{
+					// Settings resolved differently than when the entry was written, decode the image after all
+					rasterJob = PDF_CreateRasterJob(item, fn, Profil, Embedded, Intent);
+					PDF_RunRasterJob(*rasterJob);
+					if (!rasterJob->imageLoaded)
+					{
+						PDF_Error_ImageLoadFailure(fn);
+						return false;
+					}
+					img = rasterJob->image;
+					rasterJob.reset();
+					fromStreamCache = false;
+				}
+				PdfId maskObj = 0;
+				if (alphaM)
+				{
+					maskObj = writer.newObject();
+					writer.startObj(maskObj);
+					PutDoc("<<\n/Type /XObject\n/Subtype /Image\n");
+					if (Options.supportsTransparency())
+					{
+						PutDoc("/Width " + Pdf::toPdf(origWidth) + "\n");
+						PutDoc("/Height " + Pdf::toPdf(origHeight) + "\n");
+						PutDoc("/ColorSpace /DeviceGray\n");
+						PutDoc("/BitsPerComponent 8\n");
+						PutDoc("/Length " + Pdf::toPdf(im2.size()) + "\n");
+					}
+					else
+					{
+						PutDoc("/Width " + Pdf::toPdf(origWidth) + "\n");
+						PutDoc("/Height " + Pdf::toPdf(origHeight) + "\n");
+						PutDoc("/ImageMask true\n/BitsPerComponent 1\n");
+						PutDoc("/Length " + Pdf::toPdf(im2.size()) + "\n");
+					}
+					if ((Options.CompressMethod != PDFOptions::Compression_None) && compAlphaAvail)
+						PutDoc("/Filter /FlateDecode\n");
+					PutDoc(">>\nstream\n");
+					EncodeArrayToStream(im2, maskObj);
+					PutDoc("\nendstream");
+					writer.endObj(maskObj);
+					pageData.ImgObjects[ResNam + "I" + Pdf::toPdf(ResCount)] = maskObj;
+					ResCount++;
+				}
+				PdfId imageObj = writer.newObject();
+				writer.startObj(imageObj);
+				PutDoc("<<\n/Type /XObject\n/Subtype /Image\n");
+				PutDoc("/Width " + Pdf::toPdf(imageWidth) + "\n");
+				PutDoc("/Height " + Pdf::toPdf(imageHeight) + "\n");
+				int bytesWritten = 0;
+				PutDoc(colorSpaceEntries);
+				if (outType == ColorSpaceMonochrome)
+					PutDoc("/BitsPerComponent 1\n");
+				else
+					PutDoc("/BitsPerComponent 8\n");
+				PdfId lengthObj = writer.newObject();
+				PutDoc("/Length " + Pdf::toPdf(lengthObj) + " 0 R\n");
+				if (cm == PDFOptions::Compression_JPEG)
+					PutDoc("/Filter /DCTDecode\n");
+				else if (cm != PDFOptions::Compression_None)
+					PutDoc("/Filter /FlateDecode\n");
 //			if (exportToCMYK && (cm == PDFOptions::Compression_JPEG))
 //				PutDoc("/Decode [1 0 1 0 1 0 1 0]\n");
-			if (alphaM)
-			{
-				if (Options.supportsTransparency())
-					PutDoc("/SMask " + Pdf::toPdf(maskObj) + " 0 R\n");
+				if (alphaM)
+				{
+					if (Options.supportsTransparency())
+						PutDoc("/SMask " + Pdf::toPdf(maskObj) + " 0 R\n");
+					else
+						PutDoc("/Mask " + Pdf::toPdf(maskObj) + " 0 R\n");
+				}
+				PutDoc(">>\nstream\n");
+				if (fromStreamCache)
+				{
+					if (EncodeArrayToStream(cachedImage.stream, imageObj))
+						bytesWritten = cachedImage.stream.size();
+				}
+				else if (!streamCacheKey.isEmpty())
+				{
+					QByteArray stream = PDF_EncodeImageStream(img, fn, cm, quality, outType, jpegUseOriginal, precalGray);
+					if (!stream.isEmpty() && EncodeArrayToStream(stream, imageObj))
+						bytesWritten = stream.size();
+					if (bytesWritten > 0)
+					{
+						PdfImageStreamCache::Entry entry;
+						entry.colorSpace = img.imgInfo.colorspace;
+						entry.realCMYK = realCMYK;
+						entry.progressive = img.imgInfo.progressive;
+						entry.exifOrientation = img.imgInfo.exifInfo.orientation;
+						entry.width = imageWidth;
+						entry.height = imageHeight;
+						entry.origWidth = origWidth;
+						entry.origHeight = origHeight;
+						entry.pixelDigest = pixelDigest;
+						entry.hasAlpha = alphaM;
+						entry.alphaCompressed = compAlphaAvail;
+						entry.alpha = im2;
+						entry.outputType = outType;
+						entry.compression = cm;
+						entry.quality = quality;
+						entry.jpegUseOriginal = jpegUseOriginal;
+						entry.precalculatedGray = precalGray;
+						entry.stream = stream;
+						PdfImageStreamCache::instance().store(streamCacheKey, entry);
+					}
+				}
+				else if (cm == PDFOptions::Compression_JPEG) // Fixme: should not do this with monochrome images?
+					bytesWritten = WriteJPEGImageToStream(img, fn, imageObj, quality, outType, jpegUseOriginal, precalGray);
+				else if (cm == PDFOptions::Compression_ZIP)
+					bytesWritten = WriteFlateImageToStream(img, imageObj, outType, precalGray);
 				else
-					PutDoc("/Mask " + Pdf::toPdf(maskObj) + " 0 R\n");
-			}
-			PutDoc(">>\nstream\n");
-			if (cm == PDFOptions::Compression_JPEG) // Fixme: should not do this with monochrome images?
-			{
-				int quality = item->OverrideCompressionQuality ? item->CompressionQualityIndex : Options.Quality;
-				if (item->OverrideCompressionQuality)
-					jpegUseOriginal = false;
-				bytesWritten = WriteJPEGImageToStream(img, fn, imageObj, quality, outType, jpegUseOriginal, (!hasColorEffect && hasGrayProfile));
-			}
-			else if (cm == PDFOptions::Compression_ZIP)
-				bytesWritten = WriteFlateImageToStream(img, imageObj, outType, (!hasColorEffect && hasGrayProfile));
-			else
-				bytesWritten = WriteImageToStream(img, imageObj, outType, (!hasColorEffect && hasGrayProfile));
-			PutDoc("\nendstream");
-			writer.endObj(imageObj);
-			if (bytesWritten <= 0)
-			{
-				PDF_Error_ImageWriteFailure(fn);
-				return false;
-			}
-			writer.startObj(lengthObj);
-			PutDoc("    " + Pdf::toPdf(bytesWritten));
-			writer.endObj(lengthObj);
-			pageData.ImgObjects[ResNam + "I" + Pdf::toPdf(ResCount)] = imageObj;
-			ImInfo.ResNum = ResCount;
-			ImInfo.Width = img.width();
-			ImInfo.Height = img.height();
+					bytesWritten = WriteImageToStream(img, imageObj, outType, precalGray);
+				PutDoc("\nendstream");
+				writer.endObj(imageObj);
+				if (bytesWritten <= 0)
+				{
+					PDF_Error_ImageWriteFailure(fn);
+					return false;
+				}
+				writer.startObj(lengthObj);
+				PutDoc("    " + Pdf::toPdf(bytesWritten));
+				writer.endObj(lengthObj);
+				pageData.ImgObjects[ResNam + "I" + Pdf::toPdf(ResCount)] = imageObj;
+				ImInfo.ResNum = ResCount;
+				ImageOutputs.insert(outputKey, ResCount);
+			}
+			ImInfo.Width = imageWidth;
+			ImInfo.Height = imageHeight;
 			ImInfo.xa = sx;
 			ImInfo.ya = sy;
 			ImInfo.RequestProps = item->pixm.imgInfo.RequestProps;
 		} // not embedded PDF
 		if (!SharedImages.containsSuitable(fn, ImInfo))
 			SharedImages.insert(fn, ImInfo);
+		if (!sourceKey.isEmpty())
+			SourceImages.insert(sourceKey, ImInfo);
 		ResCount++;
 	}
 	else
 	{
-		ImInfo = *sharedImageIt;
+		ImInfo = *sharedImage;
 		ImInfo.sxa *= sx / ImInfo.xa;
 		ImInfo.sya *= sy / ImInfo.ya;
 	}
@@ -11261,51 +11784,67 @@ void PDFLibCore::PDF_End_Bookmarks()
 	if (writer.OutlinesObj == 0)
 		return;
 
-	if ((Bvie->topLevelItemCount() <= 0) || (!Options.Bookmarks) || (!BookMinUse))
+	if (doc.BookMarks.isEmpty() || (!Options.Bookmarks) || (!BookMinUse))
 		return;
 	
+	// Bookmarks are listed in the order of the bookmark palette tree, children after their parent
 	QByteArray content;
 	QMap<int, QByteArray> bookmarkMap;
-	const BookMItem* ip = (BookMItem*) Bvie->topLevelItem(0);
+	QHash<int, int> childCounts;
+	const ScribusDoc::BookMa* firstTopLevel = nullptr;
+	const ScribusDoc::BookMa* lastTopLevel = nullptr;
+	int topLevelCount = 0;
+	for (const ScribusDoc::BookMa& bookmark : std::as_const(doc.BookMarks))
+	{
+		if (bookmark.Parent != 0)
+		{
+			childCounts[bookmark.Parent]++;
+			continue;
+		}
+		if (firstTopLevel == nullptr)
+			firstTopLevel = &bookmark;
+		lastTopLevel = &bookmark;
+		++topLevelCount;
+	}
+	if (topLevelCount == 0)
+		return;
 	PdfId basis = writer.objectCounter() - 1;
-	Outlines.Count = Bvie->topLevelItemCount();
-	Outlines.First = ip->ItemNr + basis;
-	Outlines.Last  = ((BookMItem*) Bvie->topLevelItem(Outlines.Count - 1))->ItemNr + basis;
-	QTreeWidgetItemIterator it(Bvie);
-	while (*it)
-	{
-		ip = (BookMItem*)(*it);
-		QString encText = ip->text(0);
+	Outlines.Count = topLevelCount;
+	Outlines.First = firstTopLevel->ItemNr + basis;
+	Outlines.Last  = lastTopLevel->ItemNr + basis;
+	for (const ScribusDoc::BookMa& bookmark : std::as_const(doc.BookMarks))
+	{
 		content.clear();
-		content += "<<\n/Title " + EncStringUTF16(encText, ip->ItemNr + basis) + "\n";
-		if (ip->Pare == 0)
+		content += "<<\n/Title " + EncStringUTF16(bookmark.Text, bookmark.ItemNr + basis) + "\n";
+		if (bookmark.Parent == 0)
 			content += "/Parent 3 0 R\n";
 		else
-			content += "/Parent " + Pdf::toPdf(ip->Pare + basis) + " 0 R\n";
-		if (ip->Prev != 0)
-			content += "/Prev " + Pdf::toPdf(ip->Prev + basis) + " 0 R\n";
-		if (ip->Next != 0)
-			content += "/Next " + Pdf::toPdf(ip->Next + basis) + " 0 R\n";
-		if (ip->First != 0)
-			content += "/First " + Pdf::toPdf(ip->First + basis) + " 0 R\n";
-		if (ip->Last != 0)
-			content += "/Last " + Pdf::toPdf(ip->Last + basis) + " 0 R\n";
-		if (ip->childCount())
-			content += "/Count -" + Pdf::toPdf(ip->childCount()) + "\n";
-		if ((ip->PageObject->OwnPage != -1) && PageTree.KidsMap.contains(ip->PageObject->OwnPage))
-		{
-			QByteArray action = Pdf::toPdfDocEncoding(ip->Action);
+			content += "/Parent " + Pdf::toPdf(bookmark.Parent + basis) + " 0 R\n";
+		if (bookmark.Prev != 0)
+			content += "/Prev " + Pdf::toPdf(bookmark.Prev + basis) + " 0 R\n";
+		if (bookmark.Next != 0)
+			content += "/Next " + Pdf::toPdf(bookmark.Next + basis) + " 0 R\n";
+		if (bookmark.First != 0)
+			content += "/First " + Pdf::toPdf(bookmark.First + basis) + " 0 R\n";
+		if (bookmark.Last != 0)
+			content += "/Last " + Pdf::toPdf(bookmark.Last + basis) + " 0 R\n";
+		int childCount = childCounts.value(bookmark.ItemNr);
+		if (childCount)
+			content += "/Count -" + Pdf::toPdf(childCount) + "\n";
+		const PageItem* pageObject = bookmark.PageObject;
+		if ((pageObject != nullptr) && (pageObject->OwnPage != -1) && PageTree.KidsMap.contains(pageObject->OwnPage))
+		{
+			QByteArray action = Pdf::toPdfDocEncoding(bookmark.Action);
 			if (action.isEmpty())
 			{
-				const ScPage* page = doc.DocPages.at(ip->PageObject->OwnPage);
-				double actionPos = page->height() - (ip->PageObject->yPos() - page->yOffset());
+				const ScPage* page = doc.DocPages.at(pageObject->OwnPage);
+				double actionPos = page->height() - (pageObject->yPos() - page->yOffset());
 				action = "/XYZ 0 " + Pdf::toPdf(actionPos) + " 0";
 			}
-			content += "/Dest [" + Pdf::toPdf(PageTree.KidsMap[ip->PageObject->OwnPage]) + " 0 R " + action + "]\n";
+			content += "/Dest [" + Pdf::toPdf(PageTree.KidsMap[pageObject->OwnPage]) + " 0 R " + action + "]\n";
 		}
 		content += ">>";
-		bookmarkMap[ip->ItemNr] = content;
-		++it;
+		bookmarkMap[bookmark.ItemNr] = content;
 	}
 
 	writer.reserveObjects(bookmarkMap.count());
@@ -11360,7 +11899,7 @@ void PDFLibCore::PDF_End_Outlines()
 	writer.startObj(writer.OutlinesObj);
 	PutDoc("<<\n/Type /Outlines\n");
 	PutDoc("/Count " + Pdf::toPdf(Outlines.Count) + "\n");
-	if ((Bvie->topLevelItemCount() != 0) && (Options.Bookmarks))
+	if ((Outlines.Count != 0) && (Options.Bookmarks))
 	{
 		PutDoc("/First " + Pdf::toPdf(Outlines.First) + " 0 R\n");
 		PutDoc("/Last " + Pdf::toPdf(Outlines.Last) + " 0 R\n");
@@ -11991,6 +12530,9 @@ bool PDFLibCore::closeAndCleanup()
 	Shadings.clear();
 	Transpar.clear();
 	ICCProfiles.clear();
+	SourceImages.clear();
+	ImageOutputs.clear();
+	PdfImageStreamCache::instance().saveFileDigests();
 	return writeSucceed;
 }
 
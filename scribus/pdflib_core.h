@@ -10,10 +10,13 @@ for which a new license (GPL+exception) is in place.
 
 #include <QFile>
 #include <QDataStream>
+#include <QHash>
 #include <QPixmap>
 #include <QList>
 #include <QMultiMap>
+#include <QPair>
 #include <QStack>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -22,8 +25,6 @@ class QRect;
 class QString;
 class QTextCodec;
 class PageItem;
-class BookMItem;
-class BookmarkView;
 class ScribusDoc;
 class ScPage;
 class PDFOptions;
@@ -133,11 +134,17 @@ private:
 		}
 	};
 
+	/**
+	 * Decoding step of PDF_Image() for bitmap image files, run on worker threads
+	 * for the pages ahead of the one being exported. See PDF_Begin_ImagePrefetch().
+	 */
+	struct PdfRasterJob;
+
 	bool PDF_HasXMP() const;
 	bool PDF_IsPDFX() const;
 	bool PDF_IsPDFX(const PDFVersion& ver) const;
 
-	bool PDF_Begin_Doc(const QString& fn, BookmarkView* vi);
+	bool PDF_Begin_Doc(const QString& fn);
 	void PDF_Begin_Catalog();
 	void PDF_Begin_MetadataAndEncrypt();
 	QMap<QString, QMap<uint, QString> > PDF_Begin_FindUsedFonts();
@@ -266,6 +273,18 @@ private:
 	void    PDF_xForm(PdfId objNr, double w, double h, const QByteArray& im);
 	bool    PDF_Image(PageItem* c, const QString& fn, double sx, double sy, double x, double y, bool fromAN = false, const QString& Profil = "", bool Embedded = false, eRenderIntent Intent = Intent_Relative_Colorimetric, QByteArray* output = nullptr);
 	bool    PDF_EmbeddedPDF(PageItem* c, const QString& fn, double sx, double sy, double x, double y, ShIm& imgInfo, bool &fatalError);
+
+	void    PDF_Begin_ImagePrefetch(const QList<const ScPage*>& pages);
+	void    PDF_PrefetchImages(int currentPage);
+	void    PDF_ReleasePrefetchedImages(int page);
+	void    PDF_End_ImagePrefetch();
+	bool    PDF_IsRasterImage(const PageItem* item, const QString& fn) const;
+	std::shared_ptr<PdfRasterJob> PDF_CreateRasterJob(PageItem* item, const QString& fn, const QString& Profil, bool Embedded, eRenderIntent Intent) const;
+	std::shared_ptr<PdfRasterJob> PDF_TakeRasterJob(const PageItem* item, const QString& fn, const QString& Profil, bool Embedded, eRenderIntent Intent);
+	void    PDF_RunRasterJob(PdfRasterJob& job) const;
+	QByteArray PDF_ImageSourceKey(const PageItem* item, const QString& fn, const QString& Profil, bool Embedded, eRenderIntent Intent);
+	QByteArray PDF_ImageStreamCacheKey(const PageItem* item, const QByteArray& sourceKey) const;
+	QByteArray PDF_EncodeImageStream(ScImage& image, const QString& fn, PDFOptions::PDFCompression compression, int quality, ColorSpaceEnum format, bool jpegUseOriginal, bool precal);
 #if HAVE_PODOFO
 	void copyPoDoFoObject(const PoDoFo::PdfObject* obj, PdfId scObjID, QMap<PoDoFo::PdfReference, uint>& importedObjects);
 	void copyPoDoFoDirect(const PoDoFo::PdfObject* obj, QList<PoDoFo::PdfReference>& referencedObjects, QMap<PoDoFo::PdfReference, uint>& importedObjects);
@@ -296,9 +315,11 @@ private:
 	ScribusDoc & doc;
 	const ScPage * ActPageP { nullptr };
 	const PDFOptions & Options;
-	BookmarkView* Bvie { nullptr };
 	//int Dokument;
 	SharedImgRsrc SharedImages;
+	// Images indexed by hash of source file content and load settings, and by hash of output pixels
+	QHash<QByteArray, ShIm> SourceImages;
+	QHash<QByteArray, int> ImageOutputs;
 	QList<PdfDest> NamedDest;
 	QList<PdfId> CalcFields;
 	Pdf::ResourceMap Patterns;
@@ -331,6 +352,11 @@ private:
 	QByteArray xmpPacket;
 	QStack<QPointF> groupStackPos;
 	QStack<QPointF> patternStackPos;
+	// Bitmap images decoded ahead of time, indexed in pages passed to PDF_Begin_ImagePrefetch()
+	QList< QPair<int, PageItem*> > rasterQueue;
+	int rasterQueuePos { 0 };
+	int rasterPage { 0 };
+	QHash<const PageItem*, std::shared_ptr<PdfRasterJob> > rasterJobs;
 
 protected slots:
 	void cancelRequested();
@@ -13,7 +13,17 @@ for which a new license (GPL+exception) is in place.
 #include <QPixmap>
 #include <QString>
 #include <QSharedPointer>
+#include <QThread>
+#include <QThreadPool>
 
+#include <deque>
+#include <memory>
+
+#include "bandedimagewriter.h"
+#include "pagerasterizer.h"
+#include "prefscontext.h"
+#include "prefsfile.h"
+#include "prefsmanager.h"
 #include "scribus.h"
 #include "scribusdoc.h"
 #include "scribusview.h"
@@ -165,6 +175,9 @@ ExportBitmap::ExportBitmap()
 	exportDir = QDir::currentPath();
 	bitmapType = QString("png");
 	overwrite = false;
+	PrefsContext* prefs = PrefsManager::instance().prefsFile->getPluginContext("pixmapexport");
+	pagesInFlight = qMax(1, prefs->getInt("PagesInFlight", QThread::idealThreadCount()));
+	maxImageMemory = qMax(1, prefs->getInt("MaxImageMemory", 256));
 }
 
 QString ExportBitmap::getFileName(ScribusDoc* doc, uint pageNr)
@@ -176,55 +189,118 @@ ExportBitmap::~ExportBitmap()
 {
 }
 
-bool ExportBitmap::exportPage(ScribusDoc* doc, uint pageNr, bool background, bool single = true)
+double ExportBitmap::exportScale() const
 {
-	uint over   = 0;
-	bool saved = false, doFileSave = true;
-	QString fileName(getFileName(doc, pageNr));
+	return enlargement / 100.0 * pageDPI / 72.0;
+}
 
-	if (!doc->Pages->at(pageNr))
-		return false;
-	ScPage* page = doc->Pages->at(pageNr);
+bool ExportBitmap::confirmOverwrite(ScribusDoc* doc, const QString& fileName, bool single)
+{
+	if (!QFile::exists(fileName) || overwrite)
+		return true;
 
-	/* a little magic here - I need to compute the "maxGr" value...
-	* We need to know the right size of the page for landscape,
-	* portrait and user defined sizes.
-	*/
-	double pixmapSize = (page->height() > page->width()) ? page->height() : page->width();
-	PageToPixmapFlags flags;
-	if (background)
-		flags |= Pixmap_DrawBackground;
-	QImage im(doc->view()->PageToPixmap(pageNr, qRound(pixmapSize * enlargement * (pageDPI / 72.0) / 100.0), flags));
+	bool doFileSave = false;
+	QString fn = QDir::toNativeSeparators(fileName);
+//	QApplication::restoreOverrideCursor();
+	QApplication::changeOverrideCursor(Qt::ArrowCursor);
+	uint over = ScMessageBox::question(doc->scMW(), tr("File exists. Overwrite?"),
+			fn +"\n"+ tr("exists already. Overwrite?"),
+			// hack for multiple overwriting (petr) 
+			(single) ? QMessageBox::Yes | QMessageBox::No : QMessageBox::Yes | QMessageBox::No | QMessageBox::YesToAll,
+			QMessageBox::NoButton,	// GUI default
+			QMessageBox::YesToAll);	// batch default
+	QApplication::changeOverrideCursor(QCursor(Qt::WaitCursor));
+	if (over == QMessageBox::Yes || over == QMessageBox::YesToAll)
+		doFileSave = true;
+	if (over == QMessageBox::YesToAll)
+		overwrite = true;
+	return doFileSave;
+}
+
+QImage ExportBitmap::renderPage(ScribusDoc* doc, PageRasterizer& rasterizer, uint pageNr)
+{
+	QImage im(rasterizer.render(doc->Pages->at(pageNr), exportScale()));
 	if (im.isNull())
 	{
 		ScMessageBox::warning(doc->scMW(), tr("Save as Image"), tr("Insufficient memory for this image size."));
 		doc->scMW()->setStatusBarInfoText( tr("Insufficient memory for this image size."));
-		return false;
+		return im;
 	}
 	int dpm = qRound(100.0 / 2.54 * pageDPI);
 	im.setDotsPerMeterY(dpm);
 	im.setDotsPerMeterX(dpm);
-	if (QFile::exists(fileName) && !overwrite)
+	return im;
+}
+
+bool ExportBitmap::needsBands(ScribusDoc* doc, uint pageNr) const
+{
+	if (!BandedImageWriter::supportsFormat(bitmapType.toLatin1()))
+		return false;
+	QSize size = PageRasterizer::imageSize(doc->Pages->at(pageNr), exportScale());
+	qint64 imageMemory = static_cast<qint64>(size.width()) * size.height() * 4;
+	return imageMemory > static_cast<qint64>(maxImageMemory) * 1024 * 1024;
+}
+
+bool ExportBitmap::exportBanded(ScribusDoc* doc, PageRasterizer& rasterizer, uint pageNr, const QString& fileName)
+{
+	ScPage* page = doc->Pages->at(pageNr);
+	QSize size = PageRasterizer::imageSize(page, exportScale());
+	// Bands of about 16 MiB, large enough to keep the per band overhead low
+	int bandHeight = qMax(16, static_cast<int>(16 * 1024 * 1024 / (static_cast<qint64>(size.width()) * 4)));
+
+	BandedImageWriter writer(fileName, bitmapType.toLatin1());
+	writer.setDotsPerMeter(qRound(100.0 / 2.54 * pageDPI));
+	writer.setQuality(quality);
+	bool success = writer.open(size.width(), size.height());
+	if (success)
 	{
-		doFileSave = false;
-		QString fn = QDir::toNativeSeparators(fileName);
-//		QApplication::restoreOverrideCursor();
-		QApplication::changeOverrideCursor(Qt::ArrowCursor);
-		over = ScMessageBox::question(doc->scMW(), tr("File exists. Overwrite?"),
-				fn +"\n"+ tr("exists already. Overwrite?"),
-				// hack for multiple overwriting (petr) 
-				(single) ? QMessageBox::Yes | QMessageBox::No : QMessageBox::Yes | QMessageBox::No | QMessageBox::YesToAll,
-				QMessageBox::NoButton,	// GUI default
-				QMessageBox::YesToAll);	// batch default
-		QApplication::changeOverrideCursor(QCursor(Qt::WaitCursor));
-		if (over == QMessageBox::Yes || over == QMessageBox::YesToAll)
-			doFileSave = true;
-		if (over == QMessageBox::YesToAll)
-			overwrite = true;
+		success = rasterizer.renderBands(page, exportScale(), bandHeight, [&writer](const QImage& band) {
+			return writer.writeBand(band);
+		});
+	}
+	if (!writer.close())
+		success = false;
+	if (!success)
+	{
+		QString message = writer.hasError() ? tr("Error writing the output file(s).") : tr("Insufficient memory for this image size.");
+		ScMessageBox::warning(doc->scMW(), tr("Save as Image"), message);
+		doc->scMW()->setStatusBarInfoText(message);
+	}
+	return success;
+}
+
+bool ExportBitmap::finishWriteJob(ScribusDoc* doc, PageWriteJob& job)
+{
+	job.finished.acquire();
+	if (!job.saved)
+	{
+		ScMessageBox::warning(doc->scMW(), tr("Save as Image"), tr("Error writing the output file(s)."));
+		doc->scMW()->setStatusBarInfoText( tr("Error writing the output file(s)."));
+	}
+	return job.saved;
+}
+
+bool ExportBitmap::exportPage(ScribusDoc* doc, uint pageNr, bool background, bool single = true)
+{
+	QString fileName(getFileName(doc, pageNr));
+
+	if (!doc->Pages->at(pageNr))
+		return false;
+	if (!confirmOverwrite(doc, fileName, single))
+		return false;
+
+	QImage im;
+	{
+		PageRasterizer rasterizer(doc, background ? Pixmap_DrawBackground : Pixmap_NoFlags);
+		if (needsBands(doc, pageNr))
+			return exportBanded(doc, rasterizer, pageNr, fileName);
+		im = renderPage(doc, rasterizer, pageNr);
 	}
-	if (doFileSave)
-		saved = im.save(fileName, bitmapType.toLocal8Bit().constData(), quality);
-	if (!saved && doFileSave)
+	if (im.isNull())
+		return false;
+
+	bool saved = im.save(fileName, bitmapType.toLocal8Bit().constData(), quality);
+	if (!saved)
 	{
 		ScMessageBox::warning(doc->scMW(), tr("Save as Image"), tr("Error writing the output file(s)."));
 		doc->scMW()->setStatusBarInfoText( tr("Error writing the output file(s)."));
@@ -239,12 +315,68 @@ bool ExportBitmap::exportCurrent(ScribusDoc* doc,  bool background)
 
 bool ExportBitmap::exportInterval(ScribusDoc* doc, std::vector<int> &pageNs, bool background)
 {
+	// Pages are drawn one after the other, the document is not thread safe. Encoding and
+	// writing them runs in the thread pool meanwhile, with at most pagesInFlight pages
+	// kept in memory.
+	QThreadPool* threadPool = QThreadPool::globalInstance();
+	QByteArray format = bitmapType.toLocal8Bit();
+	int imageQuality = quality;
+	std::deque< std::shared_ptr<PageWriteJob> > jobs;
+	bool success = true;
+
 	doc->scMW()->mainWindowProgressBar->setMaximum(pageNs.size());
+	PageRasterizer rasterizer(doc, background ? Pixmap_DrawBackground : Pixmap_NoFlags);
 	for (uint a = 0; a < pageNs.size(); ++a)
 	{
 		doc->scMW()->mainWindowProgressBar->setValue(a);
-		if (!exportPage(doc, pageNs[a]-1, background, false))
-			return false;
+		while (success && (jobs.size() >= static_cast<size_t>(pagesInFlight)))
+		{
+			success = finishWriteJob(doc, *jobs.front());
+			jobs.pop_front();
+		}
+		if (!success)
+			break;
+
+		uint pageNr = pageNs[a] - 1;
+		QString fileName(getFileName(doc, pageNr));
+		if (!doc->Pages->at(pageNr) || !confirmOverwrite(doc, fileName, false))
+		{
+			success = false;
+			break;
+		}
+		if (needsBands(doc, pageNr))
+		{
+			// Too large to be kept in memory while other pages are rendered, written right away
+			success = exportBanded(doc, rasterizer, pageNr, fileName);
+			if (!success)
+				break;
+			continue;
+		}
+		QImage im(renderPage(doc, rasterizer, pageNr));
+		if (im.isNull())
+		{
+			success = false;
+			break;
+		}
+
+		std::shared_ptr<PageWriteJob> job = std::make_shared<PageWriteJob>();
+		job->image = im;
+		job->fileName = fileName;
+		jobs.push_back(job);
+		threadPool->start([job, format, imageQuality]() {
+			job->saved = job->image.save(job->fileName, format.constData(), imageQuality);
+			job->image = QImage();
+			job->finished.release();
+		});
 	}
-	return true;
+	while (!jobs.empty())
+	{
+		// Report only the first error, wait for all pages anyway
+		if (success)
+			success = finishWriteJob(doc, *jobs.front());
+		else
+			jobs.front()->finished.acquire();
+		jobs.pop_front();
+	}
+	return success;
 }
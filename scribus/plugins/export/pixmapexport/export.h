@@ -9,10 +9,13 @@ for which a new license (GPL+exception) is in place.
 
 #include <QString>
 #include <QFileDialog>
+#include <QImage>
+#include <QSemaphore>
 #include <pluginapi.h>
 #include <loadsaveplugin.h>
 #include <vector>
 
+class PageRasterizer;
 class ScrAction;
 
 class PLUGIN_API PixmapExportPlugin : public ScActionPlugin
@@ -63,6 +66,10 @@ public:
 	bool overwrite;
 	/*! \brief Prefix for filenames */
 	QString filenamePrefix;
+	/*! \brief Maximum number of rendered pages waiting to be written */
+	int pagesInFlight;
+	/*! \brief Size in MiB above which pages are rendered and written in bands */
+	int maxImageMemory;
 
 	/*! \brief Exports only the actual page
 	\retval bool true on success */
@@ -72,8 +79,35 @@ public:
 	\retval true on success */
 	bool exportInterval(ScribusDoc* doc, std::vector<int> &pageNs, bool background);
 private:
+	/*! \brief A rendered page being written by a worker thread */
+	struct PageWriteJob
+	{
+		QImage image;
+		QString fileName;
+		bool saved { false };
+		QSemaphore finished;
+	};
+
 	/*! \brief create specified filename "docfilename-005.ext" */
 	QString getFileName(ScribusDoc* doc, uint pageNr);
+	/*! \brief Scale of the exported pages, 1.0 being 72 dpi */
+	double exportScale() const;
+	/*! \brief Asks whether an existing file may be overwritten
+	\param single bool TRUE if only the one page is exported
+	\retval bool true if the file can be written */
+	bool confirmOverwrite(ScribusDoc* doc, const QString& fileName, bool single);
+	/*! \brief Renders one page, warns about insufficient memory if it cannot
+	\retval QImage the page, null on failure */
+	QImage renderPage(ScribusDoc* doc, PageRasterizer& rasterizer, uint pageNr);
+	/*! \brief Tells whether a page is too large to be rendered into a single image
+	\retval bool true if the page has to be written in bands */
+	bool needsBands(ScribusDoc* doc, uint pageNr) const;
+	/*! \brief Renders one page in bands streamed to the file, warns on failure
+	\retval bool true on success */
+	bool exportBanded(ScribusDoc* doc, PageRasterizer& rasterizer, uint pageNr, const QString& fileName);
+	/*! \brief Waits for a page to be written, warns about write errors
+	\retval bool true on success */
+	bool finishWriteJob(ScribusDoc* doc, PageWriteJob& job);
 	/*! \brief export one specified page
 	\param pageNr number of the page
 	\param single bool TRUE if only the one page is exported
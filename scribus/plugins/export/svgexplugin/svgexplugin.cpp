@@ -204,6 +204,8 @@ bool SVGExPlug::doExport( const QString& fName, SVGOptions &Opts )
 	m_pattCount = 0;
 	m_maskCount = 0;
 	m_filterCount = 0;
+	// Images of large documents are loaded on demand, export needs them
+	m_Doc->imageLoadScheduler()->loadAll();
 
 	m_domDoc = QDomDocument("svgdoc");
 	QString vo = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
@@ -230,6 +230,8 @@ bool XPSExPlug::doExport(const QString& fName)
 	imageCounter = 0;
 	fontCounter = 0;
 	xps_fontMap.clear();
+	// Images of large documents are loaded on demand, export needs all of them
+	m_Doc->imageLoadScheduler()->loadAll();
 	baseDir = dir.path();
 	// Create directory tree
 	QDir outDir(baseDir);
@@ -23,6 +23,7 @@ for which a new license (GPL+exception) is in place.
 #include "../../formatidlist.h"
 #include "commonstrings.h"
 #include "hyphenator.h"
+#include "imageloadscheduler.h"
 #include "langmgr.h"
 #include "notesstyles.h"
 #include "pageitem_arc.h"
@@ -1646,6 +1647,7 @@ bool Scribus171Format::loadFile(const QString & fileName, const FileFormat & /*
 	notesFramesData.clear();
 	notesMasterMarks.clear();
 	notesNSets.clear();
+	m_deferredImageLoads.clear();
 
 	QScopedPointer<QIODevice> ioDevice(slaReader(fileName));
 	if (ioDevice.isNull())
@@ -1694,6 +1696,7 @@ bool Scribus171Format::loadFile(const QString & fileName, const FileFormat & /*
 	bool success = true;
 	bool hasPageSets = false;
 	int  progress = 0;
+	m_deferImageLoads = true;
 
 	ScXmlStreamReader reader(ioDevice.data());
 	ScXmlStreamAttributes attrs;
@@ -2060,13 +2063,17 @@ bool Scribus171Format::loadFile(const QString & fileName, const FileFormat & /*
 			reader.skipCurrentElement();
 		}
 	}
+	m_deferImageLoads = false;
 
 	if (reader.hasError())
 	{
+		m_deferredImageLoads.clear();
 		setDomParsingError(reader.errorString(), reader.lineNumber(), reader.columnNumber());
 		return false;
 	}
 
+	loadDeferredImages();
+
 	for (auto it = bookmarks.begin(); it != bookmarks.end(); ++it)
 	{
 		int elem = it.key();
@@ -5422,7 +5429,19 @@ bool Scribus171Format::readObject(ScribusDoc* doc, ScXmlStreamReader& reader, co
 	if (newItem->isImageFrame() || newItem->isLatexFrame())
 #endif
 	{
-		if (!newItem->Pfile.isEmpty())
+		if (!newItem->Pfile.isEmpty() && m_deferImageLoads && newItem->isImageFrame() && (itemKind != PageItem::PatternItem))
+		{
+			// Pattern items are loaded immediately as pattern previews are created while parsing
+			DeferredImageLoad imageLoad;
+			imageLoad.item = newItem;
+			imageLoad.clipPath = clipPath;
+			imageLoad.layerFound = layerFound;
+			// Inline images are drawn as part of their text frame, the canvas never requests them.
+			// Layer selections are only saved along with the layers of the loaded image.
+			imageLoad.onDemand = (itemKind != PageItem::InlineItem) && !layerFound;
+			m_deferredImageLoads.append(imageLoad);
+		}
+		else if (!newItem->Pfile.isEmpty())
 		{
 			double imageXOffset = newItem->imageXOffset();
 			double imageYOffset = newItem->imageYOffset();
@@ -5459,6 +5478,29 @@ bool Scribus171Format::readObject(ScribusDoc* doc, ScXmlStreamReader& reader, co
 	return !reader.hasError();
 }
 
+void Scribus171Format::loadDeferredImages()
+{
+	if (m_deferredImageLoads.isEmpty())
+		return;
+
+	ImageLoadScheduler* imageLoadScheduler = m_Doc->imageLoadScheduler();
+	bool loadsOnDemand = imageLoadScheduler->loadsOnDemand();
+
+	QList<PageItem*> imageItems;
+	imageItems.reserve(m_deferredImageLoads.count());
+	for (const DeferredImageLoad& imageLoad : std::as_const(m_deferredImageLoads))
+	{
+		PageItem* newItem = imageLoad.item;
+		imageLoadScheduler->addPending(newItem, imageLoad.layerFound);
+		// The clipping path is kept when the document is saved and applied once the image is loaded
+		newItem->pixm.imgInfo.usedPath = imageLoad.clipPath;
+		if (!loadsOnDemand || !imageLoad.onDemand)
+			imageItems.append(newItem);
+	}
+	imageLoadScheduler->load(imageItems);
+	m_deferredImageLoads.clear();
+}
+
 bool Scribus171Format::readPattern(ScribusDoc* doc, ScXmlStreamReader& reader, const QString& baseDir)
 {
 	ScPattern pat;
@@ -8912,7 +8954,7 @@ bool Scribus171Format::readStyles(const QString& fileName, ScribusDoc* doc, Styl
 	bool firstElement = true;
 	bool success = true;
 
-	QScopedPointer<QIODevice> ioDevice(slaReader(fileName));
+	QScopedPointer<QIODevice> ioDevice(slaSectionReader(fileName, { "ParagraphStyles" }));
 	if (ioDevice.isNull())
 		return false;
 
@@ -8953,7 +8995,7 @@ bool Scribus171Format::readCharStyles(const QString& fileName, ScribusDoc* doc,
 	bool firstElement = true;
 	//bool success = true;
 
-	QScopedPointer<QIODevice> ioDevice(slaReader(fileName));
+	QScopedPointer<QIODevice> ioDevice(slaSectionReader(fileName, { "CharacterStyles" }));
 	if (ioDevice.isNull())
 		return false;
 
@@ -8995,7 +9037,7 @@ bool Scribus171Format::readLineStyles(const QString& fileName, QHash<QString, Mu
 	bool firstElement = true;
 	bool success = true;
 
-	QScopedPointer<QIODevice> ioDevice(slaReader(fileName));
+	QScopedPointer<QIODevice> ioDevice(slaSectionReader(fileName, { "LineStyles" }));
 	if (ioDevice.isNull())
 		return false;
 
@@ -9045,7 +9087,7 @@ bool Scribus171Format::readColors(const QString& fileName, ColorList & colors)
 	bool firstElement = true;
 	bool success = true;
 
-	QScopedPointer<QIODevice> ioDevice(slaReader(fileName));
+	QScopedPointer<QIODevice> ioDevice(slaSectionReader(fileName, { "Colors" }));
 	if (ioDevice.isNull())
 		return false;
 
@@ -9100,7 +9142,7 @@ bool Scribus171Format::readPageCount(const QString& fileName, int *num1, int *nu
 	notesMasterMarks.clear();
 	notesNSets.clear();
 
-	QScopedPointer<QIODevice> ioDevice(slaReader(fileName));
+	QScopedPointer<QIODevice> ioDevice(slaSectionReader(fileName, { "MasterPages", "Pages" }));
 	if (ioDevice.isNull())
 		return false;
 
@@ -20,11 +20,13 @@ for which a new license (GPL+exception) is in place.
 #include <QProgressBar>
 #include <QString>
 
+class QFile;
 class QIODevice;
 
 class  ColorList;
 class  MultiLine;
 class  PageItem_NoteFrame;
+class  ParallelGzipDevice;
 class  ScLayer;
 class  ScribusDoc;
 //struct ScribusDoc::BookMa;
@@ -55,6 +57,7 @@ class PLUGIN_API Scribus171Format : public LoadSavePlugin
 
 		bool loadFile(const QString & fileName, const FileFormat & fmt, int flags, int index = 0) override;
 		bool saveFile(const QString & fileName, const FileFormat & fmt) override;
+		bool saveToDevice(QIODevice* device, const QString& fileDir) override;
 		
 		bool loadPalette(const QString & fileName) override;
 		bool savePalette(const QString & fileName) override;
@@ -118,6 +121,31 @@ class PLUGIN_API Scribus171Format : public LoadSavePlugin
 		QIODevice* slaReader(const QString & fileName);
 		QIODevice* paletteReader(const QString & fileName);
 
+		//table of contents of saved documents, see scribus171format_index.cpp
+		struct FileSection
+		{
+			QString name;
+			qint64 offset { 0 };
+			qint64 length { 0 };
+			qint64 compressedOffset { -1 };
+			// restart points of the compressing device while saving
+			int startPoint { -1 };
+			int endPoint { -1 };
+		};
+		QList<FileSection> m_fileSections;
+		bool m_recordFileSections { false };
+		ParallelGzipDevice* m_gzipDevice { nullptr };
+		void beginFileSection(ScXmlStreamWriter& docu, const QString& name);
+		void endFileSection(ScXmlStreamWriter& docu);
+		QByteArray fileSectionIndex(qint64 documentLength) const;
+		static QList<FileSection> parseFileSectionIndex(const QByteArray& index, qint64& documentLength);
+		bool writeIndexedFile(QFile& file, const QString& fileDir, bool compress);
+		bool writePlainIndexedFile(QFile& file, const QString& fileDir);
+		bool writeCompressedIndexedFile(QFile& file, const QString& fileDir);
+		QList<FileSection> readFileSections(const QString& fileName, qint64& dataStart) const;
+		//reader for some sections of a document, reads the whole document if the file has no index
+		QIODevice* slaSectionReader(const QString& fileName, const QStringList& sectionNames);
+
 		void getStyle(ParagraphStyle& style, ScXmlStreamReader& reader, StyleSet<ParagraphStyle> *docParagraphStyles, ScribusDoc* doc, bool equiv);
 		void getStyle(CharStyle& style, ScXmlStreamReader& reader, StyleSet<CharStyle> *docCharStyles, ScribusDoc* doc, bool equiv);
 
@@ -180,6 +208,19 @@ class PLUGIN_API Scribus171Format : public LoadSavePlugin
 		};
 		QList<NoteFrameData> notesFramesData;
 		QList<PDFPresentationData> pdfPresEffects;
+
+		//images of items read by loadFile(), loaded all at once after parsing
+		//or, for large documents, on demand by the document's image load scheduler
+		struct DeferredImageLoad
+		{
+			PageItem* item { nullptr };
+			QString clipPath;
+			bool layerFound { false };
+			bool onDemand { false };
+		};
+		QList<DeferredImageLoad> m_deferredImageLoads;
+		bool m_deferImageLoads { false };
+		void loadDeferredImages();
 		
 		void updateNames2Ptr(); //after document load items pointers should be updated in markeredItemList
 
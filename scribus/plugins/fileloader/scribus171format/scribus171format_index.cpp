@@ -0,0 +1,371 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#include "scribus171format.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+
+#include "parallelgzipdevice.h"
+#include "scxmlstreamwriter.h"
+
+/*
+ * Saved documents carry a table of contents giving the location of a few sections,
+ * so that page counts, colors and styles can be read without parsing the whole file.
+ * The document itself stays an ordinary XML file, the table is stored where existing
+ * readers ignore it:
+ * - uncompressed files end with a processing instruction after the root element,
+ *   its offsets and lengths refer to the file content,
+ * - gzip files store it in a "SI" subfield of the gzip header. Each section starts
+ *   a block of the deflate stream sharing no history with the previous data, inflating
+ *   can restart there. Compressed offsets refer to the start of the deflate stream,
+ *   after the gzip header. The subfield is reserved with spaces and filled once the
+ *   compressed document is written.
+ * Index data is a version number and the length of the XML document, followed by one
+ * name:offset:length[:compressedOffset] entry per section. Files whose index is missing
+ * or does not match their content are read completely as before.
+ */
+
+namespace
+{
+	const int sectionIndexVersion = 1;
+	const QByteArray sectionIndexTarget("scribus-index");
+	const char gzipSubfieldId[2] = { 'S', 'I' };
+	// The plain index is searched for at the end of uncompressed files
+	const qint64 maxPlainIndexSearch = 65536;
+	// Room reserved in the gzip header, enough for the few sections indexed
+	const int maxGzipIndexLength = 1024;
+}
+
+void Scribus171Format::beginFileSection(ScXmlStreamWriter& docu, const QString& name)
+{
+	if (!m_recordFileSections)
+		return;
+	FileSection section;
+	section.name = name;
+	// Start tags are closed by the writer once the next token is written, the section
+	// starts at the first '<' written from now on
+	if (m_gzipDevice)
+		section.startPoint = m_gzipDevice->addRestartPoint('<');
+	else
+		section.offset = docu.device()->pos();
+	m_fileSections.append(section);
+}
+
+void Scribus171Format::endFileSection(ScXmlStreamWriter& docu)
+{
+	if (!m_recordFileSections || m_fileSections.isEmpty())
+		return;
+	FileSection& section = m_fileSections.last();
+	if (m_gzipDevice)
+		section.endPoint = m_gzipDevice->addRestartPoint('<');
+	else
+		section.length = docu.device()->pos() - section.offset;
+}
+
+QByteArray Scribus171Format::fileSectionIndex(qint64 documentLength) const
+{
+	QByteArray index = QByteArray::number(sectionIndexVersion) + ' ' + QByteArray::number(documentLength);
+	for (const FileSection& section : m_fileSections)
+	{
+		index += ' ' + section.name.toLatin1() + ':' + QByteArray::number(section.offset) + ':' + QByteArray::number(section.length);
+		if (section.compressedOffset >= 0)
+			index += ':' + QByteArray::number(section.compressedOffset);
+	}
+	return index;
+}
+
+QList<Scribus171Format::FileSection> Scribus171Format::parseFileSectionIndex(const QByteArray& index, qint64& documentLength)
+{
+	QList<FileSection> sections;
+	QList<QByteArray> fields = index.simplified().split(' ');
+	if ((fields.count() < 2) || (fields.at(0).toInt() != sectionIndexVersion))
+		return sections;
+	bool ok = false;
+	documentLength = fields.at(1).toLongLong(&ok);
+	if (!ok)
+		return sections;
+	for (int i = 2; i < fields.count(); ++i)
+	{
+		QList<QByteArray> values = fields.at(i).split(':');
+		if ((values.count() < 3) || (values.count() > 4))
+			return QList<FileSection>();
+		FileSection section;
+		section.name = QString::fromLatin1(values.at(0));
+		bool okOffset = false;
+		bool okLength = false;
+		section.offset = values.at(1).toLongLong(&okOffset);
+		section.length = values.at(2).toLongLong(&okLength);
+		if (values.count() == 4)
+			section.compressedOffset = values.at(3).toLongLong(&ok);
+		if (!okOffset || !okLength || !ok || (section.offset < 0) || (section.length < 0) || (section.offset + section.length > documentLength))
+			return QList<FileSection>();
+		sections.append(section);
+	}
+	return sections;
+}
+
+bool Scribus171Format::writeIndexedFile(QFile& file, const QString& fileDir, bool compress)
+{
+	m_fileSections.clear();
+	m_recordFileSections = true;
+	bool success = compress ? writeCompressedIndexedFile(file, fileDir) : writePlainIndexedFile(file, fileDir);
+	m_recordFileSections = false;
+	m_fileSections.clear();
+	return success;
+}
+
+bool Scribus171Format::writePlainIndexedFile(QFile& file, const QString& fileDir)
+{
+	if (!saveToDevice(&file, fileDir))
+		return false;
+	const qint64 documentLength = file.pos();
+
+	// Turn recorded writer positions into the exact byte ranges of the section elements
+	auto nextTagStart = [&file](qint64 pos) -> qint64 {
+		if (!file.seek(pos))
+			return -1;
+		while (!file.atEnd())
+		{
+			QByteArray data = file.read(4096);
+			int index = data.indexOf('<');
+			if (index >= 0)
+				return pos + index;
+			pos += data.size();
+		}
+		return -1;
+	};
+	for (FileSection& section : m_fileSections)
+	{
+		qint64 start = nextTagStart(section.offset);
+		qint64 end = nextTagStart(section.offset + qMax<qint64>(section.length, 0));
+		if ((start < 0) || (end < start))
+		{
+			m_fileSections.clear();
+			break;
+		}
+		section.offset = start;
+		section.length = end - start;
+	}
+
+	if (!file.seek(documentLength))
+		return false;
+	if (m_fileSections.isEmpty())
+		return true;
+	QByteArray index = "<?" + sectionIndexTarget + ' ' + fileSectionIndex(documentLength) + "?>\n";
+	return (file.write(index) == index.size());
+}
+
+bool Scribus171Format::writeCompressedIndexedFile(QFile& file, const QString& fileDir)
+{
+	// Compression runs on the thread pool while the document is serialised, each section
+	// starts a new compressed block from which inflating can start
+	ParallelGzipDevice gzipDevice(&file);
+	gzipDevice.reserveExtraField(QByteArray(gzipSubfieldId, 2), maxGzipIndexLength);
+	if (!gzipDevice.open(QIODevice::WriteOnly))
+		return false;
+	m_gzipDevice = &gzipDevice;
+	bool success = saveToDevice(&gzipDevice, fileDir);
+	m_gzipDevice = nullptr;
+	gzipDevice.close();
+	if (!success || gzipDevice.hasError())
+		return false;
+
+	for (FileSection& section : m_fileSections)
+	{
+		ParallelGzipDevice::RestartPoint start = gzipDevice.restartPoint(section.startPoint);
+		ParallelGzipDevice::RestartPoint end = gzipDevice.restartPoint(section.endPoint);
+		if ((start.offset < 0) || (start.compressedOffset < 0) || (end.offset < start.offset))
+		{
+			m_fileSections.clear();
+			break;
+		}
+		section.offset = start.offset;
+		section.length = end.offset - start.offset;
+		section.compressedOffset = start.compressedOffset;
+	}
+	// The index is only an accelerator, the file stays valid without it
+	if (!m_fileSections.isEmpty())
+	{
+		QByteArray index = fileSectionIndex(gzipDevice.uncompressedSize());
+		if (index.size() <= maxGzipIndexLength)
+			gzipDevice.setExtraField(index);
+	}
+	return true;
+}
+
+QList<Scribus171Format::FileSection> Scribus171Format::readFileSections(const QString& fileName, qint64& dataStart) const
+{
+	QList<FileSection> sections;
+	qint64 documentLength = 0;
+	dataStart = 0;
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return sections;
+
+	if (fileName.right(2) != "gz")
+	{
+		qint64 searchLength = qMin(file.size(), maxPlainIndexSearch);
+		if (!file.seek(file.size() - searchLength))
+			return sections;
+		QByteArray tail = file.read(searchLength);
+		int indexStart = tail.lastIndexOf("<?" + sectionIndexTarget + ' ');
+		int indexEnd = tail.indexOf("?>", indexStart);
+		if ((indexStart < 0) || (indexEnd < 0))
+			return sections;
+		int dataOffset = indexStart + sectionIndexTarget.size() + 3;
+		sections = parseFileSectionIndex(tail.mid(dataOffset, indexEnd - dataOffset), documentLength);
+		// The index must directly follow the document it describes
+		if (file.size() - searchLength + indexStart != documentLength)
+			sections.clear();
+		return sections;
+	}
+
+	QByteArray header = file.read(12);
+	if ((header.size() < 12) || (header.at(0) != '\x1f') || (header.at(1) != '\x8b') || (header.at(2) != '\x08'))
+		return sections;
+	const int flags = static_cast<uchar>(header.at(3));
+	if ((flags & 0x04) == 0)
+		return sections;
+	const int extraLength = static_cast<uchar>(header.at(10)) | (static_cast<uchar>(header.at(11)) << 8);
+	QByteArray extra = file.read(extraLength);
+	if (extra.size() != extraLength)
+		return sections;
+
+	QByteArray index;
+	for (int pos = 0; pos + 4 <= extra.size(); )
+	{
+		int length = static_cast<uchar>(extra.at(pos + 2)) | (static_cast<uchar>(extra.at(pos + 3)) << 8);
+		if ((extra.at(pos) == gzipSubfieldId[0]) && (extra.at(pos + 1) == gzipSubfieldId[1]))
+		{
+			index = extra.mid(pos + 4, length);
+			break;
+		}
+		pos += 4 + length;
+	}
+	if (index.isEmpty())
+		return sections;
+
+	// Skip file name, comment and header checksum if any tool added them
+	dataStart = 12 + extraLength;
+	for (int flag : { 0x08, 0x10 })
+	{
+		if ((flags & flag) == 0)
+			continue;
+		char c = 0;
+		do
+		{
+			if (!file.getChar(&c))
+				return sections;
+			++dataStart;
+		} while (c != 0);
+	}
+	if (flags & 0x02)
+		dataStart += 2;
+
+	sections = parseFileSectionIndex(index, documentLength);
+	for (const FileSection& section : std::as_const(sections))
+	{
+		if (section.compressedOffset < 0)
+			return QList<FileSection>();
+	}
+
+	// The gzip trailer ends with the uncompressed size modulo 2^32
+	if (!file.seek(file.size() - 4))
+		return QList<FileSection>();
+	QByteArray sizeBytes = file.read(4);
+	if (sizeBytes.size() != 4)
+		return QList<FileSection>();
+	quint32 storedSize = 0;
+	for (int i = 3; i >= 0; --i)
+		storedSize = (storedSize << 8) | static_cast<uchar>(sizeBytes.at(i));
+	if (storedSize != static_cast<quint32>(documentLength & 0xffffffff))
+		sections.clear();
+	return sections;
+}
+
+QIODevice* Scribus171Format::slaSectionReader(const QString& fileName, const QStringList& sectionNames)
+{
+	if (!fileSupported(nullptr, fileName))
+		return nullptr;
+
+	qint64 dataStart = 0;
+	const QList<FileSection> sections = readFileSections(fileName, dataStart);
+	QList<FileSection> requested;
+	for (const QString& name : sectionNames)
+	{
+		auto it = std::find_if(sections.begin(), sections.end(), [&name](const FileSection& section) { return section.name == name; });
+		if (it == sections.end())
+			return slaReader(fileName);
+		requested.append(*it);
+	}
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return nullptr;
+
+	// Wrap the sections in a root element, readers then parse them like a complete document
+	QByteArray data("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<SCRIBUSUTF8NEW>\n");
+	for (const FileSection& section : std::as_const(requested))
+	{
+		if (section.length == 0)
+			continue;
+		QByteArray sectionData;
+		if (fileName.right(2) != "gz")
+		{
+			if (file.seek(section.offset))
+				sectionData = file.read(section.length);
+		}
+		else if (file.seek(dataStart + section.compressedOffset))
+		{
+			z_stream zs;
+			zs.zalloc = Z_NULL;
+			zs.zfree = Z_NULL;
+			zs.opaque = Z_NULL;
+			zs.next_in = Z_NULL;
+			zs.avail_in = 0;
+			if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+				return slaReader(fileName);
+			sectionData.resize(section.length);
+			zs.next_out = reinterpret_cast<Bytef*>(sectionData.data());
+			zs.avail_out = static_cast<uInt>(section.length);
+			int status = Z_OK;
+			while ((zs.avail_out > 0) && (status == Z_OK))
+			{
+				QByteArray input = file.read(65536);
+				if (input.isEmpty())
+					break;
+				zs.next_in = reinterpret_cast<Bytef*>(input.data());
+				zs.avail_in = static_cast<uInt>(input.size());
+				while ((zs.avail_in > 0) && (zs.avail_out > 0) && (status == Z_OK))
+					status = inflate(&zs, Z_NO_FLUSH);
+			}
+			if (zs.avail_out > 0)
+				sectionData.clear();
+			inflateEnd(&zs);
+		}
+		// Stale or damaged index, read the whole document instead
+		if ((sectionData.size() != section.length) || !sectionData.startsWith('<'))
+			return slaReader(fileName);
+		data += sectionData;
+	}
+	data += "\n</SCRIBUSUTF8NEW>\n";
+
+	auto* buffer = new QBuffer();
+	buffer->setData(data);
+	if (!buffer->open(QIODevice::ReadOnly))
+	{
+		delete buffer;
+		return nullptr;
+	}
+	return buffer;
+}
@@ -33,7 +33,6 @@ for which a new license (GPL+exception) is in place.
 #include "pageitem_spiral.h"
 #include "pageitem_table.h"
 #include "prefsmanager.h"
-#include "qtiocompressor.h"
 #include "resourcecollection.h"
 #include "scconfig.h"
 #include "scpaths.h"
@@ -272,49 +271,11 @@ bool Scribus171Format::savePalette(const QString & fileName)
 	return writeSucceed;
 }
 
-bool Scribus171Format::saveFile(const QString & fileName, const FileFormat & /* fmt */)
+bool Scribus171Format::saveToDevice(QIODevice* device, const QString& fileDir)
 {
-	m_lastSavedFile = "";
-
-	// #11279: Image links get corrupted when symlinks involved
-	// We have to proceed in tow steps here as QFileInfo::canonicalPath()
-	// may not return correct result if fileName does not exists
-	QString fileDir = QFileInfo(fileName).absolutePath();
-	QString canonicalPath = QFileInfo(fileDir).canonicalFilePath();
-	if (!canonicalPath.isEmpty())
-		fileDir = canonicalPath;
-
-	// Create a random temporary file name
-	srand(time(nullptr)); // initialize random sequence each time
-	long randt = 0;
-	long randn = 1 + (int) (((double) rand() / ((double) RAND_MAX + 1)) * 10000);
-	QString  tmpFileName  = QString("%1.%2").arg(fileName).arg(randn);
-	while (QFile::exists(tmpFileName) && (randt < 100))
-	{
-		randn = 1 + (int) (((double) rand() / ((double) RAND_MAX + 1)) * 10000);
-		tmpFileName = QString("%1.%2").arg(fileName).arg(randn);
-		++randt;
-	}
-	if (QFile::exists(tmpFileName))
-		return false;
-
-	QScopedPointer<QIODevice> outputFile;
-	if (fileName.toLower().right(2) == "gz")
-	{
-		aFile.setFileName(tmpFileName);
-		QtIOCompressor *compressor = new QtIOCompressor(&aFile);
-		compressor->setStreamFormat(QtIOCompressor::GzipFormat);
-		outputFile.reset(compressor);
-	}
-	else
-		outputFile.reset( new QFile(tmpFileName) );
-
-	if (!outputFile->open(QIODevice::WriteOnly))
-		return false;
-
 	ScXmlStreamWriter docu;
 	docu.setAutoFormatting(true);
-	docu.setDevice(outputFile.data());
+	docu.setDevice(device);
 	docu.writeStartDocument();
 	docu.writeStartElement("SCRIBUSUTF8NEW");
 	docu.writeAttribute("Version", ScribusAPI::getVersion());
@@ -515,14 +476,22 @@ bool Scribus171Format::saveFile(const QString & fileName, const FileFormat & /*
 	writeCheckerProfiles(docu);
 	writeJavascripts(docu);
 	writeBookmarks(docu);
+	beginFileSection(docu, "Colors");
 	writeColors(docu);
+	endFileSection(docu);
 	writeGradients(docu);
 	writeHyphenatorLists(docu);
+	beginFileSection(docu, "CharacterStyles");
 	writeCharStyles(docu);
+	endFileSection(docu);
+	beginFileSection(docu, "ParagraphStyles");
 	writeParagraphStyles(docu);
+	endFileSection(docu);
 	writeTableStyles(docu);
 	writeCellStyles(docu);
+	beginFileSection(docu, "LineStyles");
 	writeLineStyles(docu);
+	endFileSection(docu);
 	writeArrowStyles(docu);
 	writeLayers(docu);
 	writePrintOptions(docu);
@@ -542,14 +511,45 @@ bool Scribus171Format::saveFile(const QString & fileName, const FileFormat & /*
 
 	docu.writeEndElement();
 	docu.writeEndDocument();
+	return !docu.hasError();
+}
 
-	bool  writeSucceed = false;
-	const QFile* qFile = qobject_cast<QFile*>(outputFile.data());
-	if (qFile)
-		writeSucceed = (qFile->error() == QFile::NoError);
-	else
-		writeSucceed = true;
-	outputFile->close();
+bool Scribus171Format::saveFile(const QString & fileName, const FileFormat & /* fmt */)
+{
+	m_lastSavedFile = "";
+
+	// #11279: Image links get corrupted when symlinks involved
+	// We have to proceed in tow steps here as QFileInfo::canonicalPath()
+	// may not return correct result if fileName does not exists
+	QString fileDir = QFileInfo(fileName).absolutePath();
+	QString canonicalPath = QFileInfo(fileDir).canonicalFilePath();
+	if (!canonicalPath.isEmpty())
+		fileDir = canonicalPath;
+
+	// Create a random temporary file name
+	srand(time(nullptr)); // initialize random sequence each time
+	long randt = 0;
+	long randn = 1 + (int) (((double) rand() / ((double) RAND_MAX + 1)) * 10000);
+	QString  tmpFileName  = QString("%1.%2").arg(fileName).arg(randn);
+	while (QFile::exists(tmpFileName) && (randt < 100))
+	{
+		randn = 1 + (int) (((double) rand() / ((double) RAND_MAX + 1)) * 10000);
+		tmpFileName = QString("%1.%2").arg(fileName).arg(randn);
+		++randt;
+	}
+	if (QFile::exists(tmpFileName))
+		return false;
+
+	// Sections of the document are indexed while it is written, see scribus171format_index.cpp.
+	// Uncompressed files are read back to locate them.
+	bool compress = (fileName.toLower().right(2) == "gz");
+	QFile outputFile(tmpFileName);
+	if (!outputFile.open(compress ? QIODevice::WriteOnly : QIODevice::ReadWrite))
+		return false;
+
+	bool writeSucceed = writeIndexedFile(outputFile, fileDir, compress);
+	writeSucceed &= (outputFile.error() == QFile::NoError);
+	outputFile.close();
 	if (writeSucceed)
 	{
 		if (QFile::exists(fileName))
@@ -1756,8 +1756,12 @@ void Scribus171Format::writeContent(ScXmlStreamWriter & docu, const QString& bas
 		m_mwProgressBar->setMaximum(m_Doc->DocPages.count()+m_Doc->MasterPages.count()+m_Doc->DocItems.count()+m_Doc->MasterItems.count()+m_Doc->FrameItems.count());
 		m_mwProgressBar->setValue(0);
 	}
+	beginFileSection(docu, "MasterPages");
 	WritePages(m_Doc, docu, m_mwProgressBar, 0, true);
+	endFileSection(docu);
+	beginFileSection(docu, "Pages");
 	WritePages(m_Doc, docu, m_mwProgressBar, m_Doc->MasterPages.count(), false);
+	endFileSection(docu);
 	WriteObjects(m_Doc, docu, baseDir, m_mwProgressBar, m_Doc->MasterPages.count()+m_Doc->DocPages.count(), ItemSelectionFrame);
 	WriteObjects(m_Doc, docu, baseDir, m_mwProgressBar, m_Doc->MasterPages.count()+m_Doc->DocPages.count()+m_Doc->FrameItems.count(), ItemSelectionMaster);
 	WriteObjects(m_Doc, docu, baseDir, m_mwProgressBar, m_Doc->MasterPages.count()+m_Doc->DocPages.count()+m_Doc->MasterItems.count()+m_Doc->FrameItems.count(), ItemSelectionPage);
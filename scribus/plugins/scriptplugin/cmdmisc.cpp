@@ -7,11 +7,13 @@ for which a new license (GPL+exception) is in place.
 #include "cmdmisc.h"
 #include "cmdutil.h"
 
+#include <memory>
 #include <string>
 
 #include <QBuffer>
 #include <QList>
 #include <QPixmap>
+#include <QPointer>
 
 #include "prefsmanager.h"
 #include "pyesstring.h"
@@ -19,6 +21,8 @@ for which a new license (GPL+exception) is in place.
 #include "scribusdoc.h"
 #include "scribusview.h"
 #include "selection.h"
+#include "undomanager.h"
+#include "undotransaction.h"
 #include "fonts/scfontmetrics.h"
 #include "pdfoptionsio.h"
 
@@ -33,6 +37,98 @@ PyObject *scribus_setredraw(PyObject* /* self */, PyObject* args)
 	Py_RETURN_NONE;
 }
 
+namespace
+{
+	// Batch edit started by beginBatchEdit()
+	struct BatchEdit
+	{
+		int depth { 0 };
+		QPointer<ScribusDoc> doc;
+		bool wasDrawing { true };
+		std::unique_ptr<UndoTransaction> transaction;
+	};
+
+	BatchEdit& batchEdit()
+	{
+		static BatchEdit edit;
+		return edit;
+	}
+
+	void endBatchEdit(BatchEdit& edit)
+	{
+		edit.depth = 0;
+		ScribusDoc* doc = edit.doc;
+		edit.doc.clear();
+		if (doc == nullptr)
+		{
+			// The document was closed during the batch edit
+			if (edit.transaction)
+				edit.transaction->cancel();
+			edit.transaction.reset();
+			return;
+		}
+		if (edit.transaction)
+		{
+			edit.transaction->commit();
+			edit.transaction.reset();
+		}
+		doc->DoDrawing = edit.wasDrawing;
+		// Sends the merged notifications of the edit, then the whole document is redrawn once
+		doc->updateManager()->setUpdatesEnabled();
+		doc->regionsChanged()->update(QRectF());
+		doc->changed();
+	}
+}
+
+PyObject *scribus_beginbatchedit(PyObject* /* self */, PyObject* args)
+{
+	PyESString name;
+	if (!PyArg_ParseTuple(args, "|es", "utf-8", name.ptr()))
+		return nullptr;
+	if (!checkHaveDocument())
+		return nullptr;
+	BatchEdit& edit = batchEdit();
+	if (edit.depth++ > 0)
+		Py_RETURN_NONE;
+
+	ScribusDoc* doc = ScCore->primaryMainWindow()->doc;
+	edit.doc = doc;
+	edit.wasDrawing = doc->DoDrawing;
+	doc->DoDrawing = false;
+	doc->updateManager()->setUpdatesDisabled();
+	if (UndoManager::undoEnabled())
+	{
+		QString actionName = (name.length() > 0) ? QString::fromUtf8(name.c_str()) : QObject::tr("Script");
+		edit.transaction = std::make_unique<UndoTransaction>(UndoManager::instance()->beginTransaction(doc->getUName(), Um::IDocument, actionName));
+	}
+	Py_RETURN_NONE;
+}
+
+PyObject *scribus_endbatchedit(PyObject* /* self */)
+{
+	BatchEdit& edit = batchEdit();
+	if (edit.depth == 0)
+	{
+		PyErr_SetString(PyExc_RuntimeError, QObject::tr("No batch edit is running.", "python error").toUtf8().constData());
+		return nullptr;
+	}
+	if (--edit.depth == 0)
+		endBatchEdit(edit);
+	Py_RETURN_NONE;
+}
+
+PyObject *scribus_isbatchediting(PyObject* /* self */)
+{
+	return PyBool_FromLong(static_cast<long>(batchEdit().depth > 0));
+}
+
+void finishBatchEdit()
+{
+	BatchEdit& edit = batchEdit();
+	if (edit.depth > 0)
+		endBatchEdit(edit);
+}
+
 PyObject *scribus_getfontnames(PyObject* /* self */)
 {
 	int cc2 = 0;
@@ -805,8 +901,10 @@ PV */
 void cmdmiscdocwarnings()
 {
 	QStringList s;
-	s << scribus_createlayer__doc__
+	s << scribus_beginbatchedit__doc__
+	  << scribus_createlayer__doc__
 	  << scribus_deletelayer__doc__
+	  << scribus_endbatchedit__doc__
 	  << scribus_filequit__doc__
 	  << scribus_getfontnames__doc__
 	  << scribus_getactivelayer__doc__ 
@@ -814,6 +912,7 @@ void cmdmiscdocwarnings()
 	  << scribus_getlayerblendmode__doc__
 	  << scribus_getlayers__doc__
 	  << scribus_getlayertransparency__doc__
+	  << scribus_isbatchediting__doc__
 	  << scribus_islayerflow__doc__
 	  << scribus_islayerlocked__doc__
 	  << scribus_islayeroutlined__doc__
@@ -25,6 +25,44 @@ setRedraw(True) in a finally: clause at the top level of your script.\n\
 /*! Enable/disable page redrawing. */
 PyObject *scribus_setredraw(PyObject * /*self*/, PyObject* args);
 
+/*! docstring */
+PyDoc_STRVAR(scribus_beginbatchedit__doc__,
+QT_TR_NOOP("beginBatchEdit([\"name\"])\n\
+\n\
+Starts a batch edit of the current document. Until endBatchEdit() is called,\n\
+changes made by the script are collected into a single undo action named \"name\",\n\
+and redrawing and notifications of changed items are held back and merged.\n\
+Use it when a script changes many items, e.g. when placing thousands of frames.\n\
+Batch edits may be nested, only the outermost one takes effect. A batch edit\n\
+still open when the script ends is ended automatically.\n\
+"));
+/*! Start a batch edit. */
+PyObject *scribus_beginbatchedit(PyObject * /*self*/, PyObject* args);
+
+/*! docstring */
+PyDoc_STRVAR(scribus_endbatchedit__doc__,
+QT_TR_NOOP("endBatchEdit()\n\
+\n\
+Ends the batch edit started by beginBatchEdit(). The document is redrawn\n\
+once and the collected changes become a single undo action.\n\
+\n\
+May raise RuntimeError if no batch edit is running.\n\
+"));
+/*! End a batch edit. */
+PyObject *scribus_endbatchedit(PyObject * /*self*/);
+
+/*! docstring */
+PyDoc_STRVAR(scribus_isbatchediting__doc__,
+QT_TR_NOOP("isBatchEditing() -> bool\n\
+\n\
+Returns True if a batch edit is running, see beginBatchEdit().\n\
+"));
+/*! Test if a batch edit is running. */
+PyObject *scribus_isbatchediting(PyObject * /*self*/);
+
+/*! Ends a batch edit left open by a script, called once the script has finished. */
+void finishBatchEdit();
+
 /*! docstring */
 PyDoc_STRVAR(scribus_getfontnames__doc__,
 QT_TR_NOOP("getFontNames() -> list\n\
@@ -17,6 +17,7 @@ for which a new license (GPL+exception) is in place.
 #include <QStringList>
 #include <QWidget>
 
+#include "cmdmisc.h"
 #include "cmdutil.h"
 #include "pconsole.h"
 #include "prefscontext.h"
@@ -382,6 +383,7 @@ void ScripterCore::slotRunScriptFile(const QString& fileName, QStringList argume
 		ScCore->primaryMainWindow()->setScriptRunning(false);
 	}
 
+	finishBatchEdit();
 	enableMainWindowMenu();
 }
 
@@ -466,6 +468,7 @@ void ScripterCore::slotRunScript(const QString& Script)
 	}
 	ScCore->primaryMainWindow()->setScriptRunning(false);
 
+	finishBatchEdit();
 	enableMainWindowMenu();
 }
 
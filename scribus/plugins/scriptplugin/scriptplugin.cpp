@@ -284,6 +284,7 @@ PyMethodDef scribus_methods[] = {
 	// 2004/10/03 pv - aliases with common Python syntax - ClassName methodName
 	// 2004-11-06 cr - move aliasing to dynamically generated wrapper functions, sort methoddef
 	{ "applyMasterPage", scribus_applymasterpage, METH_VARARGS, tr(scribus_applymasterpage__doc__)},
+	{ "beginBatchEdit", scribus_beginbatchedit, METH_VARARGS, tr(scribus_beginbatchedit__doc__)},
 	{ "changeColor", scribus_setcolor, METH_VARARGS, tr(scribus_setcolor__doc__)},
 	{ "changeColorCMYK", scribus_setcolorcmyk, METH_VARARGS, tr(scribus_setcolorcmyk__doc__)},
 	{ "changeColorCMYKFloat", scribus_setcolorcmykfloat, METH_VARARGS, tr(scribus_setcolorcmykfloat__doc__)},
@@ -326,6 +327,7 @@ PyMethodDef scribus_methods[] = {
 	{ "deselectAll", (PyCFunction) scribus_deselectall, METH_NOARGS, tr(scribus_deselectall__doc__)},
 	{ "docChanged", scribus_docchanged, METH_VARARGS, tr(scribus_docchanged__doc__)},
 	{ "editMasterPage", scribus_editmasterpage, METH_VARARGS, tr(scribus_editmasterpage__doc__)},
+	{ "endBatchEdit", (PyCFunction) scribus_endbatchedit, METH_NOARGS, tr(scribus_endbatchedit__doc__)},
 	{ "fileDialog", (PyCFunction) scribus_filedialog, METH_VARARGS|METH_KEYWORDS, tr(scribus_filedialog__doc__)},
 	{ "fileQuit", scribus_filequit, METH_VARARGS, tr(scribus_filequit__doc__)},
 	{ "flipObject", scribus_flipobject, METH_VARARGS, tr(scribus_flipobject__doc__)},
@@ -454,6 +456,7 @@ PyMethodDef scribus_methods[] = {
 	{ "insertTableColumns", scribus_inserttablecolumns, METH_VARARGS, tr(scribus_inserttablecolumns__doc__)},
 	{ "insertTableRows", scribus_inserttablerows, METH_VARARGS, tr(scribus_inserttablerows__doc__)},
 	{ "insertText", scribus_inserttext, METH_VARARGS, tr(scribus_inserttext__doc__)},
+	{ "isBatchEditing", (PyCFunction) scribus_isbatchediting, METH_NOARGS, tr(scribus_isbatchediting__doc__)},
 	{ "isExportable", scribus_isexportable, METH_VARARGS, tr(scribus_isexportable__doc__)},
 	{ "isLayerFlow", scribus_islayerflow, METH_VARARGS, tr(scribus_islayerflow__doc__)},
 	{ "isLayerLocked", scribus_islayerlocked, METH_VARARGS, tr(scribus_islayerlocked__doc__)},
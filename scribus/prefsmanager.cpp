@@ -457,6 +457,7 @@ void PrefsManager::initDefaults()
 	appPrefs.pageSets.append(pageS);
 	appPrefs.docSetupPrefs.pagePositioning = singlePage;
 	appPrefs.fontPrefs.askBeforeSubstitute = true;
+	appPrefs.fontPrefs.glyphCacheSizeMiB = 64;
 	appPrefs.miscPrefs.haveStylePreview = true;
 	appPrefs.miscPrefs.saveEmergencyFile = true;
 	// lorem ipsum defaults
@@ -1508,6 +1509,7 @@ bool PrefsManager::writePref(const QString& filePath)
 
 	QDomElement dcFonts = docu.createElement("Fonts");
 	dcFonts.setAttribute("AutomaticSubstitution", static_cast<int>(appPrefs.fontPrefs.askBeforeSubstitute));
+	dcFonts.setAttribute("GlyphCacheSize", appPrefs.fontPrefs.glyphCacheSizeMiB);
 	elem.appendChild(dcFonts);
 
 	QDomElement dcTypography = docu.createElement("Typography");
@@ -2617,6 +2619,7 @@ bool PrefsManager::readPref(const QString& filePath)
 		if (dc.tagName() == "Fonts")
 		{
 			appPrefs.fontPrefs.askBeforeSubstitute = static_cast<bool>(dc.attribute("AutomaticSubstitution", "1").toInt());
+			appPrefs.fontPrefs.glyphCacheSizeMiB = dc.attribute("GlyphCacheSize", "64").toInt();
 		}
 		if (dc.tagName() == "Font")
 		{
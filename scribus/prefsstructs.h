@@ -311,6 +311,7 @@ struct FontPrefs
 {
 	SCFonts AvailFonts; //! Fonts that Scribus has available to it, or the current document has available to use
 	bool askBeforeSubstitute; //! Request that the user confirms a font substitution or not
+	int glyphCacheSizeMiB; //! Memory budget of the glyph outlines and metrics cached for all fonts
 	QMap<QString,QString> GFontSub;
 };
 
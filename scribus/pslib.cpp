@@ -1598,6 +1598,9 @@ int PSLib::createPS(const QString& outputFileName)
 	if (!PS_set_file(outputFileName))
 		return 1;
 
+	// Images of large documents are loaded on demand, output needs all of them
+	m_Doc->imageLoadScheduler()->loadAll();
+
 	std::vector<int> &pageNs = Options.pageNumbers;
 	bool outputSep = Options.outputSeparations;
 	QString separationName = Options.separationName;
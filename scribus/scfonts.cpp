@@ -16,8 +16,8 @@ for which a new license (GPL+exception) is in place.
 */
 
 #include <QApplication>
+#include <QDataStream>
 #include <QDir>
-#include <QDomDocument>
 #include <QFile>
 #include <QFileInfo>
 #include <QFont>
@@ -25,14 +25,18 @@ for which a new license (GPL+exception) is in place.
 #include <QHash>
 #include <QMap>
 #include <QRawFont>
-#ifdef Q_OS_WIN32
+#include <QSaveFile>
+#include <QSemaphore>
 #include <QSet>
+#ifdef Q_OS_WIN32
 #include <QSettings>
 #include <QStandardPaths>
 #endif
 #include <QString>
 #include <QTextCodec>
+#include <QThreadPool>
 
+#include <atomic>
 #include <cstdlib>
 #include <utility>
 #include <vector>
@@ -79,6 +83,14 @@ for which a new license (GPL+exception) is in place.
 
 /***************************************************************************/
 
+namespace
+{
+	const QString fontIndexFileName = QStringLiteral("fontindex170.bin");
+	const quint32 fontIndexMagic = 0x53434649; // "SCFI"
+	// Increase whenever the index layout or the metadata stored for faces changes
+	const quint16 fontIndexVersion = 1;
+}
+
 SCFonts::SCFonts()
 {
 //	insert("", ScFace::none()); // Wtf why inserting an empty entry here ????
@@ -125,6 +137,30 @@ void SCFonts::addPath(QString p)
 }
 
 void SCFonts::addScalableFonts(const QString &path, const QString& DocName)
+{
+	QStringList fontFiles;
+	QStringList resourceForkFiles;
+	findFontFiles(path, DocName.isEmpty(), fontFiles, resourceForkFiles);
+	addScalableFontFiles(fontFiles, DocName);
+
+	if (resourceForkFiles.isEmpty())
+		return;
+	// Files without extension may be Mac fonts having their data in the resource fork
+	FT_Library library = nullptr;
+	FT_Init_FreeType(&library);
+	for (const QString& fileName : std::as_const(resourceForkFiles))
+	{
+		bool error = addScalableFont(fileName, library, DocName);
+		if (error)
+			addScalableFont(fileName + "/..namedfork/rsrc", library, DocName);
+	}
+	FT_Done_FreeType(library);
+}
+
+/* Collect the font files found in path, and in its subdirectories
+   if recursive is set, in the order fonts should be registered.
+*/
+void SCFonts::findFontFiles(const QString& path, bool recursive, QStringList& fontFiles, QStringList& resourceForkFiles) const
 {
 	//Make sure this is not empty or we will scan the whole drive on *nix
 	//QString()+/ is / of course.
@@ -132,83 +168,138 @@ void SCFonts::addScalableFonts(const QString &path, const QString& DocName)
 		return;
 	QString pathfile, fullpath;
 
-	FT_Library library = nullptr;
-	FT_Init_FreeType (&library );
-
 	QString pathname(path);
 	if (!pathname.endsWith("/"))
 		pathname += "/";
 	pathname = QDir::toNativeSeparators(pathname);
 
 	QDir d(pathname, "*", QDir::Name, QDir::Dirs | QDir::Files | QDir::Readable);
-	if ((d.exists()) && (d.count() != 0))
+	if ((!d.exists()) || (d.count() == 0))
+		return;
+	for (uint i = 0; i < d.count(); ++i)
 	{
-		for (uint i = 0; i < d.count(); ++i)
+		// readdir may return . or .., which we don't want to recurse
+		// over. Skip 'em.
+		if (d[i] == "." || d[i] == "..")
+			continue;
+		fullpath = pathname + d[i];
+		QFileInfo fi(fullpath);
+		if (!fi.exists())      // Sanity check for broken Symlinks
+			continue;
+
+		QCoreApplication::processEvents();
+
+		bool symlink = fi.isSymLink();
+		if (symlink)
 		{
-			// readdir may return . or .., which we don't want to recurse
-			// over. Skip 'em.
-			if (d[i] == "." || d[i] == "..")
-				continue;
-			fullpath = pathname + d[i];
-			QFileInfo fi(fullpath);
-			if (!fi.exists())      // Sanity check for broken Symlinks
-				continue;
-			
-			QCoreApplication::processEvents();
-			
-			bool symlink = fi.isSymLink();
-			if (symlink)
-			{
-				QFileInfo fi3(fi.symLinkTarget());
-				if (fi3.isRelative())
-					pathfile = pathname + fi.symLinkTarget();
-				else
-					pathfile = fi3.absoluteFilePath();
-			}
+			QFileInfo fi3(fi.symLinkTarget());
+			if (fi3.isRelative())
+				pathfile = pathname + fi.symLinkTarget();
 			else
-				pathfile = fullpath;
-			QFileInfo fi2(pathfile);
-			if (fi2.isDir()) 
+				pathfile = fi3.absoluteFilePath();
+		}
+		else
+			pathfile = fullpath;
+		QFileInfo fi2(pathfile);
+		if (fi2.isDir()) 
+		{
+			if (symlink)
 			{
-				if (symlink)
+				// Check if symlink points to a parent directory
+				// in order to avoid infinite recursion
+				QString fullpath2 = fullpath, pathfile2 = pathfile;
+				if (ScCore->isWinGUI())
 				{
-					// Check if symlink points to a parent directory
-					// in order to avoid infinite recursion
-					QString fullpath2 = fullpath, pathfile2 = pathfile;
-					if (ScCore->isWinGUI())
-					{
-						// Ensure both path use same separators on Windows
-						fullpath2 = QDir::toNativeSeparators(fullpath2.toLower());
-						pathfile2 = QDir::toNativeSeparators(pathfile2.toLower());
-					}
-					if (fullpath2.startsWith(pathfile2))
-						continue;
+					// Ensure both path use same separators on Windows
+					fullpath2 = QDir::toNativeSeparators(fullpath2.toLower());
+					pathfile2 = QDir::toNativeSeparators(pathfile2.toLower());
 				}
-				if (DocName.isEmpty())
-					addScalableFonts(pathfile);
-				continue;
-			}
-			QString ext = fi.suffix().toLower();
-			QString ext2 = fi2.suffix().toLower();
-			if ((ext != ext2) && (ext.isEmpty())) 
-				ext = ext2;
-			if ((ext == "ttc") || (ext == "dfont") || (ext == "pfa") || (ext == "pfb") || (ext == "ttf") || (ext == "otf"))
-			{
-				addScalableFont(pathfile, library, DocName);
+				if (fullpath2.startsWith(pathfile2))
+					continue;
 			}
+			if (recursive)
+				findFontFiles(pathfile, recursive, fontFiles, resourceForkFiles);
+			continue;
+		}
+		QString ext = fi.suffix().toLower();
+		QString ext2 = fi2.suffix().toLower();
+		if ((ext != ext2) && (ext.isEmpty())) 
+			ext = ext2;
+		if ((ext == "ttc") || (ext == "dfont") || (ext == "pfa") || (ext == "pfb") || (ext == "ttf") || (ext == "otf"))
+			fontFiles.append(pathfile);
 #ifdef Q_OS_MACOS
-			else if (ext.isEmpty() && DocName.isEmpty())
-			{
-				bool error = addScalableFont(pathfile, library, DocName);
-				if (error)
-					error = addScalableFont(pathfile + "/..namedfork/rsrc",library, DocName);
-			}
-#endif				
+		else if (ext.isEmpty() && recursive)
+			resourceForkFiles.append(pathfile);
+#endif
+	}
+}
+
+/* Register the passed font files. Files whose font index entry is
+   still valid are registered without being opened, the other ones
+   are scanned first, concurrently as this is what takes time at startup.
+*/
+void SCFonts::addScalableFontFiles(const QStringList& fileNames, const QString& DocName)
+{
+	struct ScanJob
+	{
+		QString fileName;
+		IndexedFontFile result;
+	};
+	std::vector<ScanJob> scanJobs;
+	QSet<QString> scanFiles;
+	for (const QString& fileName : fileNames)
+	{
+		if (scanFiles.contains(fileName) || isIndexed(fileName))
+			continue;
+		scanFiles.insert(fileName);
+		scanJobs.push_back({ fileName, IndexedFontFile() });
+	}
+
+	if (!scanJobs.empty())
+	{
+		if (m_checkedFonts.isEmpty())
+			ScCore->setSplashStatus( QObject::tr("Creating Font Cache") );
+		else
+			ScCore->setSplashStatus( QObject::tr("New Font found, checking...") );
+
+		// A FreeType library must not be used by several threads at once, give each worker its own
+		QThreadPool* threadPool = QThreadPool::globalInstance();
+		const int jobCount = static_cast<int>(scanJobs.size());
+		const int workerCount = qBound(1, threadPool->maxThreadCount(), jobCount);
+		std::atomic<int> nextJob { 0 };
+		QSemaphore workersDone;
+		for (int i = 0; i < workerCount; ++i)
+		{
+			threadPool->start([&scanJobs, &nextJob, &workersDone, jobCount]() {
+				FT_Library library = nullptr;
+				FT_Init_FreeType(&library);
+				for (int j = nextJob++; j < jobCount; j = nextJob++)
+					scanJobs[j].result = scanFontFile(scanJobs[j].fileName, library);
+				FT_Done_FreeType(library);
+				workersDone.release();
+			});
 		}
+		while (!workersDone.tryAcquire(workerCount, 50))
+			QCoreApplication::processEvents();
+
+		for (const ScanJob& job : scanJobs)
+			m_checkedFonts.insert(job.fileName, job.result);
 	}
-	FT_Done_FreeType(library);
+
+	// Faces are registered in the order files were found, first one wins for duplicates
+	for (const QString& fileName : fileNames)
+		registerFontFile(fileName, DocName);
 }
 
+// Returns true if the font index has an entry for that file which is still valid
+bool SCFonts::isIndexed(const QString& filename) const
+{
+	auto it = m_checkedFonts.constFind(filename);
+	if (it == m_checkedFonts.cend())
+		return false;
+	QFileInfo fi(filename);
+	return (it->lastModified == fi.lastModified().toSecsSinceEpoch()) && (it->size == fi.size());
+}
 
 /*****
    What to do with font files:
@@ -635,181 +726,114 @@ ScFace SCFonts::loadScalableFont(const QString &filename)
 
 static QString getFtError(int code)
 {
+	// Font files get scanned concurrently, fill the table once only
+	static const QHash<int, QString> ftErrors = []() {
+		QHash<int, QString> errors;
 #undef FTERRORS_H_
-#define FT_ERRORDEF(e, v, s) ftErrors[e] = s;
-	static QHash<int, QString> ftErrors;
+#define FT_ERRORDEF(e, v, s) errors[e] = s;
 #include FT_ERRORS_H
 #undef FT_ERRORDEF
+		return errors;
+	}();
 
-	if (ftErrors.contains(code))
-		return ftErrors.value(code);
-	return QString();
+	return ftErrors.value(code);
 }
 
 // Load a single font into the library from the passed filename. Returns true on error.
 bool SCFonts::addScalableFont(const QString& filename, FT_Library &library, const QString& DocName)
 {
-	static bool firstRun;
-	bool Subset = false;
-	char buf[128];
-	QString glyName;
+	if (!isIndexed(filename))
+	{
+		if (m_checkedFonts.isEmpty())
+			ScCore->setSplashStatus( QObject::tr("Creating Font Cache") );
+		m_checkedFonts.insert(filename, scanFontFile(filename, library));
+	}
+	return registerFontFile(filename, DocName);
+}
+
+// Check a font file through FreeType and read the metadata of all its faces.
+// Uses nothing but the passed library, so that files can be scanned concurrently.
+SCFonts::IndexedFontFile SCFonts::scanFontFile(const QString& filename, FT_Library library)
+{
+	IndexedFontFile fontFile;
+	QFileInfo fi(filename);
+	// File time is sometimes stored with a precision of msecs, only compare seconds
+	fontFile.lastModified = fi.lastModified().toSecsSinceEpoch();
+	fontFile.size = fi.size();
+	fontFile.isChecked = true;
+
 	ScFace::FontFormat format;
 	ScFace::FontType   type;
 	FT_Face         face = nullptr;
-	struct testCache foCache;
-	QFileInfo fic(filename);
-	QDateTime lastMod = fic.lastModified();
-	QTime lastModTime = lastMod.time();
-	if (lastModTime.msec() != 0)  //Sometime file time is stored with precision up to msecs
-	{
-		lastModTime.setHMS(lastModTime.hour(), lastModTime.minute(), lastModTime.second());
-		lastMod.setTime(lastModTime);
-	}
-	foCache.isOK = false;
-	foCache.isChecked = true;
-	foCache.lastMod = lastMod;
-	if (m_checkedFonts.count() == 0)
-	{
-		firstRun = true;
-		ScCore->setSplashStatus( QObject::tr("Creating Font Cache") );
-	}
 	FT_Error error = FT_New_Face( library, QFile::encodeName(filename), 0, &face );
 	if (error || (face == nullptr))
 	{
 		if (face != nullptr)
 			FT_Done_Face(face);
-		m_checkedFonts.insert(filename, foCache);
-		addRejectedFont(filename, QObject::tr("Font is broken: \"%1\"").arg(getFtError(error)));
-		if (m_showFontInfo)
-			sDebug(QObject::tr("Font %1 is broken, discarding it. Error message: \"%2\"").arg(filename, getFtError(error)));
-		return true;
+		fontFile.message = QObject::tr("Font is broken: \"%1\"").arg(getFtError(error));
+		return fontFile;
 	}
 	if (face->family_name == nullptr)
 	{
-		addRejectedFont(filename, QObject::tr("Failed to load font: font family unspecified"));
-		if (m_showFontInfo)
-			sDebug(QObject::tr("Failed to load font %1 - font family unspecified").arg(filename));
+		fontFile.message = QObject::tr("Failed to load font: font family unspecified");
 		FT_Done_Face(face);
-		m_checkedFonts.insert(filename, foCache);
-		return true;
+		return fontFile;
 	}
 	getFontFormat(face, format, type);
 	if (format == ScFace::UNKNOWN_FORMAT) 
 	{
-		addRejectedFont(filename, QObject::tr("Failed to load font: font type unknown"));
-		if (m_showFontInfo)
-			sDebug(QObject::tr("Failed to load font %1 - font type unknown").arg(filename));
+		fontFile.message = QObject::tr("Failed to load font: font type unknown");
 		FT_Done_Face(face);
-		m_checkedFonts.insert(filename, foCache);
-		return true;
+		return fontFile;
 	}
 	// Some fonts such as Noto ColorEmoji are in fact bitmap fonts
 	// and do not provide a valid value for units_per_EM
 	if (face->units_per_EM == 0)
 	{
-		addRejectedFont(filename, QObject::tr("Failed to load font: font is not scalable"));
-		if (m_showFontInfo)
-			sDebug(QObject::tr("Failed to load font %1 - font is not scalable").arg(filename));
+		fontFile.message = QObject::tr("Failed to load font: font is not scalable");
 		FT_Done_Face(face);
-		m_checkedFonts.insert(filename, foCache);
-		return true;
+		return fontFile;
 	}
-	bool HasNames = FT_HAS_GLYPH_NAMES(face);
 
-	if (!m_checkedFonts.contains(filename))
+	bool HasNames = FT_HAS_GLYPH_NAMES(face);
+	bool Subset = false;
+	char buf[128];
+	QString glyName;
+	FT_UInt gindex = 0;
+	FT_ULong charcode = FT_Get_First_Char( face, &gindex );
+	while ( gindex != 0 )
 	{
-		if (!firstRun)
-			ScCore->setSplashStatus( QObject::tr("New Font found, checking...") );
-		FT_UInt gindex = 0;
-		FT_ULong charcode = FT_Get_First_Char( face, &gindex );
-		while ( gindex != 0 )
+		error = FT_Load_Glyph(face, gindex, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP);
+		if (error)
 		{
-			error = FT_Load_Glyph(face, gindex, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP);
-			if (error)
-			{
-				auto errorMessage = QObject::tr("Font %1 has broken glyph %2 (charcode U+%3). Error message: \"%4\"")
+			fontFile.message = QObject::tr("Font %1 has broken glyph %2 (charcode U+%3). Error message: \"%4\"")
 							   .arg(filename)
 							   .arg(gindex)
 							   .arg(charcode, 4, 16, QChar('0'))
 							   .arg(getFtError(error));
-				addRejectedFont(filename, errorMessage);
-				if (m_showFontInfo)
-					sDebug(errorMessage);
-				FT_Done_Face(face);
-				m_checkedFonts.insert(filename, foCache);
-				return true;
-			}
-			FT_Get_Glyph_Name(face, gindex, buf, 128);
-			QString newName(buf);
-			if (newName == glyName)
-			{
-				HasNames = false;
-				Subset = true;
-			}
-			glyName = newName;
-			charcode = FT_Get_Next_Char( face, charcode, &gindex );
-		}
-		foCache.isOK = true;
-		m_checkedFonts.insert(filename, foCache);
-	}
-	else
-	{
-		auto& checkedFont = m_checkedFonts[filename];
-		if (!checkedFont.isOK)
-		{
-			checkedFont.isChecked = true;
 			FT_Done_Face(face);
-			return true;
+			return fontFile;
 		}
-		if (checkedFont.lastMod != foCache.lastMod)
-		{
-			ScCore->setSplashStatus( QObject::tr("Modified Font found, checking...") );
-			FT_UInt gindex = 0;
-			FT_ULong charcode = FT_Get_First_Char( face, &gindex );
-			while ( gindex != 0 )
-			{
-				error = FT_Load_Glyph(face, gindex, FT_LOAD_NO_SCALE | FT_LOAD_NO_BITMAP);
-				if (error)
-				{
-					auto errorMessage = QObject::tr("Font %1 has broken glyph %2 (charcode U+%3). Error message: \"%4\"")
-								   .arg(filename)
-								   .arg(gindex)
-								   .arg(charcode, 4, 16, QChar('0'))
-								   .arg(getFtError(error));
-					addRejectedFont(filename, errorMessage);
-					if (m_showFontInfo)
-						sDebug(errorMessage);
-					FT_Done_Face(face);
-					m_checkedFonts.insert(filename, foCache);
-					return true;
-				}
-				FT_Get_Glyph_Name(face, gindex, buf, 128);
-				QString newName(buf);
-				if (newName == glyName)
-				{
-					HasNames = false;
-					Subset = true;
-				}
-				glyName = newName;
-				charcode = FT_Get_Next_Char( face, charcode, &gindex );
-			}
-			foCache.isOK = true;
-			checkedFont = foCache;
-		}
-		else
+		FT_Get_Glyph_Name(face, gindex, buf, 128);
+		QString newName(buf);
+		if (newName == glyName)
 		{
-			checkedFont.isOK = true;
-			checkedFont.isChecked = true;
+			HasNames = false;
+			Subset = true;
 		}
+		glyName = newName;
+		charcode = FT_Get_Next_Char( face, charcode, &gindex );
 	}
+	fontFile.isOK = true;
 
 	// Warning: code below is also present in loadScalableFont, so if you do
 	// any modification here, think also about modifying code in loadScalableFont
 	int faceIndex = 0;
 	while (!error)
 	{
-		QString fam(getFamilyName(face));
-		QStringList features(getFontFeatures(face));
+		IndexedFace indexedFace;
+		indexedFace.family = getFamilyName(face);
+		indexedFace.features = getFontFeatures(face);
 		QString sty(face->style_name);
 		if ((sty == "Regular" && face->style_flags != 0) || sty.isEmpty())
 		{
@@ -831,102 +855,107 @@ bool SCFonts::addScalableFont(const QString& filename, FT_Library &library, cons
 					break;
 			}
 		}
-		QString fullName(fam);
-		if (!sty.isEmpty())
-			fullName += " " + sty;
+		indexedFace.style = sty;
 		const char* psName = FT_Get_Postscript_Name(face);
-		QString qpsName;
 		if (psName)
-			qpsName = QString(psName);
+			indexedFace.psName = QString(psName);
+		else if (sty.isEmpty())
+			indexedFace.psName = indexedFace.family;
 		else
-			qpsName = fullName;
+			indexedFace.psName = indexedFace.family + " " + sty;
+		indexedFace.faceIndex = faceIndex;
+		indexedFace.format = format;
+		indexedFace.type = (format == ScFace::TTCF) ? ScFace::TTF : ScFace::UNKNOWN_TYPE;
+		getSubFontType(face, indexedFace.type);
+		indexedFace.hasGlyphNames = HasNames;
+		indexedFace.subset = Subset || (face->num_glyphs > 2048);
+		fontFile.faces.append(indexedFace);
+
+		if ((++faceIndex) >= face->num_faces)
+			break;
+		FT_Done_Face(face);
+		face = nullptr;
+		error = FT_New_Face(library, QFile::encodeName(filename), faceIndex, &face);
+	} //while
+
+	if (face != nullptr)
+		FT_Done_Face(face);
+	return fontFile;
+}
+
+// Register the faces of a font file from its font index entry. Returns true if the file is rejected.
+bool SCFonts::registerFontFile(const QString& filename, const QString& DocName)
+{
+	IndexedFontFile& fontFile = m_checkedFonts[filename];
+	fontFile.isChecked = true;
+	if (!fontFile.isOK)
+	{
+		addRejectedFont(filename, fontFile.message);
+		if (m_showFontInfo)
+			sDebug(fontFile.message);
+		return true;
+	}
+
+	for (const IndexedFace& indexedFace : std::as_const(fontFile.faces))
+	{
+		QString sty(indexedFace.style);
+		QString fullName(indexedFace.family);
+		if (!sty.isEmpty())
+			fullName += " " + sty;
 		ScFace t;
 		if (contains(fullName))
 		{
 			t = (*this)[fullName];
-			if (t.psName() != qpsName)
+			if (t.psName() != indexedFace.psName)
 			{
-				QString alt = " (" + qpsName + ")";
+				QString alt = " (" + indexedFace.psName + ")";
 				fullName += alt;
 				sty += alt;
 			}
 		}
-		t = (*this)[fullName];
+		t = value(fullName);
 		if (t.isNone())
 		{
-			switch (format) 
+			switch (indexedFace.format) 
 			{
 				case ScFace::PFA:
-					t = ScFace(new ScFace_PFA(fam, sty, "", fullName, qpsName, filename, faceIndex, features));
-					t.subset(Subset);
+					t = ScFace(new ScFace_PFA(indexedFace.family, sty, "", fullName, indexedFace.psName, filename, indexedFace.faceIndex, indexedFace.features));
 					break;
 				case ScFace::PFB:
-					t = ScFace(new ScFace_PFB(fam, sty, "", fullName, qpsName, filename, faceIndex, features));
-					t.subset(Subset);
+					t = ScFace(new ScFace_PFB(indexedFace.family, sty, "", fullName, indexedFace.psName, filename, indexedFace.faceIndex, indexedFace.features));
 					break;
 				case ScFace::SFNT:
-					t = ScFace(new ScFace_ttf(fam, sty, "", fullName, qpsName, filename, faceIndex, features));
-					getSubFontType(face, t.m_m->typeCode);
-					t.subset(Subset);
-					break;
 				case ScFace::TTCF:
-					t = ScFace(new ScFace_ttf(fam, sty, "", fullName, qpsName, filename, faceIndex, features));
-					t.m_m->formatCode = ScFace::TTCF;
-					t.m_m->typeCode = ScFace::TTF;
-					getSubFontType(face, t.m_m->typeCode);
-					t.subset(Subset);
-					break;
 				case ScFace::TYPE42:
-					t = ScFace(new ScFace_ttf(fam, sty, "", fullName, qpsName, filename, faceIndex, features));
-					getSubFontType(face, t.m_m->typeCode);
-					t.subset(Subset);
+					t = ScFace(new ScFace_ttf(indexedFace.family, sty, "", fullName, indexedFace.psName, filename, indexedFace.faceIndex, indexedFace.features));
+					if (indexedFace.format == ScFace::TTCF)
+						t.m_m->formatCode = ScFace::TTCF;
+					t.m_m->typeCode = indexedFace.type;
 					break;
 				default:
 				/* catching any types not handled above to silence compiler */
 					break;
 			}
 			insert(fullName, t);
-			t.m_m->hasGlyphNames = HasNames;
+			t.subset(indexedFace.subset);
+			t.m_m->hasGlyphNames = indexedFace.hasGlyphNames;
 			t.embedPs(true);
 			t.usable(true);
 			t.m_m->status = ScFace::UNKNOWN;
-			if (face->num_glyphs > 2048)
-				t.subset(true);
 			t.m_m->forDocument = DocName;
-			//setBestEncoding(face); //AV
 			if (m_showFontInfo)
-				sDebug(QObject::tr("Font %1 loaded from %2(%3)").arg(t.psName(), filename).arg(faceIndex + 1));
-
-/*
-//debug
-			QByteArray bb;
-			t->rawData(bb);
-			QFile dump(QString("/tmp/fonts/%1-%2").arg(fullName, psName));
-			dump.open(IO_WriteOnly);
-			QDataStream os(&dump);
-			os.writeRawBytes(bb.data(), bb.size());
-			dump.close();
-*/
+				sDebug(QObject::tr("Font %1 loaded from %2(%3)").arg(t.psName(), filename).arg(indexedFace.faceIndex + 1));
 		}
 		else 
 		{
 			if (m_showFontInfo)
-				sDebug(QObject::tr("Font %1(%2) is duplicate of %3").arg(filename).arg(faceIndex + 1).arg(t.fontPath()));
+				sDebug(QObject::tr("Font %1(%2) is duplicate of %3").arg(filename).arg(indexedFace.faceIndex + 1).arg(t.fontPath()));
 			// this is needed since eg. AppleSymbols will happily return a face for *any* face_index
-			if (faceIndex > 0) {
+			if (indexedFace.faceIndex > 0)
 				break;
-			}
 		}
-		if ((++faceIndex) >= face->num_faces)
-			break;
-		FT_Done_Face(face);
-		face = nullptr;
-		error = FT_New_Face(library, QFile::encodeName(filename), faceIndex, &face);
-	} //while
-	
-	if (face != nullptr)
-		FT_Done_Face(face);
-	return error && faceIndex == 0;
+	}
+	return false;
 }
 
 void SCFonts::removeFont(const QString& name)
@@ -1028,11 +1057,8 @@ void SCFonts::addFontconfigFonts()
 	FcConfigDestroy(config);
 	FcObjectSetDestroy(os);
 	FcPatternDestroy(pat);
-	// Create the Freetype library
-//	bool error;
-	FT_Library library = nullptr;
-	FT_Init_FreeType( &library );
 	// Now iterate over the font files and load them
+	QStringList fontFiles;
 	for (int i = 0; i < fs->nfont; i++)
 	{
 		FcChar8 *file = nullptr;
@@ -1040,7 +1066,7 @@ void SCFonts::addFontconfigFonts()
 		{
 			if (m_showFontInfo)
 				sDebug(QObject::tr("Loading font %1 (found using fontconfig)").arg(QString((char*)file)));
-			addScalableFont(QString((char*)file), library, "");
+			fontFiles.append(QString((char*)file));
 		}
 		else
 			if (m_showFontInfo)
@@ -1050,8 +1076,8 @@ void SCFonts::addFontconfigFonts()
 				sDebug(errorMessage);
 			}
 	}
-	FT_Done_FreeType(library);
 	FcFontSetDestroy(fs);
+	addScalableFontFiles(fontFiles, QString());
 }
 
 #elif defined(Q_OS_WIN32)
@@ -1066,9 +1092,7 @@ void SCFonts::addRegistryFonts()
 #endif
 	                         };
 	QSet<QString> foundFonts;
-
-	FT_Library library = nullptr;
-	FT_Init_FreeType( &library );
+	QStringList fontFiles;
 
 	for (const auto& key : keys)
 	{
@@ -1113,12 +1137,12 @@ void SCFonts::addRegistryFonts()
 			if ((ext == "ttc") || (ext == "dfont") || (ext == "pfa") || (ext == "pfb") || (ext == "ttf") || (ext == "otf"))
 			{
 				foundFonts.insert(fontPath);
-				addScalableFont(fontPath, library, QString());
+				fontFiles.append(fontPath);
 			}
 		}
 	}
 
-	FT_Done_FreeType(library);
+	addScalableFontFiles(fontFiles, QString());
 }
 
 void SCFonts::addType1RegistryFonts()
@@ -1131,9 +1155,7 @@ void SCFonts::addType1RegistryFonts()
 #endif
 	                         };
 	QSet<QString> foundFonts;
-
-	FT_Library library = nullptr;
-	FT_Init_FreeType( &library );
+	QStringList fontFiles;
 
 	for (const auto& key : keys)
 	{
@@ -1190,14 +1212,14 @@ void SCFonts::addType1RegistryFonts()
 				if ((ext == "pfa") || (ext == "pfb"))
 				{
 					foundFonts.insert(fontPath);
-					addScalableFont(fontPath, library, QString());
+					fontFiles.append(fontPath);
 					break;
 				}
 			}
 		}
 	}
 
-	FT_Done_FreeType(library);
+	addScalableFontFiles(fontFiles, QString());
 }
 
 #endif
@@ -1221,52 +1243,53 @@ void SCFonts::readFontCache(const QString& pf)
 	if (fir.exists())
 		fr.remove();
 	m_checkedFonts.clear();
-	struct testCache foCache;
 
-	QDomDocument docu("fontcacherc");
-	QFile f(pf + "/checkfonts170.xml");
+	QFile f(pf + "/" + fontIndexFileName);
 	if (!f.open(QIODevice::ReadOnly))
 		return;
 	ScCore->setSplashStatus( QObject::tr("Reading Font Cache") );
 
-	QTextStream ts(&f);
-	ts.setEncoding(QStringConverter::Utf8);
-
-#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
-	QDomDocument::ParseResult parseResult = docu.setContent(ts.readAll());
-	if (!parseResult)
-	{
-		f.close();
-		return;
-	}
-#else
-	QString errorMsg;
-	int errorLine = 0, errorColumn = 0;
-	if ( !docu.setContent(ts.readAll(), &errorMsg, &errorLine, &errorColumn) )
-	{
-		f.close();
-		return;
-	}
-#endif
-	f.close();
-
-	QDomElement elem = docu.documentElement();
-	if (elem.tagName() != "CachedFonts")
+	// Parse the index straight from the mapped file, avoiding a copy of the whole index
+	QByteArray indexData;
+	const uchar* mappedData = f.map(0, f.size());
+	if (mappedData)
+		indexData = QByteArray::fromRawData(reinterpret_cast<const char*>(mappedData), f.size());
+	else
+		indexData = f.readAll();
+
+	QDataStream ds(indexData);
+	ds.setVersion(QDataStream::Qt_6_0);
+	quint32 magic = 0;
+	quint16 version = 0;
+	quint32 fileCount = 0;
+	ds >> magic >> version >> fileCount;
+	if ((magic != fontIndexMagic) || (version != fontIndexVersion))
 		return;
 
-	QDomNode DOC = elem.firstChild();
-	while (!DOC.isNull())
+	m_checkedFonts.reserve(fileCount);
+	for (quint32 i = 0; (i < fileCount) && (ds.status() == QDataStream::Ok); ++i)
 	{
-		QDomElement dc = DOC.toElement();
-		if (dc.tagName()=="Font")
+		QString fileName;
+		IndexedFontFile fontFile;
+		quint32 faceCount = 0;
+		ds >> fileName >> fontFile.lastModified >> fontFile.size >> fontFile.isOK >> fontFile.message >> faceCount;
+		for (quint32 j = 0; (j < faceCount) && (ds.status() == QDataStream::Ok); ++j)
 		{
-			foCache.isChecked = false;
-			foCache.isOK = static_cast<bool>(dc.attribute("Status", "1").toInt());
-			foCache.lastMod = QDateTime::fromString(dc.attribute("Modified"), Qt::ISODate);
-			m_checkedFonts.insert(dc.attribute("File"), foCache);
+			IndexedFace face;
+			qint32 faceIndex = 0;
+			qint32 format = 0;
+			qint32 type = 0;
+			ds >> face.family >> face.style >> face.psName >> face.features >> faceIndex >> format >> type >> face.hasGlyphNames >> face.subset;
+			face.faceIndex = faceIndex;
+			face.format = static_cast<ScFace::FontFormat>(format);
+			face.type = static_cast<ScFace::FontType>(type);
+			fontFile.faces.append(face);
 		}
-		DOC = DOC.nextSibling();
+		m_checkedFonts.insert(fileName, fontFile);
 	}
+	// Entries read from a damaged index cannot be trusted, rescan everything
+	if (ds.status() != QDataStream::Ok)
+		m_checkedFonts.clear();
 }
 
 void SCFonts::writeFontCache() const
@@ -1277,37 +1300,42 @@ void SCFonts::writeFontCache() const
 
 void SCFonts::writeFontCache(const QString& pf) const
 {
-	QDomDocument docu("fontcacherc");
-	QString st="<CachedFonts></CachedFonts>";
-
-	docu.setContent(st);
-	QDomElement elem = docu.documentElement();
+	std::vector<QHash<QString, IndexedFontFile>::const_iterator> savedFonts;
 	for (auto it = m_checkedFonts.cbegin(); it != m_checkedFonts.cend(); ++it)
 	{
-		const auto& checkedFont = it.value();
-
-		bool saveItem = checkedFont.isChecked;
-		if (!checkedFont.isChecked) // Font might be located in another local Scribus font folder
+		bool saveItem = it->isChecked;
+		if (!it->isChecked) // Font might be located in another local Scribus font folder
 			saveItem = QFile::exists(it.key());
-		if (!saveItem)
-			continue;
-
-		QDomElement fosu = docu.createElement("Font");
-		fosu.setAttribute("File", it.key());
-		fosu.setAttribute("Status", static_cast<int>(checkedFont.isOK));
-		fosu.setAttribute("Modified", checkedFont.lastMod.toString(Qt::ISODate));
-		elem.appendChild(fosu);
+		if (saveItem)
+			savedFonts.push_back(it);
 	}
 
 	ScCore->setSplashStatus( QObject::tr("Writing updated Font Cache") );
 
-	QFile file(pf + "/checkfonts170.xml");
+	// Several Scribus instances may start at once, never let them see a partial index
+	QSaveFile file(pf + "/" + fontIndexFileName);
 	if (!file.open(QIODevice::WriteOnly))
 		return;
-	QTextStream s(&file);
-	s.setEncoding(QStringConverter::Utf8);
-	s << docu.toString();
-	file.close();
+	QDataStream ds(&file);
+	ds.setVersion(QDataStream::Qt_6_0);
+	ds << fontIndexMagic << fontIndexVersion << static_cast<quint32>(savedFonts.size());
+	for (const auto& it : savedFonts)
+	{
+		const IndexedFontFile& fontFile = it.value();
+		ds << it.key() << fontFile.lastModified << fontFile.size << fontFile.isOK << fontFile.message << static_cast<quint32>(fontFile.faces.count());
+		for (const IndexedFace& face : fontFile.faces)
+		{
+			ds << face.family << face.style << face.psName << face.features;
+			ds << static_cast<qint32>(face.faceIndex) << static_cast<qint32>(face.format) << static_cast<qint32>(face.type);
+			ds << face.hasGlyphNames << face.subset;
+		}
+	}
+	if (ds.status() != QDataStream::Ok)
+	{
+		file.cancelWriting();
+		return;
+	}
+	file.commit();
 }
 
 void SCFonts::getFonts(const QString& pf, bool showFontInfo)
@@ -1455,6 +1483,32 @@ QString SCFonts::getItalicStyle(const QString& family)
 	return style;
 }
 
+QString SCFonts::glyphCacheReport() const
+{
+	QList<QPair<QString, ScFace::GlyphCacheStatistics>> usedFaces;
+	for (auto it = begin(); it != end(); ++it)
+	{
+		// Replacements share the data of the face they replace
+		if (it.value().isReplacement())
+			continue;
+		ScFace::GlyphCacheStatistics stats = it.value().glyphCacheStatistics();
+		if (stats.hits + stats.misses > 0)
+			usedFaces.append(qMakePair(it.key(), stats));
+	}
+	std::sort(usedFaces.begin(), usedFaces.end(), [](const auto& a, const auto& b) { return a.second.size > b.second.size; });
+
+	QString report = QString("Glyph cache: %1 KiB used of %2 KiB\n").arg(ScFace::glyphCacheSize() / 1024).arg(ScFace::glyphCacheLimitMiB() * 1024);
+	for (const auto& face : std::as_const(usedFaces))
+	{
+		const ScFace::GlyphCacheStatistics& stats = face.second;
+		double hitRate = 100.0 * stats.hits / (stats.hits + stats.misses);
+		report += QString("%1: %2 glyphs, %3 KiB, hit rate %4% (%5 hits, %6 misses, %7 evictions)\n")
+				  .arg(face.first).arg(stats.glyphs).arg(stats.size / 1024).arg(hitRate, 0, 'f', 1)
+				  .arg(stats.hits).arg(stats.misses).arg(stats.evictions);
+	}
+	return report;
+}
+
 void SCFonts::addRejectedFont(const QString& fontPath, const QString& message)
 {
 	rejectedFonts.insert(fontPath, message);
@@ -10,6 +10,7 @@ for which a new license (GPL+exception) is in place.
 #include <QByteArray>
 #include <QDateTime>
 #include <QFont>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QVector>
@@ -62,8 +63,10 @@ class SCRIBUS_API SCFonts : public QMap<QString,ScFace>
 		/// Changes replacement fonts to point to new real fonts. For all keys 'nam' in 'substitutes', findFont(name).isReplacement() must be true
 		void setSubstitutions(const QMap<QString,QString>& substitutes, ScribusDoc* doc = nullptr);
 		void removeFont(const QString& name);
-		/// Write checked fonts file
+		/// Write the font index
 		void writeFontCache() const;
+		/// Glyph cache usage of each face which was used, faces with the largest cache first
+		QString glyphCacheReport() const;
 
 		/// maps family name to face variants
 		QMap<QString, QStringList> fontMap;
@@ -78,10 +81,40 @@ class SCRIBUS_API SCFonts : public QMap<QString,ScFace>
 		QString getItalicStyle(const QString& family);
 
 	private:
+		/// Metadata of one face of a font file, everything needed to register it without opening the file
+		struct IndexedFace
+		{
+			QString family;
+			QString style;
+			QString psName;
+			QStringList features;
+			int faceIndex { 0 };
+			ScFace::FontFormat format { ScFace::UNKNOWN_FORMAT };
+			ScFace::FontType type { ScFace::UNKNOWN_TYPE };
+			bool hasGlyphNames { false };
+			bool subset { false };
+		};
+
+		/// Font index entry of a font file, valid as long as modification time and size are unchanged
+		struct IndexedFontFile
+		{
+			qint64 lastModified { 0 };
+			qint64 size { 0 };
+			bool isOK { false };
+			bool isChecked { false };
+			QString message;
+			QList<IndexedFace> faces;
+		};
+
 		void readFontCache(const QString& pf);
 		void writeFontCache(const QString& pf) const;
 		void addPath(QString p);
+		void findFontFiles(const QString& path, bool recursive, QStringList& fontFiles, QStringList& otherFiles) const;
+		void addScalableFontFiles(const QStringList& fileNames, const QString& DocName);
 		bool addScalableFont(const QString& filename, FT_Library &library, const QString& DocName);
+		bool registerFontFile(const QString& filename, const QString& DocName);
+		bool isIndexed(const QString& filename) const;
+		static IndexedFontFile scanFontFile(const QString& filename, FT_Library library);
 		void addRejectedFont(const QString& fontPath, const QString& message);
 		void addUserPath(const QString& pf);
 #ifdef HAVE_FONTCONFIG
@@ -92,13 +125,7 @@ class SCRIBUS_API SCFonts : public QMap<QString,ScFace>
 #endif
 		QStringList m_fontPaths;
 
-		struct testCache
-		{
-			bool isOK;
-			bool isChecked;
-			QDateTime lastMod;
-		};
-		QMap<QString, testCache> m_checkedFonts;
+		QHash<QString, IndexedFontFile> m_checkedFonts;
 
 	protected:
 		bool m_showFontInfo { false };
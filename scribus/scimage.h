@@ -43,6 +43,9 @@ public:
 	ScImage( int width, int height );
 	~ScImage();
 
+	// Unlike the copy constructor, assignment shares image data and copies image infos
+	ScImage& operator=(const ScImage& image) = default;
+
 	enum RequestType
 	{
 		CMYKData = 0,
@@ -52,6 +55,15 @@ public:
 		Thumbnail = 4,
 	};
 
+	/// Filters of scaleImage(), see ScImageKernels::ResampleFilter
+	enum class ScaleFilter
+	{
+		Area,      ///< Former single threaded area averaging in fixed point, for any image format
+		Box,       ///< Area averaging with the threaded resampler, other formats fall back to Area
+		Bilinear,
+		Lanczos
+	};
+
 	void initialize();
 
 	const QImage& qImage() const;
@@ -85,8 +97,8 @@ public:
 	// Generate a low res image for user preview
 	bool createLowRes(double scale);
 
-	// Scale this image in-place
-	void scaleImage(int width, int height);
+	// Scale this image in-place, area averaging unless another filter is asked for
+	void scaleImage(int width, int height, ScaleFilter filter = ScaleFilter::Box);
 
 	// Retrieve an embedded ICC profile from the file path `fn', storing it in `profile'.
 	// TODO: Bad API. Should probably be static member returning an ICCProfile (custom class) or something like that.
@@ -0,0 +1,1022 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include "scimagekernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SCIMAGEKERNELS_SSE2
+#include <emmintrin.h>
+// AVX2 functions are compiled for their target only, which needs GCC or Clang
+#if defined(__GNUC__) || defined(__clang__)
+#define SCIMAGEKERNELS_AVX2
+#define SCIMAGEKERNELS_AVX2_FUNCTION __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+namespace
+{
+	std::atomic<int> maxThreads { 0 };
+	std::atomic<int> selectedInstructionSet { -1 };
+
+	// Amount of work, in pixels or kernel taps, a thread takes at once
+	const qint64 workPerChunk = 65536;
+
+	/// Ranges of items shared by the calling thread and pool threads, see forEachRange()
+	struct RangeJob
+	{
+		std::function<void (int, int)> function;
+		int count { 0 };
+		int chunkSize { 1 };
+		int chunkCount { 0 };
+		std::atomic<int> nextChunk { 0 };
+		std::atomic<int> finishedChunks { 0 };
+		QSemaphore finished;
+
+		void run()
+		{
+			int chunk;
+			while ((chunk = nextChunk.fetch_add(1)) < chunkCount)
+			{
+				int begin = chunk * chunkSize;
+				function(begin, qMin(begin + chunkSize, count));
+				if (finishedChunks.fetch_add(1) + 1 == chunkCount)
+					finished.release();
+			}
+		}
+	};
+
+	/**
+	 * Calls \a function for ranges of items covering [0, \a count), on several threads when the
+	 * work is large enough. \a itemWork is the work of one item, e.g. the width of a row. The
+	 * calling thread processes ranges too and only waits for ranges being processed, pool threads
+	 * starting late find nothing left to do.
+	 */
+	void forEachRange(int count, qint64 itemWork, const std::function<void (int, int)>& function)
+	{
+		if (count <= 0)
+			return;
+		QThreadPool* threadPool = QThreadPool::globalInstance();
+		int threadCount = ScImageKernels::maxThreadCount();
+		if (threadCount <= 0)
+			threadCount = threadPool->maxThreadCount();
+		int chunkSize = static_cast<int>(qBound<qint64>(1, workPerChunk / qMax<qint64>(1, itemWork), count));
+		int chunkCount = (count + chunkSize - 1) / chunkSize;
+		if ((threadCount <= 1) || (chunkCount <= 1))
+		{
+			function(0, count);
+			return;
+		}
+
+		std::shared_ptr<RangeJob> job = std::make_shared<RangeJob>();
+		job->function = function;
+		job->count = count;
+		job->chunkSize = chunkSize;
+		job->chunkCount = chunkCount;
+		for (int i = 1; i < qMin(threadCount, chunkCount); ++i)
+			threadPool->start([job]() { job->run(); });
+		job->run();
+		job->finished.acquire();
+	}
+
+	// ---- invert
+
+	void invertScalar(QRgb* row, int width, bool cmyk)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			if (cmyk)
+			{
+				unsigned char *p = (unsigned char *) (row + x);
+				unsigned char c = 255 - qMin(255, p[0] + p[3]);
+				unsigned char m = 255 - qMin(255, p[1] + p[3]);
+				unsigned char y = 255 - qMin(255, p[2] + p[3]);
+				unsigned char k = qMin(qMin(c, m), y);
+				p[0] = c - k;
+				p[1] = m - k;
+				p[2] = y - k;
+				p[3] = k;
+			}
+			else
+				row[x] ^= 0x00ffffff;
+		}
+	}
+
+#ifdef SCIMAGEKERNELS_SSE2
+	void invertSSE2(QRgb* row, int width, bool cmyk)
+	{
+		const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+		const __m128i byteMask = _mm_set1_epi32(0xff);
+		const __m128i allBits = _mm_set1_epi32(-1);
+		int x = 0;
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i* pixels = reinterpret_cast<__m128i*>(row + x);
+			__m128i v = _mm_loadu_si128(pixels);
+			if (cmyk)
+			{
+				// Black copied to all bytes, then 255 - min(255, channel + black) in each byte
+				__m128i black = _mm_srli_epi32(v, 24);
+				black = _mm_or_si128(black, _mm_slli_epi32(black, 8));
+				black = _mm_or_si128(black, _mm_slli_epi32(black, 16));
+				__m128i inverted = _mm_xor_si128(_mm_adds_epu8(v, black), allBits);
+				// Minimum of the three colour bytes, new black
+				__m128i k = _mm_min_epu8(inverted, _mm_srli_epi32(inverted, 8));
+				k = _mm_and_si128(_mm_min_epu8(k, _mm_srli_epi32(inverted, 16)), byteMask);
+				__m128i kRgb = _mm_or_si128(k, _mm_or_si128(_mm_slli_epi32(k, 8), _mm_slli_epi32(k, 16)));
+				v = _mm_or_si128(_mm_and_si128(_mm_sub_epi8(inverted, kRgb), rgbMask), _mm_slli_epi32(k, 24));
+			}
+			else
+				v = _mm_xor_si128(v, rgbMask);
+			_mm_storeu_si128(pixels, v);
+		}
+		invertScalar(row + x, width - x, cmyk);
+	}
+#endif
+
+#ifdef SCIMAGEKERNELS_AVX2
+	SCIMAGEKERNELS_AVX2_FUNCTION void invertAVX2(QRgb* row, int width, bool cmyk)
+	{
+		const __m256i rgbMask = _mm256_set1_epi32(0x00ffffff);
+		const __m256i byteMask = _mm256_set1_epi32(0xff);
+		const __m256i allBits = _mm256_set1_epi32(-1);
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i* pixels = reinterpret_cast<__m256i*>(row + x);
+			__m256i v = _mm256_loadu_si256(pixels);
+			if (cmyk)
+			{
+				__m256i black = _mm256_srli_epi32(v, 24);
+				black = _mm256_or_si256(black, _mm256_slli_epi32(black, 8));
+				black = _mm256_or_si256(black, _mm256_slli_epi32(black, 16));
+				__m256i inverted = _mm256_xor_si256(_mm256_adds_epu8(v, black), allBits);
+				__m256i k = _mm256_min_epu8(inverted, _mm256_srli_epi32(inverted, 8));
+				k = _mm256_and_si256(_mm256_min_epu8(k, _mm256_srli_epi32(inverted, 16)), byteMask);
+				__m256i kRgb = _mm256_or_si256(k, _mm256_or_si256(_mm256_slli_epi32(k, 8), _mm256_slli_epi32(k, 16)));
+				v = _mm256_or_si256(_mm256_and_si256(_mm256_sub_epi8(inverted, kRgb), rgbMask), _mm256_slli_epi32(k, 24));
+			}
+			else
+				v = _mm256_xor_si256(v, rgbMask);
+			_mm256_storeu_si256(pixels, v);
+		}
+		invertScalar(row + x, width - x, cmyk);
+	}
+#endif
+
+	// ---- luminance mapping
+
+	inline QRgb mapPixel(QRgb pixel, int luminance, const QRgb* colorTable, bool cmyk)
+	{
+		QRgb color = colorTable[qMin(luminance, 255)];
+		if (cmyk)
+			return color;
+		return (color & 0x00ffffff) | (pixel & 0xff000000);
+	}
+
+	void mapLuminanceScalar(QRgb* row, int width, const QRgb* colorTable, bool cmyk)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			QRgb r = row[x];
+			int luminance;
+			if (cmyk)
+				luminance = qRound(0.3 * qRed(r) + 0.59 * qGreen(r) + 0.11 * qBlue(r) + qAlpha(r));
+			else
+				luminance = qRound(0.3 * qRed(r) + 0.59 * qGreen(r) + 0.11 * qBlue(r));
+			row[x] = mapPixel(r, luminance, colorTable, cmyk);
+		}
+	}
+
+#ifdef SCIMAGEKERNELS_SSE2
+	// Luminance of the two pixels whose channels are in the low lanes, the sums are made
+	// in the same order as by the scalar code so that results are identical. Luminances
+	// are not negative, truncating them plus 0.5 thus rounds them as qRound() does.
+	inline __m128i luminanceSSE2(__m128i red, __m128i green, __m128i blue, __m128i alpha, bool cmyk)
+	{
+		__m128d sum = _mm_mul_pd(_mm_set1_pd(0.3), _mm_cvtepi32_pd(red));
+		sum = _mm_add_pd(sum, _mm_mul_pd(_mm_set1_pd(0.59), _mm_cvtepi32_pd(green)));
+		sum = _mm_add_pd(sum, _mm_mul_pd(_mm_set1_pd(0.11), _mm_cvtepi32_pd(blue)));
+		if (cmyk)
+			sum = _mm_add_pd(sum, _mm_cvtepi32_pd(alpha));
+		return _mm_cvttpd_epi32(_mm_add_pd(sum, _mm_set1_pd(0.5)));
+	}
+
+	void mapLuminanceSSE2(QRgb* row, int width, const QRgb* colorTable, bool cmyk)
+	{
+		const __m128i byteMask = _mm_set1_epi32(0xff);
+		alignas(16) int luminances[4];
+		int x = 0;
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			__m128i red = _mm_and_si128(_mm_srli_epi32(v, 16), byteMask);
+			__m128i green = _mm_and_si128(_mm_srli_epi32(v, 8), byteMask);
+			__m128i blue = _mm_and_si128(v, byteMask);
+			__m128i alpha = _mm_srli_epi32(v, 24);
+			__m128i low = luminanceSSE2(red, green, blue, alpha, cmyk);
+			__m128i high = luminanceSSE2(_mm_shuffle_epi32(red, _MM_SHUFFLE(3, 2, 3, 2)), _mm_shuffle_epi32(green, _MM_SHUFFLE(3, 2, 3, 2)),
+			                             _mm_shuffle_epi32(blue, _MM_SHUFFLE(3, 2, 3, 2)), _mm_shuffle_epi32(alpha, _MM_SHUFFLE(3, 2, 3, 2)), cmyk);
+			_mm_store_si128(reinterpret_cast<__m128i*>(luminances), _mm_unpacklo_epi64(low, high));
+			for (int i = 0; i < 4; ++i)
+				row[x + i] = mapPixel(row[x + i], luminances[i], colorTable, cmyk);
+		}
+		mapLuminanceScalar(row + x, width - x, colorTable, cmyk);
+	}
+#endif
+
+#ifdef SCIMAGEKERNELS_AVX2
+	SCIMAGEKERNELS_AVX2_FUNCTION void mapLuminanceAVX2(QRgb* row, int width, const QRgb* colorTable, bool cmyk)
+	{
+		const __m256i byteMask = _mm256_set1_epi32(0xff);
+		const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xff000000));
+		const __m256i rgbMask = _mm256_set1_epi32(0x00ffffff);
+		const __m128i maxLuminance = _mm_set1_epi32(255);
+		const __m256d redFactor = _mm256_set1_pd(0.3);
+		const __m256d greenFactor = _mm256_set1_pd(0.59);
+		const __m256d blueFactor = _mm256_set1_pd(0.11);
+		const __m256d half = _mm256_set1_pd(0.5);
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256i* pixels = reinterpret_cast<__m256i*>(row + x);
+			__m256i v = _mm256_loadu_si256(pixels);
+			__m256i red = _mm256_and_si256(_mm256_srli_epi32(v, 16), byteMask);
+			__m256i green = _mm256_and_si256(_mm256_srli_epi32(v, 8), byteMask);
+			__m256i blue = _mm256_and_si256(v, byteMask);
+			__m256i alpha = _mm256_srli_epi32(v, 24);
+			__m128i luminances[2];
+			for (int i = 0; i < 2; ++i)
+			{
+				__m128i r = (i == 0) ? _mm256_castsi256_si128(red) : _mm256_extracti128_si256(red, 1);
+				__m128i g = (i == 0) ? _mm256_castsi256_si128(green) : _mm256_extracti128_si256(green, 1);
+				__m128i b = (i == 0) ? _mm256_castsi256_si128(blue) : _mm256_extracti128_si256(blue, 1);
+				__m256d sum = _mm256_mul_pd(redFactor, _mm256_cvtepi32_pd(r));
+				sum = _mm256_add_pd(sum, _mm256_mul_pd(greenFactor, _mm256_cvtepi32_pd(g)));
+				sum = _mm256_add_pd(sum, _mm256_mul_pd(blueFactor, _mm256_cvtepi32_pd(b)));
+				if (cmyk)
+				{
+					__m128i a = (i == 0) ? _mm256_castsi256_si128(alpha) : _mm256_extracti128_si256(alpha, 1);
+					sum = _mm256_add_pd(sum, _mm256_cvtepi32_pd(a));
+				}
+				luminances[i] = _mm_min_epi32(_mm256_cvttpd_epi32(_mm256_add_pd(sum, half)), maxLuminance);
+			}
+			__m256i indexes = _mm256_inserti128_si256(_mm256_castsi128_si256(luminances[0]), luminances[1], 1);
+			__m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int*>(colorTable), indexes, 4);
+			if (!cmyk)
+				colors = _mm256_or_si256(_mm256_and_si256(colors, rgbMask), _mm256_and_si256(v, alphaMask));
+			_mm256_storeu_si256(pixels, colors);
+		}
+		mapLuminanceScalar(row + x, width - x, colorTable, cmyk);
+	}
+#endif
+
+	// ---- stack blur
+
+	// Blurs \a count pixels \a step apart in place. Pixels are read ahead of the written ones, the
+	// last read coming after the last write is not used anymore. \a stack holds 4 * (2 * radius + 1) ints.
+	void blurLineScalar(QRgb* line, int count, qsizetype step, int radius, const int* dv, int* stack)
+	{
+		const int last = count - 1;
+		const int div = radius + radius + 1;
+		const int r1 = radius + 1;
+		int sum[4] = { 0, 0, 0, 0 };
+		int inSum[4] = { 0, 0, 0, 0 };
+		int outSum[4] = { 0, 0, 0, 0 };
+
+		for (int i = -radius; i <= radius; ++i)
+		{
+			QRgb p = line[qMin(last, qMax(i, 0)) * step];
+			int* sir = stack + 4 * (i + radius);
+			int rbs = r1 - abs(i);
+			for (int c = 0; c < 4; ++c)
+			{
+				sir[c] = (p >> (8 * c)) & 0xff;
+				sum[c] += sir[c] * rbs;
+				if (i > 0)
+					inSum[c] += sir[c];
+				else
+					outSum[c] += sir[c];
+			}
+		}
+
+		int stackPointer = radius;
+		for (int x = 0; x < count; ++x)
+		{
+			line[x * step] = static_cast<QRgb>(dv[sum[0]]) | (static_cast<QRgb>(dv[sum[1]]) << 8)
+			               | (static_cast<QRgb>(dv[sum[2]]) << 16) | (static_cast<QRgb>(dv[sum[3]]) << 24);
+			int* sir = stack + 4 * ((stackPointer - radius + div) % div);
+			QRgb p = line[qMin(x + r1, last) * step];
+			for (int c = 0; c < 4; ++c)
+			{
+				sum[c] -= outSum[c];
+				outSum[c] -= sir[c];
+				sir[c] = (p >> (8 * c)) & 0xff;
+				inSum[c] += sir[c];
+				sum[c] += inSum[c];
+			}
+			stackPointer = (stackPointer + 1) % div;
+			sir = stack + 4 * stackPointer;
+			for (int c = 0; c < 4; ++c)
+			{
+				outSum[c] += sir[c];
+				inSum[c] -= sir[c];
+			}
+		}
+	}
+
+#ifdef SCIMAGEKERNELS_SSE2
+	inline __m128i unpackPixelSSE2(QRgb pixel)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pixel)), zero), zero);
+	}
+
+	// Same as blurLineScalar() with the four channels in the lanes of a register, the radius
+	// must be below 32768. \a stack holds 4 * (2 * radius + 1) ints.
+	void blurLineSSE2(QRgb* line, int count, qsizetype step, int radius, const int* dv, int* stack)
+	{
+		const int last = count - 1;
+		const int div = radius + radius + 1;
+		const int r1 = radius + 1;
+		__m128i sum = _mm_setzero_si128();
+		__m128i inSum = _mm_setzero_si128();
+		__m128i outSum = _mm_setzero_si128();
+
+		for (int i = -radius; i <= radius; ++i)
+		{
+			__m128i channels = unpackPixelSSE2(line[qMin(last, qMax(i, 0)) * step]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(stack + 4 * (i + radius)), channels);
+			// Channels and weights fit in the low 16 bits of each lane
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(channels, _mm_set1_epi32(r1 - abs(i))));
+			if (i > 0)
+				inSum = _mm_add_epi32(inSum, channels);
+			else
+				outSum = _mm_add_epi32(outSum, channels);
+		}
+
+		alignas(16) int sums[4];
+		int stackPointer = radius;
+		for (int x = 0; x < count; ++x)
+		{
+			_mm_store_si128(reinterpret_cast<__m128i*>(sums), sum);
+			line[x * step] = static_cast<QRgb>(dv[sums[0]]) | (static_cast<QRgb>(dv[sums[1]]) << 8)
+			               | (static_cast<QRgb>(dv[sums[2]]) << 16) | (static_cast<QRgb>(dv[sums[3]]) << 24);
+			sum = _mm_sub_epi32(sum, outSum);
+			__m128i* sir = reinterpret_cast<__m128i*>(stack + 4 * ((stackPointer - radius + div) % div));
+			outSum = _mm_sub_epi32(outSum, _mm_loadu_si128(sir));
+			__m128i channels = unpackPixelSSE2(line[qMin(x + r1, last) * step]);
+			_mm_storeu_si128(sir, channels);
+			inSum = _mm_add_epi32(inSum, channels);
+			sum = _mm_add_epi32(sum, inSum);
+			stackPointer = (stackPointer + 1) % div;
+			channels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stack + 4 * stackPointer));
+			outSum = _mm_add_epi32(outSum, channels);
+			inSum = _mm_sub_epi32(inSum, channels);
+		}
+	}
+#endif
+
+	// ---- convolution
+
+	inline unsigned char convolutionResult(double value)
+	{
+		value = value < 0 ? 0 : value > 65535 ? 65535 : value + 0.5;
+		return (unsigned char)(value / 257UL);
+	}
+
+	// Computes one row of the convolution, \a rows are the source rows under the kernel and
+	// \a columns the source column of each kernel position, both clamped to the image.
+	void convolveRowScalar(const QRgb* const* rows, const int* columns, int widthk, const double* kernel, QRgb* dest, int width)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const double* k = kernel;
+			double red = 0, green = 0, blue = 0, alpha = 0;
+			for (int mcy = 0; mcy < widthk; ++mcy)
+			{
+				const QRgb* row = rows[mcy];
+				for (int mcx = 0; mcx < widthk; ++mcx)
+				{
+					QRgb px = row[columns[x + mcx]];
+					red += (*k) * (qRed(px) * 257);
+					green += (*k) * (qGreen(px) * 257);
+					blue += (*k) * (qBlue(px) * 257);
+					alpha += (*k) * (qAlpha(px) * 257);
+					++k;
+				}
+			}
+			dest[x] = qRgba(convolutionResult(red), convolutionResult(green), convolutionResult(blue), convolutionResult(alpha));
+		}
+	}
+
+#ifdef SCIMAGEKERNELS_SSE2
+	void convolveRowSSE2(const QRgb* const* rows, const int* columns, int widthk, const double* kernel, QRgb* dest, int width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i factor = _mm_set1_epi16(257);
+		alignas(16) double sums[4];
+		for (int x = 0; x < width; ++x)
+		{
+			const double* k = kernel;
+			// Blue and green, red and alpha
+			__m128d blueGreen = _mm_setzero_pd();
+			__m128d redAlpha = _mm_setzero_pd();
+			for (int mcy = 0; mcy < widthk; ++mcy)
+			{
+				const QRgb* row = rows[mcy];
+				for (int mcx = 0; mcx < widthk; ++mcx)
+				{
+					// Channels times 257 fit in unsigned 16 bit lanes
+					__m128i channels = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(row[columns[x + mcx]])), zero), factor);
+					channels = _mm_unpacklo_epi16(channels, zero);
+					__m128d weight = _mm_set1_pd(*k);
+					blueGreen = _mm_add_pd(blueGreen, _mm_mul_pd(weight, _mm_cvtepi32_pd(channels)));
+					redAlpha = _mm_add_pd(redAlpha, _mm_mul_pd(weight, _mm_cvtepi32_pd(_mm_shuffle_epi32(channels, _MM_SHUFFLE(3, 2, 3, 2)))));
+					++k;
+				}
+			}
+			_mm_store_pd(sums, blueGreen);
+			_mm_store_pd(sums + 2, redAlpha);
+			dest[x] = qRgba(convolutionResult(sums[2]), convolutionResult(sums[1]), convolutionResult(sums[0]), convolutionResult(sums[3]));
+		}
+	}
+#endif
+
+#ifdef SCIMAGEKERNELS_AVX2
+	SCIMAGEKERNELS_AVX2_FUNCTION void convolveRowAVX2(const QRgb* const* rows, const int* columns, int widthk, const double* kernel, QRgb* dest, int width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i factor = _mm_set1_epi16(257);
+		alignas(32) double sums[4];
+		for (int x = 0; x < width; ++x)
+		{
+			const double* k = kernel;
+			// Blue, green, red and alpha
+			__m256d channelSums = _mm256_setzero_pd();
+			for (int mcy = 0; mcy < widthk; ++mcy)
+			{
+				const QRgb* row = rows[mcy];
+				for (int mcx = 0; mcx < widthk; ++mcx)
+				{
+					__m128i channels = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(row[columns[x + mcx]])), zero), factor);
+					channels = _mm_unpacklo_epi16(channels, zero);
+					channelSums = _mm256_add_pd(channelSums, _mm256_mul_pd(_mm256_set1_pd(*k), _mm256_cvtepi32_pd(channels)));
+					++k;
+				}
+			}
+			_mm256_store_pd(sums, channelSums);
+			dest[x] = qRgba(convolutionResult(sums[2]), convolutionResult(sums[1]), convolutionResult(sums[0]), convolutionResult(sums[3]));
+		}
+	}
+#endif
+
+	// ---- resampling
+
+	double bilinearFilter(double x)
+	{
+		x = fabs(x);
+		return (x < 1.0) ? 1.0 - x : 0.0;
+	}
+
+	double sinc(double x)
+	{
+		if (x == 0.0)
+			return 1.0;
+		x *= M_PI;
+		return sin(x) / x;
+	}
+
+	double lanczosFilter(double x)
+	{
+		return ((x > -3.0) && (x < 3.0)) ? sinc(x) * sinc(x / 3.0) : 0.0;
+	}
+
+	/// Source range and weights of each output position along one axis
+	struct ResampleCoefficients
+	{
+		int taps { 0 };
+		std::vector<int> first;
+		std::vector<int> count;
+		// taps weights for each output position, unused ones are 0
+		std::vector<float> weights;
+	};
+
+	ResampleCoefficients resampleCoefficients(int inSize, int outSize, ScImageKernels::ResampleFilter filter)
+	{
+		// Box weights are the source areas covered, computed below
+		double (*filterFunction)(double) = nullptr;
+		double support = 0.5;
+		if (filter == ScImageKernels::ResampleFilter::Bilinear)
+		{
+			filterFunction = bilinearFilter;
+			support = 1.0;
+		}
+		else if (filter == ScImageKernels::ResampleFilter::Lanczos)
+		{
+			filterFunction = lanczosFilter;
+			support = 3.0;
+		}
+		// The filter is stretched over several source pixels when reducing
+		const double scale = static_cast<double>(inSize) / outSize;
+		const double filterScale = qMax(scale, 1.0);
+		support *= filterScale;
+
+		ResampleCoefficients coefficients;
+		coefficients.taps = static_cast<int>(ceil(support)) * 2 + 1;
+		coefficients.first.resize(outSize);
+		coefficients.count.resize(outSize);
+		coefficients.weights.resize(static_cast<size_t>(outSize) * coefficients.taps, 0.0f);
+		std::vector<double> weights(coefficients.taps);
+		for (int i = 0; i < outSize; ++i)
+		{
+			double center = (i + 0.5) * scale;
+			int first = qMax(static_cast<int>(center - support + 0.5), 0);
+			int count = qMin(static_cast<int>(center + support + 0.5), inSize) - first;
+			double total = 0.0;
+			if (filter == ScImageKernels::ResampleFilter::Box)
+			{
+				// Area averaging: source pixels weigh as much as the output pixel covers of them
+				const double start = i * scale;
+				const double end = start + scale;
+				first = qBound(0, static_cast<int>(floor(start)), inSize - 1);
+				count = qMin(static_cast<int>(ceil(end)), inSize) - first;
+				count = qMin(count, coefficients.taps);
+				for (int k = 0; k < count; ++k)
+				{
+					weights[k] = qMax(0.0, qMin(first + k + 1.0, end) - qMax(first + k + 0.0, start));
+					total += weights[k];
+				}
+			}
+			else
+			{
+				count = qMin(count, coefficients.taps);
+				for (int k = 0; k < count; ++k)
+				{
+					weights[k] = filterFunction((first + k - center + 0.5) / filterScale);
+					total += weights[k];
+				}
+			}
+			if (total == 0.0)
+			{
+				// Nothing under the filter, take the nearest pixel
+				first = qBound(0, static_cast<int>(center), inSize - 1);
+				count = 1;
+				weights[0] = total = 1.0;
+			}
+			coefficients.first[i] = first;
+			coefficients.count[i] = count;
+			float* outWeights = coefficients.weights.data() + static_cast<size_t>(i) * coefficients.taps;
+			for (int k = 0; k < count; ++k)
+				outWeights[k] = static_cast<float>(weights[k] / total);
+		}
+		return coefficients;
+	}
+
+	inline uchar resampledByte(float value)
+	{
+		return static_cast<uchar>(qBound(0.0f, value, 255.0f) + 0.5f);
+	}
+
+	template <int channels>
+	void resampleRowScalar(const uchar* source, uchar* dest, const ResampleCoefficients& coefficients)
+	{
+		const int outSize = static_cast<int>(coefficients.first.size());
+		for (int i = 0; i < outSize; ++i)
+		{
+			const float* weights = coefficients.weights.data() + static_cast<size_t>(i) * coefficients.taps;
+			const uchar* s = source + coefficients.first[i] * channels;
+			float sums[channels] = {};
+			for (int k = 0; k < coefficients.count[i]; ++k)
+			{
+				for (int c = 0; c < channels; ++c)
+					sums[c] += weights[k] * s[k * channels + c];
+			}
+			for (int c = 0; c < channels; ++c)
+				dest[i * channels + c] = resampledByte(sums[c]);
+		}
+	}
+
+	// Combines \a count source rows with \a weights into \a dest, \a bytes bytes long
+	void resampleColumnsScalar(const uchar* const* rows, const float* weights, int count, uchar* dest, int bytes)
+	{
+		for (int x = 0; x < bytes; ++x)
+		{
+			float sum = 0.0f;
+			for (int k = 0; k < count; ++k)
+				sum += weights[k] * rows[k][x];
+			dest[x] = resampledByte(sum);
+		}
+	}
+
+#ifdef SCIMAGEKERNELS_SSE2
+	// Rounds and packs four float vectors of 4 values into 16 bytes
+	inline __m128i packResampledSSE2(__m128 v0, __m128 v1, __m128 v2, __m128 v3)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 maxValue = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		__m128i i0 = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(v0, zero), maxValue), half));
+		__m128i i1 = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(v1, zero), maxValue), half));
+		__m128i i2 = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(v2, zero), maxValue), half));
+		__m128i i3 = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(v3, zero), maxValue), half));
+		return _mm_packus_epi16(_mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3));
+	}
+
+	// 32 bit pixels, the four channels of a pixel in the lanes of a register
+	void resampleRowSSE2(const uchar* source, uchar* dest, const ResampleCoefficients& coefficients)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const int outSize = static_cast<int>(coefficients.first.size());
+		const QRgb* pixels = reinterpret_cast<const QRgb*>(source);
+		QRgb* out = reinterpret_cast<QRgb*>(dest);
+		for (int i = 0; i < outSize; ++i)
+		{
+			const float* weights = coefficients.weights.data() + static_cast<size_t>(i) * coefficients.taps;
+			const QRgb* s = pixels + coefficients.first[i];
+			__m128 sum = _mm_setzero_ps();
+			for (int k = 0; k < coefficients.count[i]; ++k)
+			{
+				__m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(s[k])), zero), zero);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_cvtepi32_ps(channels)));
+			}
+			out[i] = static_cast<QRgb>(_mm_cvtsi128_si32(packResampledSSE2(sum, sum, sum, sum)));
+		}
+	}
+
+	void resampleColumnsSSE2(const uchar* const* rows, const float* weights, int count, uchar* dest, int bytes)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		int x = 0;
+		for (; x + 16 <= bytes; x += 16)
+		{
+			__m128 sums[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+			for (int k = 0; k < count; ++k)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + x));
+				__m128i low = _mm_unpacklo_epi8(v, zero);
+				__m128i high = _mm_unpackhi_epi8(v, zero);
+				__m128 weight = _mm_set1_ps(weights[k]);
+				sums[0] = _mm_add_ps(sums[0], _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero))));
+				sums[1] = _mm_add_ps(sums[1], _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero))));
+				sums[2] = _mm_add_ps(sums[2], _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero))));
+				sums[3] = _mm_add_ps(sums[3], _mm_mul_ps(weight, _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero))));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x), packResampledSSE2(sums[0], sums[1], sums[2], sums[3]));
+		}
+		std::vector<const uchar*> tailRows(rows, rows + count);
+		for (const uchar*& row : tailRows)
+			row += x;
+		resampleColumnsScalar(tailRows.data(), weights, count, dest + x, bytes - x);
+	}
+#endif
+
+#ifdef SCIMAGEKERNELS_AVX2
+	SCIMAGEKERNELS_AVX2_FUNCTION void resampleColumnsAVX2(const uchar* const* rows, const float* weights, int count, uchar* dest, int bytes)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 maxValue = _mm256_set1_ps(255.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		int x = 0;
+		for (; x + 32 <= bytes; x += 32)
+		{
+			__m256 sums[4] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+			for (int k = 0; k < count; ++k)
+			{
+				const uchar* row = rows[k] + x;
+				__m256 weight = _mm256_set1_ps(weights[k]);
+				for (int j = 0; j < 4; ++j)
+				{
+					__m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + 8 * j));
+					sums[j] = _mm256_add_ps(sums[j], _mm256_mul_ps(weight, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v))));
+				}
+			}
+			__m256i values[4];
+			for (int j = 0; j < 4; ++j)
+				values[j] = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_min_ps(_mm256_max_ps(sums[j], zero), maxValue), half));
+			// Packing works within 128 bit lanes, restore the order of values afterwards
+			__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(values[0], values[1]), _mm256_packs_epi32(values[2], values[3]));
+			packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + x), packed);
+		}
+		std::vector<const uchar*> tailRows(rows, rows + count);
+		for (const uchar*& row : tailRows)
+			row += x;
+		resampleColumnsScalar(tailRows.data(), weights, count, dest + x, bytes - x);
+	}
+#endif
+}
+
+ScImageKernels::InstructionSet ScImageKernels::supportedInstructionSet()
+{
+#if defined(SCIMAGEKERNELS_AVX2)
+	static const InstructionSet supported = []() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? InstructionSet::AVX2 : InstructionSet::SSE2;
+	}();
+	return supported;
+#elif defined(SCIMAGEKERNELS_SSE2)
+	return InstructionSet::SSE2;
+#else
+	return InstructionSet::Scalar;
+#endif
+}
+
+ScImageKernels::InstructionSet ScImageKernels::instructionSet()
+{
+	InstructionSet supported = supportedInstructionSet();
+	int selected = selectedInstructionSet.load(std::memory_order_relaxed);
+	if ((selected < 0) || (selected > static_cast<int>(supported)))
+		return supported;
+	return static_cast<InstructionSet>(selected);
+}
+
+void ScImageKernels::setInstructionSet(InstructionSet instructionSet)
+{
+	selectedInstructionSet.store(static_cast<int>(instructionSet), std::memory_order_relaxed);
+}
+
+int ScImageKernels::maxThreadCount()
+{
+	return maxThreads.load(std::memory_order_relaxed);
+}
+
+void ScImageKernels::setMaxThreadCount(int count)
+{
+	maxThreads.store(qMax(0, count), std::memory_order_relaxed);
+}
+
+void ScImageKernels::invert(QImage& image, bool cmyk)
+{
+	void (*invertRow)(QRgb*, int, bool) = invertScalar;
+#ifdef SCIMAGEKERNELS_SSE2
+	if (instructionSet() == InstructionSet::SSE2)
+		invertRow = invertSSE2;
+#endif
+#ifdef SCIMAGEKERNELS_AVX2
+	if (instructionSet() == InstructionSet::AVX2)
+		invertRow = invertAVX2;
+#endif
+
+	const int w = image.width();
+	uchar* bits = image.bits();
+	const qsizetype bytesPerLine = image.bytesPerLine();
+	forEachRange(image.height(), w, [=](int begin, int end) {
+		for (int y = begin; y < end; ++y)
+			invertRow(reinterpret_cast<QRgb*>(bits + y * bytesPerLine), w, cmyk);
+	});
+}
+
+void ScImageKernels::applyCurve(QImage& image, const QVector<int>& curveTable, bool cmyk)
+{
+	// Table lookups gain nothing from SIMD, rows are only spread over threads
+	unsigned char table[256];
+	for (int i = 0; i < 256; ++i)
+		table[i] = cmyk ? (unsigned char) (255 - curveTable[255 - i]) : (unsigned char) curveTable[i];
+
+	const int w = image.width();
+	uchar* bits = image.bits();
+	const qsizetype bytesPerLine = image.bytesPerLine();
+	forEachRange(image.height(), w, [&](int begin, int end) {
+		for (int y = begin; y < end; ++y)
+		{
+			QRgb* s = reinterpret_cast<QRgb*>(bits + y * bytesPerLine);
+			for (int x = 0; x < w; ++x, ++s)
+			{
+				if (cmyk)
+				{
+					unsigned char *p = (unsigned char *) s;
+					p[0] = table[p[0]];
+					p[1] = table[p[1]];
+					p[2] = table[p[2]];
+					p[3] = table[p[3]];
+				}
+				else
+				{
+					QRgb r = *s;
+					*s = qRgba(table[qRed(r)], table[qGreen(r)], table[qBlue(r)], qAlpha(r));
+				}
+			}
+		}
+	});
+}
+
+void ScImageKernels::mapLuminance(QImage& image, const QRgb* colorTable, bool cmyk)
+{
+	void (*mapRow)(QRgb*, int, const QRgb*, bool) = mapLuminanceScalar;
+#ifdef SCIMAGEKERNELS_SSE2
+	if (instructionSet() == InstructionSet::SSE2)
+		mapRow = mapLuminanceSSE2;
+#endif
+#ifdef SCIMAGEKERNELS_AVX2
+	if (instructionSet() == InstructionSet::AVX2)
+		mapRow = mapLuminanceAVX2;
+#endif
+
+	const int w = image.width();
+	uchar* bits = image.bits();
+	const qsizetype bytesPerLine = image.bytesPerLine();
+	forEachRange(image.height(), w, [=](int begin, int end) {
+		for (int y = begin; y < end; ++y)
+			mapRow(reinterpret_cast<QRgb*>(bits + y * bytesPerLine), w, colorTable, cmyk);
+	});
+}
+
+void ScImageKernels::blur(QImage& image, int radius)
+{
+	const int w = image.width();
+	const int h = image.height();
+	if ((radius < 1) || (w <= 0) || (h <= 0))
+		return;
+
+	const int div = radius + radius + 1;
+	int divsum = (div + 1) >> 1;
+	divsum *= divsum;
+	std::vector<int> dvTable(256 * divsum);
+	for (int i = 0; i < 256 * divsum; ++i)
+		dvTable[i] = (i / divsum);
+	const int* dv = dvTable.data();
+
+	// The horizontal pass writes its result back into the image, where the vertical pass reads
+	// it, as bytes hold the blurred channels exactly. No intermediate planes are needed.
+	QRgb* pix = reinterpret_cast<QRgb*>(image.bits());
+	const qsizetype stride = image.bytesPerLine() / 4;
+#ifdef SCIMAGEKERNELS_SSE2
+	// Blurring a line has no wider variant, AVX2 uses the SSE2 one
+	if ((instructionSet() != InstructionSet::Scalar) && (radius < 32768))
+	{
+		forEachRange(h, w, [=](int begin, int end) {
+			std::vector<int> stack(4 * div);
+			for (int y = begin; y < end; ++y)
+				blurLineSSE2(pix + y * stride, w, 1, radius, dv, stack.data());
+		});
+		forEachRange(w, h, [=](int begin, int end) {
+			std::vector<int> stack(4 * div);
+			for (int x = begin; x < end; ++x)
+				blurLineSSE2(pix + x, h, stride, radius, dv, stack.data());
+		});
+		return;
+	}
+#endif
+	forEachRange(h, w, [=](int begin, int end) {
+		std::vector<int> stack(4 * div);
+		for (int y = begin; y < end; ++y)
+			blurLineScalar(pix + y * stride, w, 1, radius, dv, stack.data());
+	});
+	forEachRange(w, h, [=](int begin, int end) {
+		std::vector<int> stack(4 * div);
+		for (int x = begin; x < end; ++x)
+			blurLineScalar(pix + x, h, stride, radius, dv, stack.data());
+	});
+}
+
+bool ScImageKernels::convolve(const QImage& source, QImage& dest, int order, const double* kernel)
+{
+	const int widthk = order;
+	if ((widthk % 2) == 0)
+		return false;
+
+	std::vector<double> normalKernel(widthk * widthk);
+	double normalize = 0.0;
+	for (int i = 0; i < (widthk * widthk); i++)
+		normalize += kernel[i];
+	if (fabs(normalize) <= 1.0e-12)
+		normalize = 1.0;
+	normalize = 1.0 / normalize;
+	for (int i = 0; i < (widthk * widthk); i++)
+		normalKernel[i] = normalize * kernel[i];
+
+	// Pixels are read as QImage::pixel() returns them, i.e. as ARGB32: opaque for RGB32,
+	// unpremultiplied for ARGB32_Premultiplied. Only ARGB32 is stored that way.
+	QImage image(source);
+	if (image.format() != QImage::Format_ARGB32)
+		image = source.convertToFormat(QImage::Format_ARGB32);
+	const int w = image.width();
+	const int h = image.height();
+	dest = QImage(w, h, QImage::Format_ARGB32);
+	if ((w <= 0) || (h <= 0))
+		return true;
+	if (dest.isNull())
+		return false;
+
+	void (*convolveRow)(const QRgb* const*, const int*, int, const double*, QRgb*, int) = convolveRowScalar;
+#ifdef SCIMAGEKERNELS_SSE2
+	if (instructionSet() == InstructionSet::SSE2)
+		convolveRow = convolveRowSSE2;
+#endif
+#ifdef SCIMAGEKERNELS_AVX2
+	if (instructionSet() == InstructionSet::AVX2)
+		convolveRow = convolveRowAVX2;
+#endif
+
+	std::vector<int> columns(w + widthk - 1);
+	for (int i = 0; i < static_cast<int>(columns.size()); ++i)
+		columns[i] = qBound(0, i - (widthk / 2), w - 1);
+
+	const QImage& constImage = image;
+	uchar* destBits = dest.bits();
+	const qsizetype destBytesPerLine = dest.bytesPerLine();
+	forEachRange(h, static_cast<qint64>(w) * widthk * widthk, [&](int begin, int end) {
+		std::vector<const QRgb*> rows(widthk);
+		for (int y = begin; y < end; ++y)
+		{
+			for (int mcy = 0; mcy < widthk; ++mcy)
+				rows[mcy] = reinterpret_cast<const QRgb*>(constImage.constScanLine(qBound(0, y - (widthk / 2) + mcy, h - 1)));
+			convolveRow(rows.data(), columns.data(), widthk, normalKernel.data(), reinterpret_cast<QRgb*>(destBits + y * destBytesPerLine), w);
+		}
+	});
+	return true;
+}
+
+bool ScImageKernels::resample(const QImage& source, QImage& dest, int width, int height, ResampleFilter filter)
+{
+	int channels = 0;
+	if (source.depth() == 32)
+		channels = 4;
+	else if ((source.format() == QImage::Format_RGB888) || (source.format() == QImage::Format_BGR888))
+		channels = 3;
+	else if (source.format() == QImage::Format_Grayscale8)
+		channels = 1;
+	if ((channels == 0) || source.isNull() || (width <= 0) || (height <= 0))
+		return false;
+
+	const QImage::Format format = source.format();
+	const InstructionSet instructions = instructionSet();
+
+	// Rows first, into an image as wide as the result and as high as the source
+	QImage horizontal(source);
+	if (width != source.width())
+	{
+		horizontal = QImage(width, source.height(), format);
+		if (horizontal.isNull())
+			return false;
+		ResampleCoefficients coefficients = resampleCoefficients(source.width(), width, filter);
+		void (*resampleRow)(const uchar*, uchar*, const ResampleCoefficients&) = resampleRowScalar<4>;
+		if (channels == 3)
+			resampleRow = resampleRowScalar<3>;
+		else if (channels == 1)
+			resampleRow = resampleRowScalar<1>;
+#ifdef SCIMAGEKERNELS_SSE2
+		// Pixels are too narrow for AVX2 to gain anything, it uses the SSE2 code
+		if ((channels == 4) && (instructions != InstructionSet::Scalar))
+			resampleRow = resampleRowSSE2;
+#endif
+		uchar* bits = horizontal.bits();
+		const qsizetype bytesPerLine = horizontal.bytesPerLine();
+		forEachRange(source.height(), static_cast<qint64>(width) * coefficients.taps, [&](int begin, int end) {
+			for (int y = begin; y < end; ++y)
+				resampleRow(source.constScanLine(y), bits + y * bytesPerLine, coefficients);
+		});
+	}
+
+	// Then columns, combining whole rows so that memory is read in order
+	if (height == source.height())
+	{
+		dest = horizontal;
+		return true;
+	}
+	QImage vertical(width, height, format);
+	if (vertical.isNull())
+		return false;
+	ResampleCoefficients coefficients = resampleCoefficients(source.height(), height, filter);
+	void (*resampleColumns)(const uchar* const*, const float*, int, uchar*, int) = resampleColumnsScalar;
+#ifdef SCIMAGEKERNELS_SSE2
+	if (instructions == InstructionSet::SSE2)
+		resampleColumns = resampleColumnsSSE2;
+#endif
+#ifdef SCIMAGEKERNELS_AVX2
+	if (instructions == InstructionSet::AVX2)
+		resampleColumns = resampleColumnsAVX2;
+#endif
+	const QImage& constHorizontal = horizontal;
+	const int bytes = width * channels;
+	uchar* bits = vertical.bits();
+	const qsizetype bytesPerLine = vertical.bytesPerLine();
+	forEachRange(height, static_cast<qint64>(width) * coefficients.taps, [&](int begin, int end) {
+		std::vector<const uchar*> rows(coefficients.taps);
+		for (int y = begin; y < end; ++y)
+		{
+			int first = coefficients.first[y];
+			int count = coefficients.count[y];
+			for (int k = 0; k < count; ++k)
+				rows[k] = constHorizontal.constScanLine(first + k);
+			resampleColumns(rows.data(), coefficients.weights.data() + static_cast<size_t>(y) * coefficients.taps, count, bits + y * bytesPerLine, bytes);
+		}
+	});
+	dest = vertical;
+	return true;
+}
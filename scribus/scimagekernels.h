@@ -0,0 +1,84 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef SCIMAGEKERNELS_H
+#define SCIMAGEKERNELS_H
+
+#include <QImage>
+#include <QVector>
+
+#include "scribusapi.h"
+
+/**
+ * \brief Pixel loops of the image effects and of the scaling of ScImage.
+ *
+ * Effect kernels work on 32 bit images in place, as ScImage does, and produce the same output
+ * as the former per pixel code down to the last bit. They are vectorised with SSE2 or AVX2,
+ * chosen at runtime from what the processor supports, and fall back to scalar code on other
+ * processors. Rows, or columns for the vertical pass of blur(), are split among the threads
+ * of the global thread pool. The calling thread takes part and processes the rows no pool
+ * thread has started on, so kernels may be run from pool threads, as when loading images.
+ */
+class SCRIBUS_API ScImageKernels
+{
+public:
+	enum class InstructionSet
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	/// Filters of resample()
+	enum class ResampleFilter
+	{
+		Box,       ///< Area averaging, source pixels weigh as much as the output pixel covers of them
+		Bilinear,  ///< Triangle filter
+		Lanczos    ///< Lanczos filter with three lobes, sharpest
+	};
+
+	/// Best instruction set supported by both the build and the processor
+	static InstructionSet supportedInstructionSet();
+	static InstructionSet instructionSet();
+	/// Restricts the instructions used by kernels, e.g. to compare them with scalar code
+	static void setInstructionSet(InstructionSet instructionSet);
+
+	/// Number of threads a kernel may use, 0 meaning as many as the global thread pool allows
+	static int maxThreadCount();
+	static void setMaxThreadCount(int count);
+
+	/// Inverts RGB channels, or CMYK channels with the black channel stored as alpha
+	static void invert(QImage& image, bool cmyk);
+	/// Maps the RGB channels, or the four CMYK channels, through \a curveTable of 256 entries
+	static void applyCurve(QImage& image, const QVector<int>& curveTable, bool cmyk);
+	/**
+	 * \brief Replaces each pixel by the entry of \a colorTable at its luminance.
+	 * The luminance is 0.3 R + 0.59 G + 0.11 B rounded and clamped to 255, the black channel
+	 * stored as alpha is added to it for CMYK images. The alpha channel of RGB images is kept,
+	 * the one of the table is ignored. \a colorTable has 256 entries.
+	 */
+	static void mapLuminance(QImage& image, const QRgb* colorTable, bool cmyk);
+	/// Stack blur of \a radius pixels, by Mario Klingemann
+	static void blur(QImage& image, int radius);
+	/**
+	 * \brief Convolves \a source with the square \a kernel of \a order by \a order values into \a dest.
+	 * The kernel is normalized first, \a dest is created as an ARGB32 image. Returns false if
+	 * \a order is even or memory is short.
+	 */
+	static bool convolve(const QImage& source, QImage& dest, int order, const double* kernel);
+	/**
+	 * \brief Scales \a source to \a width by \a height pixels into \a dest with \a filter.
+	 * Rows are resampled first, then columns, with weights computed once for each output
+	 * position. Channels are filtered independently, as stored: premultiply images with alpha
+	 * beforehand if transparent pixels must not bleed. 32 bit images and 8 bit per channel
+	 * grayscale and RGB images are supported, \a dest has the format of \a source. Returns
+	 * false for other formats or if memory is short.
+	 */
+	static bool resample(const QImage& source, QImage& dest, int width, int height, ResampleFilter filter);
+};
+
+#endif // SCIMAGEKERNELS_H
@@ -64,6 +64,8 @@ ScPage::~ScPage()
 //		}
 //	}
 	FromMaster.clear();
+	if (m_Doc)
+		m_Doc->pageDestroyed(this);
 }
 
 QRectF ScPage::bleedRect() const
@@ -59,6 +59,8 @@ ScPageOutput::ScPageOutput(ScribusDoc* doc, bool reloadImages, int resolution, b
 	m_reloadImages = reloadImages;
 	m_imageRes = resolution;
 	m_useProfiles = useProfiles;
+	// Images of large documents are loaded on demand, output needs all of them
+	m_doc->imageLoadScheduler()->loadAll();
 }
 
 ScImage::RequestType ScPageOutput::translateImageModeToRequest(ScPainterExBase::ImageMode mode) const
@@ -54,6 +54,9 @@ public:
 	virtual QTransform worldMatrix();
 	virtual void setZoomFactor(double);
 	virtual double zoomFactor() { return m_zoomFactor; }
+	/// Drawing at reduced detail: no soft shadows, flat complex gradients, simplified long paths
+	void setReducedDetail(bool reduced) { m_reducedDetail = reduced; }
+	bool reducedDetail() const { return m_reducedDetail; }
 	virtual void translate(double, double);
 	virtual void translate(const QPointF& offset);
 	virtual void rotate(double);
@@ -231,6 +234,8 @@ private:
 	double m_offset { 0.0 };
 	/*! \brief Zoom Factor of the Painter */
 	double m_zoomFactor { 1.0 };
+	/*! \brief Set by the canvas for items drawn at reduced detail */
+	bool m_reducedDetail { false };
 	bool m_imageMode { true };
 };
 
@@ -581,6 +581,11 @@ QString ScPaths::imageCacheDir()
 	return applicationDataDir() + "cache/img/";
 }
 
+QString ScPaths::pdfImageCacheDir()
+{
+	return applicationDataDir() + "cache/pdf/";
+}
+
 QString ScPaths::pluginDataDir(bool createIfNotExists)
 {
 	QDir useFilesDirectory(applicationDataDir() + "plugins/");
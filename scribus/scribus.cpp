@@ -122,6 +122,7 @@ for which a new license (GPL+exception) is in place.
 #include "pageitem_table.h"
 #include "pageitem_textframe.h"
 #include "pagesize.h"
+#include "pdfimagestreamcache.h"
 #include "pdflib.h"
 #include "pdfoptions.h"
 #include "pluginmanager.h"
@@ -1958,7 +1959,7 @@ QStringList ScribusMainWindow::findRecoverableFile()
 			for (int i = 0; i < aList.count(); i++)
 				foundFiles.insert(aList[i].absoluteFilePath());
 		}
-		QDir dirAuto2(m_prefsManager.appPrefs.docSetupPrefs.AutoSaveDir, "*_autosave_*.sla", sortflags, filterflags);
+		QDir dirAuto2(m_prefsManager.appPrefs.docSetupPrefs.AutoSaveDir, "*_autosave_*.sla *_autosave_*.sla.gz", sortflags, filterflags);
 		QFileInfoList aList2 = dirAuto2.entryInfoList();
 		if (aList2.count() > 0)
 		{
@@ -1971,7 +1972,7 @@ QStringList ScribusMainWindow::findRecoverableFile()
 	for (int i = 0; i < dList.count(); i++)
 		foundFiles.insert(dList[i].absoluteFilePath());
 
-	QDir dirDoc2(m_prefsManager.documentDir(), "*_autosave_*.sla", sortflags, filterflags);
+	QDir dirDoc2(m_prefsManager.documentDir(), "*_autosave_*.sla *_autosave_*.sla.gz", sortflags, filterflags);
 	QFileInfoList dList2 = dirDoc2.entryInfoList();
 	for (int i = 0; i < dList2.count(); i++)
 		foundFiles.insert(dList2[i].absoluteFilePath());
@@ -1981,7 +1982,7 @@ QStringList ScribusMainWindow::findRecoverableFile()
 	for (int i = 0; i < hList.count(); i++)
 		foundFiles.insert(hList[i].absoluteFilePath());
 
-	QDir dirHome2(QDir::toNativeSeparators(QDir::homePath()), "*_autosave_*.sla", sortflags, filterflags);
+	QDir dirHome2(QDir::toNativeSeparators(QDir::homePath()), "*_autosave_*.sla *_autosave_*.sla.gz", sortflags, filterflags);
 	QFileInfoList hList2 = dirHome2.entryInfoList();
 	for (int i = 0; i < hList2.count(); i++)
 		foundFiles.insert(hList2[i].absoluteFilePath());
@@ -2667,6 +2668,8 @@ void ScribusMainWindow::HaveNewSel()
 	const int docSelectionCount = doc->m_Selection->count();
 	if (docSelectionCount > 0)
 	{
+		// Properties of selected images are shown and edited, load those loaded on demand
+		doc->imageLoadScheduler()->load(doc->m_Selection->items());
 		currItem = doc->m_Selection->itemAt(0);
 		selectedType = currItem->itemType();
 	}
@@ -3496,80 +3499,7 @@ bool ScribusMainWindow::loadDoc(const QString& fileName)
 			doc->HasCMS = false;
 		if ((ScCore->haveCMS()) && (doc->cmsSettings().CMSinUse))
 		{
-			QString missing, replacement;
-			QMultiMap<QString, QString> missingMap;
-			if (!ScCore->InputProfiles.contains(doc->cmsSettings().DefaultImageRGBProfile))
-			{
-				missing = doc->cmsSettings().DefaultImageRGBProfile;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultImageRGBProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->cmsSettings().DefaultImageRGBProfile = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultImageRGBProfile;
-			}
-			if (!ScCore->InputProfilesCMYK.contains(doc->cmsSettings().DefaultImageCMYKProfile))
-			{
-				missing = doc->cmsSettings().DefaultImageCMYKProfile;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultImageCMYKProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->cmsSettings().DefaultImageCMYKProfile = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultImageCMYKProfile;
-			}
-			if (!ScCore->InputProfiles.contains(doc->cmsSettings().DefaultSolidColorRGBProfile))
-			{
-				missing = doc->cmsSettings().DefaultSolidColorRGBProfile;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultSolidColorRGBProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->cmsSettings().DefaultSolidColorRGBProfile = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultSolidColorRGBProfile;
-			}
-			if (!ScCore->InputProfilesCMYK.contains(doc->cmsSettings().DefaultSolidColorCMYKProfile))
-			{
-				missing = doc->cmsSettings().DefaultSolidColorCMYKProfile;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultSolidColorCMYKProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->cmsSettings().DefaultSolidColorCMYKProfile = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultSolidColorCMYKProfile;
-			}
-			if (!ScCore->MonitorProfiles.contains(doc->cmsSettings().DefaultMonitorProfile))
-			{
-				missing = doc->cmsSettings().DefaultMonitorProfile;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultMonitorProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->cmsSettings().DefaultMonitorProfile = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultMonitorProfile;
-			}
-			if (!ScCore->PrinterProfiles.contains(doc->cmsSettings().DefaultPrinterProfile))
-			{
-				missing = doc->cmsSettings().DefaultPrinterProfile;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultPrinterProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->cmsSettings().DefaultPrinterProfile = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultPrinterProfile;
-			}
-			if (!ScCore->PrinterProfiles.contains(doc->pdfOptions().PrintProf))
-			{
-				missing = doc->pdfOptions().PrintProf;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultPrinterProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->pdfOptions().PrintProf = doc->cmsSettings().DefaultPrinterProfile;
-			}
-			if (!ScCore->InputProfiles.contains(doc->pdfOptions().ImageProf))
-			{
-				missing = doc->pdfOptions().ImageProf;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultImageRGBProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->pdfOptions().ImageProf = doc->cmsSettings().DefaultImageRGBProfile;
-			}
-			if (!ScCore->InputProfiles.contains(doc->pdfOptions().SolidProf))
-			{
-				missing = doc->pdfOptions().SolidProf;
-				replacement = m_prefsManager.appPrefs.colorPrefs.DCMSset.DefaultSolidColorRGBProfile;
-				if (!missingMap.contains(missing, replacement))
-					missingMap.insert(missing, replacement);
-				doc->pdfOptions().SolidProf = doc->cmsSettings().DefaultSolidColorRGBProfile;
-			}
+			QMultiMap<QString, QString> missingMap = doc->replaceMissingCMSProfiles();
 			if (missingMap.count() > 0)
 			{
 				QApplication::changeOverrideCursor(QCursor(Qt::ArrowCursor));
@@ -3582,19 +3512,7 @@ bool ScribusMainWindow::loadDoc(const QString& fileName)
 			}
 			doc->SoftProofing = doc->cmsSettings().SoftProofOn;
 			doc->Gamut        = doc->cmsSettings().GamutCheck;
-			doc->IntentColors = doc->cmsSettings().DefaultIntentColors;
-			doc->IntentImages = doc->cmsSettings().DefaultIntentImages;
-			if (doc->OpenCMSProfiles(ScCore->InputProfiles, ScCore->InputProfilesCMYK, ScCore->MonitorProfiles, ScCore->PrinterProfiles))
-			{
-				doc->HasCMS = true;
-				doc->pdfOptions().SComp = doc->cmsSettings().ComponentsInput2;
-			}
-			else
-			{
-				doc->SetDefaultCMSParams();
-				doc->HasCMS = false;
-			}
-			if (doc->HasCMS)
+			if (doc->openLoadedCMSProfiles())
 			{
 				recalcColors();
 				doc->RecalcPictures(&ScCore->InputProfiles, &ScCore->InputProfilesCMYK);
@@ -3622,65 +3540,8 @@ bool ScribusMainWindow::loadDoc(const QString& fileName)
 		}
 		HaveNewDoc();
 		doc->hasName = true;
-		if (doc->MasterPages.isEmpty())
-		{
-			ScPage *docPage = doc->Pages->at(0);
-			ScPage *addedPage = doc->addMasterPage(0, CommonStrings::masterPageNormal);
-			addedPage->setSize(docPage->size());
-			addedPage->setInitialHeight(docPage->height());
-			addedPage->setInitialWidth(docPage->width());
-			addedPage->setHeight(docPage->height());
-			addedPage->setWidth(docPage->width());
-			addedPage->initialMargins = docPage->initialMargins;
-			addedPage->LeftPg = docPage->LeftPg;
-			addedPage->setOrientation(docPage->orientation());
-		}
-		//Add doc sections if we have none
-		if (doc->sections().count() == 0)
-		{
-			doc->addSection(-1);
-			doc->setFirstSectionFromFirstPageNumber();
-		}
-		doc->RePos = true;
-		doc->setMasterPageMode(true);
-		doc->reformPages();
-		doc->refreshGuides();
-		doc->setLoading(false);
-		for (PageItem* ite : doc->MasterItems)
-		{
-			// TODO fix that for Groups on Masterpages
-//			if (ite->Groups.count() != 0)
-//				view->GroupOnPage(ite);
-//			qDebug() << QString("load M: %1 %2 %3").arg(azz).arg((uint)ite).arg(ite->itemType());
-			ite->layout();
-		}
-		doc->setMasterPageMode(false);
-		/*QTime t;
-		t.start();*/
-		doc->flag_Renumber = false;
-		doc->updateNumbers(true);
-		for (auto iti = doc->Items->begin(); iti != doc->Items->end(); ++iti)
-		{
-			PageItem* ite = *iti;
-			if ((ite->nextInChain() == nullptr) && !ite->isNoteFrame())  //do not layout notes frames
-				ite->layout();
-		}
-		if (!doc->marksList().isEmpty())
-		{
-			doc->setLoading(true);
-			doc->updateMarks(true);
-			doc->updateChangedEndNotesFrames();
-			doc->setLoading(false);
-		}
-		for (auto itf = doc->FrameItems.begin(); itf != doc->FrameItems.end(); ++itf)
-		{
-			PageItem *ite = itf.value();
-//			qDebug() << QString("load F: %1 %2 %3").arg(azz).arg((uint)ite).arg(ite->itemType());
-			if (ite->nextInChain() == nullptr)
-				ite->layout();
-		}
-		/*qDebug("Time elapsed: %d ms", t.elapsed());*/
-		doc->RePos = false;
+		doc->addMissingMasterPageAndSection();
+		doc->layoutLoadedItems();
 		doc->setModified(false);
 		inlinePalette->setDoc(doc);
 		updateRecent(filename);
@@ -3740,6 +3601,8 @@ bool ScribusMainWindow::loadDoc(const QString& fileName)
 	doc->setModified(false);
 	foreach (NotesStyle* NS, doc->m_docNotesStylesList)
 		doc->updateNotesFramesStyles(NS);
+	if (ret)
+		doc->pageThumbnailCache()->load();
 #ifdef DEBUG_LOAD_TIMES
 	times(&tms2);
 	double ticks = sysconf(_SC_CLK_TCK);
@@ -4140,6 +4003,7 @@ bool ScribusMainWindow::DoFileSave(const QString& fileName, QString* savedFileNa
 		m_undoManager->renameStack(fileName);
 		scrActions["fileRevert"]->setEnabled(false);
 		updateRecent(fileName);
+		doc->pageThumbnailCache()->save();
 	}
 	m_mainWindowStatusLabel->setText("");
 	mainWindowProgressBar->reset();
@@ -4167,6 +4031,7 @@ bool ScribusMainWindow::DoFileClose()
 	closeActiveWindowMasterPageEditor();
 	slotSelect();
 	doc->autoSaveTimer->stop();
+	doc->pageThumbnailCache()->save();
 	doc->disconnectDocSignals();
 	disconnect(ScCore->fileWatcher, SIGNAL(fileChanged(QString )), doc, SLOT(updatePict(QString)));
 	disconnect(ScCore->fileWatcher, SIGNAL(fileDeleted(QString )), doc, SLOT(removePict(QString)));
@@ -6619,6 +6484,10 @@ void ScribusMainWindow::slotPrefsOrg()
 	icm.setMaxCacheSizeMiB(newPrefs.imageCachePrefs.maxCacheSizeMiB);
 	icm.setMaxCacheEntries(newPrefs.imageCachePrefs.maxCacheEntries);
 	icm.setCompressionLevel(newPrefs.imageCachePrefs.compressionLevel);
+	PdfImageStreamCache & pdfCache = PdfImageStreamCache::instance();
+	pdfCache.setEnabled(newPrefs.imageCachePrefs.cacheEnabled);
+	pdfCache.setMaxCacheSizeMiB(newPrefs.imageCachePrefs.maxCacheSizeMiB);
+	ScFace::setGlyphCacheLimitMiB(newPrefs.fontPrefs.glyphCacheSizeMiB);
 
 	m_prefsManager.savePrefs();
 	m_mainWindowStatusLabel->setText( tr("Ready"));
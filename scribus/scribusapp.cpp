@@ -38,6 +38,7 @@ for which a new license (GPL+exception) is in place.
 #include "scribusapp.h"
 
 #include "downloadmanager/scdlmgr.h"
+#include "exportservice.h"
 #include "iconmanager.h"
 #include "langmgr.h"
 #include "localemgr.h"
@@ -49,6 +50,7 @@ for which a new license (GPL+exception) is in place.
 #include "util.h"
 
 #ifdef WITH_TESTS
+#include "tests/runbenchmarks.h"
 #include "tests/runtests.h"
 #endif
 
@@ -69,7 +71,10 @@ for which a new license (GPL+exception) is in place.
 #define ARG_PREFS "--prefs"
 #define ARG_UPGRADECHECK "--upgradecheck"
 #define ARG_TESTS "--tests"
+#define ARG_BENCHMARKS "--benchmarks"
 #define ARG_PYTHONSCRIPT "--python-script"
+#define ARG_EXPORTSERVICE "--export-service"
+#define ARG_EXPORTWORKERS "--export-workers"
 #define CMD_OPTIONS_END "--"
 
 #define ARG_VERSION_SHORT "-v"
@@ -85,7 +90,10 @@ for which a new license (GPL+exception) is in place.
 #define ARG_PREFS_SHORT "-pr"
 #define ARG_UPGRADECHECK_SHORT "-u"
 #define ARG_TESTS_SHORT "-T"
+#define ARG_BENCHMARKS_SHORT "-B"
 #define ARG_PYTHONSCRIPT_SHORT "-py"
+#define ARG_EXPORTSERVICE_SHORT "-es"
+#define ARG_EXPORTWORKERS_SHORT "-ew"
 
 // Qt wants -display not --display or -d
 #define ARG_DISPLAY_QT "-display"
@@ -206,6 +214,21 @@ void ScribusQApp::parseCommandLine()
 			testargsv = argv() + argi;
 			break;
 		}
+		else if (arg == ARG_BENCHMARKS || arg == ARG_BENCHMARKS_SHORT)
+		{
+			if (argi + 1 == argsc)
+			{
+				std::cout << tr("Option %1 requires an argument.").arg(arg).toLocal8Bit().data() << std::endl;
+				std::exit(EXIT_FAILURE);
+			}
+			m_runBenchmarks = true;
+			m_benchmarkOutput = args[++argi];
+			// An optional filter selects benchmarks by name
+			if ((argi + 1 < argsc) && !args[argi + 1].startsWith('-'))
+				m_benchmarkFilter = args[++argi];
+			useGUI = false;
+			m_showSplash = false;
+		}
 #endif
 		else if (arg == ARG_AVAILLANG || arg == ARG_AVAILLANG_SHORT)
 		{
@@ -234,6 +257,29 @@ void ScribusQApp::parseCommandLine()
 		{
 			useGUI = false;
 		}
+		else if (arg == ARG_EXPORTSERVICE || arg == ARG_EXPORTSERVICE_SHORT)
+		{
+			if (argi + 1 == argsc)
+			{
+				std::cout << tr("Option %1 requires an argument.").arg(arg).toLocal8Bit().data() << std::endl;
+				std::exit(EXIT_FAILURE);
+			}
+			m_runExportService = true;
+			m_exportServiceName = args[++argi];
+			useGUI = false;
+			m_showSplash = false;
+		}
+		else if (arg == ARG_EXPORTWORKERS || arg == ARG_EXPORTWORKERS_SHORT)
+		{
+			bool ok = false;
+			if (argi + 1 < argsc)
+				m_exportWorkers = args[++argi].toInt(&ok);
+			if (!ok || (m_exportWorkers < 1))
+			{
+				std::cout << tr("Option %1 requires a number of workers.").arg(arg).toLocal8Bit().data() << std::endl;
+				std::exit(EXIT_FAILURE);
+			}
+		}
 		else if (arg == ARG_FONTINFO || arg == ARG_FONTINFO_SHORT)
 		{
 			m_showFontInfo = true;
@@ -351,6 +397,17 @@ int ScribusQApp::init()
 	processEvents(QEventLoop::ExcludeUserInputEvents|QEventLoop::ExcludeSocketNotifiers, 1000);
 	ScCore->init(useGUI, m_filesToLoad);
 	processEvents();
+	if (m_runExportService)
+		return startExportService();
+#ifdef WITH_TESTS
+	if (m_runBenchmarks)
+	{
+		int retVal = ScCore->startHeadless(m_showFontInfo, m_showProfileInfo, m_lang);
+		if (retVal == EXIT_FAILURE)
+			return EXIT_FAILURE;
+		return (RunBenchmarks::runBenchmarks(m_benchmarkOutput, m_benchmarkFilter) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+#endif
 	/* TODO:
 	 * When Scribus is truly able to run without GUI
 	 * we should uncomment if (useGUI)
@@ -366,6 +423,28 @@ int ScribusQApp::init()
 	return retVal;
 }
 
+int ScribusQApp::startExportService()
+{
+	int retVal = ScCore->startHeadless(m_showFontInfo, m_showProfileInfo, m_lang);
+	if (retVal == EXIT_FAILURE)
+		return EXIT_FAILURE;
+
+	// Workers are export services reading their jobs from the standard input
+	QStringList workerArguments;
+	if (!m_lang.isEmpty())
+		workerArguments << ARG_LANG << m_lang;
+	if (!m_prefsUserDir.isEmpty())
+		workerArguments << ARG_PREFS << m_prefsUserDir;
+	workerArguments << ARG_EXPORTSERVICE << "-";
+
+	m_exportService = new ExportService(this);
+	m_exportService->setWorkerArguments(workerArguments);
+	connect(m_exportService, &ExportService::finished, this, &QCoreApplication::quit, Qt::QueuedConnection);
+	if (!m_exportService->start(m_exportServiceName, m_exportWorkers))
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
+
 QStringList ScribusQApp::getLang(QString lang)
 {
 	QStringList langs;
@@ -600,6 +679,8 @@ void ScribusQApp::showUsage()
 	printArgLine(ts, ARG_VERSION_SHORT, ARG_VERSION, tr("Output version information and exit") );
 	printArgLine(ts, ARG_PYTHONSCRIPT_SHORT, qPrintable(QString("%1 <%2> [%3] ").arg(ARG_PYTHONSCRIPT, tr("script"), tr("arguments ..."))), tr("Run script in Python [with optional arguments]. This option must be last option used") );
 	printArgLine(ts, ARG_NOGUI_SHORT, ARG_NOGUI, tr("Do not start GUI") );
+	printArgLine(ts, ARG_EXPORTSERVICE_SHORT, qPrintable(QString("%1 <%2>").arg(ARG_EXPORTSERVICE, tr("socket"))), tr("Run as a PDF export service reading jobs from a local socket, or from standard input if socket is -") );
+	printArgLine(ts, ARG_EXPORTWORKERS_SHORT, qPrintable(QString("%1 <%2>").arg(ARG_EXPORTWORKERS, tr("count"))), tr("Number of worker processes running export service jobs concurrently") );
 	ts << (QString("     %1").arg(CMD_OPTIONS_END,-39)) << tr("Explicit end of command line options"); Qt::endl(ts);
 	
 #if defined(_WIN32) && !defined(_CONSOLE)
@@ -608,6 +689,7 @@ void ScribusQApp::showUsage()
 
 #if WITH_TESTS
 	printArgLine(ts, ARG_TESTS_SHORT, ARG_TESTS, tr("Run unit tests and exit") );
+	printArgLine(ts, ARG_BENCHMARKS_SHORT, qPrintable(QString("%1 <%2> [%3]").arg(ARG_BENCHMARKS, tr("file"), tr("filter"))), tr("Run benchmarks, write results as JSON to file or to standard output if file is -, and exit") );
 #endif
 
 /* Delete me?
@@ -28,6 +28,7 @@ for which a new license (GPL+exception) is in place.
 
 #include "scribusapi.h"
 
+class ExportService;
 class ScribusCore;
 class ScribusMainWindow;
 class ScDLManager;
@@ -81,6 +82,7 @@ class SCRIBUS_API ScribusQApp : public QApplication
 		ScDLManager* dlManager() { return m_scDLMgr; }
 		QString pythonScript; // script to be run in python from CLI
 		QStringList pythonScriptArgs; // command line arguments and flags for script from CLI
+		bool runsExportService() const { return m_runExportService; }
 
 	private:
 		void showHeader();
@@ -98,6 +100,10 @@ class SCRIBUS_API ScribusQApp : public QApplication
 		\brief Instantiates the Language Manager and prints installed languages with brief instructions around
 		*/
 		void showAvailLangs();
+		/*!
+		\brief Initializes the core without GUI and starts accepting export jobs
+		*/
+		int startExportService();
 
 		ScribusCore* m_ScCore {nullptr};
 		QString m_lang;
@@ -111,6 +117,13 @@ class SCRIBUS_API ScribusQApp : public QApplication
 		QList<QString> m_filesToLoad;
 		QString m_fileName;
 		ScDLManager *m_scDLMgr {nullptr};
+		bool m_runExportService {false};
+		QString m_exportServiceName;
+		int m_exportWorkers {1};
+		ExportService* m_exportService {nullptr};
+		bool m_runBenchmarks {false};
+		QString m_benchmarkOutput;
+		QString m_benchmarkFilter;
 
 	protected:
 		virtual bool event(QEvent *event);
@@ -38,6 +38,7 @@ for which a new license (GPL+exception) is in place.
 #include "iconmanager.h"
 #include "langmgr.h"
 #include "localemgr.h"
+#include "pdfimagestreamcache.h"
 #include "pluginmanager.h"
 #include "prefsmanager.h"
 #include "scimagecachemanager.h"
@@ -147,6 +148,27 @@ int ScribusCore::startGUI(bool showSplash, bool showFontInfo, bool showProfileIn
 	return EXIT_SUCCESS;
 }
 
+int ScribusCore::startHeadless(bool showFontInfo, bool showProfileInfo, const QString& newGuiLanguage)
+{
+	// Fonts, color profiles and plugins are set up as for the GUI, but the main
+	// window is never shown: it only hosts what documents and plugins expect from it
+	auto* scribus = new ScribusMainWindow();
+	Q_CHECK_PTR(scribus);
+	if (!scribus)
+		return EXIT_FAILURE;
+	m_ScMWList.append(scribus);
+	int retVal = initScribusCore(false, showFontInfo, showProfileInfo, newGuiLanguage);
+	if (retVal == EXIT_FAILURE)
+		return EXIT_FAILURE;
+
+	retVal = scribus->initScMW(true);
+	if (retVal == EXIT_FAILURE)
+		return EXIT_FAILURE;
+
+	m_scribusInitialized = true;
+	return EXIT_SUCCESS;
+}
+
 int ScribusCore::initScribusCore(bool showSplash, bool showFontInfo, bool showProfileInfo, const QString& newGuiLanguage)
 {
 	CommonStrings::languageChange();
@@ -248,6 +270,11 @@ int ScribusCore::initScribusCore(bool showSplash, bool showFontInfo, bool showPr
 	icm.setMaxCacheEntries(m_prefsManager.appPrefs.imageCachePrefs.maxCacheEntries);
 	icm.setCompressionLevel(m_prefsManager.appPrefs.imageCachePrefs.compressionLevel);
 	icm.initialize();
+	PdfImageStreamCache & pdfCache = PdfImageStreamCache::instance();
+	pdfCache.setEnabled(m_prefsManager.appPrefs.imageCachePrefs.cacheEnabled);
+	pdfCache.setMaxCacheSizeMiB(m_prefsManager.appPrefs.imageCachePrefs.maxCacheSizeMiB);
+	pdfCache.initialize();
+	ScFace::setGlyphCacheLimitMiB(m_prefsManager.appPrefs.fontPrefs.glyphCacheSizeMiB);
 	return 0;
 }
 
@@ -79,6 +79,10 @@ public:
 	bool usingGUI() const;
 	int startGUI(bool showSplash, bool showFontInfo, bool showProfileInfo, const QString& newGuiLanguage);
 	/**
+	* @brief Initializes the core without showing any window, for the export service
+	*/
+	int startHeadless(bool showFontInfo, bool showProfileInfo, const QString& newGuiLanguage);
+	/**
 	* @brief Are we trying to adhere to Apple Mac HIG ?
 	* @retval bool true if we are on Qt/Mac
 	*/
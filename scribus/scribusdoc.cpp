@@ -25,6 +25,7 @@ for which a new license (GPL+exception) is in place.
 #include <memory>
 #include <utility>
 #include <sstream>
+#include <vector>
 
 #include <QByteArray>
 #include <QDebug>
@@ -42,6 +43,7 @@ for which a new license (GPL+exception) is in place.
 #include <QScopedValueRollback>
 #include <QStringList>
 #include <QtAlgorithms>
+#include <QThreadPool>
 #include <QTime>
 #include <QTransform>
 //#include <qtconcurrentmap.h>
@@ -54,6 +56,7 @@ for which a new license (GPL+exception) is in place.
 #include "desaxe/digester.h"
 #include "fileloader.h"
 #include "filewatcher.h"
+#include "imageloadjob.h"
 #include "fpoint.h"
 #include "hyphenator.h"
 #include "notesstyles.h"
@@ -165,6 +168,7 @@ public:
 	
 	void changed(PageItem* it, bool doLayout) override
 	{
+		doc->itemBoundsChanged(it);
 		it->invalidateLayout();
 		if (doLayout)
 			it->layout();
@@ -272,6 +276,9 @@ void ScribusDoc::init()
 
 	m_uuid = QUuid::createUuid();
 
+	// Autosaves are started by the timer, their completion must be handled even while closing
+	connect(&m_autoSaveWriter, SIGNAL(finished(bool,QString)), this, SLOT(slotAutoSaveFinished(bool,QString)));
+
 	m_docPrefsData.colorPrefs.DCMSset.CMSinUse = false;
 
 	colorEngine = ScCore->defaultEngine;
@@ -288,6 +295,8 @@ void ScribusDoc::init()
 	m_docUpdater = new DocUpdater(this);
 	m_itemsChanged.connectObserver(m_docUpdater);
 	m_pagesChanged.connectObserver(m_docUpdater);
+	m_itemsChanged.connectObserver(&m_pageThumbnailCache);
+	m_regionsChanged.connectObserver(&m_pageThumbnailCache);
 
 	PrefsManager& prefsManager = PrefsManager::instance();
 	m_docPrefsData.colorPrefs.DCMSset = prefsManager.appPrefs.colorPrefs.DCMSset;
@@ -467,6 +476,8 @@ void ScribusDoc::init()
 ScribusDoc::~ScribusDoc()
 {
 	m_guardedObject.nullify();
+	m_itemsChanged.disconnectObserver(&m_pageThumbnailCache);
+	m_regionsChanged.disconnectObserver(&m_pageThumbnailCache);
 	CloseCMSProfiles();
 	ScCore->fileWatcher->stop();
 	ScCore->fileWatcher->removeFile(m_documentFileName);
@@ -604,6 +615,13 @@ ScribusDoc::~ScribusDoc()
 	delete m_serializer;
 	delete m_tserializer;
 	delete m_docUpdater;
+	// Make sure a running autosave is done and its file known before cleaning up.
+	// slotAutoSaveFinished() must not run here, it uses the main window and restarts the timer.
+	bool autoSaveRunning = m_autoSaveWriter.isRunning();
+	m_autoSaveWriter.blockSignals(true);
+	m_autoSaveWriter.waitForFinished();
+	if (autoSaveRunning && m_autoSaveWriter.lastSucceeded())
+		autoSaveFiles.append(m_autoSaveWriter.lastFileName());
 	if (!m_docPrefsData.docSetupPrefs.AutoSaveKeep)
 	{
 		if (autoSaveFiles.count() != 0)
@@ -763,6 +781,12 @@ void ScribusDoc::createHyphenator()
 void ScribusDoc::setLoading(bool docLoading)
 {
 	m_loading = docLoading;
+	// Text layout and image loads deferred while loading can go on now
+	if (!docLoading)
+	{
+		m_textLayoutScheduler.resume();
+		m_imageLoadScheduler.resume();
+	}
 }
 
 
@@ -822,6 +846,50 @@ void ScribusDoc::SetDefaultCMSParams()
 	stdProofLabGC         = ScCore->defaultLabToRGBTrans;
 }
 
+QMultiMap<QString, QString> ScribusDoc::replaceMissingCMSProfiles()
+{
+	QMultiMap<QString, QString> missingMap;
+	auto replace = [&missingMap](QString& profile, const ScProfileInfoMap& profiles, const QString& replacement)
+	{
+		if (profiles.contains(profile))
+			return;
+		if (!missingMap.contains(profile, replacement))
+			missingMap.insert(profile, replacement);
+		profile = replacement;
+	};
+
+	CMSData& settings = cmsSettings();
+	const CMSData& defaultSettings = PrefsManager::instance().appPrefs.colorPrefs.DCMSset;
+	replace(settings.DefaultImageRGBProfile, ScCore->InputProfiles, defaultSettings.DefaultImageRGBProfile);
+	replace(settings.DefaultImageCMYKProfile, ScCore->InputProfilesCMYK, defaultSettings.DefaultImageCMYKProfile);
+	replace(settings.DefaultSolidColorRGBProfile, ScCore->InputProfiles, defaultSettings.DefaultSolidColorRGBProfile);
+	replace(settings.DefaultSolidColorCMYKProfile, ScCore->InputProfilesCMYK, defaultSettings.DefaultSolidColorCMYKProfile);
+	replace(settings.DefaultMonitorProfile, ScCore->MonitorProfiles, defaultSettings.DefaultMonitorProfile);
+	replace(settings.DefaultPrinterProfile, ScCore->PrinterProfiles, defaultSettings.DefaultPrinterProfile);
+	// PDF output profiles fall back to the profiles of the document
+	replace(pdfOptions().PrintProf, ScCore->PrinterProfiles, settings.DefaultPrinterProfile);
+	replace(pdfOptions().ImageProf, ScCore->InputProfiles, settings.DefaultImageRGBProfile);
+	replace(pdfOptions().SolidProf, ScCore->InputProfiles, settings.DefaultSolidColorRGBProfile);
+	return missingMap;
+}
+
+bool ScribusDoc::openLoadedCMSProfiles()
+{
+	IntentColors = cmsSettings().DefaultIntentColors;
+	IntentImages = cmsSettings().DefaultIntentImages;
+	if (OpenCMSProfiles(ScCore->InputProfiles, ScCore->InputProfilesCMYK, ScCore->MonitorProfiles, ScCore->PrinterProfiles))
+	{
+		HasCMS = true;
+		pdfOptions().SComp = cmsSettings().ComponentsInput2;
+	}
+	else
+	{
+		SetDefaultCMSParams();
+		HasCMS = false;
+	}
+	return HasCMS;
+}
+
 bool ScribusDoc::OpenCMSProfiles(ScProfileInfoMap InPo, ScProfileInfoMap InPoCMYK, ScProfileInfoMap  /*MoPo*/, ScProfileInfoMap PrPo)
 {
 	HasCMS = false;
@@ -5682,22 +5750,34 @@ void ScribusDoc::setUsesAutomaticTextFrames(bool atf)
 
 bool ScribusDoc::loadPict(const QString& fn, PageItem *pageItem, bool reload, bool showMsg)
 {
-	if (!reload)
+	prepareLoadPict(pageItem, reload);
+	bool loaded = pageItem->loadImage(fn, reload, -1, showMsg);
+	return finishLoadPict(pageItem, reload, loaded);
+}
+
+void ScribusDoc::prepareLoadPict(PageItem *pageItem, bool reload)
+{
+	// The image is loaded now, settings kept for a deferred load are obsolete
+	m_imageLoadScheduler.removePending(pageItem);
+	if (reload)
+		return;
+	if (pageItem->imageIsAvailable)
 	{
-		if (pageItem->imageIsAvailable)
+		if (ScCore->fileWatcher->isWatching(pageItem->Pfile))
+			ScCore->fileWatcher->removeFile(pageItem->Pfile);
+		if (pageItem->isTempFile)
 		{
-			if (ScCore->fileWatcher->isWatching(pageItem->Pfile))
-				ScCore->fileWatcher->removeFile(pageItem->Pfile);
-			if (pageItem->isTempFile)
-			{
-				QFile::remove(pageItem->Pfile);
-				pageItem->Pfile.clear();
-			}
-			pageItem->isInlineImage = false;
-			pageItem->isTempFile = false;
+			QFile::remove(pageItem->Pfile);
+			pageItem->Pfile.clear();
 		}
+		pageItem->isInlineImage = false;
+		pageItem->isTempFile = false;
 	}
-	if (!pageItem->loadImage(fn, reload, -1, showMsg))
+}
+
+bool ScribusDoc::finishLoadPict(PageItem *pageItem, bool reload, bool loaded)
+{
+	if (!loaded)
 	{
 		if (!reload)
 		{
@@ -5725,6 +5805,52 @@ bool ScribusDoc::loadPict(const QString& fn, PageItem *pageItem, bool reload, bo
 	return true;
 }
 
+int ScribusDoc::loadPicts(const QList<PageItem*>& items, bool reload, const std::function<void(int)>& itemLoaded)
+{
+	QThreadPool* threadPool = QThreadPool::globalInstance();
+	// Decoded images wait in their job until committed, bound their number
+	const int maxJobsInFlight = qMax(2, 2 * threadPool->maxThreadCount());
+	const int itemCount = items.count();
+
+	std::vector< std::unique_ptr<ImageLoadJob> > jobs(itemCount);
+	int nextJob = 0;
+	int loadedCount = 0;
+	for (int i = 0; i < itemCount; ++i)
+	{
+		for ( ; (nextJob < itemCount) && (nextJob < i + maxJobsInFlight); ++nextJob)
+		{
+			PageItem* item = items.at(nextJob);
+			if (item->itemType() != PageItem::ImageFrame)
+				continue;
+			prepareLoadPict(item, reload);
+			jobs[nextJob] = item->createImageLoadJob(item->Pfile, reload);
+			if (!jobs[nextJob])
+				continue;
+			ImageLoadJob* job = jobs[nextJob].get();
+			threadPool->start([job]() {
+				PageItem::runImageLoadJob(*job);
+				job->setFinished();
+			});
+		}
+
+		PageItem* item = items.at(i);
+		bool loaded = false;
+		if (jobs[i])
+		{
+			jobs[i]->waitForFinished();
+			loaded = finishLoadPict(item, reload, item->finishImageLoadJob(*jobs[i]));
+			jobs[i].reset();
+		}
+		else
+			loaded = loadPict(item->Pfile, item, reload);
+		if (loaded)
+			++loadedCount;
+		if (itemLoaded)
+			itemLoaded(i);
+	}
+	return loadedCount;
+}
+
 
 void ScribusDoc::canvasMinMax(FPoint& minPoint, FPoint& maxPoint) const
 {
@@ -5821,6 +5947,43 @@ QRectF ScribusDoc::canvasOptimalRect() const
 	return canvasRect;
 }
 
+QList<PageItem*> ScribusDoc::itemsInRect(const QList<PageItem*>* itemList, const QRectF& rect)
+{
+	if (itemList == &DocItems)
+		return m_docItemsIndex.itemsIntersecting(rect);
+	if (itemList == &MasterItems)
+		return m_masterItemsIndex.itemsIntersecting(rect);
+	return *itemList;
+}
+
+void ScribusDoc::itemBoundsChanged(PageItem* item)
+{
+	// Only top level items are indexed, changes of a group child may change the bounds of its group
+	PageItem* topItem = item;
+	while (topItem->Parent)
+		topItem = topItem->Parent;
+	if (topItem->OnMasterPage.isEmpty())
+		m_docItemsIndex.itemChanged(topItem);
+	else
+		m_masterItemsIndex.itemChanged(topItem);
+}
+
+void ScribusDoc::itemDestroyed(const PageItem* item)
+{
+	m_docItemsIndex.itemDestroyed(item);
+	m_masterItemsIndex.itemDestroyed(item);
+	m_pageThumbnailCache.itemDestroyed(item);
+	// Notifications held back by a batch edit must not reach observers after the item is gone
+	m_updateManager.removePending(item);
+}
+
+
+void ScribusDoc::pageDestroyed(const ScPage* page)
+{
+	m_pageThumbnailCache.pageDestroyed(page);
+	m_updateManager.removePending(page);
+}
+
 
 int ScribusDoc::OnPage(double x2, double  y2) const
 {
@@ -6277,6 +6440,60 @@ void ScribusDoc::refreshGuides()
 	}
 }
 
+void ScribusDoc::addMissingMasterPageAndSection()
+{
+	if (MasterPages.isEmpty())
+	{
+		ScPage *docPage = Pages->at(0);
+		ScPage *addedPage = addMasterPage(0, CommonStrings::masterPageNormal);
+		addedPage->setSize(docPage->size());
+		addedPage->setInitialHeight(docPage->height());
+		addedPage->setInitialWidth(docPage->width());
+		addedPage->setHeight(docPage->height());
+		addedPage->setWidth(docPage->width());
+		addedPage->initialMargins = docPage->initialMargins;
+		addedPage->LeftPg = docPage->LeftPg;
+		addedPage->setOrientation(docPage->orientation());
+	}
+	if (sections().count() == 0)
+	{
+		addSection(-1);
+		setFirstSectionFromFirstPageNumber();
+	}
+}
+
+void ScribusDoc::layoutLoadedItems()
+{
+	RePos = true;
+	setMasterPageMode(true);
+	reformPages();
+	refreshGuides();
+	setLoading(false);
+	for (PageItem* ite : std::as_const(MasterItems))
+		ite->layout();
+	setMasterPageMode(false);
+	flag_Renumber = false;
+	updateNumbers(true);
+	for (PageItem* ite : std::as_const(*Items))
+	{
+		if ((ite->nextInChain() == nullptr) && !ite->isNoteFrame())  //do not layout notes frames
+			ite->layout();
+	}
+	if (!marksList().isEmpty())
+	{
+		setLoading(true);
+		updateMarks(true);
+		updateChangedEndNotesFrames();
+		setLoading(false);
+	}
+	for (PageItem* ite : std::as_const(FrameItems))
+	{
+		if (ite->nextInChain() == nullptr)
+			ite->layout();
+	}
+	RePos = false;
+}
+
 double ScribusDoc::getXOffsetForPage(int pageNumber) const
 {
 	if (Pages->at(pageNumber) != nullptr)
@@ -7350,57 +7567,22 @@ void ScribusDoc::RecalcPictures(ScProfileInfoMap *Pr, ScProfileInfoMap *PrCMYK,
 	RecalcPictures(&DocItems, Pr, PrCMYK, dia);
 	QList<PageItem*> itemList = FrameItems.values();
 	RecalcPictures(&itemList, Pr, PrCMYK, dia);
-	QList<PageItem*> allItems;
-	if (FrameItems.isEmpty())
-		return;
-	bool usingGUI = ScCore->usingGUI();
-	int counter = 0;
-	if (usingGUI && dia != nullptr)
-		counter = dia->value();
-	for (auto itf = FrameItems.begin(); itf != FrameItems.end(); ++itf)
-	{
-		PageItem *it = itf.value();
-		if (it->isGroup())
-			allItems = it->getAllChildren();
-		else
-			allItems.append(it);
-		for (int i = 0; i < allItems.count(); i++)
-		{
-			it = allItems.at(i);
-			if ((it->itemType() == PageItem::ImageFrame) && (it->imageIsAvailable))
-			{
-				if (it->pixm.imgInfo.colorspace == ColorSpaceCMYK)
-				{
-					if (!PrCMYK->contains(it->ImageProfile))
-						it->ImageProfile = m_docPrefsData.colorPrefs.DCMSset.DefaultImageCMYKProfile;
-				}
-				else
-				{
-					if (!Pr->contains(it->ImageProfile))
-						it->ImageProfile = m_docPrefsData.colorPrefs.DCMSset.DefaultImageRGBProfile;
-				}
-				loadPict(it->Pfile, it, true);
-			}
-		}
-		allItems.clear();
-		if (usingGUI)
-		{
-			++counter;
-			if (dia != nullptr)
-				dia->setValue(counter);
-		}
-	}
 }
 
 void ScribusDoc::RecalcPictures(const QList<PageItem*>* items, ScProfileInfoMap *Pr, ScProfileInfoMap *PrCMYK, QProgressBar *dia)
 {
 	if (items->isEmpty())
 		return;
-	QList<PageItem*> allItems;
 	bool usingGUI = ScCore->usingGUI();
 	int counter = 0;
 	if (usingGUI && dia != nullptr)
 		counter = dia->value();
+
+	// Collect image frames, remembering for each the top level item it belongs to,
+	// as progress is counted in top level items
+	QList<PageItem*> imageItems;
+	QList<int> topLevelIndexes;
+	QList<PageItem*> allItems;
 	PageItem* it;
 	int docItemCount = items->count();
 	for (int i = 0; i < docItemCount; ++i)
@@ -7425,17 +7607,20 @@ void ScribusDoc::RecalcPictures(const QList<PageItem*>* items, ScProfileInfoMap
 					if (!Pr->contains(it->ImageProfile))
 						it->ImageProfile = m_docPrefsData.colorPrefs.DCMSset.DefaultImageRGBProfile;
 				}
-				loadPict(it->Pfile, it, true);
+				imageItems.append(it);
+				topLevelIndexes.append(i);
 			}
 		}
 		allItems.clear();
-		if (usingGUI)
-		{
-			++counter;
-			if (dia != nullptr)
-				dia->setValue(counter);
-		}
 	}
+
+	loadPicts(imageItems, true, [&](int index) {
+		if (usingGUI && (dia != nullptr))
+			dia->setValue(counter + topLevelIndexes.at(index) + 1);
+	});
+
+	if (usingGUI && (dia != nullptr))
+		dia->setValue(counter + docItemCount);
 }
 
 
@@ -13590,6 +13775,9 @@ void ScribusDoc::itemSelection_SwapRight()
 void ScribusDoc::changed()
 {
 	setModified(true);
+	// Items may have been added, deleted or restacked
+	m_docItemsIndex.listChanged();
+	m_masterItemsIndex.listChanged();
 	// Do not emit docChanged signal() unnecessarily
 	// Processing of that signal is slowwwwwww and
 	// DocUpdater will trigger it when necessary
@@ -17115,7 +17303,7 @@ void ScribusDoc::restartAutoSaveTimer()
 
 void ScribusDoc::slotAutoSave()
 {
-	if (!isModified())
+	if (!isModified() || m_autoSaveWriter.isRunning())
 		return;
 	autoSaveTimer->stop();
 	QString base = tr("Document");
@@ -17130,11 +17318,24 @@ void ScribusDoc::slotAutoSave()
 	QDateTime dat = QDateTime::currentDateTime();
 	if ((!m_docPrefsData.docSetupPrefs.AutoSaveLocation) && (!m_docPrefsData.docSetupPrefs.AutoSaveDir.isEmpty()))
 		path = m_docPrefsData.docSetupPrefs.AutoSaveDir;
-	fileName = QDir::cleanPath(path + "/" + base + QString("_autosave_%1.sla").arg(dat.toString("dd_MM_yyyy_hh_mm")));
-	FileLoader fl(fileName);
-	if (fl.saveFile(fileName, this, nullptr))
+	fileName = QDir::cleanPath(path + "/" + base + QString("_autosave_%1.sla.gz").arg(dat.toString("dd_MM_yyyy_hh_mm")));
+	// The document is only serialised here, compressing and writing happen in the background
+	scMW()->statusBar()->showMessage( tr("Autosaving %1...").arg(base));
+	if (!m_autoSaveWriter.start(this, fileName))
+	{
+		scMW()->statusBar()->clearMessage();
+		if (m_docPrefsData.docSetupPrefs.AutoSave)
+			autoSaveTimer->start(m_docPrefsData.docSetupPrefs.AutoSaveTime);
+	}
+}
+
+void ScribusDoc::slotAutoSaveFinished(bool success, const QString& fileName)
+{
+	QString base = hasName ? QFileInfo(m_documentFileName).baseName() : tr("Document");
+	if (success)
 	{
-		scMW()->statusBar()->showMessage( tr("File %1 autosaved").arg(base), 5000);
+		const AutoSaveWriter::Statistics& stats = m_autoSaveWriter.lastStatistics();
+		scMW()->statusBar()->showMessage( tr("File %1 autosaved (%2 ms blocking, %3 ms in background)").arg(base).arg(stats.snapshotTime).arg(stats.writeTime), 5000);
 		if (autoSaveFiles.count() >= m_docPrefsData.docSetupPrefs.AutoSaveCount)
 		{
 			QFile f(autoSaveFiles.first());
@@ -17143,6 +17344,8 @@ void ScribusDoc::slotAutoSave()
 		}
 		autoSaveFiles.append(fileName);
 	}
+	else
+		scMW()->statusBar()->clearMessage();
 	if (m_docPrefsData.docSetupPrefs.AutoSave)
 		autoSaveTimer->start(m_docPrefsData.docSetupPrefs.AutoSaveTime);
 }
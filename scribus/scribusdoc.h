@@ -26,6 +26,7 @@ for which a new license (GPL+exception) is in place.
 #ifdef HAVE_CONFIG_H
 #include "scconfig.h"
 #endif
+#include <functional>
 // include files for QT
 #include <QColor>
 #include <QFile>
@@ -56,7 +57,11 @@ for which a new license (GPL+exception) is in place.
 #include "pageitem_group.h"
 #include "pageitem_latexframe.h"
 #include "pageitem_textframe.h"
+#include "autosavewriter.h"
+#include "imageloadscheduler.h"
+#include "pageitemspatialindex.h"
 #include "pagestructs.h"
+#include "pagethumbnailcache.h"
 #include "prefsstructs.h"
 #include "scguardedptr.h"
 #include "scpage.h"
@@ -64,6 +69,7 @@ for which a new license (GPL+exception) is in place.
 #include "styles/styleset.h"
 #include "styles/tablestyle.h"
 #include "styles/cellstyle.h"
+#include "textlayoutscheduler.h"
 #include "undoobject.h"
 #include "undostate.h"
 #include "undotransaction.h"
@@ -558,6 +564,16 @@ public:
 	bool OpenCMSProfiles(ScProfileInfoMap InPo, ScProfileInfoMap InPoCMYK, ScProfileInfoMap MoPo, ScProfileInfoMap PrPo);
 	void CloseCMSProfiles();
 	void SetDefaultCMSParams();
+	/**
+	 * @brief Replaces the color profiles of a loaded document which are not installed by the default ones
+	 * @return Missing profiles mapped to their replacements
+	 */
+	QMultiMap<QString, QString> replaceMissingCMSProfiles();
+	/**
+	 * @brief Opens the color profiles of a loaded document, color management is off if they cannot be opened
+	 * @return true if color management is active
+	 */
+	bool openLoadedCMSProfiles();
 	/**
 	 * @brief Switch Colormanagement on or of
 	 * @param enable bool, if true Colormanagement is switched on, else off
@@ -916,6 +932,17 @@ public:
 	 * @return 
 	 */
 	bool loadPict(const QString& fn, PageItem *pageItem, bool reload = false, bool showMsg = false);
+	/**
+	 * \brief Load the images of several items concurrently
+	 * Decoding, color management, image effects and low resolution proxies of image frames
+	 * are processed by a thread pool, results are committed to the items in list order on the
+	 * calling (GUI) thread. Other kinds of items are loaded one after the other through loadPict().
+	 * @param items items whose image file (Pfile) is to be loaded
+	 * @param reload same as for loadPict()
+	 * @param itemLoaded optional callback, called with the index of each item once committed
+	 * @return number of images successfully loaded
+	 */
+	int loadPicts(const QList<PageItem*>& items, bool reload, const std::function<void(int)>& itemLoaded = nullptr);
 	/**
 	 * \brief Handle image with color profiles
 	 * @param Pr profile
@@ -941,6 +968,37 @@ public:
 	 * @brief Find the optimal area for canvas
 	 */
 	QRectF canvasOptimalRect() const;
+
+	/**
+	 * @brief Find the items of an item list whose bounding rect intersects an area of the canvas
+	 * @param itemList the item list to search, usually Items
+	 * @param rect the area in canvas coordinates
+	 * @return the found items in stacking order. DocItems and MasterItems are searched through
+	 * a spatial index, for any other list a copy of the whole list is returned.
+	 */
+	QList<PageItem*> itemsInRect(const QList<PageItem*>* itemList, const QRectF& rect);
+	/// Reports to the spatial index that the bounds of \a item may have changed
+	void itemBoundsChanged(PageItem* item);
+	/// Reports to the spatial index, the thumbnail cache and the update manager that \a item is being deleted
+	void itemDestroyed(const PageItem* item);
+	/// Reports to the thumbnail cache and the update manager that \a page is being deleted
+	void pageDestroyed(const ScPage* page);
+	/**
+	 * @brief Scheduler laying out long text chains progressively for drawing
+	 */
+	TextLayoutScheduler* textLayoutScheduler() { return &m_textLayoutScheduler; }
+	/**
+	 * @brief Scheduler loading the images of large documents when they are needed
+	 */
+	ImageLoadScheduler* imageLoadScheduler() { return &m_imageLoadScheduler; }
+	/**
+	 * @brief Thumbnails of the document pages, updated when pages change
+	 */
+	PageThumbnailCache* pageThumbnailCache() { return &m_pageThumbnailCache; }
+	/**
+	 * @brief Timings of the last autosave
+	 */
+	const AutoSaveWriter::Statistics& autoSaveStatistics() const { return m_autoSaveWriter.lastStatistics(); }
 	
 	int  OnPage(double x2, double  y2) const;
 	int  OnPage(PageItem *currItem) const;
@@ -949,6 +1007,13 @@ public:
 	void reformPages(bool moveObjects = true);
 	/** @brief Refresh automatic guides once Margin struct has been properly configure by reformPages() */
 	void refreshGuides();
+	/** @brief Adds a master page and a section to a loaded document which has none */
+	void addMissingMasterPageAndSection();
+	/**
+	 * @brief Lays out master pages and text frames of a loaded document
+	 * Called when the file has been read, while the document is still loading. Ends loading.
+	 */
+	void layoutLoadedItems();
 
 	/** @brief Check and fix if needed PageItem OwnPage member */
 	void fixItemPageOwner();
@@ -1306,6 +1371,8 @@ public:
 
 protected:
 	void addSymbols();
+	void prepareLoadPict(PageItem *pageItem, bool reload);
+	bool finishLoadPict(PageItem *pageItem, bool reload, bool loaded);
 	void applyPrefsPageSizingAndMargins(bool resizePages, bool resizeMasterPages, bool resizePageMargins, bool resizeMasterPageMargins);
 	bool m_hasGUI {false};
 	QFileDevice::Permissions m_docFilePermissions {QFileDevice::ReadOwner|QFileDevice::WriteOwner};
@@ -1507,6 +1574,12 @@ private:
 	MassObservable<ScPage*> m_pagesChanged;
 	MassObservable<QRectF> m_regionsChanged;
 	DocUpdater* m_docUpdater {nullptr};
+	PageItemSpatialIndex m_docItemsIndex {DocItems};
+	PageItemSpatialIndex m_masterItemsIndex {MasterItems};
+	TextLayoutScheduler m_textLayoutScheduler {this};
+	ImageLoadScheduler m_imageLoadScheduler {this};
+	PageThumbnailCache m_pageThumbnailCache {this};
+	AutoSaveWriter m_autoSaveWriter {this};
 	
 signals:
 	//Lets make our doc talk to our GUI rather than confusing all our normal stuff
@@ -1911,6 +1984,7 @@ public slots:
 
 protected slots:
 	void slotAutoSave();
+	void slotAutoSaveFinished(bool success, const QString& fileName);
 
 //auto-numerations
 public:
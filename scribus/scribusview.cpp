@@ -364,7 +364,7 @@ void ScribusView::changed(QRectF re, bool)
 	if (!m_doc->isLoading() && !m_ScMW->scriptIsRunning())
 	{
 // 		qDebug() << "ScribusView-changed(): changed region:" << re;
-		m_canvas->setForcedRedraw(true);
+		m_canvas->setForcedRedraw(re);
 		updateCanvas(re);
 	}
 }
@@ -2418,6 +2418,8 @@ QImage ScribusView::MPageToPixmap(const QString& name, int maxGr, bool drawFrame
 	setScale(1.0);
 	m_canvas->setPreviewMode(true);
 	m_canvas->setForcedRedraw(true);
+	m_doc->textLayoutScheduler()->beginOutput();
+	m_doc->imageLoadScheduler()->beginOutput();
 	QImage pm(clipw, cliph, QImage::Format_ARGB32_Premultiplied);
 	ScPainter *painter = new ScPainter(&pm, pm.width(), pm.height(), 1.0, 0);
 	painter->clear(m_doc->paperColor());
@@ -2448,6 +2450,8 @@ QImage ScribusView::MPageToPixmap(const QString& name, int maxGr, bool drawFrame
 		im = pm.scaled(static_cast<int>(pm.width() / sy), static_cast<int>(pm.height() / sy), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 	delete painter;
 	painter = nullptr;
+	m_doc->imageLoadScheduler()->endOutput();
+	m_doc->textLayoutScheduler()->endOutput();
 	m_canvas->setPreviewMode(false);
 	m_canvas->setForcedRedraw(false);
 	m_doc->guidesPrefs().framesShown = frs;
@@ -2512,6 +2516,8 @@ QMap<int, QImage> ScribusView::PagesToPixmap(int maxGr, int Nr, PageToPixmapFlag
 	m_canvas->setForcedRedraw(true);
 	m_doc->setMasterPageMode(false);
 	m_doc->setLoading(true);
+	m_doc->textLayoutScheduler()->beginOutput();
+	m_doc->imageLoadScheduler()->beginOutput();
 
 //	QElapsedTimer timer;
 //	timer.start();
@@ -2550,6 +2556,8 @@ QMap<int, QImage> ScribusView::PagesToPixmap(int maxGr, int Nr, PageToPixmapFlag
 	m_canvas->setScale(oldScale);
 	m_doc->setMasterPageMode(mMode);
 	m_doc->setCurrentPage(act);
+	m_doc->imageLoadScheduler()->endOutput();
+	m_doc->textLayoutScheduler()->endOutput();
 	m_doc->setLoading(false);
 	m_canvas->setPreviewMode(m_doc->drawAsPreview);
 	m_canvas->setForcedRedraw(false);
@@ -3546,6 +3554,7 @@ void ScribusView::zoom(int canvasX, int canvasY, double scale, bool preservePoin
 	undoManager->setUndoEnabled(false);
 	updatesOn(false);
 	setScale(newScale);
+	m_canvas->startReducedDetail();
 
 	FPoint minPos = m_doc->minCanvasCoordinate;
 	FPoint maxPos = m_doc->maxCanvasCoordinate;
@@ -0,0 +1,58 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#include <cstddef>
+
+#include "allocationcounter.h"
+
+// Allocation functions of the C library (glibc) wrapped below
+extern "C"
+{
+	void* __libc_malloc(std::size_t size);
+	void* __libc_calloc(std::size_t count, std::size_t size);
+	void* __libc_realloc(void* p, std::size_t size);
+	void __libc_free(void* p);
+}
+
+extern "C" __attribute__((visibility("default"))) AllocationCounters scribusAllocationCounters;
+AllocationCounters scribusAllocationCounters;
+
+namespace
+{
+	inline void countAllocation(std::size_t size)
+	{
+		if (!scribusAllocationCounters.enabled.load(std::memory_order_relaxed))
+			return;
+		scribusAllocationCounters.count.fetch_add(1, std::memory_order_relaxed);
+		scribusAllocationCounters.bytes.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+	}
+}
+
+extern "C"
+{
+	__attribute__((visibility("default"))) void* malloc(std::size_t size)
+	{
+		countAllocation(size);
+		return __libc_malloc(size);
+	}
+
+	__attribute__((visibility("default"))) void* calloc(std::size_t count, std::size_t size)
+	{
+		countAllocation(count * size);
+		return __libc_calloc(count, size);
+	}
+
+	__attribute__((visibility("default"))) void* realloc(void* p, std::size_t size)
+	{
+		countAllocation(size);
+		return __libc_realloc(p, size);
+	}
+
+	__attribute__((visibility("default"))) void free(void* p)
+	{
+		__libc_free(p);
+	}
+}
@@ -0,0 +1,32 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <atomic>
+
+/**
+ * Counters of the allocation counter library, a library preloaded into Scribus when
+ * benchmarks are run, e.g.
+ *   LD_PRELOAD=libscribus_allocationcounter.so scribus --benchmarks results.json
+ *
+ * The library wraps malloc(), calloc() and realloc() of the C library, which also serve
+ * operator new and Qt containers. Allocations are only counted while counting is enabled,
+ * benchmarks enable it around the code they measure. The application never links the
+ * library, benchmarks look up the counters by name and report no allocations without it.
+ */
+struct AllocationCounters
+{
+	std::atomic<bool> enabled { false };
+	std::atomic<long long> count { 0 };
+	std::atomic<long long> bytes { 0 };
+};
+
+/// Name of the AllocationCounters instance exported by the library
+#define ALLOCATIONCOUNTERS_SYMBOL "scribusAllocationCounters"
+
+#endif
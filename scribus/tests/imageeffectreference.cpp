@@ -0,0 +1,676 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <QColor>
+#include <QPoint>
+#include <QVector>
+
+#include "imageeffectreference.h"
+
+#include "fpointarray.h"
+#include "sccolor.h"
+#include "sccolorengine.h"
+#include "scimagestructs.h"
+#include "sctextstream.h"
+#include "scribusdoc.h"
+#include "util_color.h"
+
+namespace
+{
+	void invert(QImage& image)
+	{
+		int h = image.height();
+		int w = image.width();
+		QRgb * s;
+		for (int yi = 0; yi < h; ++yi)
+		{
+			s = (QRgb*)(image.scanLine( yi ));
+			for (int xi = 0; xi < w; ++xi)
+			{
+				*s ^= 0x00ffffff;
+				s++;
+			}
+		}
+	}
+
+	void toGrayscale(QImage& image)
+	{
+		int h = image.height();
+		int w = image.width();
+		int k;
+		QRgb * s;
+		QRgb r;
+		for (int yi = 0; yi < h; ++yi)
+		{
+			s = (QRgb*)(image.scanLine( yi ));
+			for (int xi = 0; xi < w; ++xi)
+			{
+				r = *s;
+				k = qMin(qRound(0.3 * qRed(r) + 0.59 * qGreen(r) + 0.11 * qBlue(r)), 255);
+				*s = qRgba(k, k, k, qAlpha(r));
+				s++;
+			}
+		}
+	}
+
+	void applyCurve(QImage& image, const QVector<int>& curveTable)
+	{
+		int h = image.height();
+		int w = image.width();
+		QRgb *s;
+		QRgb r;
+		int c, m, y, k;
+		for (int yi=0; yi < h; ++yi)
+		{
+			s = (QRgb*)(image.scanLine( yi ));
+			for (int xi=0; xi < w; ++xi)
+			{
+				r = *s;
+				c = curveTable[qRed(r)];
+				m = curveTable[qGreen(r)];
+				y = curveTable[qBlue(r)];
+				k = qAlpha(r);
+				*s = qRgba(c, m, y, k);
+				s++;
+			}
+		}
+	}
+
+	void contrast(QImage& image, int contrastValue)
+	{
+		QVector<int> curveTable(256);
+		QPoint p1(0,0 - contrastValue);
+		QPoint p2(256, 256 + contrastValue);
+		double mc = (p1.y() - p2.y()) / (double)(p1.x() - p2.x());
+		for (int i = 0; i < 256; ++i)
+		{
+			curveTable[i] = qMin(255, qMax(0, int(i * mc) + p1.y()));
+		}
+		applyCurve(image, curveTable);
+	}
+
+	void brightness(QImage& image, int brightnessValue)
+	{
+		QVector<int> curveTable(256);
+		QPoint p1(0,0 + brightnessValue);
+		QPoint p2(256, 256 + brightnessValue);
+		double mc = (p1.y() - p2.y()) / (double)(p1.x() - p2.x());
+		for (int i = 0; i < 256; ++i)
+		{
+			curveTable[i] = qMin(255, qMax(0, int(i * mc) + p1.y()));
+		}
+		applyCurve(image, curveTable);
+	}
+
+	void colorize(QImage& image, ScribusDoc* doc, const ScColor& color, int shade)
+	{
+		int h = image.height();
+		int w = image.width();
+		int cc, cm, cy;
+		int hu, sa, v;
+		QColor tmpR;
+		QRgb *s;
+		QRgb r;
+		int cc2, cm2, cy2, k2;
+		RGBColor rgbCol;
+		ScColorEngine::getShadeColorRGB(color, doc, rgbCol, shade);
+		rgbCol.getValues(cc, cm, cy);
+		for (int yi = 0; yi < h; ++yi)
+		{
+			s = (QRgb*)(image.scanLine( yi ));
+			for (int xi = 0; xi < w; ++xi)
+			{
+				r = *s;
+				k2 = 255 - qMin(qRound(0.3 * qRed(r) + 0.59 * qGreen(r) + 0.11 * qBlue(r)), 255);
+				tmpR.setRgb(cc, cm, cy);
+				tmpR.getHsv(&hu, &sa, &v);
+				tmpR.setHsv(hu, sa * k2 / 255, 255 - ((255 - v) * k2 / 255));
+				tmpR.getRgb(&cc2, &cm2, &cy2);
+				*s = qRgba(cc2, cm2, cy2, qAlpha(r));
+				s++;
+			}
+		}
+	}
+
+	void duotone(QImage& image, ScribusDoc* doc, const ScColor& color1, int shade1, FPointArray curve1, bool lin1, const ScColor& color2, int shade2, FPointArray curve2, bool lin2)
+	{
+		int h = image.height();
+		int w = image.width();
+		int c, c1, m, m1, y, y1, k, k1;
+		int cn, c1n, mn, m1n, yn, y1n, kn, k1n;
+		uchar cb;
+		QVector<int> curveTable1;
+		QVector<int> curveTable2;
+		CMYKColor cmykCol;
+		ScColorEngine::getShadeColorCMYK(color1, doc, cmykCol, shade1);
+		cmykCol.getValues(c, m, y, k);
+		ScColorEngine::getShadeColorCMYK(color2, doc, cmykCol, shade2);
+		cmykCol.getValues(c1, m1, y1, k1);
+		curveTable1.resize(256);
+		for (int x = 0 ; x < 256 ; x++)
+		{
+			curveTable1[x] = qMin(255, qMax(0, qRound(getCurveYValue(curve1, x / 255.0, lin1) * 255)));
+		}
+		curveTable2.resize(256);
+		for (int x = 0 ; x < 256 ; x++)
+		{
+			curveTable2[x] = qMin(255, qMax(0, qRound(getCurveYValue(curve2, x / 255.0, lin2) * 255)));
+		}
+		for (int yi=0; yi < h; ++yi)
+		{
+			QRgb * s = (QRgb*)(image.scanLine( yi ));
+			for (int xi=0; xi < w; ++xi)
+			{
+				QRgb r = *s;
+				cb = 255 - qMin(qRound(0.3 * qRed(r) + 0.59 * qGreen(r) + 0.11 * qBlue(r)), 255);
+				cn = qMin((c * curveTable1[(int)cb]) >> 8, 255);
+				mn = qMin((m * curveTable1[(int)cb]) >> 8, 255);
+				yn = qMin((y * curveTable1[(int)cb]) >> 8, 255);
+				kn = qMin((k * curveTable1[(int)cb]) >> 8, 255);
+				c1n = qMin((c1 * curveTable1[(int)cb]) >> 8, 255);
+				m1n = qMin((m1 * curveTable2[(int)cb]) >> 8, 255);
+				y1n = qMin((y1 * curveTable2[(int)cb]) >> 8, 255);
+				k1n = qMin((k1 * curveTable2[(int)cb]) >> 8, 255);
+				ScColor col = ScColor(qMin(cn + c1n, 255), qMin(mn + m1n, 255), qMin(yn + y1n, 255), qMin(kn + k1n, 255));
+				col.getRawRGBColor(&cn, &mn, &yn);
+				kn = qAlpha(r);
+				*s = qRgba(cn, mn, yn, kn);
+				s++;
+			}
+		}
+	}
+
+	// Stack Blur Algorithm by Mario Klingemann <mario@quasimondo.com>
+	void blur(QImage& image, int radius)
+	{
+		if (radius < 1) {
+			return;
+		}
+
+		QRgb *pix = (QRgb*) image.bits();
+		int w   = image.width();
+		int h   = image.height();
+		int wm  = w - 1;
+		int hm  = h - 1;
+		int wh  = w * h;
+		int div = radius + radius + 1;
+
+		int *r = new int[wh];
+		int *g = new int[wh];
+		int *b = new int[wh];
+		int *a = new int[wh];
+		int rsum, gsum, bsum, asum, x, y, i, yp, yi, yw;
+		QRgb p;
+		int *vmin = new int[qMax(w, h)];
+
+		int divsum = (div + 1) >> 1;
+		divsum *= divsum;
+		int *dv = new int[256*divsum];
+		for (i = 0; i < 256 * divsum; ++i) {
+			dv[i] = (i / divsum);
+		}
+
+		yw = yi = 0;
+
+		int **stack = new int*[div];
+		for (int i = 0; i < div; ++i) {
+			stack[i] = new int[4];
+		}
+
+		int stackpointer;
+		int stackstart;
+		int *sir;
+		int rbs;
+		int r1 = radius + 1;
+		int routsum, goutsum, boutsum, aoutsum;
+		int rinsum, ginsum, binsum, ainsum;
+
+		for (y = 0; y < h; ++y)
+		{
+			rinsum = ginsum = binsum = ainsum
+				= routsum = goutsum = boutsum = aoutsum
+				= rsum = gsum = bsum = asum = 0;
+			for (i = -radius; i <= radius; ++i)
+			{
+				p = pix[yi + qMin(wm, qMax(i, 0))];
+				sir = stack[i + radius];
+				sir[0] = qRed(p);
+				sir[1] = qGreen(p);
+				sir[2] = qBlue(p);
+				sir[3] = qAlpha(p);
+
+				rbs = r1 - abs(i);
+				rsum += sir[0] * rbs;
+				gsum += sir[1] * rbs;
+				bsum += sir[2] * rbs;
+				asum += sir[3] * rbs;
+
+				if (i > 0)
+				{
+					rinsum += sir[0];
+					ginsum += sir[1];
+					binsum += sir[2];
+					ainsum += sir[3];
+				}
+				else
+				{
+					routsum += sir[0];
+					goutsum += sir[1];
+					boutsum += sir[2];
+					aoutsum += sir[3];
+				}
+			}
+			stackpointer = radius;
+
+			for (x=0; x < w; ++x)
+			{
+				r[yi] = dv[rsum];
+				g[yi] = dv[gsum];
+				b[yi] = dv[bsum];
+				a[yi] = dv[asum];
+
+				rsum -= routsum;
+				gsum -= goutsum;
+				bsum -= boutsum;
+				asum -= aoutsum;
+
+				stackstart = stackpointer - radius + div;
+				sir = stack[stackstart % div];
+
+				routsum -= sir[0];
+				goutsum -= sir[1];
+				boutsum -= sir[2];
+				aoutsum -= sir[3];
+
+				if (y == 0)
+				{
+					vmin[x] = qMin(x + radius + 1, wm);
+				}
+				p = pix[yw + vmin[x]];
+
+				sir[0] = qRed(p);
+				sir[1] = qGreen(p);
+				sir[2] = qBlue(p);
+				sir[3] = qAlpha(p);
+
+				rinsum += sir[0];
+				ginsum += sir[1];
+				binsum += sir[2];
+				ainsum += sir[3];
+
+				rsum += rinsum;
+				gsum += ginsum;
+				bsum += binsum;
+				asum += ainsum;
+
+				stackpointer = (stackpointer+1)%div;
+				sir = stack[(stackpointer)%div];
+
+				routsum += sir[0];
+				goutsum += sir[1];
+				boutsum += sir[2];
+				aoutsum += sir[3];
+
+				rinsum -= sir[0];
+				ginsum -= sir[1];
+				binsum -= sir[2];
+				ainsum -= sir[3];
+
+				++yi;
+			}
+			yw += w;
+		}
+		for (x=0; x < w; ++x)
+		{
+			rinsum = ginsum = binsum = ainsum
+				= routsum = goutsum = boutsum = aoutsum
+				= rsum = gsum = bsum = asum = 0;
+
+			yp =- radius * w;
+
+			for (i=-radius; i <= radius; ++i)
+			{
+				yi = qMax(0, yp) + x;
+
+				sir = stack[i + radius];
+
+				sir[0] = r[yi];
+				sir[1] = g[yi];
+				sir[2] = b[yi];
+				sir[3] = a[yi];
+
+				rbs = r1 - abs(i);
+
+				rsum += r[yi]*rbs;
+				gsum += g[yi]*rbs;
+				bsum += b[yi]*rbs;
+				asum += a[yi]*rbs;
+
+				if (i > 0)
+				{
+					rinsum += sir[0];
+					ginsum += sir[1];
+					binsum += sir[2];
+					ainsum += sir[3];
+				}
+				else
+				{
+					routsum += sir[0];
+					goutsum += sir[1];
+					boutsum += sir[2];
+					aoutsum += sir[3];
+				}
+
+				if (i < hm)
+				{
+					yp += w;
+				}
+			}
+
+			yi = x;
+			stackpointer = radius;
+
+			for (y=0; y < h; ++y)
+			{
+				pix[yi] = qRgba(dv[rsum], dv[gsum], dv[bsum], dv[asum]);
+
+				rsum -= routsum;
+				gsum -= goutsum;
+				bsum -= boutsum;
+				asum -= aoutsum;
+
+				stackstart = stackpointer-radius+div;
+				sir = stack[stackstart%div];
+
+				routsum -= sir[0];
+				goutsum -= sir[1];
+				boutsum -= sir[2];
+				aoutsum -= sir[3];
+
+				if (x==0)
+				{
+					vmin[y] = qMin(y + r1,hm)*w;
+				}
+				p = x + vmin[y];
+
+				sir[0] = r[p];
+				sir[1] = g[p];
+				sir[2] = b[p];
+				sir[3] = a[p];
+
+				rinsum += sir[0];
+				ginsum += sir[1];
+				binsum += sir[2];
+				ainsum += sir[3];
+
+				rsum += rinsum;
+				gsum += ginsum;
+				bsum += binsum;
+				asum += ainsum;
+
+				stackpointer = (stackpointer + 1) % div;
+				sir = stack[stackpointer];
+
+				routsum += sir[0];
+				goutsum += sir[1];
+				boutsum += sir[2];
+				aoutsum += sir[3];
+
+				rinsum -= sir[0];
+				ginsum -= sir[1];
+				binsum -= sir[2];
+				ainsum -= sir[3];
+
+				yi += w;
+			}
+		}
+		delete [] r;
+		delete [] g;
+		delete [] b;
+		delete [] a;
+		delete [] vmin;
+		delete [] dv;
+
+		for (int i = 0; i < div; ++i)
+		{
+			delete [] stack[i];
+		}
+		delete [] stack;
+	}
+
+	bool convolveImage(const QImage& image, QImage *dest, const unsigned int order, const double *kernel)
+	{
+		double red, green, blue, alpha;
+		const double *k;
+		unsigned int *q;
+		int x, y, mx, my, sx, sy;
+		long i;
+		int mcx, mcy;
+		long widthk = order;
+		if ((widthk % 2) == 0)
+			return false;
+		double *normal_kernel = (double *)malloc(widthk*widthk*sizeof(double));
+		if (!normal_kernel)
+			return false;
+		*dest = QImage(image.width(), image.height(), QImage::Format_ARGB32);
+		double normalize = 0.0;
+		for (i=0; i < (widthk * widthk); i++)
+			normalize += kernel[i];
+		if (fabs(normalize) <= 1.0e-12)
+			normalize = 1.0;
+		normalize = 1.0 / normalize;
+		for (i = 0; i < (widthk * widthk); i++)
+			normal_kernel[i] = normalize*kernel[i];
+		for (y = 0; y < dest->height(); ++y)
+		{
+			sy = y - (widthk / 2);
+			q = (unsigned int *) dest->scanLine(y);
+			for (x = 0; x < dest->width(); ++x)
+			{
+				k = normal_kernel;
+				red = green = blue = alpha = 0;
+				sy = y - (widthk / 2);
+				for (mcy = 0; mcy < widthk; ++mcy, ++sy)
+				{
+					my = sy < 0 ? 0 : sy > image.height() - 1 ? image.height() - 1 : sy;
+					sx = x + (-widthk / 2);
+					for (mcx=0; mcx < widthk; ++mcx, ++sx)
+					{
+						mx = sx < 0 ? 0 : sx > image.width()-1 ? image.width()-1 : sx;
+						int px = image.pixel(mx, my);
+						red += (*k)*(qRed(px) * 257);
+						green += (*k)*(qGreen(px) * 257);
+						blue += (*k)*(qBlue(px) * 257);
+						alpha += (*k)*(qAlpha(px) * 257);
+						++k;
+					}
+				}
+				red = red < 0 ? 0 : red > 65535 ? 65535 : red + 0.5;
+				green = green < 0 ? 0 : green > 65535 ? 65535 : green + 0.5;
+				blue = blue < 0 ? 0 : blue > 65535 ? 65535 : blue + 0.5;
+				alpha = alpha < 0 ? 0 : alpha > 65535 ? 65535 : alpha + 0.5;
+				*q++ = qRgba((unsigned char)(red / 257UL),
+				             (unsigned char)(green / 257UL),
+				             (unsigned char)(blue / 257UL),
+				             (unsigned char)(alpha / 257UL));
+			}
+		}
+		free(normal_kernel);
+		return(true);
+	}
+
+	int getOptimalKernelWidth(double radius, double sigma)
+	{
+		double normalize, value;
+		long width;
+		long u;
+		assert(sigma != 0.0);
+		if (radius > 0.0)
+			return((int)(2.0 * ceil(radius) + 1.0));
+		for (width = 5; ;)
+		{
+			normalize = 0.0;
+			for (u= (-width / 2); u <= (width / 2); u++)
+				normalize += exp(-((double) u * u) / (2.0 * sigma * sigma)) / (2.50662827463100024161235523934010416269302368164062 * sigma);
+			u = width / 2;
+			value = exp(-((double) u*u) / (2.0 * sigma * sigma)) / (2.50662827463100024161235523934010416269302368164062 * sigma) / normalize;
+			if ((long)(65535 * value) <= 0)
+				break;
+			width += 2;
+		}
+		return ((int) width - 2);
+	}
+
+	void sharpen(QImage& image, double radius, double sigma)
+	{
+		long u, v;
+		if (sigma == 0.0)
+			return;
+
+		int widthk = getOptimalKernelWidth(radius, sigma);
+		if ((widthk <= 0) || (image.width() < widthk))
+			return;
+
+		double *kernel = (double *) malloc(widthk * widthk * sizeof(double));
+		if (!kernel)
+			return;
+
+		long i = 0;
+		double alpha;
+		double normalize = 0.0;
+		for (v= (-widthk / 2); v <= (widthk / 2); v++)
+		{
+			for (u= (-widthk / 2); u <= (widthk / 2); u++)
+			{
+				alpha = exp(-((double) u * u + v * v) / (2.0 * sigma * sigma));
+				kernel[i] = alpha / (2.0 * 3.14159265358979323846264338327950288419716939937510 * sigma * sigma);
+				normalize += kernel[i];
+				i++;
+			}
+		}
+		kernel[i / 2] = (-2.0) * normalize;
+
+		QImage dest;
+		convolveImage(image, &dest, widthk, kernel);
+		free(kernel);
+
+		for (int yi = 0; yi < dest.height(); ++yi)
+		{
+			QRgb *s = (QRgb*) dest.scanLine(yi);
+			QRgb *d = (QRgb*) image.scanLine(yi);
+			for (int xi = 0; xi < dest.width(); ++xi)
+			{
+				(*d) = (*s);
+				s++;
+				d++;
+			}
+		}
+	}
+
+	FPointArray readCurve(ScTextStream& fp, int& linear)
+	{
+		int numVals;
+		double xval, yval;
+		FPointArray curve;
+		fp >> numVals;
+		for (int nv = 0; nv < numVals; nv++)
+		{
+			fp >> xval;
+			fp >> yval;
+			curve.addPoint(xval, yval);
+		}
+		fp >> linear;
+		return curve;
+	}
+}
+
+bool ImageEffectReference::apply(QImage& image, const ImageEffect& effect, ColorList& colors)
+{
+	ScribusDoc* doc = colors.document();
+	QString tmpstr(effect.effectParameters);
+	ScTextStream fp(&tmpstr, QIODevice::ReadOnly);
+	switch (effect.effectCode)
+	{
+		case ImageEffect::EF_INVERT:
+			invert(image);
+			return true;
+		case ImageEffect::EF_GRAYSCALE:
+			toGrayscale(image);
+			return true;
+		case ImageEffect::EF_COLORIZE:
+		{
+			int shading = 100;
+			QString col = fp.readLine();
+			fp >> shading;
+			colorize(image, doc, colors[col], shading);
+			return true;
+		}
+		case ImageEffect::EF_BRIGHTNESS:
+		{
+			int brightnessValue = 0;
+			fp >> brightnessValue;
+			brightness(image, brightnessValue);
+			return true;
+		}
+		case ImageEffect::EF_CONTRAST:
+		{
+			int contrastValue = 0;
+			fp >> contrastValue;
+			contrast(image, contrastValue);
+			return true;
+		}
+		case ImageEffect::EF_SHARPEN:
+		{
+			double radius, sigma;
+			fp >> radius;
+			fp >> sigma;
+			sharpen(image, radius, sigma);
+			return true;
+		}
+		case ImageEffect::EF_BLUR:
+		{
+			double radius, sigma;
+			fp >> radius;
+			fp >> sigma;
+			blur(image, static_cast<int>(radius));
+			return true;
+		}
+		case ImageEffect::EF_DUOTONE:
+		{
+			int shading1 = 100;
+			int shading2 = 100;
+			QString col1 = fp.readLine();
+			QString col2 = fp.readLine();
+			fp >> shading1;
+			fp >> shading2;
+			int lin1, lin2;
+			FPointArray curve1 = readCurve(fp, lin1);
+			FPointArray curve2 = readCurve(fp, lin2);
+			duotone(image, doc, colors[col1], shading1, curve1, lin1, colors[col2], shading2, curve2, lin2);
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+bool ImageEffectReference::identical(const QImage& image, const QImage& other)
+{
+	if ((image.format() != other.format()) || (image.size() != other.size()))
+		return false;
+	const qsizetype rowBytes = static_cast<qsizetype>(image.width()) * image.depth() / 8;
+	for (int y = 0; y < image.height(); ++y)
+	{
+		if (memcmp(image.constScanLine(y), other.constScanLine(y), rowBytes) != 0)
+			return false;
+	}
+	return true;
+}
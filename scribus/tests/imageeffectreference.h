@@ -0,0 +1,29 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#ifndef IMAGEEFFECTREFERENCE_H
+#define IMAGEEFFECTREFERENCE_H
+
+#include <QImage>
+
+class ColorList;
+struct ImageEffect;
+
+/**
+ * Per pixel loops ScImage used for image effects before they moved to ScImageKernels, kept
+ * unchanged as reference: the kernels must produce the same bytes on every instruction set.
+ * Only the RGB variants of the effects the benchmarks apply are kept.
+ */
+class ImageEffectReference
+{
+public:
+	/// Applies \a effect to the 32 bit RGB \a image, returns false if the effect has no reference
+	static bool apply(QImage& image, const ImageEffect& effect, ColorList& colors);
+	/// Returns true if \a image and \a other have the same format, size and bytes
+	static bool identical(const QImage& image, const QImage& other);
+};
+
+#endif
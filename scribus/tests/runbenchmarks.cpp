@@ -0,0 +1,652 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFont>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QPen>
+#include <QRandomGenerator>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtGlobal>
+
+#if defined(Q_OS_LINUX)
+#include <dlfcn.h>
+#endif
+
+#include "runbenchmarks.h"
+
+#include "allocationcounter.h"
+#include "api/api_application.h"
+#include "commonstrings.h"
+#include "fileloader.h"
+#include "imageeffectreference.h"
+#include "pageitem.h"
+#include "pageitem_textframe.h"
+#include "pdflib.h"
+#include "pdfoptions.h"
+#include "prefsmanager.h"
+#include "scimage.h"
+#include "scimagekernels.h"
+#include "scimagestructs.h"
+#include "scpage.h"
+#include "scpainter.h"
+#include "scribuscore.h"
+#include "scribusdoc.h"
+#include "text/specialchars.h"
+#include "text/storytext.h"
+#include "text/textshaper.h"
+#include "undomanager.h"
+
+namespace
+{
+	const char* loremWords[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do",
+	                             "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore", "magna", "aliqua", "enim" };
+
+	class BenchmarkSuite
+	{
+	public:
+		explicit BenchmarkSuite(const QString& filter);
+
+		bool run();
+		QJsonObject results() const;
+
+	private:
+		QString m_filter;
+		QTemporaryDir m_tempDir;
+		QString m_imageFile;
+		QJsonArray m_results;
+		bool m_failed { false };
+		// Counters of the preloaded allocation counter library, if any
+		AllocationCounters* m_allocationCounters { nullptr };
+
+		/// Times \a iterations runs of \a body after a warm-up run, \a prepare is run untimed before each of them
+		void measure(const QString& name, const QJsonObject& parameters, int iterations,
+		             const std::function<void()>& prepare, const std::function<void()>& body);
+		bool selected(const QString& name) const { return m_filter.isEmpty() || name.contains(m_filter); }
+		void fail(const QString& name, const QString& message);
+		/// Adds \a value as \a key to the result of benchmark \a name
+		void annotate(const QString& name, const QString& key, double value);
+
+		QString text(int paragraphs, int seed) const;
+		std::unique_ptr<ScribusDoc> createDocument(int pageCount) const;
+		/// Adds a text frame on each page, linked in a single chain holding \a paragraphs paragraphs
+		QList<PageItem*> addTextChain(ScribusDoc* doc, int paragraphs) const;
+		/// Adds shapes and an image frame on each page
+		void addGraphics(ScribusDoc* doc) const;
+		std::unique_ptr<ScribusDoc> loadDocument(const QString& fileName) const;
+
+		void benchmarkStoryText();
+		void benchmarkTextShaper();
+		void benchmarkTextLayout();
+		void benchmarkSlaSaveLoad();
+		void benchmarkPainting();
+		void benchmarkPdfExport();
+		void benchmarkImageEffects();
+		void benchmarkImageScaling();
+	};
+
+	BenchmarkSuite::BenchmarkSuite(const QString& filter) : m_filter(filter)
+	{
+#if defined(Q_OS_LINUX)
+		m_allocationCounters = static_cast<AllocationCounters*>(dlsym(RTLD_DEFAULT, ALLOCATIONCOUNTERS_SYMBOL));
+#endif
+	}
+
+	bool BenchmarkSuite::run()
+	{
+		if (!m_tempDir.isValid())
+			return false;
+
+		QImage image(1200, 900, QImage::Format_RGB32);
+		QPainter painter(&image);
+		QLinearGradient gradient(0, 0, image.width(), image.height());
+		gradient.setColorAt(0.0, QColor(200, 40, 40));
+		gradient.setColorAt(0.5, QColor(40, 200, 80));
+		gradient.setColorAt(1.0, QColor(40, 60, 220));
+		painter.fillRect(image.rect(), gradient);
+		painter.end();
+		m_imageFile = m_tempDir.filePath("image.png");
+		if (!image.save(m_imageFile))
+			return false;
+
+		UndoBlocker undoBlocker;
+		benchmarkStoryText();
+		benchmarkTextShaper();
+		benchmarkTextLayout();
+		benchmarkSlaSaveLoad();
+		benchmarkPainting();
+		benchmarkPdfExport();
+		benchmarkImageEffects();
+		benchmarkImageScaling();
+		return !m_failed;
+	}
+
+	QJsonObject BenchmarkSuite::results() const
+	{
+		QJsonObject results;
+		results.insert("version", ScribusAPI::getVersionScribus());
+		results.insert("date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+		results.insert("platform", QSysInfo::prettyProductName());
+		results.insert("cpuArchitecture", QSysInfo::currentCpuArchitecture());
+		results.insert("threads", QThread::idealThreadCount());
+		results.insert("countsAllocations", m_allocationCounters != nullptr);
+		results.insert("benchmarks", m_results);
+		return results;
+	}
+
+	void BenchmarkSuite::measure(const QString& name, const QJsonObject& parameters, int iterations,
+	                             const std::function<void()>& prepare, const std::function<void()>& body)
+	{
+		if (!selected(name))
+			return;
+
+		if (prepare)
+			prepare();
+		body();
+
+		std::vector<double> times;
+		qint64 allocations = 0;
+		qint64 bytes = 0;
+		QElapsedTimer timer;
+		for (int i = 0; i < iterations; ++i)
+		{
+			if (prepare)
+				prepare();
+			if (m_allocationCounters)
+			{
+				m_allocationCounters->count.store(0);
+				m_allocationCounters->bytes.store(0);
+				m_allocationCounters->enabled.store(true);
+			}
+			timer.start();
+			body();
+			times.push_back(timer.nsecsElapsed() / 1.0e6);
+			if (m_allocationCounters)
+			{
+				m_allocationCounters->enabled.store(false);
+				allocations += m_allocationCounters->count.load();
+				bytes += m_allocationCounters->bytes.load();
+			}
+		}
+
+		std::sort(times.begin(), times.end());
+		double total = 0.0;
+		for (double time : times)
+			total += time;
+
+		QJsonObject result;
+		result.insert("name", name);
+		result.insert("parameters", parameters);
+		result.insert("iterations", iterations);
+		result.insert("minTime", times.front());
+		result.insert("medianTime", times.at(times.size() / 2));
+		result.insert("meanTime", total / iterations);
+		result.insert("maxTime", times.back());
+		if (m_allocationCounters)
+		{
+			result.insert("allocations", allocations / iterations);
+			result.insert("allocatedBytes", bytes / iterations);
+			qInfo("%-28s median %10.3f ms, %lld allocations", qPrintable(name), times.at(times.size() / 2), allocations / iterations);
+		}
+		else
+			qInfo("%-28s median %10.3f ms", qPrintable(name), times.at(times.size() / 2));
+		m_results.append(result);
+	}
+
+	void BenchmarkSuite::fail(const QString& name, const QString& message)
+	{
+		QJsonObject result;
+		result.insert("name", name);
+		result.insert("error", message);
+		m_results.append(result);
+		qWarning("%s: %s", qPrintable(name), qPrintable(message));
+		m_failed = true;
+	}
+
+	void BenchmarkSuite::annotate(const QString& name, const QString& key, double value)
+	{
+		for (int i = m_results.count() - 1; i >= 0; --i)
+		{
+			QJsonObject result = m_results.at(i).toObject();
+			if (result.value("name").toString() != name)
+				continue;
+			result.insert(key, value);
+			m_results.replace(i, result);
+			return;
+		}
+	}
+
+	QString BenchmarkSuite::text(int paragraphs, int seed) const
+	{
+		QRandomGenerator random(seed);
+		QString result;
+		for (int i = 0; i < paragraphs; ++i)
+		{
+			if (i > 0)
+				result += SpecialChars::PARSEP;
+			const int wordCount = random.bounded(20, 120);
+			for (int word = 0; word < wordCount; ++word)
+			{
+				if (word > 0)
+					result += QChar(' ');
+				result += QLatin1String(loremWords[random.bounded(20)]);
+			}
+			result += QChar('.');
+		}
+		return result;
+	}
+
+	std::unique_ptr<ScribusDoc> BenchmarkSuite::createDocument(int pageCount) const
+	{
+		std::unique_ptr<ScribusDoc> doc(new ScribusDoc());
+		doc->setLoading(true);
+		doc->PageColors = PrefsManager::instance().appPrefs.colorPrefs.DColors;
+		doc->PageColors.ensureDefaultColors();
+		doc->setup(0, 0, 0, 0, 1, "A4", "Benchmark");
+		doc->setPage(595.28, 841.89, 40, 40, 40, 40, 1, 0, false, 0);
+		doc->setMasterPageMode(false);
+		doc->createDefaultMasterPages();
+		doc->createNewDocPages(pageCount);
+		doc->addSection();
+		doc->setFirstSectionFromFirstPageNumber();
+		doc->setGUI(false, ScCore->primaryMainWindow(), nullptr);
+		doc->setLoading(false);
+		return doc;
+	}
+
+	QList<PageItem*> BenchmarkSuite::addTextChain(ScribusDoc* doc, int paragraphs) const
+	{
+		QList<PageItem*> chain;
+		for (ScPage* page : std::as_const(doc->DocPages))
+		{
+			int index = doc->itemAdd(PageItem::TextFrame, PageItem::Unspecified, page->xOffset() + 40, page->yOffset() + 40,
+			                         (page->width() - 80) / 2, page->height() - 80, 1, CommonStrings::None, "Black");
+			PageItem* frame = doc->Items->at(index);
+			if (!chain.isEmpty())
+				chain.last()->link(frame, false);
+			chain.append(frame);
+		}
+		if (!chain.isEmpty())
+			chain.first()->itemText.insertChars(0, text(paragraphs, 42));
+		return chain;
+	}
+
+	void BenchmarkSuite::addGraphics(ScribusDoc* doc) const
+	{
+		QRandomGenerator random(7);
+		for (ScPage* page : std::as_const(doc->DocPages))
+		{
+			const double left = page->xOffset() + page->width() / 2 + 10;
+			for (int i = 0; i < 20; ++i)
+			{
+				int index = doc->itemAdd(PageItem::Polygon, (i % 2) ? PageItem::Ellipse : PageItem::Rectangle,
+				                         left + random.bounded(150.0), page->yOffset() + 40 + random.bounded(300.0),
+				                         20 + random.bounded(100.0), 20 + random.bounded(100.0), 1, "Black", "Black");
+				PageItem* shape = doc->Items->at(index);
+				shape->setFillTransparency(random.bounded(0.8));
+				shape->setRotation(random.bounded(360.0));
+			}
+			int index = doc->itemAdd(PageItem::ImageFrame, PageItem::Unspecified, left, page->yOffset() + 420,
+			                         240, 180, 1, CommonStrings::None, CommonStrings::None);
+			PageItem* imageFrame = doc->Items->at(index);
+			doc->loadPict(m_imageFile, imageFrame);
+			imageFrame->setImageScalingMode(false, true);
+			imageFrame->adjustPictScale();
+		}
+	}
+
+	std::unique_ptr<ScribusDoc> BenchmarkSuite::loadDocument(const QString& fileName) const
+	{
+		std::unique_ptr<ScribusDoc> doc(new ScribusDoc());
+		doc->setGUI(false, ScCore->primaryMainWindow(), nullptr);
+		doc->setLoading(true);
+		FileLoader fileLoader(fileName);
+		if ((fileLoader.testFile() == -1) || !fileLoader.loadFile(doc.get()))
+			return nullptr;
+		doc->setLoading(false);
+		return doc;
+	}
+
+	void BenchmarkSuite::benchmarkStoryText()
+	{
+		const QString paragraph = text(1, 1) + SpecialChars::PARSEP;
+		std::unique_ptr<ScribusDoc> doc(createDocument(1));
+
+		std::unique_ptr<StoryText> story;
+		QJsonObject parameters { { "paragraphs", 2000 } };
+		measure("storyText.insert", parameters, 10,
+				[&]() { story.reset(new StoryText(doc.get())); },
+				[&]() {
+					QRandomGenerator random(3);
+					for (int i = 0; i < 2000; ++i)
+						story->insertChars(random.bounded(story->length() + 1), paragraph);
+				});
+
+		measure("storyText.remove", parameters, 10,
+				[&]() {
+					story.reset(new StoryText(doc.get()));
+					for (int i = 0; i < 2000; ++i)
+						story->insertChars(story->length(), paragraph);
+				},
+				[&]() {
+					QRandomGenerator random(4);
+					while (story->length() > paragraph.length())
+					{
+						int length = qMin(paragraph.length(), story->length() - 1);
+						story->removeChars(random.bounded(story->length() - length), length);
+					}
+				});
+	}
+
+	void BenchmarkSuite::benchmarkTextShaper()
+	{
+		std::unique_ptr<ScribusDoc> doc(createDocument(1));
+		QList<PageItem*> chain = addTextChain(doc.get(), 500);
+		PageItem* frame = chain.first();
+
+		measure("textShaper.shape", QJsonObject { { "paragraphs", 500 }, { "characters", frame->itemText.length() } }, 10,
+				nullptr,
+				[&]() {
+					TextShaper shaper(frame, frame->itemText, 0);
+					ShapedText shapedText = shaper.shape(0, frame->itemText.length());
+					Q_UNUSED(shapedText);
+				});
+	}
+
+	void BenchmarkSuite::benchmarkTextLayout()
+	{
+		std::unique_ptr<ScribusDoc> doc(createDocument(40));
+		QList<PageItem*> chain = addTextChain(doc.get(), 1500);
+
+		measure("textFrame.layoutChain", QJsonObject { { "frames", chain.count() }, { "paragraphs", 1500 } }, 5,
+				[&]() {
+					for (PageItem* frame : std::as_const(chain))
+						frame->invalidateLayout();
+				},
+				[&]() { chain.last()->layout(); });
+	}
+
+	void BenchmarkSuite::benchmarkSlaSaveLoad()
+	{
+		if (!selected("sla.save") && !selected("sla.load"))
+			return;
+
+		std::unique_ptr<ScribusDoc> doc(createDocument(40));
+		addTextChain(doc.get(), 1500);
+		addGraphics(doc.get());
+		const QString fileName = m_tempDir.filePath("benchmark.sla");
+		QJsonObject parameters { { "pages", 40 }, { "items", doc->Items->count() } };
+
+		bool saved = true;
+		measure("sla.save", parameters, 5, nullptr,
+				[&]() {
+					FileLoader fileLoader(fileName);
+					saved = fileLoader.saveFile(fileName, doc.get()) && saved;
+				});
+		if (!saved)
+		{
+			fail("sla.save", "Cannot save " + fileName);
+			return;
+		}
+		parameters.insert("fileSize", QFileInfo(fileName).size());
+
+		bool loaded = true;
+		measure("sla.load", parameters, 5, nullptr,
+				[&]() { loaded = (loadDocument(fileName) != nullptr) && loaded; });
+		if (!loaded)
+			fail("sla.load", "Cannot load " + fileName);
+	}
+
+	void BenchmarkSuite::benchmarkPainting()
+	{
+		if (!selected("canvas.paintPages"))
+			return;
+
+		std::unique_ptr<ScribusDoc> doc(createDocument(10));
+		QList<PageItem*> chain = addTextChain(doc.get(), 400);
+		addGraphics(doc.get());
+		chain.last()->layout();
+
+		const double scale = 150.0 / 72.0;
+		doc->drawAsPreview = true;
+		doc->guidesPrefs().framesShown = false;
+		doc->guidesPrefs().showControls = false;
+		measure("canvas.paintPages", QJsonObject { { "pages", 10 }, { "dpi", 150 } }, 5, nullptr,
+				[&]() {
+					for (ScPage* page : std::as_const(doc->DocPages))
+					{
+						const int clipX = static_cast<int>(page->xOffset() * scale);
+						const int clipY = static_cast<int>(page->yOffset() * scale);
+						QImage image(qRound(page->width() * scale), qRound(page->height() * scale), QImage::Format_ARGB32_Premultiplied);
+						image.fill(Qt::white);
+						ScPainter painter(&image, image.width(), image.height(), 1.0, 0);
+						painter.translate(-clipX, -clipY);
+						painter.setFillMode(ScPainter::Solid);
+						painter.beginLayer(1.0, 0);
+						painter.setZoomFactor(scale);
+						QRectF cullingArea(page->xOffset(), page->yOffset(), page->width(), page->height());
+						for (PageItem* item : std::as_const(*doc->Items))
+						{
+							if (item->OwnPage == page->pageNr())
+								item->DrawObj(&painter, cullingArea);
+						}
+						painter.endLayer();
+						painter.end();
+					}
+				});
+	}
+
+	void BenchmarkSuite::benchmarkPdfExport()
+	{
+		if (!selected("pdf.export"))
+			return;
+
+		std::unique_ptr<ScribusDoc> doc(createDocument(20));
+		QList<PageItem*> chain = addTextChain(doc.get(), 800);
+		addGraphics(doc.get());
+		chain.last()->layout();
+
+		PDFOptions options = doc->pdfOptions();
+		options.Thumbnails = false;
+		std::vector<int> pageNs;
+		for (int i = 1; i <= doc->DocPages.count(); ++i)
+			pageNs.push_back(i);
+		const QString fileName = m_tempDir.filePath("benchmark.pdf");
+
+		bool exported = true;
+		measure("pdf.export", QJsonObject { { "pages", 20 } }, 5, nullptr,
+				[&]() {
+					PDFlib pdflib(*doc, options);
+					exported = pdflib.doExport(fileName, pageNs, QMap<int, QImage>()) && exported;
+				});
+		if (!exported)
+			fail("pdf.export", "Cannot export " + fileName);
+	}
+
+	void BenchmarkSuite::benchmarkImageEffects()
+	{
+		QImage source(m_imageFile);
+		source = source.scaled(2400, 1800).convertToFormat(QImage::Format_ARGB32);
+		ColorList colors = PrefsManager::instance().appPrefs.colorPrefs.DColors;
+
+		const struct
+		{
+			const char* name;
+			int effectCode;
+			const char* parameters;
+		} effects[] = {
+			{ "scImage.invert", ImageEffect::EF_INVERT, "" },
+			{ "scImage.grayscale", ImageEffect::EF_GRAYSCALE, "" },
+			{ "scImage.brightness", ImageEffect::EF_BRIGHTNESS, "20" },
+			{ "scImage.contrast", ImageEffect::EF_CONTRAST, "30" },
+			{ "scImage.colorize", ImageEffect::EF_COLORIZE, "Blue\n60" },
+			{ "scImage.duotone", ImageEffect::EF_DUOTONE, "Black\nRed\n100 80 2 0 0 1 1 0 2 0 0 1 1 0" },
+			{ "scImage.sharpen", ImageEffect::EF_SHARPEN, "2 1" },
+			{ "scImage.blur", ImageEffect::EF_BLUR, "3 1.5" },
+		};
+		const QJsonObject parameters { { "width", source.width() }, { "height", source.height() } };
+		const ScImageKernels::InstructionSet instructionSet = ScImageKernels::supportedInstructionSet();
+		for (const auto& effect : effects)
+		{
+			ScImageEffectList effectList;
+			ImageEffect imageEffect;
+			imageEffect.effectCode = effect.effectCode;
+			imageEffect.effectParameters = effect.parameters;
+			effectList.append(imageEffect);
+
+			// The former per pixel loops first, as reference for output and time
+			const QString name(effect.name);
+			QImage reference;
+			measure(name + ".reference", parameters, 5,
+					[&]() { reference = source.copy(); },
+					[&]() { ImageEffectReference::apply(reference, imageEffect, colors); });
+
+			// Scalar kernels on one thread, then the kernels as dispatched
+			std::unique_ptr<ScImage> image;
+			ScImageKernels::setInstructionSet(ScImageKernels::InstructionSet::Scalar);
+			ScImageKernels::setMaxThreadCount(1);
+			measure(name + ".scalar", parameters, 5,
+					[&]() { image.reset(new ScImage(source)); },
+					[&]() { image->applyEffect(effectList, colors, false); });
+			if (image && !reference.isNull() && !ImageEffectReference::identical(image->qImage(), reference))
+				fail(name + ".scalar", "Output differs from the reference code");
+
+			image.reset();
+			ScImageKernels::setInstructionSet(instructionSet);
+			ScImageKernels::setMaxThreadCount(0);
+			QJsonObject vectorParameters(parameters);
+			vectorParameters.insert("instructionSet", instructionSet == ScImageKernels::InstructionSet::AVX2 ? "AVX2"
+			                                          : instructionSet == ScImageKernels::InstructionSet::SSE2 ? "SSE2" : "scalar");
+			measure(name, vectorParameters, 5,
+					[&]() { image.reset(new ScImage(source)); },
+					[&]() { image->applyEffect(effectList, colors, false); });
+			if (image && !reference.isNull() && !ImageEffectReference::identical(image->qImage(), reference))
+				fail(name, "Output differs from the reference code");
+		}
+	}
+
+	// Peak signal to noise ratio of the colour channels of \a image against \a reference, in dB
+	double psnr(const QImage& image, const QImage& reference)
+	{
+		const QImage a = image.convertToFormat(QImage::Format_ARGB32);
+		const QImage b = reference.convertToFormat(QImage::Format_ARGB32);
+		double squares = 0.0;
+		for (int y = 0; y < a.height(); ++y)
+		{
+			const QRgb* rowA = reinterpret_cast<const QRgb*>(a.constScanLine(y));
+			const QRgb* rowB = reinterpret_cast<const QRgb*>(b.constScanLine(y));
+			for (int x = 0; x < a.width(); ++x)
+			{
+				const int red = qRed(rowA[x]) - qRed(rowB[x]);
+				const int green = qGreen(rowA[x]) - qGreen(rowB[x]);
+				const int blue = qBlue(rowA[x]) - qBlue(rowB[x]);
+				squares += red * red + green * green + blue * blue;
+			}
+		}
+		const double mse = squares / (3.0 * a.width() * a.height());
+		if (mse <= 0.0)
+			return 99.0;
+		return 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+
+	void BenchmarkSuite::benchmarkImageScaling()
+	{
+		// The gradient with fine lines and text, details a resampler should keep
+		QImage source(m_imageFile);
+		source = source.scaled(2400, 1800).convertToFormat(QImage::Format_ARGB32);
+		QPainter painter(&source);
+		painter.setRenderHint(QPainter::Antialiasing);
+		painter.setPen(QPen(Qt::black, 1.5));
+		for (int i = 0; i < 60; ++i)
+			painter.drawEllipse(QPointF(1200, 900), 20.0 * i, 14.0 * i);
+		QFont font;
+		font.setPixelSize(28);
+		painter.setFont(font);
+		painter.setPen(Qt::white);
+		painter.drawText(QRect(20, 20, source.width() - 40, source.height() - 40), Qt::TextWordWrap, text(12, 3).replace(SpecialChars::PARSEP, QChar('\n')));
+		painter.end();
+
+		const struct
+		{
+			const char* name;
+			ScImage::ScaleFilter filter;
+		} filters[] = {
+			{ "area", ScImage::ScaleFilter::Area },
+			{ "box", ScImage::ScaleFilter::Box },
+			{ "bilinear", ScImage::ScaleFilter::Bilinear },
+			{ "lanczos", ScImage::ScaleFilter::Lanczos },
+		};
+		// 32 bit images go through scaleImage32bpp() with the area filter, others through scaleImageGeneric()
+		const struct
+		{
+			const char* name;
+			QImage::Format format;
+		} formats[] = {
+			{ "argb32", QImage::Format_ARGB32 },
+			{ "rgb888", QImage::Format_RGB888 },
+		};
+		const int width = 1000;
+		const int height = 750;
+		for (const auto& format : formats)
+		{
+			const QImage formatSource = source.convertToFormat(format.format);
+			for (const auto& filter : filters)
+			{
+				const QString name = QString("scImage.scale.%1.%2").arg(format.name, filter.name);
+				std::unique_ptr<ScImage> image;
+				measure(name, QJsonObject { { "width", width }, { "height", height } }, 5,
+						[&]() { image.reset(new ScImage(formatSource)); },
+						[&]() { image->scaleImage(width, height, filter.filter); });
+				if (!image)
+					continue;
+				// Quality: scaled back to the source size with the same smooth transformation
+				// for every filter, so that only the downscaling differs, compared with the source
+				const QImage upscaled = image->qImage().scaled(source.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+				annotate(name, "psnr", psnr(upscaled, source));
+			}
+		}
+	}
+}
+
+int RunBenchmarks::runBenchmarks(const QString& outputFile, const QString& filter)
+{
+	BenchmarkSuite suite(filter);
+	bool success = suite.run();
+
+	QFile output;
+	bool opened = false;
+	if (outputFile == "-")
+		opened = output.open(stdout, QIODevice::WriteOnly);
+	else
+	{
+		output.setFileName(outputFile);
+		opened = output.open(QIODevice::WriteOnly);
+	}
+	if (!opened)
+	{
+		qWarning("Cannot write benchmark results to %s", qPrintable(outputFile));
+		return 1;
+	}
+	output.write(QJsonDocument(suite.results()).toJson());
+	output.close();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#ifndef RUNBENCHMARKS_H
+#define RUNBENCHMARKS_H
+
+#include <QString>
+
+#include "scribusapi.h"
+
+/**
+ * Runs benchmarks of the load, layout, render and export code over generated documents
+ * and writes their results as JSON. Benchmarks need fonts, plugins and profiles, they are
+ * run by the application once its core is initialized, see the --benchmarks option.
+ *
+ * Each benchmark reports the minimum, median, mean and maximum time of its iterations in
+ * milliseconds. On Linux, when the allocation counter library is preloaded, see
+ * allocationcounter.h, it also reports the number and size of allocations per iteration.
+ */
+class RunBenchmarks
+{
+public:
+	/// Runs all benchmarks whose name contains \a filter, writes results to \a outputFile or to stdout if it is "-"
+	static int runBenchmarks(const QString& outputFile, const QString& filter = QString());
+};
+
+#endif
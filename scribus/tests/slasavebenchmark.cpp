@@ -0,0 +1,165 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#include <zlib.h>
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <QtTest/QtTest>
+
+#include "slasavebenchmark.h"
+#include "parallelgzipdevice.h"
+#include "qtiocompressor.h"
+
+namespace
+{
+	// Decompresses gzip data the way documents are opened
+	QByteArray gunzip(QByteArray data)
+	{
+		QBuffer buffer(&data);
+		QtIOCompressor compressor(&buffer);
+		compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+		if (!compressor.open(QIODevice::ReadOnly))
+			return QByteArray();
+		QByteArray result = compressor.readAll();
+		compressor.close();
+		return result;
+	}
+}
+
+void SlaSaveBenchmark::initTestCase()
+{
+	// About 32 MB of items and stories looking like those of a saved document
+	QRandomGenerator random(1234);
+	const QByteArray words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do" };
+	m_document = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<SCRIBUSUTF8NEW Version=\"1.7.1\">\n <DOCUMENT>\n";
+	int itemID = 0;
+	while (m_document.size() < 32 * 1024 * 1024)
+	{
+		m_document += "  <PAGEOBJECT XPOS=\"" + QByteArray::number(random.bounded(600.0), 'f', 4)
+		              + "\" YPOS=\"" + QByteArray::number(random.bounded(800.0), 'f', 4)
+		              + "\" OwnPage=\"" + QByteArray::number(itemID / 40)
+		              + "\" ItemID=\"" + QByteArray::number(itemID)
+		              + "\" PTYPE=\"4\" WIDTH=\"" + QByteArray::number(random.bounded(300.0), 'f', 4)
+		              + "\" HEIGHT=\"" + QByteArray::number(random.bounded(300.0), 'f', 4)
+		              + "\" FRTYPE=\"0\" CLIPEDIT=\"0\" PWIDTH=\"1\" PLINEART=\"1\" LOCALSCX=\"1\" LOCALSCY=\"1\">\n"
+		              + "   <StoryText>\n    <DefaultStyle/>\n";
+		const int runCount = random.bounded(1, 6);
+		for (int run = 0; run < runCount; ++run)
+		{
+			QByteArray text;
+			const int wordCount = random.bounded(5, 60);
+			for (int word = 0; word < wordCount; ++word)
+				text += words[random.bounded(10)] + ' ';
+			m_document += "    <ITEXT FONTSIZE=\"" + QByteArray::number(random.bounded(8, 24)) + "\" CH=\"" + text + "\"/>\n    <para/>\n";
+		}
+		m_document += "   </StoryText>\n  </PAGEOBJECT>\n";
+		++itemID;
+	}
+	m_document += " </DOCUMENT>\n</SCRIBUSUTF8NEW>\n";
+}
+
+void SlaSaveBenchmark::benchmarkCompression_data()
+{
+	QTest::addColumn<int>("threadCount");
+
+	QTest::newRow("QtIOCompressor") << 0;
+	QTest::newRow("1 thread") << 1;
+	QTest::newRow("2 threads") << 2;
+	QTest::newRow("4 threads") << 4;
+	QTest::newRow("all threads") << QThread::idealThreadCount();
+}
+
+void SlaSaveBenchmark::benchmarkCompression()
+{
+	QFETCH(int, threadCount);
+
+	QByteArray compressed;
+	QBuffer buffer(&compressed);
+	QVERIFY(buffer.open(QIODevice::WriteOnly));
+
+	// Documents are written by many small writes, as the XML stream writer does
+	const int chunkSize = 256;
+	QElapsedTimer timer;
+	timer.start();
+	if (threadCount == 0)
+	{
+		QtIOCompressor compressor(&buffer);
+		compressor.setStreamFormat(QtIOCompressor::GzipFormat);
+		QVERIFY(compressor.open(QIODevice::WriteOnly));
+		for (qint64 pos = 0; pos < m_document.size(); pos += chunkSize)
+			compressor.write(m_document.constData() + pos, qMin<qint64>(chunkSize, m_document.size() - pos));
+		compressor.close();
+	}
+	else
+	{
+		QThreadPool threadPool;
+		threadPool.setMaxThreadCount(threadCount);
+		ParallelGzipDevice compressor(&buffer);
+		compressor.setThreadPool(&threadPool);
+		QVERIFY(compressor.open(QIODevice::WriteOnly));
+		for (qint64 pos = 0; pos < m_document.size(); pos += chunkSize)
+			compressor.write(m_document.constData() + pos, qMin<qint64>(chunkSize, m_document.size() - pos));
+		compressor.close();
+		QVERIFY(!compressor.hasError());
+	}
+	const qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+	buffer.close();
+
+	const double megaBytes = m_document.size() / (1024.0 * 1024.0);
+	qInfo("%s: %.1f MB in %lld ms, %.1f MB/s, compressed to %.1f%%", QTest::currentDataTag(),
+	      megaBytes, elapsed, megaBytes * 1000.0 / elapsed, 100.0 * compressed.size() / m_document.size());
+
+	QVERIFY(gunzip(compressed) == m_document);
+}
+
+void SlaSaveBenchmark::testRestartPoints()
+{
+	QByteArray compressed;
+	QBuffer buffer(&compressed);
+	QVERIFY(buffer.open(QIODevice::WriteOnly));
+
+	ParallelGzipDevice compressor(&buffer);
+	compressor.setBlockSize(64 * 1024);
+	compressor.reserveExtraField("SI", 64);
+	QVERIFY(compressor.open(QIODevice::WriteOnly));
+	const qint64 half = m_document.size() / 2;
+	compressor.write(m_document.constData(), half);
+	int point = compressor.addRestartPoint('<');
+	compressor.write(m_document.constData() + half, m_document.size() - half);
+	compressor.close();
+	QVERIFY(!compressor.hasError());
+	QVERIFY(compressor.setExtraField("1 test"));
+	QVERIFY(gunzip(compressed) == m_document);
+
+	ParallelGzipDevice::RestartPoint restart = compressor.restartPoint(point);
+	QCOMPARE(restart.offset, m_document.indexOf('<', half));
+	QVERIFY(restart.compressedOffset >= 0);
+
+	// Inflating from the restart point gives the data from its offset
+	const int headerSize = 10 + 2 + 4 + 64;
+	QByteArray expected = m_document.mid(restart.offset, 4096);
+	QByteArray inflated(expected.size(), '\0');
+	z_stream zs;
+	zs.zalloc = Z_NULL;
+	zs.zfree = Z_NULL;
+	zs.opaque = Z_NULL;
+	zs.next_in = Z_NULL;
+	zs.avail_in = 0;
+	QCOMPARE(inflateInit2(&zs, -MAX_WBITS), Z_OK);
+	zs.next_in = reinterpret_cast<Bytef*>(compressed.data() + headerSize + restart.compressedOffset);
+	zs.avail_in = static_cast<uInt>(compressed.size() - headerSize - restart.compressedOffset);
+	zs.next_out = reinterpret_cast<Bytef*>(inflated.data());
+	zs.avail_out = static_cast<uInt>(inflated.size());
+	int status = inflate(&zs, Z_NO_FLUSH);
+	inflateEnd(&zs);
+	QVERIFY((status == Z_OK) || (status == Z_STREAM_END));
+	QCOMPARE(inflated, expected);
+}
+
+QTEST_GUILESS_MAIN(SlaSaveBenchmark)
@@ -0,0 +1,34 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+#ifndef SLASAVEBENCHMARK_H
+#define SLASAVEBENCHMARK_H
+
+#include <QByteArray>
+#include <QtTest/QtTest>
+
+/**
+ * Compares compression throughput of saved documents, single threaded with QtIOCompressor
+ * and with ParallelGzipDevice on a growing number of threads. Output is checked to be
+ * readable by QtIOCompressor.
+ */
+class SlaSaveBenchmark : public QObject
+{
+	Q_OBJECT
+public:
+	SlaSaveBenchmark() {}
+
+private slots:
+	void initTestCase();
+	void benchmarkCompression();
+	void benchmarkCompression_data();
+	void testRestartPoints();
+
+private:
+	QByteArray m_document;
+};
+
+#endif // SLASAVEBENCHMARK_H
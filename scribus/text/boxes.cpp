@@ -106,6 +106,16 @@ double GroupBox::naturalHeight() const
 	return nH;
 }
 
+void Box::moveCharsBy(int delta)
+{
+	if (m_firstChar != INT_MAX)
+		m_firstChar += delta;
+	if (m_lastChar != INT_MIN)
+		m_lastChar += delta;
+	for (Box* box : std::as_const(m_boxes))
+		box->moveCharsBy(delta);
+}
+
 void GroupBox::addBox(const Box* box)
 {
 	boxes().append(const_cast<Box*>(box));
@@ -491,6 +501,12 @@ void PathLineBox::drawBackGround(TextLayoutPainter *p) const
 }
 
 
+void GlyphBox::moveCharsBy(int delta)
+{
+	Box::moveCharsBy(delta);
+	m_glyphRun.moveCharsBy(delta);
+}
+
 void GlyphBox::render(ScreenPainter *p, ITextContext *ctx) const
 {
 	const PageItem* item = ctx->getFrame();
@@ -96,6 +96,9 @@ public:
 	int firstChar() const { return m_firstChar == INT_MAX ? 0 : m_firstChar; }
 	/// The last character within the box.
 	int lastChar() const { return m_lastChar == INT_MIN ? 0 : m_lastChar; }
+	/// Shifts the characters of the box and of its children by delta,
+	/// used when reusing a box after text before it changed length.
+	virtual void moveCharsBy(int delta);
 
 	/// Sets the transformation matrix to applied to the box.
 	void setMatrix(const QTransform& x) { m_matrix = x; }
@@ -256,6 +259,8 @@ public:
 
 	GlyphCluster glyphRun() const { return m_glyphRun; }
 
+	void moveCharsBy(int delta) override;
+
 	const CharStyle& style() const { return m_glyphRun.style(); }
 
 protected:
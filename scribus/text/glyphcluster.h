@@ -25,6 +25,8 @@ public:
 	int firstChar() const;
 	int lastChar() const;
 	int visualIndex() const;
+	/// Shift the character range by delta, used when text before the cluster changed length
+	void moveCharsBy(int delta);
 
 	double width() const;
 
@@ -0,0 +1,66 @@
+/*
+ For general Scribus (>=1.3.2) copyright and licensing information please refer
+ to the COPYING file provided with the program. Following this notice may exist
+ a copyright and/or license notice that predates the release of Scribus 1.3.2
+ for which a new license (GPL+exception) is in place.
+ */
+
+#include <QHash>
+
+#include "shapedruncache.h"
+
+bool ShapedRunCache::Key::operator==(const Key& other) const
+{
+	return (runStart == other.runStart) && (runLength == other.runLength)
+		&& (fontSize == other.fontSize) && (script == other.script)
+		&& (direction == other.direction) && (text == other.text)
+		&& (fontPath == other.fontPath) && (language == other.language)
+		&& (features == other.features);
+}
+
+size_t qHash(const ShapedRunCache::Key& key, size_t seed)
+{
+	return qHashMulti(seed, key.text, key.runStart, key.runLength, key.fontPath, key.fontSize, key.language, key.script, key.direction, key.features);
+}
+
+ShapedRunCache::ShapedRunCache() :
+	m_cache(250000)
+{
+
+}
+
+ShapedRunCache& ShapedRunCache::instance()
+{
+	static ShapedRunCache instance;
+	return instance;
+}
+
+bool ShapedRunCache::find(const Key& key, GlyphList& glyphs)
+{
+	const GlyphList* cached = m_cache.object(key);
+	if (cached == nullptr)
+	{
+		++m_misses;
+		return false;
+	}
+	++m_hits;
+	glyphs = *cached;
+	return true;
+}
+
+void ShapedRunCache::insert(const Key& key, const GlyphList& glyphs)
+{
+	// Cost is the glyph count, runs without glyphs still take some memory
+	m_cache.insert(key, new GlyphList(glyphs), qMax(1, static_cast<int>(glyphs.count())));
+}
+
+void ShapedRunCache::clear()
+{
+	m_cache.clear();
+}
+
+void ShapedRunCache::resetStatistics()
+{
+	m_hits = 0;
+	m_misses = 0;
+}
@@ -0,0 +1,87 @@
+/*
+ For general Scribus (>=1.3.2) copyright and licensing information please refer
+ to the COPYING file provided with the program. Following this notice may exist
+ a copyright and/or license notice that predates the release of Scribus 1.3.2
+ for which a new license (GPL+exception) is in place.
+ */
+
+#ifndef SHAPEDRUNCACHE_H
+#define SHAPEDRUNCACHE_H
+
+#include <QCache>
+#include <QString>
+#include <QVector>
+
+#include "scribusapi.h"
+
+/**
+ * LRU cache of the glyphs HarfBuzz returns for a run of text.
+ *
+ * Unlike ShapedTextCache, entries are not bound to a position in a story but keyed
+ * by the run text and everything shaping depends on, so that a run is shaped once
+ * whichever story, frame or position it appears at. TextShaper looks up each run
+ * before calling HarfBuzz and only shapes on a miss.
+ * The cache is used by text layout and must only be accessed from the GUI thread.
+ */
+class SCRIBUS_API ShapedRunCache
+{
+public:
+	struct Key
+	{
+		QString text;       // run text including the context HarfBuzz looks at
+		int runStart { 0 }; // start of the run within text
+		int runLength { 0 };
+		QString fontPath;
+		double fontSize { 0.0 };
+		QString language;
+		int script { 0 };
+		int direction { 0 };
+		QString features;   // features with their range relative to the run start
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct Glyph
+	{
+		uint codepoint { 0 };
+		uint cluster { 0 };  // relative to the run start
+		int xOffset { 0 };
+		int yOffset { 0 };
+		int xAdvance { 0 };
+		int yAdvance { 0 };
+	};
+	using GlyphList = QVector<Glyph>;
+
+	static ShapedRunCache& instance();
+
+	/**
+	 * Looks up the glyphs of a run
+	 * @param key run properties
+	 * @param glyphs receives the cached glyphs
+	 * @return true if the run was found
+	 */
+	bool find(const Key& key, GlyphList& glyphs);
+	/// Stores the glyphs of a run, evicting least recently used runs if needed
+	void insert(const Key& key, const GlyphList& glyphs);
+	void clear();
+
+	/// Maximum number of glyphs kept in the cache
+	int maxGlyphs() const { return static_cast<int>(m_cache.maxCost()); }
+	void setMaxGlyphs(int count) { m_cache.setMaxCost(count); }
+
+	qint64 hits() const { return m_hits; }
+	qint64 misses() const { return m_misses; }
+	void resetStatistics();
+
+private:
+	ShapedRunCache();
+	~ShapedRunCache() = default;
+
+	QCache<Key, GlyphList> m_cache;
+	qint64 m_hits { 0 };
+	qint64 m_misses { 0 };
+};
+
+size_t qHash(const ShapedRunCache::Key& key, size_t seed = 0);
+
+#endif // SHAPEDRUNCACHE_H
@@ -654,7 +654,8 @@ void StoryText::removeChars(int pos, uint len)
 		d->selFirst =  0;
 		d->selLast  = -1;
 	}
-	invalidate(pos, length());
+	// text after the removed range is unchanged, only its position moved
+	invalidate(pos, qMin(pos + 1, length()));
 }
 
 void StoryText::trim()
@@ -2179,6 +2180,8 @@ void StoryText::invalidateObject(const PageItem * embedded)
 
 void StoryText::invalidateLayout()
 {
+	if (!signalsBlocked())
+		emit changed(0, length());
 }
 
 void StoryText::invalidateAll()
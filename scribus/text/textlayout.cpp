@@ -213,6 +213,14 @@ void TextLayout::clear()
 	m_box = new GroupBox(Box::D_Horizontal);
 }
 
+QList<Box*> TextLayout::takeColumns()
+{
+	QList<Box*> columns;
+	columns.swap(m_box->boxes());
+	clear();
+	return columns;
+}
+
 void TextLayout::setStory(StoryText *story)
 {
 	m_story = story;
@@ -71,6 +71,8 @@ public:
 	void addColumn(double colLeft, double colWidth);
 
 	void clear();
+	/// Clears the layout, handing its columns with their lines over to the caller
+	QList<Box*> takeColumns();
 
 protected:
 	friend class FrameControl;
@@ -13,6 +13,7 @@
 #include "glyphcluster.h"
 #include "pageitem.h"
 #include "scribusdoc.h"
+#include "shapedruncache.h"
 #include "storytext.h"
 #include "styles/paragraphstyle.h"
 #include "util.h"
@@ -264,6 +265,79 @@ void TextShaper::buildText(int fromPos, int toPos, QVector<int>& smallCaps)
 }
 
 
+ShapedRunCache::GlyphList TextShaper::shapeRun(const TextRun& textRun, const CharStyle& style, hb_font_t* hbFont, const QList<FeaturesRun>& featuresRuns) const
+{
+	hb_font_set_scale(hbFont, style.fontSize(), style.fontSize());
+#if HB_VERSION_ATLEAST(11, 0, 0)
+	FT_Face ftFace = hb_ft_font_get_ft_face(hbFont);
+#else
+	FT_Face ftFace = hb_ft_font_get_face(hbFont);
+#endif
+	if (ftFace)
+	{
+		FT_Set_Char_Size(ftFace, style.fontSize(), 0, 72, 0);
+		hb_ft_font_changed(hbFont);
+	}
+
+	hb_direction_t hbDirection = (textRun.dir == UBIDI_LTR) ? HB_DIRECTION_LTR : HB_DIRECTION_RTL;
+	hb_script_t hbScript = hb_icu_script_to_script(textRun.script);
+	std::string language = style.language().toStdString();
+	hb_language_t hbLanguage = hb_language_from_string(language.c_str(), language.length());
+
+	hb_buffer_t *hbBuffer = hb_buffer_create();
+	hb_buffer_add_utf16(hbBuffer, m_text.utf16(), m_text.length(), textRun.start, textRun.len);
+	hb_buffer_set_direction(hbBuffer, hbDirection);
+	hb_buffer_set_script(hbBuffer, hbScript);
+	hb_buffer_set_language(hbBuffer, hbLanguage);
+	hb_buffer_set_cluster_level(hbBuffer, HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS);
+
+	QVector<hb_feature_t> hbFeatures;
+	for (const FeaturesRun& featuresRun : featuresRuns)
+	{
+		const QStringList& features = featuresRun.features;
+		hbFeatures.reserve(features.length());
+		for (const QString& feature : features)
+		{
+			hb_feature_t hbFeature;
+			std::string strFeature(feature.toStdString());
+			hb_bool_t ok = hb_feature_from_string(strFeature.c_str(), strFeature.length(), &hbFeature);
+			if (ok)
+			{
+				hbFeature.start = featuresRun.start;
+				hbFeature.end = featuresRun.len + featuresRun.start;
+				hbFeatures.append(hbFeature);
+			}
+		}
+	}
+
+	// #14523: harfbuzz proritize graphite for graphite enabled fonts, however
+	// at the point, shaping with graphite fonts is either buggy (harfbuzz 1.4.2)
+	// or trigger weird results (harfbuzz 1.4.3), so disable graphite for now.
+	// Prevent also use of platform specific shapers for cross-platform reasons
+	const char* shapers[] = { "ot", "fallback", nullptr };
+	hb_shape_full(hbFont, hbBuffer, hbFeatures.data(), hbFeatures.length(), shapers);
+
+	unsigned int count = hb_buffer_get_length(hbBuffer);
+	hb_glyph_info_t *glyphs = hb_buffer_get_glyph_infos(hbBuffer, nullptr);
+	hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(hbBuffer, nullptr);
+
+	ShapedRunCache::GlyphList result;
+	result.reserve(count);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		ShapedRunCache::Glyph glyph;
+		glyph.codepoint = glyphs[i].codepoint;
+		glyph.cluster = glyphs[i].cluster - textRun.start;
+		glyph.xOffset = positions[i].x_offset;
+		glyph.yOffset = positions[i].y_offset;
+		glyph.xAdvance = positions[i].x_advance;
+		glyph.yAdvance = positions[i].y_advance;
+		result.append(glyph);
+	}
+	hb_buffer_destroy(hbBuffer);
+	return result;
+}
+
 ShapedText TextShaper::shape(int fromPos, int toPos)
 {
 	m_contextNeeded = false;
@@ -339,61 +413,35 @@ ShapedText TextShaper::shape(int fromPos, int toPos)
 		if (hbFont == nullptr)
 			continue;
 
-		hb_font_set_scale(hbFont, style.fontSize(), style.fontSize());
-#if HB_VERSION_ATLEAST(11, 0, 0)
-		FT_Face ftFace = hb_ft_font_get_ft_face(hbFont);
-#else
-		FT_Face ftFace = hb_ft_font_get_face(hbFont);
-#endif
-		if (ftFace)
-		{
-			FT_Set_Char_Size(ftFace, style.fontSize(), 0, 72, 0);
-			hb_ft_font_changed(hbFont);
-		}
-
 		hb_direction_t hbDirection = (textRun.dir == UBIDI_LTR) ? HB_DIRECTION_LTR : HB_DIRECTION_RTL;
-		hb_script_t hbScript = hb_icu_script_to_script(textRun.script);
-		std::string language = style.language().toStdString();
-		hb_language_t hbLanguage = hb_language_from_string(language.c_str(), language.length());
-
-		hb_buffer_t *hbBuffer = hb_buffer_create();
-		hb_buffer_add_utf16(hbBuffer, m_text.utf16(), m_text.length(), textRun.start, textRun.len);
-		hb_buffer_set_direction(hbBuffer, hbDirection);
-		hb_buffer_set_script(hbBuffer, hbScript);
-		hb_buffer_set_language(hbBuffer, hbLanguage);
-		hb_buffer_set_cluster_level(hbBuffer, HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS);
-
-		QVector<hb_feature_t> hbFeatures;
 		const QList<FeaturesRun> featuresRuns = itemizeFeatures(textRun);
+
+		// HarfBuzz only looks at a few characters around the run, runs with the same
+		// text, context, font and parameters give the same glyphs wherever they are
+		ShapedRunCache::Key cacheKey;
+		int contextStart = qMax(0, textRun.start - 2 * HB_BUFFER_MAX_CONTEXT_LENGTH);
+		int contextEnd = qMin(static_cast<int>(m_text.length()), textRun.start + textRun.len + 2 * HB_BUFFER_MAX_CONTEXT_LENGTH);
+		cacheKey.text = m_text.mid(contextStart, contextEnd - contextStart);
+		cacheKey.runStart = textRun.start - contextStart;
+		cacheKey.runLength = textRun.len;
+		cacheKey.fontPath = scFace.fontPath();
+		cacheKey.fontSize = style.fontSize();
+		cacheKey.language = style.language();
+		cacheKey.script = static_cast<int>(textRun.script);
+		cacheKey.direction = textRun.dir;
 		for (const FeaturesRun& featuresRun : featuresRuns)
+			cacheKey.features += QString("%1:%2:%3;").arg(featuresRun.features.join(",")).arg(featuresRun.start - textRun.start).arg(featuresRun.len);
+
+		ShapedRunCache::GlyphList glyphs;
+		if (!ShapedRunCache::instance().find(cacheKey, glyphs))
 		{
-			const QStringList& features = featuresRun.features;
-			hbFeatures.reserve(features.length());
-			for (const QString& feature : features)
-			{
-				hb_feature_t hbFeature;
-				std::string strFeature(feature.toStdString());
-				hb_bool_t ok = hb_feature_from_string(strFeature.c_str(), strFeature.length(), &hbFeature);
-				if (ok)
-				{
-					hbFeature.start = featuresRun.start;
-					hbFeature.end = featuresRun.len + featuresRun.start;
-					hbFeatures.append(hbFeature);
-				}
-			}
+			glyphs = shapeRun(textRun, style, hbFont, featuresRuns);
+			ShapedRunCache::instance().insert(cacheKey, glyphs);
 		}
+		for (ShapedRunCache::Glyph& glyph : glyphs)
+			glyph.cluster += textRun.start;
 
-		// #14523: harfbuzz proritize graphite for graphite enabled fonts, however
-		// at the point, shaping with graphite fonts is either buggy (harfbuzz 1.4.2)
-		// or trigger weird results (harfbuzz 1.4.3), so disable graphite for now.
-		// Prevent also use of platform specific shapers for cross-platform reasons
-		const char* shapers[] = { "ot", "fallback", nullptr };
-		hb_shape_full(hbFont, hbBuffer, hbFeatures.data(), hbFeatures.length(), shapers);
-
-		unsigned int count = hb_buffer_get_length(hbBuffer);
-		hb_glyph_info_t *glyphs = hb_buffer_get_glyph_infos(hbBuffer, nullptr);
-		hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(hbBuffer, nullptr);
-
+		unsigned int count = glyphs.count();
 		result.glyphs().reserve(result.glyphs().size() + count);
 		for (size_t i = 0; i < count; )
 		{
@@ -490,15 +538,15 @@ ShapedText TextShaper::shape(int fromPos, int toPos)
 					gl.glyph = scFace.emulateGlyph(ch.unicode());
 
 					GlyphMetrics metrics = scFace.glyphBBox(gl.glyph, style.fontSize());
-					positions[i].x_advance = metrics.width;
+					glyphs[i].xAdvance = metrics.width;
 				}
 
 				if (gl.glyph < ScFace::CONTROL_GLYPHS)
 				{
-					gl.xoffset = positions[i].x_offset / 10.0;
-					gl.yoffset = -positions[i].y_offset / 10.0;
-					gl.xadvance = positions[i].x_advance / 10.0;
-					gl.yadvance = positions[i].y_advance / 10.0;
+					gl.xoffset = glyphs[i].xOffset / 10.0;
+					gl.yoffset = -glyphs[i].yOffset / 10.0;
+					gl.xadvance = glyphs[i].xAdvance / 10.0;
+					gl.yadvance = glyphs[i].yAdvance / 10.0;
 				}
 
 #if 0
@@ -660,8 +708,6 @@ ShapedText TextShaper::shape(int fromPos, int toPos)
 
 			result.glyphs().append(run);
 		}
-		hb_buffer_destroy(hbBuffer);
-
 	}
 
 	m_textMap.clear();
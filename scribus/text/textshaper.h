@@ -10,8 +10,12 @@
 
 #include "itextsource.h"
 #include "itextcontext.h"
+#include "shapedruncache.h"
 #include "shapedtext.h"
 
+struct hb_font_t;
+
+class CharStyle;
 class GlyphCluster;
 class StoryText;
 class PageItem;
@@ -60,6 +64,9 @@ private:
 	QList<TextRun> itemizeStyles(const QList<TextRun> &runs) const;
 	QList<FeaturesRun> itemizeFeatures(const TextRun &run) const;
 
+	/// Shapes a run with HarfBuzz, clusters of the returned glyphs are relative to the run start
+	ShapedRunCache::GlyphList shapeRun(const TextRun& textRun, const CharStyle& style, hb_font_t* hbFont, const QList<FeaturesRun>& featuresRuns) const;
+
 	ITextContext* m_context { nullptr };
 	bool m_contextNeeded { false };
 	ITextSource& m_story;
@@ -0,0 +1,155 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <QElapsedTimer>
+#include <QRectF>
+
+#include "textlayoutscheduler.h"
+#include "pageitem_textframe.h"
+#include "scribusdoc.h"
+
+TextLayoutScheduler::TextLayoutScheduler(ScribusDoc* doc) :
+	m_doc(doc)
+{
+	m_timer.setSingleShot(true);
+	m_timer.setInterval(0);
+	connect(&m_timer, &QTimer::timeout, this, &TextLayoutScheduler::layoutNextFrames);
+}
+
+bool TextLayoutScheduler::isReadyForDrawing(PageItem_TextFrame* frame)
+{
+	if (!frame->invalid)
+		return true;
+	if (m_outputDepth > 0)
+		return true;
+	// Frames on master pages are laid out for each page they are drawn on,
+	// notes require the layout of their master frames before anything is drawn
+	if (!frame->OnMasterPage.isEmpty() || frame->isNoteFrame() || !m_doc->notesList().isEmpty())
+		return true;
+
+	int invalidFrames = 0;
+	PageItem* item = frame;
+	while (item != nullptr)
+	{
+		if (item->invalid && (++invalidFrames > m_maxSynchronousFrames))
+		{
+			schedule(frame);
+			return false;
+		}
+		item = item->prevInChain();
+	}
+	return true;
+}
+
+void TextLayoutScheduler::schedule(PageItem_TextFrame* frame)
+{
+	PageItem_TextFrame* firstFrame = firstFrameOfChain(frame);
+	if (!m_chains.contains(firstFrame))
+		m_chains.append(firstFrame);
+	if (!m_timer.isActive() && !isSuspended())
+		m_timer.start();
+}
+
+void TextLayoutScheduler::beginOutput()
+{
+	if (m_outputDepth++ == 0)
+		layoutAll();
+}
+
+void TextLayoutScheduler::endOutput()
+{
+	if (--m_outputDepth == 0)
+		resume();
+}
+
+void TextLayoutScheduler::layoutAll()
+{
+	m_timer.stop();
+	QRectF updateRect;
+	while (PageItem_TextFrame* frame = nextInvalidFrame())
+	{
+		frame->layout();
+		if (frame->invalid)
+			m_chains.removeFirst();
+		else
+			updateRect = updateRect.united(frame->getVisualBoundingRect());
+	}
+	if (!updateRect.isNull())
+		m_doc->regionsChanged()->update(updateRect.adjusted(-5.0, -5.0, 5.0, 5.0));
+}
+
+void TextLayoutScheduler::resume()
+{
+	if (!m_chains.isEmpty() && !m_timer.isActive() && !isSuspended())
+		m_timer.start();
+}
+
+bool TextLayoutScheduler::isSuspended() const
+{
+	// The document is loading, or pages are rendered for output which lays out frames itself
+	return m_doc->isLoading() || (m_outputDepth > 0);
+}
+
+PageItem_TextFrame* TextLayoutScheduler::firstFrameOfChain(PageItem_TextFrame* frame)
+{
+	PageItem* item = frame;
+	while (item->prevInChain() != nullptr)
+		item = item->prevInChain();
+	return item->asTextFrame();
+}
+
+PageItem_TextFrame* TextLayoutScheduler::nextInvalidFrame()
+{
+	while (!m_chains.isEmpty())
+	{
+		PageItem_TextFrame* frame = m_chains.first();
+		// Frames may have been deleted or relinked since the chain was queued
+		if (frame != nullptr)
+			frame = firstFrameOfChain(frame);
+		while ((frame != nullptr) && !frame->invalid)
+		{
+			PageItem* next = frame->nextInChain();
+			frame = (next != nullptr) ? next->asTextFrame() : nullptr;
+		}
+		if (frame != nullptr)
+			return frame;
+		m_chains.removeFirst();
+	}
+	return nullptr;
+}
+
+void TextLayoutScheduler::layoutNextFrames()
+{
+	// Resumed by ScribusDoc::setLoading() or endOutput()
+	if (isSuspended())
+		return;
+
+	QRectF updateRect;
+	QElapsedTimer timer;
+	timer.start();
+	while (timer.elapsed() < m_timeSlice)
+	{
+		PageItem_TextFrame* frame = nextInvalidFrame();
+		if (frame == nullptr)
+			break;
+
+		// Previous frames are valid, this lays out only the frame itself
+		frame->layout();
+		if (frame->invalid)
+		{
+			// Layout is not possible right now, drawing will queue the chain again
+			m_chains.removeFirst();
+			continue;
+		}
+		updateRect = updateRect.united(frame->getVisualBoundingRect());
+	}
+
+	if (!updateRect.isNull())
+		m_doc->regionsChanged()->update(updateRect.adjusted(-5.0, -5.0, 5.0, 5.0));
+	if (!m_chains.isEmpty())
+		m_timer.start();
+}
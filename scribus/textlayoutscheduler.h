@@ -0,0 +1,86 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef TEXTLAYOUTSCHEDULER_H
+#define TEXTLAYOUTSCHEDULER_H
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include "scribusapi.h"
+
+class PageItem_TextFrame;
+class ScribusDoc;
+
+/**
+ * \brief Lays out long text chains in small steps from the event loop.
+ *
+ * Drawing a text frame lays out every invalid frame before it in its chain, so after
+ * a global style change the first paint of a frame at the end of a long book chain
+ * blocks until the whole chain is laid out. The canvas asks the scheduler before drawing
+ * a text frame: frames needing little work are laid out synchronously as before, for the
+ * others the chain is queued and the frame is drawn without its text. The scheduler then
+ * lays out the queued chains frame by frame, each step taking at most a time slice of the
+ * event loop, and requests a repaint of every frame it completed.
+ *
+ * Layout still runs on the GUI thread: it reads and writes the frames, the document styles
+ * and the font caches, none of which may be accessed from another thread.
+ */
+class SCRIBUS_API TextLayoutScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit TextLayoutScheduler(ScribusDoc* doc);
+
+	/**
+	 * \brief Checks whether a frame can be drawn without laying out a large part of its chain.
+	 * Returns true if at most a few frames up to and including \a frame
+	 * need layout, drawing the frame then lays them out as usual. Otherwise the chain is
+	 * queued for layout and false is returned, the caller should draw the frame without text.
+	 */
+	bool isReadyForDrawing(PageItem_TextFrame* frame);
+
+	/// Queues the chain of \a frame for layout from the event loop
+	void schedule(PageItem_TextFrame* frame);
+
+	/**
+	 * \brief Starts rendering pages for output, e.g. page previews or bitmap export.
+	 * Queued chains are laid out now and isReadyForDrawing() accepts every frame until
+	 * the matching endOutput(), so that no frame is rendered without its text.
+	 */
+	void beginOutput();
+	void endOutput();
+
+	/// Lays out all queued chains now
+	void layoutAll();
+	/// Resumes layout of queued chains from the event loop, after the document was loaded
+	void resume();
+
+private slots:
+	void layoutNextFrames();
+
+private:
+	ScribusDoc* m_doc { nullptr };
+	QList<QPointer<PageItem_TextFrame> > m_chains;
+	QTimer m_timer;
+	// Number of invalid frames drawing may lay out synchronously
+	int m_maxSynchronousFrames { 4 };
+	// Time in milliseconds after which a layout step returns to the event loop
+	int m_timeSlice { 20 };
+	// Nesting depth of beginOutput() calls
+	int m_outputDepth { 0 };
+
+	static PageItem_TextFrame* firstFrameOfChain(PageItem_TextFrame* frame);
+	/// Returns the first invalid frame of the first queued chain, dropping chains without any
+	PageItem_TextFrame* nextInvalidFrame();
+	bool isSuspended() const;
+};
+
+#endif // TEXTLAYOUTSCHEDULER_H
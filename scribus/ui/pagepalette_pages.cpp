@@ -25,6 +25,7 @@ for which a new license (GPL+exception) is in place.
 #include "ui/widgets/pagelayout.h"
 #include "pagepalette_pages.h"
 #include "pagepalette_widgets.h"
+#include "pagethumbnailcache.h"
 #include "prefsmanager.h"
 #include "qobjectdefs.h"
 #include "scpage.h"
@@ -199,6 +200,7 @@ void PagePalette_Pages::pageView_updatePagePreview()
 
 	if (pageViewWidget->pageGrid()->rowHeight() == PageGrid::Small)
 	{
+		currView->m_doc->pageThumbnailCache()->setThumbnailHeight(0);
 		for (int i = 0; i < currView->m_doc->DocPages.count(); ++i)
 		{
 			if (i < pageViewWidget->pageGrid()->pageList.count())
@@ -214,16 +216,17 @@ void PagePalette_Pages::pageView_updatePagePreview()
 	}
 	else
 	{
-		PageToPixmapFlags flags = Pixmap_DrawFrame | Pixmap_DrawBackground | Pixmap_DontReloadImages | Pixmap_NoCanvasModeChange | Pixmap_NoCMSSettingsChange;
-		QMap<int, QImage> previews = currView->PagesToPixmap(pageViewWidget->pageGrid()->pageHeight() * devicePixelRatio(), -1, flags);
+		// Outdated thumbnails are rendered again by the cache, which reports them one by one
+		PageThumbnailCache* thumbnailCache = currView->m_doc->pageThumbnailCache();
+		thumbnailCache->setThumbnailHeight(thumbnailHeight());
 
 		for (int i = 0; i < currView->m_doc->DocPages.count(); ++i)
 		{
-			if (previews.contains(i) && i < pageViewWidget->pageGrid()->pageList.count())
+			if (i < pageViewWidget->pageGrid()->pageList.count())
 			{
 				ScPage page = *currView->m_doc->DocPages.at(i);
 				double pageRatio = page.width() / page.height();
-				QPixmap pix = ( previews.contains(i) ) ? QPixmap::fromImage( previews.value(i) ) : QPixmap();
+				QPixmap pix = QPixmap::fromImage(thumbnailCache->thumbnail(i));
 				pix.setDevicePixelRatio(devicePixelRatio());
 
 				PageCell *pc = pageViewWidget->pageGrid()->pageList.at(i);
@@ -239,6 +242,21 @@ void PagePalette_Pages::pageView_updatePagePreview()
 
 }
 
+void PagePalette_Pages::pageView_updatePageThumbnail(int pageIndex)
+{
+	if (currView == nullptr || pageViewWidget->pageGrid()->rowHeight() == PageGrid::Small)
+		return;
+	if (pageIndex < 0 || pageIndex >= pageViewWidget->pageGrid()->pageList.count())
+		return;
+
+	QPixmap pix = QPixmap::fromImage(currView->m_doc->pageThumbnailCache()->thumbnail(pageIndex));
+	pix.setDevicePixelRatio(devicePixelRatio());
+
+	PageCell *pc = pageViewWidget->pageGrid()->pageList.at(pageIndex);
+	pc->pagePreview = pix;
+	pageViewWidget->pageGrid()->update();
+}
+
 void PagePalette_Pages::updatePagePreview()
 {
 	if (currView == nullptr || pageViewWidget->pageGrid()->pageList.empty())
@@ -392,9 +410,10 @@ void PagePalette_Pages::rebuildPages()
 //	QElapsedTimer timer;
 //	timer.start();
 
-	// Create all page previews
-	PageToPixmapFlags flags = Pixmap_DrawFrame | Pixmap_DrawBackground | Pixmap_DontReloadImages | Pixmap_NoCanvasModeChange;
-	QMap<int, QImage> previews = currView->PagesToPixmap(pageViewWidget->pageGrid()->pageHeight(), -1, flags);
+	// Take page previews from the thumbnail cache, missing ones are rendered later
+	bool showPreviews = (pageViewWidget->pageGrid()->rowHeight() != PageGrid::Small);
+	PageThumbnailCache* thumbnailCache = currView->m_doc->pageThumbnailCache();
+	thumbnailCache->setThumbnailHeight(showPreviews ? thumbnailHeight() : 0);
 
 	for (int i = 0; i < currView->m_doc->DocPages.count(); ++i)
 	{
@@ -403,10 +422,17 @@ void PagePalette_Pages::rebuildPages()
 		if (sectionNumber.isEmpty())
 			sectionNumber = sectionNumber.setNum(i + 1);
 
+		QPixmap pix;
+		if (showPreviews)
+		{
+			pix = QPixmap::fromImage(thumbnailCache->thumbnail(i));
+			pix.setDevicePixelRatio(devicePixelRatio());
+		}
+
 		PageCell *pc = new PageCell(
 			page.masterPageName(),
 			i, sectionNumber,
-			(previews.contains(i)) ? QPixmap::fromImage(previews.value(i)) : QPixmap(),
+			pix,
 			page.width() / page.height()
 		);
 		pageViewWidget->pageGrid()->pageList.append(pc);
@@ -452,10 +478,13 @@ void PagePalette_Pages::setView(ScribusView *view)
 		return;
 
 	currView = view;
+	disconnect(m_thumbnailConnection);
 
 	if (currView == nullptr)
 		return;
 
+	m_thumbnailConnection = connect(view->m_doc->pageThumbnailCache(), &PageThumbnailCache::thumbnailChanged, this, &PagePalette_Pages::pageView_updatePageThumbnail);
+
 	pageViewWidget->pageGrid()->setSelectionColor(PrefsManager::instance().appPrefs.displayPrefs.pageBorderColor);
 	pageViewWidget->pageGrid()->setBindingDirection(view->m_doc->docBindingDirection());
 
@@ -464,6 +493,11 @@ void PagePalette_Pages::setView(ScribusView *view)
 
 }
 
+int PagePalette_Pages::thumbnailHeight()
+{
+	return qRound(pageViewWidget->pageGrid()->pageHeight() * devicePixelRatio());
+}
+
 void PagePalette_Pages::selMasterPage()
 {
 	if (masterPageList->m_currItem == nullptr)
@@ -51,6 +51,7 @@ private slots:
 	void pageView_gotoPage(int pageID, int b);
 	void pageView_deletePage(int pageIndex);
 	void pageView_updatePagePreview();
+	void pageView_updatePageThumbnail(int pageIndex);
 
 	void newPage();
 	void duplicatePage();
@@ -66,8 +67,10 @@ protected:
 	ScribusView       *currView { nullptr};
 	ScribusMainWindow *m_scMW { nullptr};
 	bool m_pagePreviewUpdatePending {true};
+	QMetaObject::Connection m_thumbnailConnection;
 
 //	QPixmap createPagePreview(const QPixmap& pixin, QSize size);
+	int thumbnailHeight();
 
 	void changeEvent(QEvent *e) override;
 };
@@ -64,6 +64,8 @@ PicStatus::PicStatus(QWidget* parent, ScribusDoc *docu) : QDialog( parent )
 	imageViewArea->setIconSize(QSize(128, 128));
 	imageViewArea->setContextMenuPolicy(Qt::CustomContextMenu);
 	m_Doc = docu;
+	// Images of large documents are loaded on demand, the image list shows all of them
+	m_Doc->imageLoadScheduler()->loadAll();
 	setWindowIcon(IconManager::instance().loadIcon("app-icon"));
 	fillTable();
 	workTab->setCurrentIndex(0);
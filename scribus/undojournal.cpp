@@ -0,0 +1,58 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#include <QDataStream>
+#include <QDir>
+
+#include "undojournal.h"
+
+qint64 UndoJournal::write(const QByteArray& data)
+{
+	if (m_failed)
+		return -1;
+	if (!m_file.isOpen())
+	{
+		m_file.setFileTemplate(QDir::tempPath() + "/scribus_undo_XXXXXX");
+		if (!m_file.open())
+		{
+			m_failed = true;
+			return -1;
+		}
+	}
+
+	QByteArray compressed = qCompress(data);
+	if (!m_file.seek(m_size))
+		return -1;
+	QDataStream stream(&m_file);
+	stream << compressed;
+	if (stream.status() != QDataStream::Ok)
+	{
+		// Whatever was partially written is overwritten by the next record
+		m_file.seek(m_size);
+		return -1;
+	}
+	qint64 record = m_size;
+	m_size = m_file.pos();
+	return record;
+}
+
+QByteArray UndoJournal::read(qint64 record)
+{
+	if (record == m_cachedRecord)
+		return m_cachedData;
+	if (!m_file.isOpen() || (record < 0) || (record >= m_size) || !m_file.seek(record))
+		return QByteArray();
+
+	QByteArray compressed;
+	QDataStream stream(&m_file);
+	stream >> compressed;
+	if (stream.status() != QDataStream::Ok)
+		return QByteArray();
+	m_cachedRecord = record;
+	m_cachedData = qUncompress(compressed);
+	return m_cachedData;
+}
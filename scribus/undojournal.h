@@ -0,0 +1,55 @@
+/*
+For general Scribus (>=1.3.2) copyright and licensing information please refer
+to the COPYING file provided with the program. Following this notice may exist
+a copyright and/or license notice that predates the release of Scribus 1.3.2
+for which a new license (GPL+exception) is in place.
+*/
+
+#ifndef UNDOJOURNAL_H
+#define UNDOJOURNAL_H
+
+#include <QByteArray>
+#include <QTemporaryFile>
+
+#include "scribusapi.h"
+
+/**
+ * @brief Compressed temporary file holding the data of old undo states.
+ *
+ * When the undo history of a document exceeds its memory budget, the values of its
+ * oldest states are moved to the journal, see UndoStack. Records are compressed
+ * when written and read back when a state is undone or redone. The file is removed
+ * when the journal is destroyed, together with the undo stack owning it.
+ */
+class SCRIBUS_API UndoJournal
+{
+public:
+	UndoJournal() = default;
+	UndoJournal(const UndoJournal&) = delete;
+	UndoJournal& operator=(const UndoJournal&) = delete;
+
+	/**
+	 * @brief Appends a record to the journal.
+	 * @return position of the record, -1 if it could not be written
+	 */
+	qint64 write(const QByteArray& data);
+	/**
+	 * @brief Reads back the record written at position @a record.
+	 * @return the record data, an empty array on failure
+	 */
+	QByteArray read(qint64 record);
+
+	/** @brief Size of the journal file */
+	qint64 size() const { return m_size; }
+
+private:
+	QTemporaryFile m_file;
+	qint64 m_size { 0 };
+	bool m_failed { false };
+
+	// Records are read in batches, usually several times in a row
+	qint64 m_cachedRecord { -1 };
+	QByteArray m_cachedData;
+};
+
+#endif // UNDOJOURNAL_H
@@ -275,6 +275,8 @@ void UndoManager::switchStack(const QString& stackName)
 		m_stacks[m_currentDoc] = UndoStack();
 
 	m_stacks[m_currentDoc].setMaxSize(prefs_->getInt("historylength", 100));
+	// Budget in MiB, values of older states are moved to a journal on disk beyond it
+	m_stacks[m_currentDoc].setMemoryBudget(static_cast<qint64>(prefs_->getInt("historymemorylimit", 64)) * 1024 * 1024);
 	for (size_t i = 0; i < m_undoGuis.size(); ++i)
 		setState(m_undoGuis[i]);
 
@@ -361,7 +363,7 @@ void UndoManager::action(UndoObject* target, UndoState* state, QPixmap *targetPi
 	{
 //		qDebug() << "UndoManager: Action executed:" << target->getUName() << state->getName();
 		state->setUndoObject(target);
-		if (m_stacks[m_currentDoc].action(state))
+		for (uint popped = m_stacks[m_currentDoc].action(state); popped > 0; --popped)
 			emit popBack();
 	}
 	if (targetPixmap)
@@ -392,9 +394,11 @@ void UndoManager::undo(int steps)
 
 	emit undoRedoBegin();
 	setUndoEnabled(false);
+	// Fewer steps are done if a state cannot be read back from the undo journal
+	uint undoItems = m_stacks[m_currentDoc].undoItems();
 	m_stacks[m_currentDoc].undo(steps, m_currentUndoObjectId);
 	setUndoEnabled(true);
-	emit undoSignal(steps);
+	emit undoSignal(undoItems - m_stacks[m_currentDoc].undoItems());
 	emit undoRedoDone();
 	setTexts();
 }
@@ -406,9 +410,10 @@ void UndoManager::redo(int steps)
 
 	emit undoRedoBegin();
 	setUndoEnabled(false);
+	uint redoItems = m_stacks[m_currentDoc].redoItems();
 	m_stacks[m_currentDoc].redo(steps, m_currentUndoObjectId);
 	setUndoEnabled(true);
-	emit redoSignal(steps);
+	emit redoSignal(redoItems - m_stacks[m_currentDoc].redoItems());
 	emit undoRedoDone();
 	setTexts();
 }
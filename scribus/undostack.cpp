@@ -24,22 +24,32 @@ for which a new license (GPL+exception) is in place.
  *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
  ***************************************************************************/
 
+#include "undojournal.h"
 #include "undomanager.h"
 #include "undoobject.h"
 #include "undostack.h"
+#include "undostate.h"
+
+namespace
+{
+	// Number of states whose values form one compressed journal record
+	const size_t journalBatchSize = 32;
+}
 
 UndoStack::UndoStack(int maxSize) : m_maxSize(maxSize)
 {
 
 }
 
-bool UndoStack::action(UndoState *state)
+uint UndoStack::action(UndoState *state)
 {
 	m_redoActions.clear();
 	m_undoActions.insert(m_undoActions.begin(), state);
-	bool needsPopping = checkSize(); // only store maxSize_ amount of actions
+	m_memoryUsed += state->memorySize();
+	uint popped = checkSize(); // only store maxSize_ amount of actions
+	popped += checkMemory();
 
-	return needsPopping;
+	return popped;
 }
 
 bool UndoStack::undo(uint steps, int objectId)
@@ -47,11 +57,9 @@ bool UndoStack::undo(uint steps, int objectId)
 	for (uint i = 0; i < steps && !m_undoActions.empty(); ++i)
 	{
 		UndoState *tmpUndoState = nullptr;
+		auto found = m_undoActions.end();
 		if (objectId == Um::GLOBAL_UNDO_MODE)
-		{
-			tmpUndoState = m_undoActions[0];
-			m_undoActions.erase(m_undoActions.begin());
-		}
+			found = m_undoActions.begin();
 		else
 		{
 			// object specific mode (search the correct state)
@@ -60,8 +68,7 @@ bool UndoStack::undo(uint steps, int objectId)
 				UndoObject *tmp = (*it)->undoObject();
 				if (tmp && tmp->getUId() == static_cast<ulong>(objectId))
 				{
-					tmpUndoState = *it;
-					m_undoActions.erase(it);
+					found = it;
 					break;
 				}
 				if ((*it)->isTransaction())
@@ -69,13 +76,20 @@ bool UndoStack::undo(uint steps, int objectId)
 					TransactionState *ts = dynamic_cast<TransactionState*>(*it);
 					if(ts && ts->containsOnly(objectId))
 					{
-						tmpUndoState = *it;
-						m_undoActions.erase(it);
+						found = it;
 						break;
 					}
 				}
 			}
 		}
+		if (found != m_undoActions.end())
+		{
+			// States whose data is lost in the journal stay where they are
+			if (!(*found)->swapIn())
+				return false;
+			tmpUndoState = *found;
+			m_undoActions.erase(found);
+		}
 		if (tmpUndoState)
 		{
 			m_redoActions.insert(m_redoActions.begin(), tmpUndoState); // push to the redo actions
@@ -90,11 +104,9 @@ bool UndoStack::redo(uint steps, int objectId)
 	for (uint i = 0; i < steps && !m_redoActions.empty(); ++i)
 	{
 		UndoState *tmpRedoState = nullptr;
+		auto found = m_redoActions.end();
 		if (objectId == Um::GLOBAL_UNDO_MODE)
-		{
-			tmpRedoState = m_redoActions[0];
-			m_redoActions.erase(m_redoActions.begin());
-		}
+			found = m_redoActions.begin();
 		else
 		{ // object specific mode (search the correct state)
 			StateList::iterator it;
@@ -103,8 +115,7 @@ bool UndoStack::redo(uint steps, int objectId)
 				UndoObject *tmp = (*it)->undoObject();
 				if (tmp && tmp->getUId() == static_cast<ulong>(objectId))
 				{
-					tmpRedoState = *it;
-					m_redoActions.erase(it);
+					found = it;
 					break;
 				}
 				if((*it)->isTransaction())
@@ -112,13 +123,20 @@ bool UndoStack::redo(uint steps, int objectId)
 					TransactionState *ts = dynamic_cast<TransactionState*>(*it);
 					if(ts && ts->containsOnly(objectId))
 					{
-						tmpRedoState = *it;
-						m_redoActions.erase(it);
+						found = it;
 						break;
 					}
 				}
 			}
 		}
+		if (found != m_redoActions.end())
+		{
+			// States whose data is lost in the journal stay where they are
+			if (!(*found)->swapIn())
+				return false;
+			tmpRedoState = *found;
+			m_redoActions.erase(found);
+		}
 		if (tmpRedoState)
 		{
 			m_undoActions.insert(m_undoActions.begin(), tmpRedoState); // push to the undo actions
@@ -154,22 +172,178 @@ void UndoStack::setMaxSize(uint maxSize)
 	checkSize(); // we may need to remove actions
 }
 
-bool UndoStack::checkSize()
+uint UndoStack::checkSize()
 {
 	if (m_maxSize == 0) // 0 marks for infinite stack size
-		return false;
+		return 0;
 
-	bool needsPopping = size () > m_maxSize;
+	// With a memory budget, undo actions past the maximum size are moved to the journal
+	// instead of being dropped
+	if (m_memoryBudget > 0)
+		return storeOldActions();
 
+	uint popped = 0;
 	while (size() > m_maxSize)
 	{
 		if (!m_redoActions.empty()) // clear redo actions first
+		{
+			delete m_redoActions.back();
 			m_redoActions.pop_back();
+		}
 		else
+		{
+			delete m_undoActions.back();
 			m_undoActions.pop_back();
+		}
+		++popped;
+	}
+	if (popped > 0)
+		m_memoryUsed = computeMemoryUsed();
+
+	return popped;
+}
+
+bool UndoStack::canStore(const UndoState* state)
+{
+	if (state->isTransaction())
+	{
+		const auto* ts = dynamic_cast<const TransactionState*>(state);
+		for (uint i = 0; ts && i < ts->sizet(); ++i)
+		{
+			if (!canStore(ts->at(i)))
+				return false;
+		}
+		return true;
+	}
+	// States without values have nothing to store, a payload without stream operators stays in memory
+	const auto* ss = dynamic_cast<const SimpleState*>(state);
+	return !ss || ss->isSwappedOut() || ss->isEmpty() || ss->canSwapOut();
+}
+
+uint UndoStack::storeOldActions()
+{
+	size_t first = m_maxSize;
+	if (m_undoActions.size() <= first)
+		return 0;
+
+	if (!m_journal)
+		m_journal = std::make_shared<UndoJournal>();
+
+	// States are written in full batches, those of a partial one stay in memory
+	// until further actions complete it
+	std::vector<SimpleState*> batch;
+	size_t batchStart = first;
+	for (size_t i = first; i < m_undoActions.size(); ++i)
+	{
+		if (!canStore(m_undoActions[i]))
+			return dropOldestActions(i);
+		collectSwappableStates(m_undoActions[i], batch);
+		if (batch.size() < journalBatchSize)
+			continue;
+		qint64 freed = SimpleState::swapOut(m_journal, batch);
+		if (freed == 0)
+			return dropOldestActions(batchStart); // journal cannot be written
+		m_memoryUsed -= freed;
+		batch.clear();
+		batchStart = i + 1;
+	}
+	return 0;
+}
+
+uint UndoStack::dropOldestActions(size_t count)
+{
+	uint popped = 0;
+	while (m_undoActions.size() > count)
+	{
+		delete m_undoActions.back();
+		m_undoActions.pop_back();
+		++popped;
+	}
+	if (popped > 0)
+		m_memoryUsed = computeMemoryUsed();
+	return popped;
+}
+
+void UndoStack::setMemoryBudget(qint64 budget)
+{
+	m_memoryBudget = qMax<qint64>(budget, 0);
+	m_memoryUsed = computeMemoryUsed();
+	checkMemory();
+}
+
+qint64 UndoStack::computeMemoryUsed() const
+{
+	qint64 memoryUsed = 0;
+	for (const UndoState* state : m_undoActions)
+		memoryUsed += state->memorySize();
+	for (const UndoState* state : m_redoActions)
+		memoryUsed += state->memorySize();
+	return memoryUsed;
+}
+
+void UndoStack::collectSwappableStates(UndoState* state, std::vector<SimpleState*>& states)
+{
+	if (state->isTransaction())
+	{
+		auto* ts = dynamic_cast<TransactionState*>(state);
+		for (uint i = 0; ts && i < ts->sizet(); ++i)
+			collectSwappableStates(ts->at(i), states);
+		return;
+	}
+	auto* ss = dynamic_cast<SimpleState*>(state);
+	if (ss && ss->canSwapOut())
+		states.push_back(ss);
+}
+
+uint UndoStack::checkMemory()
+{
+	if ((m_memoryBudget == 0) || (m_memoryUsed <= m_memoryBudget))
+		return 0;
+	// States read back from the journal, or modified after being pushed, are not
+	// part of the running estimate
+	m_memoryUsed = computeMemoryUsed();
+	if (m_memoryUsed <= m_memoryBudget)
+		return 0;
+
+	if (!m_journal)
+		m_journal = std::make_shared<UndoJournal>();
+
+	// Oldest undo actions go first, then the redo actions farthest away. The next
+	// undo and redo actions are kept in memory, they are often inspected for merging.
+	StateList candidates;
+	for (size_t i = m_undoActions.size(); i > 1; --i)
+		candidates.push_back(m_undoActions[i - 1]);
+	for (size_t i = m_redoActions.size(); i > 1; --i)
+		candidates.push_back(m_redoActions[i - 1]);
+
+	// Leave some room so that the journal is not written on every action
+	const qint64 target = m_memoryBudget * 3 / 4;
+	std::vector<SimpleState*> batch;
+	for (size_t i = 0; (i < candidates.size()) && (m_memoryUsed > target); ++i)
+	{
+		collectSwappableStates(candidates[i], batch);
+		if ((batch.size() < journalBatchSize) && (i + 1 < candidates.size()))
+			continue;
+		if (batch.empty())
+			continue;
+		qint64 freed = SimpleState::swapOut(m_journal, batch);
+		if (freed == 0)
+			break; // journal cannot be written
+		m_memoryUsed -= freed;
+		batch.clear();
 	}
+	if ((m_memoryUsed <= m_memoryBudget) || (m_maxSize == 0))
+		return 0;
 
-	return needsPopping;
+	// Data which cannot be moved to the journal, e.g. copies of deleted items, still
+	// exceeds the budget. Only actions past the maximum size are dropped for it.
+	size_t count = m_undoActions.size();
+	while ((count > m_maxSize) && (m_memoryUsed > m_memoryBudget))
+	{
+		--count;
+		m_memoryUsed -= m_undoActions[count]->memorySize();
+	}
+	return dropOldestActions(count);
 }
 
 void UndoStack::clear()
@@ -180,6 +354,8 @@ void UndoStack::clear()
 		delete m_redoActions[i];
 	m_undoActions.clear();
 	m_redoActions.clear();
+	m_memoryUsed = 0;
+	m_journal.reset();
 }
 
 UndoState* UndoStack::getNextUndo(int objectId)
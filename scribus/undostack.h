@@ -27,8 +27,13 @@ for which a new license (GPL+exception) is in place.
 #ifndef UNDOSTACK_H
 #define UNDOSTACK_H
 
+#include <memory>
 #include <vector>
 
+#include <QtGlobal>
+
+class SimpleState;
+class UndoJournal;
 class UndoState;
 class TransactionState;
 
@@ -42,13 +47,15 @@ public:
 
     /* Used to push a new action to the stack. UndoState in the parameter will then
      * become the first undo action in the stack and all the redo actions will be
-     * cleared. If maximum size of the stack is hit and an action needs to be removed
-     * this function returns true. */
-    bool action(UndoState *state);
+     * cleared. Returns the number of old actions removed from the stack because the
+     * maximum size or the memory budget is exceeded. */
+    uint action(UndoState *state);
 
-    /* undo number of steps actions (these will then become redo actions) */
+    /* undo number of steps actions (these will then become redo actions), returns
+     * false if an action could not be read back from the journal and was not undone */
     bool undo(uint steps, int objectId);
-    /* redo number of steps actions (these will then become undo actions) */
+    /* redo number of steps actions (these will then become undo actions), returns
+     * false if an action could not be read back from the journal and was not redone */
     bool redo(uint steps, int objectId);
 
     /* number of actions stored in the stack mostly for testing */
@@ -67,6 +74,17 @@ public:
 
     void clear();
 
+    /* Memory budget in bytes for the states held in memory, 0 for no limit. When it
+     * is exceeded the values of the oldest states are moved to an on-disk journal,
+     * see SimpleState::swapOut(). They are read back when needed. With a budget,
+     * undo actions past the maximum size are moved to the journal too instead of
+     * being dropped. Only those which cannot be stored there are dropped, or those
+     * whose remaining memory still exceeds the budget. */
+    qint64 memoryBudget() const { return m_memoryBudget; }
+    void setMemoryBudget(qint64 budget);
+    /* estimated memory used by the states of the stack */
+    qint64 memoryUsed() const { return m_memoryUsed; }
+
     UndoState* getNextUndo(int objectId);
     UndoState* getNextRedo(int objectId);
 
@@ -80,9 +98,26 @@ private:
     /* maximum amount of actions stored, 0 for no limit */
     uint m_maxSize { 0 };
 
-    /* returns true if an action was popped from the stack */
-    /* assures that we only hold the maxSize_ number of UndoStates */
-    bool checkSize();
+    /* returns the number of actions popped from the stack */
+    /* assures that we only hold the maxSize_ number of UndoStates in memory */
+    uint checkSize();
+    /* moves undo actions past the maximum size to the journal, drops those which cannot be stored */
+    uint storeOldActions();
+    /* deletes the oldest undo actions until count are left */
+    uint dropOldestActions(size_t count);
+    static bool canStore(const UndoState* state);
+
+    qint64 m_memoryBudget { 0 };
+    /* running estimate, recomputed when the budget seems to be exceeded */
+    qint64 m_memoryUsed { 0 };
+    /* shared by copies of the stack, created when first needed */
+    std::shared_ptr<UndoJournal> m_journal;
+
+    /* moves values of the oldest states to the journal while over the memory budget,
+     * returns the number of actions dropped when that is not enough */
+    uint checkMemory();
+    qint64 computeMemoryUsed() const;
+    static void collectSwappableStates(UndoState* state, std::vector<SimpleState*>& states);
 
     friend class UndoManager; // UndoManager needs access to undoActions_ and redoActions_
                               // for updating the attached UndoGui widgets
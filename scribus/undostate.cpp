@@ -24,9 +24,69 @@ for which a new license (GPL+exception) is in place.
  *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.             *
  ***************************************************************************/
 
+#include <QDataStream>
+#include <QDebug>
+#include <QHash>
+#include <QStringList>
+
+#include "fpointarray.h"
+#include "sctextstruct.h"
+#include "text/storytext.h"
+#include "undojournal.h"
 #include "undostate.h"
 #include "undoobject.h"
 
+namespace
+{
+	// Undo states are only created on the GUI thread
+	QHash<QString, quint16>& undoKeyIds()
+	{
+		static QHash<QString, quint16> keyIds;
+		return keyIds;
+	}
+
+	qint64 variantMemorySize(const QVariant& value)
+	{
+		switch (value.typeId())
+		{
+			case QMetaType::QString:
+				return value.toString().capacity() * sizeof(QChar);
+			case QMetaType::QByteArray:
+				return value.toByteArray().capacity();
+			case QMetaType::QStringList:
+			{
+				qint64 size = 0;
+				const QStringList list = value.toStringList();
+				for (const QString& string : list)
+					size += sizeof(QString) + string.capacity() * sizeof(QChar);
+				return size;
+			}
+			default:
+				break;
+		}
+		// Values larger than the variant itself are allocated separately
+		if (value.isValid() && (value.metaType().sizeOf() > static_cast<int>(sizeof(QVariant))))
+			return value.metaType().sizeOf();
+		return 0;
+	}
+}
+
+qint64 undoHeapSize(const QString& value)
+{
+	return value.capacity() * sizeof(QChar);
+}
+
+qint64 undoHeapSize(const FPointArray& value)
+{
+	return value.capacity() * sizeof(FPoint);
+}
+
+qint64 undoHeapSize(const StoryText& value)
+{
+	// Each character is a separately allocated ScText
+	return value.length() * static_cast<qint64>(sizeof(ScText) + sizeof(ScText*));
+}
+
 UndoState::UndoState(const QString& name, const QString& description, QPixmap* pixmap) :
 	m_actionName(name),
 	m_actionDescription(description),
@@ -88,6 +148,11 @@ UndoObject* UndoState::undoObject()
 	return m_undoObject;
 }
 
+qint64 UndoState::memorySize() const
+{
+	return sizeof(*this) + (m_actionName.capacity() + m_actionDescription.capacity()) * sizeof(QChar);
+}
+
 /*** SimpleState **************************************************************/
 
 SimpleState::SimpleState(const QString& name, const QString& description, QPixmap* pixmap)
@@ -96,25 +161,78 @@ SimpleState::SimpleState(const QString& name, const QString& description, QPixma
 
 }
 
+quint16 SimpleState::internKey(const QString& key)
+{
+	QHash<QString, quint16>& keyIds = undoKeyIds();
+	auto it = keyIds.constFind(key);
+	if (it != keyIds.constEnd())
+		return it.value();
+	Q_ASSERT(keyIds.count() < 65535);
+	quint16 id = static_cast<quint16>(keyIds.count());
+	keyIds.insert(key, id);
+	return id;
+}
+
+int SimpleState::findKey(const QString& key)
+{
+	const QHash<QString, quint16>& keyIds = undoKeyIds();
+	auto it = keyIds.constFind(key);
+	if (it != keyIds.constEnd())
+		return it.value();
+	return -1;
+}
+
+const SimpleState::Value* SimpleState::findValue(const QString& key) const
+{
+	int id = findKey(key);
+	if (id < 0)
+		return nullptr;
+	swapIn();
+	for (const Value& value : m_values)
+	{
+		if (value.key == id)
+			return &value;
+	}
+	return nullptr;
+}
+
 bool SimpleState::contains(const QString& key) const
 {
-	return m_values.contains(key);
+	return findValue(key) != nullptr;
 }
 
 QVariant SimpleState::variant(const QString& key, const QVariant& def) const
 {
-	QMap<QString, QVariant>::const_iterator it = m_values.constFind(key);
-	if (it != m_values.constEnd())
-		return it.value();
+	const Value* value = findValue(key);
+	if (value)
+		return value->value;
 
 	return def;
 }
 
+void SimpleState::setVariant(const QString& key, const QVariant& value)
+{
+	quint16 id = internKey(key);
+	swapIn();
+	for (Value& existing : m_values)
+	{
+		if (existing.key == id)
+		{
+			existing.value = value;
+			return;
+		}
+	}
+	Value newValue;
+	newValue.key = id;
+	newValue.value = value;
+	m_values.push_back(newValue);
+}
+
 QString SimpleState::get(const QString& key, const QString& def) const
 {
-	QMap<QString, QVariant>::const_iterator it = m_values.constFind(key);
-	if (it != m_values.constEnd())
-		return it.value().toString();
+	const Value* value = findValue(key);
+	if (value)
+		return value->value.toString();
 
 	return def;
 }
@@ -191,47 +309,200 @@ void* SimpleState::getVoidPtr(const QString& key, void* def) const
 
 void SimpleState::set(const QString& key)
 {
-	m_values[key] = QVariant();
+	setVariant(key, QVariant());
 }
 
 void SimpleState::set(const QString& key, const QString& value)
 {
-	m_values[key] = QVariant(value);
+	setVariant(key, QVariant(value));
 }
 
 void SimpleState::set(const QString& key, bool value)
 {
-	m_values[key] = QVariant(value);
+	setVariant(key, QVariant(value));
 }
 
 void SimpleState::set(const QString& key, int value)
 {
-	m_values[key] = QVariant(value);
+	setVariant(key, QVariant(value));
 }
 
 void SimpleState::set(const QString& key, qlonglong value)
 {
-	m_values[key] = QVariant(value);
+	setVariant(key, QVariant(value));
 }
 
 void SimpleState::set(const QString& key, uint value)
 {
-	m_values[key] = QVariant(value);
+	setVariant(key, QVariant(value));
 }
 
 void SimpleState::set(const QString& key, qulonglong value)
 {
-	m_values[key] = QVariant(value);
+	setVariant(key, QVariant(value));
 }
 
 void SimpleState::set(const QString& key, double value)
 {
-	m_values[key] = QVariant(value);
+	setVariant(key, QVariant(value));
 }
 
 void SimpleState::set(const QString& key, void* ptr)
 {
-	m_values[key] = QVariant::fromValue<void*>(ptr);
+	setVariant(key, QVariant::fromValue<void*>(ptr));
+}
+
+qint64 SimpleState::memorySize() const
+{
+	qint64 size = UndoState::memorySize() - sizeof(UndoState) + sizeof(*this);
+	size += m_values.capacity() * sizeof(Value);
+	for (const Value& value : m_values)
+		size += variantMemorySize(value.value);
+	size += payloadMemorySize();
+	return size;
+}
+
+bool SimpleState::canSwapOut() const
+{
+	if (m_journalEntry || (m_values.empty() && !canSwapOutPayload()))
+		return false;
+	for (const Value& value : m_values)
+	{
+		if (value.value.isValid() && !value.value.metaType().hasRegisteredDataStreamOperators())
+			return false;
+	}
+	return true;
+}
+
+qint64 SimpleState::swapOut(const std::shared_ptr<UndoJournal>& journal, const std::vector<SimpleState*>& states)
+{
+	if (!journal || states.empty())
+		return 0;
+
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	const std::vector<Value>* previous = nullptr;
+	for (const SimpleState* state : states)
+	{
+		stream << static_cast<quint32>(state->m_values.size());
+		for (const Value& value : state->m_values)
+		{
+			// Repeated changes of an item carry values of the previous change again,
+			// e.g. the new position of a move is the old position of the next one.
+			// QVariant compares numbers by value, the type must match too.
+			int previousIndex = -1;
+			if (previous)
+			{
+				int count = qMin<int>(previous->size(), 256);
+				for (int i = 0; (i < count) && (previousIndex < 0); ++i)
+				{
+					const QVariant& previousValue = (*previous)[i].value;
+					if ((previousValue.metaType() == value.value.metaType()) && (previousValue == value.value))
+						previousIndex = i;
+				}
+			}
+			stream << value.key;
+			if (previousIndex >= 0)
+				stream << static_cast<quint8>(1) << static_cast<quint8>(previousIndex);
+			else
+				stream << static_cast<quint8>(0) << value.value;
+		}
+		// Payloads are stored as byte arrays, states read back skip those of the states before them
+		QByteArray payload;
+		bool hasPayload = state->canSwapOutPayload();
+		if (hasPayload)
+		{
+			QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+			state->writePayload(payloadStream);
+			hasPayload = (payloadStream.status() == QDataStream::Ok);
+		}
+		stream << hasPayload << payload;
+		previous = &state->m_values;
+	}
+	if (stream.status() != QDataStream::Ok)
+		return 0;
+
+	qint64 record = journal->write(data);
+	if (record < 0)
+		return 0;
+
+	qint64 freed = 0;
+	for (size_t i = 0; i < states.size(); ++i)
+	{
+		SimpleState* state = states[i];
+		freed += state->memorySize();
+		std::vector<Value>().swap(state->m_values);
+		if (state->canSwapOutPayload())
+			state->releasePayload();
+		state->m_journalEntry = std::make_unique<JournalEntry>();
+		state->m_journalEntry->journal = journal;
+		state->m_journalEntry->record = record;
+		state->m_journalEntry->index = static_cast<int>(i);
+		freed -= state->memorySize();
+	}
+	return freed;
+}
+
+bool SimpleState::swapIn() const
+{
+	if (!m_journalEntry)
+		return true;
+
+	// Values are stored relative to those of the previous state of the batch
+	QByteArray data = m_journalEntry->journal->read(m_journalEntry->record);
+	QDataStream stream(data);
+	std::vector<Value> previous;
+	std::vector<Value> values;
+	bool hasPayload = false;
+	QByteArray payload;
+	for (int i = 0; (i <= m_journalEntry->index) && (stream.status() == QDataStream::Ok); ++i)
+	{
+		quint32 count = 0;
+		stream >> count;
+		values.clear();
+		for (quint32 j = 0; (j < count) && (stream.status() == QDataStream::Ok); ++j)
+		{
+			Value value;
+			quint8 kind = 0;
+			stream >> value.key >> kind;
+			if (kind == 1)
+			{
+				quint8 previousIndex = 0;
+				stream >> previousIndex;
+				if (previousIndex >= previous.size())
+				{
+					stream.setStatus(QDataStream::ReadCorruptData);
+					break;
+				}
+				value.value = previous[previousIndex].value;
+			}
+			else
+				stream >> value.value;
+			values.push_back(value);
+		}
+		stream >> hasPayload >> payload;
+		previous.swap(values);
+	}
+	if (data.isEmpty() || (stream.status() != QDataStream::Ok))
+	{
+		// The entry is kept, the state cannot be applied but may be read again later
+		qWarning() << "UndoState: could not read back" << getName() << "from undo journal";
+		return false;
+	}
+	if (hasPayload)
+	{
+		QDataStream payloadStream(payload);
+		readPayload(payloadStream);
+		if (payloadStream.status() != QDataStream::Ok)
+		{
+			qWarning() << "UndoState: could not read back the data of" << getName() << "from undo journal";
+			releasePayload();
+			return false;
+		}
+	}
+	m_values = std::move(previous);
+	m_journalEntry.reset();
+	return true;
 }
 
 /*** TransactionState *****************************************************/
@@ -292,6 +563,23 @@ uint TransactionState::sizet() const
 	return m_size;
 }
 
+qint64 TransactionState::memorySize() const
+{
+	qint64 size = UndoState::memorySize() - sizeof(UndoState) + sizeof(*this);
+	size += m_states.capacity() * sizeof(UndoState*);
+	for (const UndoState* state : m_states)
+		size += state->memorySize();
+	return size;
+}
+
+bool TransactionState::swapIn() const
+{
+	bool success = true;
+	for (const UndoState* state : m_states)
+		success &= state->swapIn();
+	return success;
+}
+
 void TransactionState::useActionName()
 {
 	if (m_size > 0)
@@ -28,8 +28,11 @@ for which a new license (GPL+exception) is in place.
 #define UNDOSTATE_H
 
 #include <cstdint>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
+#include <QDataStream>
 #include <QMap>
 #include <QPair>
 #include <QPixmap>
@@ -40,7 +43,10 @@ for which a new license (GPL+exception) is in place.
 #include "undoobject.h"
 
 class QString;
+class FPointArray;
 class PageItem;
+class StoryText;
+class UndoJournal;
 
 /**
  * @brief UndoState describes an undoable state (action).
@@ -119,6 +125,13 @@ public:
 	virtual void setUndoObject(UndoObject *object);
 	/** @brief return the UndoObject this state belongs to */
 	virtual UndoObject* undoObject();
+	/** @brief Estimated memory used by this state, used to keep undo history within its memory budget */
+	virtual qint64 memorySize() const;
+	/**
+	 * @brief Reads back the data of this state moved to an undo journal, if any.
+	 * @return false if the data cannot be read, the state must then not be undone or redone
+	 */
+	virtual bool swapIn() const { return true; }
 
 	int transactionCode { 0 };
 
@@ -138,8 +151,11 @@ private:
 /**
  * @brief SimpleState provides a simple implementation of the UndoState.
  *
- * SimpleState uses a <code>QMap</code> to store key-value pairs that can be queried and
- * set using it's get() and set() methods.
+ * SimpleState stores key-value pairs that can be queried and set using it's get()
+ * and set() methods. Keys are interned, a state only stores a small number for each
+ * of them next to its values. Values of old states may be moved to an UndoJournal
+ * when the undo history grows too large, they are read back transparently when
+ * accessed.
  *
  * @author Riku Leino tsoots@gmail.com
  * @date December 2004
@@ -358,13 +374,111 @@ public:
 	*/
 	void set(const QString& key, void* ptr);
 
+	qint64 memorySize() const override;
+
+	/**
+	 * @brief Returns true if the values of this state can be moved to an undo journal.
+	 * States holding pointers or values without stream operators stay in memory.
+	 */
+	bool canSwapOut() const;
+	/** @brief Returns true if the values of this state are currently stored in an undo journal */
+	bool isSwappedOut() const { return m_journalEntry != nullptr; }
+	/** @brief Returns true if this state holds no values, in memory or in an undo journal */
+	bool isEmpty() const { return !m_journalEntry && m_values.empty(); }
+	/**
+	 * @brief Moves the values of @a states to @a journal as a single compressed record.
+	 * Values repeated from the previous state of the batch are stored as references to it,
+	 * the typed payload of subclasses is stored too if it has stream operators.
+	 * @return estimated number of bytes freed
+	 */
+	static qint64 swapOut(const std::shared_ptr<UndoJournal>& journal, const std::vector<SimpleState*>& states);
+	/**
+	 * @brief Reads back the values and payload of this state from the undo journal.
+	 * On failure the state keeps its journal entry and its values stay unavailable.
+	 */
+	bool swapIn() const override;
+
+protected:
+	/** @brief Estimated memory of the typed payload of subclasses */
+	virtual qint64 payloadMemorySize() const { return 0; }
+	/** @brief Returns true if subclasses have a payload which can be stored in an undo journal */
+	virtual bool canSwapOutPayload() const { return false; }
+	virtual void writePayload(QDataStream& /*stream*/) const {}
+	virtual void readPayload(QDataStream& /*stream*/) const {}
+	/** @brief Frees the payload once it is stored in an undo journal */
+	virtual void releasePayload() const {}
+
 private:
-	/** @brief QMap to store key-value pairs */
-	QMap<QString, QVariant> m_values;
+	struct Value
+	{
+		quint16 key { 0 };
+		QVariant value;
+	};
+	struct JournalEntry
+	{
+		std::shared_ptr<UndoJournal> journal;
+		qint64 record { -1 };
+		int index { 0 };
+	};
+
+	/** @brief key-value pairs, keys are ids of interned key strings */
+	mutable std::vector<Value> m_values;
+	/** @brief location of the values when they are swapped out */
+	mutable std::unique_ptr<JournalEntry> m_journalEntry;
+
+	static quint16 internKey(const QString& key);
+	static int findKey(const QString& key);
 
+	const Value* findValue(const QString& key) const;
 	QVariant variant(const QString& key, const QVariant& def) const;
+	void setVariant(const QString& key, const QVariant& value);
 };
 
+/*** Payload of typed states **************************************************************/
+
+/**
+ * @brief Estimated memory allocated by @a value outside of itself, see UndoState::memorySize().
+ * Types without an overload are assumed not to allocate anything.
+ */
+template<class T> qint64 undoHeapSize(const T&) { return 0; }
+SCRIBUS_API qint64 undoHeapSize(const QString& value);
+SCRIBUS_API qint64 undoHeapSize(const FPointArray& value);
+SCRIBUS_API qint64 undoHeapSize(const StoryText& value);
+template<class T> qint64 undoHeapSize(const QList<T>& list);
+template<class T1, class T2> qint64 undoHeapSize(const std::pair<T1, T2>& pair);
+template<class K, class V> qint64 undoHeapSize(const QMap<K, V>& map);
+
+template<class T> qint64 undoHeapSize(const QList<T>& list)
+{
+	qint64 size = list.capacity() * sizeof(T);
+	if constexpr (!std::is_arithmetic_v<T> && !std::is_pointer_v<T>)
+	{
+		for (const T& value : list)
+			size += undoHeapSize(value);
+	}
+	return size;
+}
+
+template<class T1, class T2> qint64 undoHeapSize(const std::pair<T1, T2>& pair)
+{
+	return undoHeapSize(pair.first) + undoHeapSize(pair.second);
+}
+
+template<class K, class V> qint64 undoHeapSize(const QMap<K, V>& map)
+{
+	// Nodes of the red-black tree hold three pointers and a color next to the pair
+	qint64 size = map.size() * static_cast<qint64>(sizeof(K) + sizeof(V) + 4 * sizeof(void*));
+	for (auto it = map.cbegin(); it != map.cend(); ++it)
+		size += undoHeapSize(it.key()) + undoHeapSize(it.value());
+	return size;
+}
+
+/** @brief True if values of type @a T can be written to and read back from an undo journal */
+template<class T>
+constexpr bool isUndoPayloadStreamable = !std::is_pointer_v<T> &&
+	QTypeTraits::has_ostream_operator_v<QDataStream, T> &&
+	QTypeTraits::has_istream_operator_v<QDataStream, T>;
+
 /*** ItemState ***************************************************************************/
 
 template<class C>
@@ -376,11 +490,27 @@ public:
 
 	~ScItemState() override = default;
 
-	void setItem(const C &c) { item_ = c; }
-	C getItem() const { return item_; }
+	void setItem(const C &c) { swapIn(); item_ = c; }
+	C getItem() const { swapIn(); return item_; }
+
+protected:
+	qint64 payloadMemorySize() const override { return sizeof(C) + undoHeapSize(item_); }
+	bool canSwapOutPayload() const override { return isUndoPayloadStreamable<C>; }
+	void writePayload(QDataStream& stream) const override
+	{
+		if constexpr (isUndoPayloadStreamable<C>)
+			stream << item_;
+	}
+	void readPayload(QDataStream& stream) const override
+	{
+		if constexpr (isUndoPayloadStreamable<C>)
+			stream >> item_;
+	}
+	void releasePayload() const override { item_ = C(); }
 
 private:
-	C item_;
+	// Read back from the undo journal on access
+	mutable C item_;
 };
 
 /**** ItemsState for list of pointers to items *****/
@@ -416,16 +546,37 @@ public:
 
 	void setStates(const C& oldState, const C& newState)
 	{
+		swapIn();
 		m_oldState = oldState;
 		m_newState = newState;
 	}
 
-	const C& getOldState() const { return m_oldState; }
-	const C& getNewState() const { return m_newState; }
+	const C& getOldState() const { swapIn(); return m_oldState; }
+	const C& getNewState() const { swapIn(); return m_newState; }
+
+protected:
+	qint64 payloadMemorySize() const override { return 2 * sizeof(C) + undoHeapSize(m_oldState) + undoHeapSize(m_newState); }
+	bool canSwapOutPayload() const override { return isUndoPayloadStreamable<C>; }
+	void writePayload(QDataStream& stream) const override
+	{
+		if constexpr (isUndoPayloadStreamable<C>)
+			stream << m_oldState << m_newState;
+	}
+	void readPayload(QDataStream& stream) const override
+	{
+		if constexpr (isUndoPayloadStreamable<C>)
+			stream >> m_oldState >> m_newState;
+	}
+	void releasePayload() const override
+	{
+		m_oldState = C();
+		m_newState = C();
+	}
 
 private:
-	C m_oldState;
-	C m_newState;
+	// Read back from the undo journal on access
+	mutable C m_oldState;
+	mutable C m_newState;
 };
 
 /*** TransactionState ********************************************************************/
@@ -504,6 +655,9 @@ public:
 	/** @brief redo all UndoStates in this transaction */
 	void redo();
 
+	qint64 memorySize() const override;
+	bool swapIn() const override;
+
 private:
 	/** @brief Number of undo states stored in this transaction */
 	uint m_size { 0 };
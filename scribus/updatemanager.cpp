@@ -19,10 +19,15 @@ void UpdateManager::setUpdatesEnabled(bool val)
 		{
 			if (--m_updatesDisabled == 0)
 			{
-				foreach(PendingUpdate pair, m_pending) {
-					pair.first->updateNow(pair.second);
+				QList<PendingUpdate> pending;
+				pending.swap(m_pending);
+				m_pendingIndexes.clear();
+				for (const PendingUpdate& pair : std::as_const(pending))
+				{
+					// Updates about deleted subjects have been removed
+					if (pair.second)
+						pair.first->updateNow(pair.second);
 				}
-				m_pending.clear();
 			}
 		}
 	}
@@ -36,6 +41,32 @@ bool UpdateManager::requestUpdate(UpdateManaged* observable, UpdateMemento* what
 {
 	if (m_updatesDisabled == 0)
 		return true;	
-	m_pending.insert(PendingUpdate(observable, what));
+	const void* subject = what->subject();
+	auto it = m_pendingIndexes.constFind(subject);
+	for ( ; it != m_pendingIndexes.cend() && it.key() == subject; ++it)
+	{
+		const PendingUpdate& pair = m_pending.at(it.value());
+		if (pair.first == observable && pair.second->merge(what))
+		{
+			delete what;
+			return false;
+		}
+	}
+	m_pendingIndexes.insert(subject, m_pending.count());
+	m_pending.append(PendingUpdate(observable, what));
 	return false;
 }
+
+void UpdateManager::removePending(const void* subject)
+{
+	if (subject == nullptr)
+		return;
+	auto it = m_pendingIndexes.find(subject);
+	while (it != m_pendingIndexes.end() && it.key() == subject)
+	{
+		PendingUpdate& pair = m_pending[it.value()];
+		delete pair.second;
+		pair.second = nullptr;
+		it = m_pendingIndexes.erase(it);
+	}
+}
@@ -18,7 +18,9 @@
 
 #include "scribusapi.h"
 
-#include <QSet>
+#include <QHash>
+#include <QList>
+#include <QPair>
 
 
 
@@ -29,6 +31,16 @@
 struct SCRIBUS_API UpdateMemento
 {
 	virtual ~UpdateMemento() = default;
+	/**
+	  Absorbs the later update 'other' of the same observable if this memento
+	  can stand for both, while updates are disabled. Returns false by default.
+	 */
+	virtual bool merge(const UpdateMemento* /*other*/) { return false; }
+	/**
+	  Returns the object this update is about, if it is an object which can be deleted
+	  while the update is pending, see UpdateManager::removePending(). Returns nullptr by default.
+	 */
+	virtual const void* subject() const { return nullptr; }
 };
 
 
@@ -60,13 +72,20 @@ public:
 
   If "requestUpdate()" is called multiple times before updates are enabled again, each
   observable will only get one notification with "updateNow()" 
-  when the updates are enabled again.
+  when the updates are enabled again. Requests of an observable about the same subject are
+  merged when their mementos allow it, see UpdateMemento::merge(), pending notifications are
+  sent in the order they were first requested.
+
+  Objects which are deleted while updates are disabled must call "removePending()",
+  notifications about them are dropped.
  */
 
 class SCRIBUS_API UpdateManager
 {
 	int m_updatesDisabled {0};
-	QSet<QPair<UpdateManaged*, UpdateMemento*> > m_pending;
+	QList<QPair<UpdateManaged*, UpdateMemento*> > m_pending;
+	// Indexes in m_pending of the pending updates about a subject
+	QMultiHash<const void*, int> m_pendingIndexes;
 	
 public:
 	UpdateManager() = default;
@@ -79,6 +98,10 @@ public:
 		Returns true if updates are enabled, otherwise stores 'observable' for notification when updates get enabled again.
 	 */
 	bool requestUpdate(UpdateManaged* observable, UpdateMemento* what);
+	/**
+		Drops pending updates about 'subject', which is being deleted.
+	 */
+	void removePending(const void* subject);
 };
 
 